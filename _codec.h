@@ -0,0 +1,196 @@
+/* SCTP bindings for Python
+ *
+ * _codec.h: definitions shared by the message codecs (_sigtran, _diameter)
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Parsed messages of every codec start with CODEC_MESSAGE_HEAD: the view of
+ * the received buffer they index, without a copy, and a memoryview of it to
+ * hand out slices. Encoders write into a caller-supplied writable buffer,
+ * or into a new bytes object. Everything here is static, as each codec is a
+ * module of its own. */
+
+#ifndef _CODEC_H
+#define _CODEC_H
+
+#define PY_SSIZE_T_CLEAN
+
+#include <Python.h>
+#include "structmember.h"
+#include <stdint.h>
+#include <string.h>
+
+#if PY_MAJOR_VERSION >= 3
+	#define Py23_PyLong_FromLong PyLong_FromLong
+#else
+	#define Py23_PyLong_FromLong PyInt_FromLong
+#endif
+
+typedef struct ktuple {
+	char* key;
+	int value;
+} ktuple;
+
+/* Adds a {0, -1} terminated table of integer constants to the module */
+static inline int codec_add_constants(PyObject* module, const ktuple* k)
+{
+	for(; k->key; ++k) {
+		if (PyModule_AddIntConstant(module, k->key, k->value) < 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/* Network byte order */
+
+static inline uint16_t get_u16(const uint8_t* p)
+{
+	return (uint16_t) ((p[0] << 8) | p[1]);
+}
+
+static inline uint32_t get_u24(const uint8_t* p)
+{
+	return ((uint32_t) p[0] << 16) | ((uint32_t) p[1] << 8) | p[2];
+}
+
+static inline uint32_t get_u32(const uint8_t* p)
+{
+	return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+static inline void put_u16(uint8_t* p, uint16_t v)
+{
+	p[0] = v >> 8;
+	p[1] = v;
+}
+
+static inline void put_u32(uint8_t* p, uint32_t v)
+{
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+/* Parsed messages */
+
+#define CODEC_MESSAGE_HEAD \
+	PyObject_VAR_HEAD           /* ob_size: number of elements */ \
+	Py_buffer view; \
+	PyObject* mview;            /* memoryview of the buffer, built on first use */ \
+	Py_ssize_t base;            /* offset of the message in the buffer */
+
+typedef struct {
+	CODEC_MESSAGE_HEAD
+} CodecMessageObject;
+
+/* Parses (buffer[, offset]) and gets a view of the buffer, in which at least
+ * "header" bytes must follow the offset. Returns the message start, or NULL
+ * with an exception set and no view held. */
+static inline const uint8_t* codec_get_message(PyObject* args, Py_buffer* view, Py_ssize_t* base,
+						Py_ssize_t header, const char* name)
+{
+	PyObject* obuf;
+
+	*base = 0;
+	if (! PyArg_ParseTuple(args, "O|n", &obuf, base)) {
+		return 0;
+	}
+	if (PyObject_GetBuffer(obuf, view, PyBUF_SIMPLE) < 0) {
+		return 0;
+	}
+	if (*base < 0 || *base > view->len || view->len - *base < header) {
+		PyErr_Format(PyExc_ValueError, "%s message shorter than its header", name);
+		PyBuffer_Release(view);
+		return 0;
+	}
+	return (const uint8_t*) view->buf + *base;
+}
+
+static inline void codec_message_dealloc(CodecMessageObject* self)
+{
+	Py_XDECREF(self->mview);
+	PyBuffer_Release(&(self->view));
+	PyObject_Del(self);
+}
+
+static inline Py_ssize_t codec_message_length(CodecMessageObject* self)
+{
+	return Py_SIZE(self);
+}
+
+/* memoryview over buffer[off:off+len] */
+static inline PyObject* codec_message_slice(CodecMessageObject* self, Py_ssize_t off, Py_ssize_t len)
+{
+	if (! self->mview) {
+		self->mview = PyMemoryView_FromObject(self->view.obj);
+		if (! self->mview) {
+			return 0;
+		}
+	}
+	return PySequence_GetSlice(self->mview, off, off + len);
+}
+
+/* Encoders */
+
+struct encoder {
+	Py_buffer out;
+	PyObject* bytes;            // returned instead of a length, when buf is None
+	uint8_t* p;
+	Py_ssize_t room;
+};
+
+/* Points e->p at "size" bytes of buf[offset:], or at a new bytes object if
+ * obuf is None */
+static inline int encoder_open(struct encoder* e, PyObject* obuf, Py_ssize_t offset, Py_ssize_t size)
+{
+	e->bytes = 0;
+	e->out.obj = 0;
+
+	if (obuf == Py_None) {
+		e->bytes = PyBytes_FromStringAndSize(0, size);
+		if (! e->bytes) {
+			return 0;
+		}
+		e->p = (uint8_t*) PyBytes_AS_STRING(e->bytes);
+		e->room = size;
+		return 1;
+	}
+
+	if (PyObject_GetBuffer(obuf, &(e->out), PyBUF_WRITABLE) < 0) {
+		return 0;
+	}
+	if (offset < 0 || offset > e->out.len || e->out.len - offset < size) {
+		PyErr_Format(PyExc_ValueError, "buffer too small: %zd bytes needed at offset %zd",
+				size, offset);
+		PyBuffer_Release(&(e->out));
+		return 0;
+	}
+	e->p = (uint8_t*) e->out.buf + offset;
+	e->room = size;
+	return 1;
+}
+
+static inline PyObject* encoder_close(struct encoder* e, Py_ssize_t size)
+{
+	if (e->bytes) {
+		return e->bytes;
+	}
+	PyBuffer_Release(&(e->out));
+	return PyLong_FromSsize_t(size);
+}
+
+#endif
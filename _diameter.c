@@ -0,0 +1,568 @@
+/* SCTP bindings for Python
+ *
+ * _diameter.c: Diameter message index (RFC 6733), for Diameter over SCTP
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Over SCTP, each message received carries exactly one Diameter message.
+ * diameter_parse() validates its header and the AVP framing of a received
+ * buffer (bytes, bytearray, memoryview...) and returns a DiameterMessage
+ * holding the code, flags, vendor id, offset and length of each top-level
+ * AVP, plus a reference to the buffer. Nothing is copied: AVP data are handed
+ * out as memoryview slices or integers. Grouped AVPs are indexed in turn by
+ * diameter_avps() over the slice of their data. */
+
+#include "_codec.h"
+
+#define DIAMETER_VERSION 1
+#define DIAMETER_HEADER 20
+#define AVP_HEADER 8
+#define AVP_VENDOR_HEADER 12
+
+#define AVP_FLAG_VENDOR 0x80
+
+static ktuple _constants[] =
+{
+	{"PPID_DIAMETER", 46},
+	{"PPID_DIAMETER_DTLS", 47},
+	// command flags
+	{"FLAG_REQUEST", 0x80},
+	{"FLAG_PROXIABLE", 0x40},
+	{"FLAG_ERROR", 0x20},
+	{"FLAG_RETRANSMITTED", 0x10},
+	// AVP flags
+	{"AVP_FLAG_VENDOR", AVP_FLAG_VENDOR},
+	{"AVP_FLAG_MANDATORY", 0x40},
+	// command codes, base protocol (RFC 6733) and credit control (RFC 4006)
+	{"CMD_CAPABILITIES_EXCHANGE", 257},
+	{"CMD_RE_AUTH", 258},
+	{"CMD_ACCOUNTING", 271},
+	{"CMD_CREDIT_CONTROL", 272},
+	{"CMD_ABORT_SESSION", 274},
+	{"CMD_SESSION_TERMINATION", 275},
+	{"CMD_DEVICE_WATCHDOG", 280},
+	{"CMD_DISCONNECT_PEER", 282},
+	// AVP codes, same sources
+	{"AVP_HOST_IP_ADDRESS", 257},
+	{"AVP_AUTH_APPLICATION_ID", 258},
+	{"AVP_ACCT_APPLICATION_ID", 259},
+	{"AVP_VENDOR_SPECIFIC_APPLICATION_ID", 260},
+	{"AVP_SESSION_ID", 263},
+	{"AVP_ORIGIN_HOST", 264},
+	{"AVP_SUPPORTED_VENDOR_ID", 265},
+	{"AVP_VENDOR_ID", 266},
+	{"AVP_FIRMWARE_REVISION", 267},
+	{"AVP_RESULT_CODE", 268},
+	{"AVP_PRODUCT_NAME", 269},
+	{"AVP_DISCONNECT_CAUSE", 273},
+	{"AVP_ORIGIN_STATE_ID", 278},
+	{"AVP_FAILED_AVP", 279},
+	{"AVP_ERROR_MESSAGE", 281},
+	{"AVP_ROUTE_RECORD", 282},
+	{"AVP_DESTINATION_REALM", 283},
+	{"AVP_DESTINATION_HOST", 293},
+	{"AVP_ORIGIN_REALM", 296},
+	{"AVP_EXPERIMENTAL_RESULT", 297},
+	{"AVP_INBAND_SECURITY_ID", 299},
+	{"AVP_EVENT_TIMESTAMP", 55},
+	{"AVP_CC_REQUEST_NUMBER", 415},
+	{"AVP_CC_REQUEST_TYPE", 416},
+	{"AVP_SUBSCRIPTION_ID", 443},
+	{"AVP_SUBSCRIPTION_ID_DATA", 444},
+	{"AVP_SUBSCRIPTION_ID_TYPE", 450},
+	{"AVP_MULTIPLE_SERVICES_CREDIT_CONTROL", 456},
+	{"AVP_USER_EQUIPMENT_INFO", 458},
+	{"AVP_SERVICE_CONTEXT_ID", 461},
+	{0, -1}
+};
+
+/* Diameter message object */
+
+struct diameter_avp {
+	uint32_t code;
+	uint32_t vendor;  // 0 without the V flag
+	uint32_t len;     // data length, without AVP header and padding
+	uint32_t off;     // data offset in the buffer
+	uint8_t flags;
+};
+
+typedef struct {
+	CODEC_MESSAGE_HEAD          // elements: AVPs; base: offset of the message or AVP data
+	unsigned char version;
+	unsigned char flags;
+	unsigned int length;
+	unsigned int command_code;
+	unsigned int application_id;
+	unsigned int hop_by_hop;
+	unsigned int end_to_end;
+	struct diameter_avp avps[1];
+} DiameterMessageObject;
+
+static PyTypeObject DiameterMessageType = { PyVarObject_HEAD_INIT(NULL, 0) };
+static PySequenceMethods diameter_as_sequence;
+
+/* Validates the AVPs in p[pos:len]. Fills "out" if not NULL, and returns the
+ * number of AVPs, or -1 with ValueError set. */
+static Py_ssize_t avp_scan(const uint8_t* p, uint32_t pos, uint32_t len, Py_ssize_t base,
+				struct diameter_avp* out)
+{
+	Py_ssize_t n = 0;
+
+	while (pos < len) {
+		uint32_t code, alen, hlen;
+		uint8_t flags;
+
+		if (len - pos < AVP_HEADER) {
+			PyErr_Format(PyExc_ValueError, "truncated Diameter AVP header at offset %u", pos);
+			return -1;
+		}
+		code = get_u32(p + pos);
+		flags = p[pos + 4];
+		alen = get_u24(p + pos + 5);
+		hlen = (flags & AVP_FLAG_VENDOR) ? AVP_VENDOR_HEADER : AVP_HEADER;
+		if (alen < hlen || alen > len - pos) {
+			PyErr_Format(PyExc_ValueError, "Diameter AVP %u at offset %u has invalid length %u",
+					code, pos, alen);
+			return -1;
+		}
+		if (out) {
+			out[n].code = code;
+			out[n].flags = flags;
+			out[n].vendor = (flags & AVP_FLAG_VENDOR) ? get_u32(p + pos + AVP_HEADER) : 0;
+			out[n].len = alen - hlen;
+			out[n].off = (uint32_t) (base + pos + hlen);
+		}
+		++n;
+		// padding of the last AVP may be missing
+		pos += (alen + 3) & ~3;
+	}
+
+	return n;
+}
+
+/* Builds the index of the AVPs in p[pos:len], p being at buffer offset
+ * "base". Takes over the buffer view, released on error. */
+static DiameterMessageObject* diameter_index(Py_buffer* view, Py_ssize_t base,
+						const uint8_t* p, uint32_t pos, uint32_t len)
+{
+	Py_ssize_t n;
+	DiameterMessageObject* m;
+
+	n = avp_scan(p, pos, len, base, 0);
+	if (n < 0) {
+		PyBuffer_Release(view);
+		return 0;
+	}
+	m = PyObject_NewVar(DiameterMessageObject, &DiameterMessageType, n);
+	if (! m) {
+		PyBuffer_Release(view);
+		return 0;
+	}
+	avp_scan(p, pos, len, base, m->avps);
+	m->view = *view;
+	m->mview = 0;
+	m->base = base;
+	m->length = len;
+	return m;
+}
+
+static PyObject* diameter_parse(PyObject* dummy, PyObject* args)
+{
+	Py_ssize_t base;
+	Py_buffer view;
+	const uint8_t* p;
+	uint32_t len;
+	DiameterMessageObject* m;
+
+	p = codec_get_message(args, &view, &base, DIAMETER_HEADER, "Diameter");
+	if (! p) {
+		return 0;
+	}
+	if (p[0] != DIAMETER_VERSION) {
+		PyErr_Format(PyExc_ValueError, "unsupported Diameter version %d", p[0]);
+		goto error;
+	}
+	len = get_u24(p + 1);
+	if (len < DIAMETER_HEADER || len > (uint64_t) (view.len - base)) {
+		PyErr_Format(PyExc_ValueError, "Diameter message length %u does not fit in %zd bytes",
+				len, view.len - base);
+		goto error;
+	}
+
+	m = diameter_index(&view, base, p, DIAMETER_HEADER, len);
+	if (! m) {
+		return 0;
+	}
+	m->version = p[0];
+	m->flags = p[4];
+	m->command_code = get_u24(p + 5);
+	m->application_id = get_u32(p + 8);
+	m->hop_by_hop = get_u32(p + 12);
+	m->end_to_end = get_u32(p + 16);
+
+	return (PyObject*) m;
+
+error:
+	PyBuffer_Release(&view);
+	return 0;
+}
+
+static PyObject* diameter_avps(PyObject* dummy, PyObject* args)
+{
+	PyObject* obuf;
+	Py_ssize_t base = 0;
+	Py_ssize_t len = -1;
+	Py_buffer view;
+	DiameterMessageObject* m;
+
+	if (! PyArg_ParseTuple(args, "O|nn", &obuf, &base, &len)) {
+		return 0;
+	}
+	if (PyObject_GetBuffer(obuf, &view, PyBUF_SIMPLE) < 0) {
+		return 0;
+	}
+	if (len < 0 && base >= 0 && base <= view.len) {
+		len = view.len - base;
+	}
+	if (base < 0 || base > view.len || len < 0 || len > view.len - base || len > 0xffffff) {
+		PyErr_SetString(PyExc_ValueError, "AVP data out of the buffer");
+		PyBuffer_Release(&view);
+		return 0;
+	}
+
+	m = diameter_index(&view, base, (const uint8_t*) view.buf + base, 0, (uint32_t) len);
+	if (! m) {
+		return 0;
+	}
+	m->version = 0;
+	m->flags = 0;
+	m->command_code = 0;
+	m->application_id = 0;
+	m->hop_by_hop = 0;
+	m->end_to_end = 0;
+
+	return (PyObject*) m;
+}
+
+static PyObject* diameter_item(DiameterMessageObject* self, Py_ssize_t i)
+{
+	const struct diameter_avp* avp;
+
+	if (i < 0 || i >= Py_SIZE(self)) {
+		PyErr_SetString(PyExc_IndexError, "Diameter AVP index out of range");
+		return 0;
+	}
+	avp = &(self->avps[i]);
+	return Py_BuildValue("(kikkk)", (unsigned long) avp->code, avp->flags, (unsigned long) avp->vendor,
+				(unsigned long) avp->off, (unsigned long) avp->len);
+}
+
+static const struct diameter_avp* diameter_find(DiameterMessageObject* self, unsigned long code,
+						unsigned long vendor)
+{
+	Py_ssize_t i;
+
+	for(i = 0; i < Py_SIZE(self); ++i) {
+		if (self->avps[i].code == code && self->avps[i].vendor == vendor) {
+			return &(self->avps[i]);
+		}
+	}
+	return 0;
+}
+
+static PyObject* diameter_find_method(DiameterMessageObject* self, PyObject* args)
+{
+	unsigned long code;
+	unsigned long vendor = 0;
+	const struct diameter_avp* avp;
+
+	if (! PyArg_ParseTuple(args, "k|k", &code, &vendor)) {
+		return 0;
+	}
+	avp = diameter_find(self, code, vendor);
+	if (! avp) {
+		return Py23_PyLong_FromLong(-1);
+	}
+	return PyLong_FromSsize_t(avp - self->avps);
+}
+
+static PyObject* diameter_find_all(DiameterMessageObject* self, PyObject* args)
+{
+	unsigned long code;
+	unsigned long vendor = 0;
+	PyObject* ret;
+	Py_ssize_t i;
+
+	if (! PyArg_ParseTuple(args, "k|k", &code, &vendor)) {
+		return 0;
+	}
+	ret = PyList_New(0);
+	for(i = 0; ret && i < Py_SIZE(self); ++i) {
+		if (self->avps[i].code == code && self->avps[i].vendor == vendor) {
+			PyObject* o = PyLong_FromSsize_t(i);
+			if (! o || PyList_Append(ret, o) < 0) {
+				Py_XDECREF(o);
+				Py_CLEAR(ret);
+				break;
+			}
+			Py_DECREF(o);
+		}
+	}
+	return ret;
+}
+
+static PyObject* diameter_get(DiameterMessageObject* self, PyObject* args)
+{
+	unsigned long code;
+	PyObject* dflt = Py_None;
+	unsigned long vendor = 0;
+	const struct diameter_avp* avp;
+
+	if (! PyArg_ParseTuple(args, "k|Ok", &code, &dflt, &vendor)) {
+		return 0;
+	}
+	avp = diameter_find(self, code, vendor);
+	if (! avp) {
+		Py_INCREF(dflt);
+		return dflt;
+	}
+	return codec_message_slice((CodecMessageObject*) self, avp->off, avp->len);
+}
+
+static PyObject* diameter_get_u32(DiameterMessageObject* self, PyObject* args)
+{
+	unsigned long code;
+	PyObject* dflt = Py_None;
+	unsigned long vendor = 0;
+	const struct diameter_avp* avp;
+
+	if (! PyArg_ParseTuple(args, "k|Ok", &code, &dflt, &vendor)) {
+		return 0;
+	}
+	avp = diameter_find(self, code, vendor);
+	if (! avp) {
+		Py_INCREF(dflt);
+		return dflt;
+	}
+	if (avp->len != 4) {
+		PyErr_Format(PyExc_ValueError, "Diameter AVP %lu is not a 32-bit integer", code);
+		return 0;
+	}
+	return PyLong_FromUnsignedLong(get_u32((const uint8_t*) self->view.buf + avp->off));
+}
+
+static PyObject* diameter_get_u64(DiameterMessageObject* self, PyObject* args)
+{
+	unsigned long code;
+	PyObject* dflt = Py_None;
+	unsigned long vendor = 0;
+	const struct diameter_avp* avp;
+	const uint8_t* p;
+
+	if (! PyArg_ParseTuple(args, "k|Ok", &code, &dflt, &vendor)) {
+		return 0;
+	}
+	avp = diameter_find(self, code, vendor);
+	if (! avp) {
+		Py_INCREF(dflt);
+		return dflt;
+	}
+	if (avp->len != 8) {
+		PyErr_Format(PyExc_ValueError, "Diameter AVP %lu is not a 64-bit integer", code);
+		return 0;
+	}
+	p = (const uint8_t*) self->view.buf + avp->off;
+	return PyLong_FromUnsignedLongLong(((unsigned PY_LONG_LONG) get_u32(p) << 32) | get_u32(p + 4));
+}
+
+static PyObject* diameter_group(DiameterMessageObject* self, PyObject* args)
+{
+	Py_ssize_t i;
+	const struct diameter_avp* avp;
+	Py_buffer view;
+	DiameterMessageObject* m;
+
+	if (! PyArg_ParseTuple(args, "n", &i)) {
+		return 0;
+	}
+	if (i < 0) {
+		i += Py_SIZE(self);
+	}
+	if (i < 0 || i >= Py_SIZE(self)) {
+		PyErr_SetString(PyExc_IndexError, "Diameter AVP index out of range");
+		return 0;
+	}
+	avp = &(self->avps[i]);
+
+	// the group holds its own export of the buffer
+	if (PyObject_GetBuffer(self->view.obj, &view, PyBUF_SIMPLE) < 0) {
+		return 0;
+	}
+	m = diameter_index(&view, avp->off, (const uint8_t*) view.buf + avp->off, 0, avp->len);
+	if (! m) {
+		return 0;
+	}
+	m->version = self->version;
+	m->flags = self->flags;
+	m->command_code = self->command_code;
+	m->application_id = self->application_id;
+	m->hop_by_hop = self->hop_by_hop;
+	m->end_to_end = self->end_to_end;
+
+	return (PyObject*) m;
+}
+
+static PyObject* diameter_ids(DiameterMessageObject* self, PyObject* noargs)
+{
+	return Py_BuildValue("(kk)", (unsigned long) self->hop_by_hop, (unsigned long) self->end_to_end);
+}
+
+static PyObject* diameter_is_request(DiameterMessageObject* self, void* closure)
+{
+	return PyBool_FromLong(self->flags & 0x80);
+}
+
+static PyMethodDef diameter_methods[] = {
+	{"find", (PyCFunction) diameter_find_method, METH_VARARGS,
+		"find(code[, vendor_id]) -> index of the first AVP with this code, or -1"},
+	{"find_all", (PyCFunction) diameter_find_all, METH_VARARGS,
+		"find_all(code[, vendor_id]) -> list of the indexes of the AVPs with this code"},
+	{"get", (PyCFunction) diameter_get, METH_VARARGS,
+		"get(code[, default[, vendor_id]]) -> memoryview of the data of the first AVP with this code"},
+	{"get_u32", (PyCFunction) diameter_get_u32, METH_VARARGS,
+		"get_u32(code[, default[, vendor_id]]) -> data of an Unsigned32/Enumerated AVP"},
+	{"get_u64", (PyCFunction) diameter_get_u64, METH_VARARGS,
+		"get_u64(code[, default[, vendor_id]]) -> data of an Unsigned64 AVP"},
+	{"group", (PyCFunction) diameter_group, METH_VARARGS,
+		"group(index) -> DiameterMessage indexing the AVPs inside the Grouped AVP at index"},
+	{"ids", (PyCFunction) diameter_ids, METH_NOARGS,
+		"ids() -> (hop_by_hop, end_to_end), to match answers with requests"},
+	{ NULL, NULL, 0, NULL }
+};
+
+static PyGetSetDef diameter_getset[] = {
+	{"is_request", (getter) diameter_is_request, NULL, "R flag of the command flags", NULL},
+	{ NULL, NULL, NULL, NULL, NULL }
+};
+
+static PyMemberDef diameter_members[] = {
+	{"version", T_UBYTE, offsetof(DiameterMessageObject, version), READONLY, ""},
+	{"flags", T_UBYTE, offsetof(DiameterMessageObject, flags), READONLY, "command flags (FLAG_*)"},
+	{"length", T_UINT, offsetof(DiameterMessageObject, length), READONLY, "message length, header included"},
+	{"command_code", T_UINT, offsetof(DiameterMessageObject, command_code), READONLY, ""},
+	{"application_id", T_UINT, offsetof(DiameterMessageObject, application_id), READONLY, ""},
+	{"hop_by_hop", T_UINT, offsetof(DiameterMessageObject, hop_by_hop), READONLY, "Hop-by-Hop Identifier"},
+	{"end_to_end", T_UINT, offsetof(DiameterMessageObject, end_to_end), READONLY, "End-to-End Identifier"},
+	{"offset", T_PYSSIZET, offsetof(DiameterMessageObject, base), READONLY, "offset of the message in the buffer"},
+	{"buffer", T_OBJECT, offsetof(DiameterMessageObject, view) + offsetof(Py_buffer, obj), READONLY, ""},
+	{ NULL, 0, 0, 0, NULL }
+};
+
+static PyMethodDef _diameter_methods[] =
+{
+	{"diameter_parse", diameter_parse, METH_VARARGS,
+		"diameter_parse(buffer[, offset]) -> DiameterMessage, without copying the buffer"},
+	{"diameter_avps", diameter_avps, METH_VARARGS,
+		"diameter_avps(buffer[, offset[, length]]) -> DiameterMessage indexing a run of AVPs\n"
+		"(e.g. the data of a Grouped AVP), without header"},
+	{ NULL, NULL, 0, NULL }
+};
+
+static int init_types(PyObject* module)
+{
+	if (DiameterMessageType.tp_name == 0) {
+		diameter_as_sequence.sq_length = (lenfunc) codec_message_length;
+		diameter_as_sequence.sq_item = (ssizeargfunc) diameter_item;
+
+		DiameterMessageType.tp_name = "_diameter.DiameterMessage";
+		DiameterMessageType.tp_doc = "Parsed Diameter message, a sequence of "
+					     "(code, flags, vendor_id, offset, length) AVPs";
+		DiameterMessageType.tp_basicsize = offsetof(DiameterMessageObject, avps);
+		DiameterMessageType.tp_itemsize = sizeof(struct diameter_avp);
+		DiameterMessageType.tp_flags = Py_TPFLAGS_DEFAULT;
+		DiameterMessageType.tp_dealloc = (destructor) codec_message_dealloc;
+		DiameterMessageType.tp_as_sequence = &diameter_as_sequence;
+		DiameterMessageType.tp_methods = diameter_methods;
+		DiameterMessageType.tp_members = diameter_members;
+		DiameterMessageType.tp_getset = diameter_getset;
+		if (PyType_Ready(&DiameterMessageType) < 0) {
+			return -1;
+		}
+	}
+	Py_INCREF(&DiameterMessageType);
+	if (PyModule_AddObject(module, "DiameterMessage", (PyObject*) &DiameterMessageType) < 0) {
+		Py_DECREF(&DiameterMessageType);
+		return -1;
+	}
+
+	return codec_add_constants(module, _constants);
+}
+
+#if PY_MAJOR_VERSION >= 3
+
+    static struct PyModuleDef moduledef = {
+            PyModuleDef_HEAD_INIT,
+            "_diameter",
+	        "Diameter message index",
+            -1,
+            _diameter_methods,
+            NULL,
+            NULL,
+            NULL,
+            NULL
+    };
+
+    #define INITERROR return NULL
+
+    PyObject * PyInit__diameter(void)
+
+#else
+
+    #define INITERROR return
+
+    void init_diameter(void)
+
+#endif
+
+{
+#if PY_MAJOR_VERSION >= 3
+
+    PyObject *module = PyModule_Create(&moduledef);
+
+#else
+
+    PyObject *module = Py_InitModule4(
+        "_diameter",
+        _diameter_methods,
+        "Diameter message index",
+        0,
+        PYTHON_API_VERSION);
+
+#endif
+
+    if (module == NULL)
+        INITERROR;
+
+    if (init_types(module) < 0) {
+        Py_DECREF(module);
+        INITERROR;
+    }
+
+#if PY_MAJOR_VERSION >= 3
+
+        return module;
+
+#endif
+}
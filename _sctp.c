@@ -22,6 +22,7 @@
 #define PY_SSIZE_T_CLEAN
 
 #include <Python.h>
+#include "structmember.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <netinet/sctp.h>
@@ -29,6 +30,12 @@
 #include <memory.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <poll.h>
 #include "_sctp.h"
 
 
@@ -70,10 +77,19 @@ static PyObject* set_nodelay(PyObject* dummy, PyObject* args);
 static PyObject* get_initparams(PyObject* dummy, PyObject* args);
 static PyObject* set_initparams(PyObject* dummy, PyObject* args);
 static PyObject* peeloff(PyObject* dummy, PyObject* args);
+static PyObject* accept_many(PyObject* dummy, PyObject* args);
+static PyObject* send_fds(PyObject* dummy, PyObject* args);
+static PyObject* recv_fds(PyObject* dummy, PyObject* args);
 static PyObject* get_events(PyObject* dummy, PyObject* args);
 static PyObject* set_events(PyObject* dummy, PyObject* args);
 static PyObject* get_maxseg(PyObject* dummy, PyObject* args);
 static PyObject* set_maxseg(PyObject* dummy, PyObject* args);
+static PyObject* get_partial_delivery_point(PyObject* dummy, PyObject* args);
+static PyObject* set_partial_delivery_point(PyObject* dummy, PyObject* args);
+static PyObject* get_fragment_interleave(PyObject* dummy, PyObject* args);
+static PyObject* set_fragment_interleave(PyObject* dummy, PyObject* args);
+static PyObject* get_explicit_eor(PyObject* dummy, PyObject* args);
+static PyObject* set_explicit_eor(PyObject* dummy, PyObject* args);
 static PyObject* get_disable_fragments(PyObject* dummy, PyObject* args);
 static PyObject* set_disable_fragments(PyObject* dummy, PyObject* args);
 static PyObject* get_autoclose(PyObject* dummy, PyObject* args);
@@ -88,11 +104,13 @@ static PyObject* set_peer_primary(PyObject* dummy, PyObject* args);
 static PyObject* set_primary(PyObject* dummy, PyObject* args);
 static PyObject* bindx(PyObject* dummy, PyObject* args);
 static PyObject* connectx(PyObject* dummy, PyObject* args);
+static PyObject* connectx_many(PyObject* dummy, PyObject* args);
 static PyObject* getpaddrs(PyObject* dummy, PyObject* args);
 static PyObject* getladdrs(PyObject* dummy, PyObject* args);
 static PyObject* sctp_send_msg(PyObject* dummy, PyObject* args);
 static PyObject* sctp_recv_msg(PyObject* dummy, PyObject* args);
 static PyObject* _sockaddr_test(PyObject* dummy, PyObject* args);
+static PyObject* _getpaddrs_tuple(PyObject* dummy, PyObject* args);
 
 static PyObject* get_status(PyObject* dummy, PyObject* args);
 static PyObject* get_rtoinfo(PyObject* dummy, PyObject* args);
@@ -103,8 +121,46 @@ static PyObject* get_paddrparams(PyObject* dummy, PyObject* args);
 static PyObject* set_rtoinfo(PyObject* dummy, PyObject* args);
 static PyObject* set_assocparams(PyObject* dummy, PyObject* args);
 static PyObject* set_paddrparams(PyObject* dummy, PyObject* args);
-
+static PyObject* get_paddrthlds(PyObject* dummy, PyObject* args);
+static PyObject* set_paddrthlds(PyObject* dummy, PyObject* args);
+static PyObject* apply_failover_profile(PyObject* dummy, PyObject* args);
+
+static PyObject* get_pr_supported(PyObject* dummy, PyObject* args);
+static PyObject* set_pr_supported(PyObject* dummy, PyObject* args);
+static PyObject* get_default_prinfo(PyObject* dummy, PyObject* args);
+static PyObject* set_default_prinfo(PyObject* dummy, PyObject* args);
+static PyObject* get_pr_assoc_status(PyObject* dummy, PyObject* args);
+static PyObject* get_pr_stream_status(PyObject* dummy, PyObject* args);
+
+static PyObject* get_reconfig_supported(PyObject* dummy, PyObject* args);
+static PyObject* set_reconfig_supported(PyObject* dummy, PyObject* args);
+static PyObject* get_enable_stream_reset(PyObject* dummy, PyObject* args);
+static PyObject* set_enable_stream_reset(PyObject* dummy, PyObject* args);
+static PyObject* reset_streams(PyObject* dummy, PyObject* args);
+static PyObject* reset_assoc(PyObject* dummy, PyObject* args);
+static PyObject* add_streams(PyObject* dummy, PyObject* args);
+
+static PyObject* get_assoc_stats(PyObject* dummy, PyObject* args);
+static PyObject* assoc_stats_delta(PyObject* dummy, PyObject* args);
+static PyObject* get_status_all(PyObject* dummy, PyObject* args);
+static PyObject* latency_stats_new(PyObject* dummy, PyObject* args);
+static PyObject* latency_stats_read(PyObject* dummy, PyObject* args);
+static PyObject* proc_read_snmp(PyObject* dummy, PyObject* args);
+static PyObject* proc_read_table(PyObject* dummy, PyObject* args);
+static PyObject* pcap_open(PyObject* dummy, PyObject* args);
+static PyObject* pcap_close(PyObject* dummy, PyObject* args);
+static PyObject* pcap_stats(PyObject* dummy, PyObject* args);
+static PyObject* register_notification_types(PyObject* dummy, PyObject* args);
+
+static int init_types(PyObject* module);
+
+static int get_assoc_id_list(int fd, sctp_assoc_t** ids);
+static int setsockopt_assoc(int fd, int opt, void* v, socklen_t lv, sctp_assoc_t* pid);
+static void probe_special_assoc(void);
 static int to_sockaddr(const char *caddr, int port, struct sockaddr* saddr, int* slen);
+#ifndef SOCK_CLOEXEC
+static int set_nonblock(int fd, int nonblock);
+#endif
 static int from_sockaddr(struct sockaddr* saddr, int* family, int* slen, int* port, char* caddr, int cnt);
 
 static PyMethodDef _sctp_methods[] = 
@@ -119,9 +175,13 @@ static PyMethodDef _sctp_methods[] =
 	{"have_sctp_addip", have_sctp_addip, METH_VARARGS, ""},
 	{"bindx", bindx, METH_VARARGS, ""},
 	{"connectx", connectx, METH_VARARGS, ""},
+	{"connectx_many", connectx_many, METH_VARARGS, ""},
 	{"getpaddrs", getpaddrs, METH_VARARGS, ""},
 	{"getladdrs", getladdrs, METH_VARARGS, ""},
 	{"peeloff", peeloff, METH_VARARGS, ""},
+	{"accept_many", accept_many, METH_VARARGS, ""},
+	{"send_fds", send_fds, METH_VARARGS, ""},
+	{"recv_fds", recv_fds, METH_VARARGS, ""},
 	{"sctp_send_msg", sctp_send_msg, METH_VARARGS, ""},
 	{"sctp_recv_msg", sctp_recv_msg, METH_VARARGS, ""},
 	{"set_peer_primary", set_peer_primary, METH_VARARGS, ""},
@@ -146,7 +206,14 @@ static PyMethodDef _sctp_methods[] =
 	{"set_mappedv4", set_mappedv4, METH_VARARGS, ""},
 	{"get_maxseg", get_maxseg, METH_VARARGS, ""},
 	{"set_maxseg", set_maxseg, METH_VARARGS, ""},
+	{"get_partial_delivery_point", get_partial_delivery_point, METH_VARARGS, ""},
+	{"set_partial_delivery_point", set_partial_delivery_point, METH_VARARGS, ""},
+	{"get_fragment_interleave", get_fragment_interleave, METH_VARARGS, ""},
+	{"set_fragment_interleave", set_fragment_interleave, METH_VARARGS, ""},
+	{"get_explicit_eor", get_explicit_eor, METH_VARARGS, ""},
+	{"set_explicit_eor", set_explicit_eor, METH_VARARGS, ""},
 	{"_sockaddr_test", _sockaddr_test, METH_VARARGS, ""},
+	{"_getpaddrs_tuple", _getpaddrs_tuple, METH_VARARGS, ""},
 	{"get_status", get_status, METH_VARARGS, ""},
 	{"get_rtoinfo", get_rtoinfo, METH_VARARGS, ""},
 	{"get_paddrinfo", get_paddrinfo, METH_VARARGS, ""},
@@ -155,6 +222,33 @@ static PyMethodDef _sctp_methods[] =
 	{"set_rtoinfo", set_rtoinfo, METH_VARARGS, ""},
 	{"set_assocparams", set_assocparams, METH_VARARGS, ""},
 	{"set_paddrparams", set_paddrparams, METH_VARARGS, ""},
+	{"get_paddrthlds", get_paddrthlds, METH_VARARGS, ""},
+	{"set_paddrthlds", set_paddrthlds, METH_VARARGS, ""},
+	{"apply_failover_profile", apply_failover_profile, METH_VARARGS, ""},
+	{"get_pr_supported", get_pr_supported, METH_VARARGS, ""},
+	{"set_pr_supported", set_pr_supported, METH_VARARGS, ""},
+	{"get_default_prinfo", get_default_prinfo, METH_VARARGS, ""},
+	{"set_default_prinfo", set_default_prinfo, METH_VARARGS, ""},
+	{"get_pr_assoc_status", get_pr_assoc_status, METH_VARARGS, ""},
+	{"get_pr_stream_status", get_pr_stream_status, METH_VARARGS, ""},
+	{"get_reconfig_supported", get_reconfig_supported, METH_VARARGS, ""},
+	{"set_reconfig_supported", set_reconfig_supported, METH_VARARGS, ""},
+	{"get_enable_stream_reset", get_enable_stream_reset, METH_VARARGS, ""},
+	{"set_enable_stream_reset", set_enable_stream_reset, METH_VARARGS, ""},
+	{"reset_streams", reset_streams, METH_VARARGS, ""},
+	{"reset_assoc", reset_assoc, METH_VARARGS, ""},
+	{"add_streams", add_streams, METH_VARARGS, ""},
+	{"get_assoc_stats", get_assoc_stats, METH_VARARGS, ""},
+	{"assoc_stats_delta", assoc_stats_delta, METH_VARARGS, ""},
+	{"get_status_all", get_status_all, METH_VARARGS, ""},
+	{"latency_stats_new", latency_stats_new, METH_VARARGS, ""},
+	{"latency_stats_read", latency_stats_read, METH_VARARGS, ""},
+	{"proc_read_snmp", proc_read_snmp, METH_VARARGS, ""},
+	{"proc_read_table", proc_read_table, METH_VARARGS, ""},
+	{"pcap_open", pcap_open, METH_VARARGS, ""},
+	{"pcap_close", pcap_close, METH_VARARGS, ""},
+	{"pcap_stats", pcap_stats, METH_VARARGS, ""},
+	{"register_notification_types", register_notification_types, METH_VARARGS, ""},
 	{ NULL, NULL, 0, NULL }
 };
 
@@ -232,6 +326,13 @@ static PyMethodDef _sctp_methods[] =
         INITERROR;
     }
 
+    if (init_types(module) < 0) {
+        Py_DECREF(module);
+        INITERROR;
+    }
+
+    probe_special_assoc();
+
 #if PY_MAJOR_VERSION >= 3
     
         return module;
@@ -274,6 +375,23 @@ typedef struct ktuple {
 #define MSG_EOF       SCTP_EOF
 #endif
 
+#ifndef SCTP_FUTURE_ASSOC
+/* RFC 6458 special association ids, missing from older kernel headers */
+#define SCTP_FUTURE_ASSOC  0
+#define SCTP_CURRENT_ASSOC 1
+#define SCTP_ALL_ASSOC     2
+#endif
+
+/* Kernels before Linux 5.1 do not reserve SCTP_CURRENT_ASSOC and
+   SCTP_ALL_ASSOC: 1 and 2 are ordinary association ids there. The module
+   then exports these values instead, which no association can have, and
+   setsockopt_assoc() emulates them; see probe_special_assoc() */
+#define EMULATED_CURRENT_ASSOC -2
+#define EMULATED_ALL_ASSOC     -3
+
+static sctp_assoc_t current_assoc = EMULATED_CURRENT_ASSOC;
+static sctp_assoc_t all_assoc = EMULATED_ALL_ASSOC;
+
 static ktuple _constants[] = 
 {
 	{"BINDX_ADD", SCTP_BINDX_ADD_ADDR},
@@ -282,6 +400,9 @@ static ktuple _constants[] =
 	{"IPPROTO_SCTP", IPPROTO_SCTP},
 	{"SOCK_SEQPACKET", SOCK_SEQPACKET},
 	{"SOCK_STREAM", SOCK_STREAM},
+	{"SCTP_FUTURE_ASSOC", SCTP_FUTURE_ASSOC},
+	{"SCTP_CURRENT_ASSOC", SCTP_CURRENT_ASSOC},
+	{"SCTP_ALL_ASSOC", SCTP_ALL_ASSOC},
 	{"MSG_UNORDERED", MSG_UNORDERED},
 	{"MSG_ADDR_OVER", MSG_ADDR_OVER},
 #ifdef SCTP_DRAFT10_LEVEL
@@ -292,6 +413,11 @@ static ktuple _constants[] =
 	{"MSG_ABORT", MSG_ABORT},
 	{"MSG_EOF", MSG_EOF},
 	{"MSG_EOR", MSG_EOR},
+#ifdef SCTP_EOR
+	{"SCTP_EOR", SCTP_EOR},
+#else
+	{"SCTP_EOR", MSG_EOR},
+#endif
 	{"MSG_FIN", MSG_FIN},
 	{"MSG_DONTROUTE", MSG_DONTROUTE},
 	{"MSG_NOTIFICATION", MSG_NOTIFICATION},
@@ -356,6 +482,64 @@ static ktuple _constants[] =
 	{"SCTP_SHUTDOWN_EVENT", SCTP_SHUTDOWN_EVENT},
 	{"SCTP_PARTIAL_DELIVERY_EVENT", SCTP_PARTIAL_DELIVERY_EVENT}, 
 	{"SCTP_ADAPTATION_INDICATION", SCTP_ADAPTATION_INDICATION},
+#ifdef SCTP_PR_SCTP_MASK
+	{"SCTP_PR_SCTP_NONE", SCTP_PR_SCTP_NONE},
+	{"SCTP_PR_SCTP_TTL", SCTP_PR_SCTP_TTL},
+	{"SCTP_PR_SCTP_RTX", SCTP_PR_SCTP_RTX},
+	{"SCTP_PR_SCTP_PRIO", SCTP_PR_SCTP_PRIO},
+	{"SCTP_PR_SCTP_MASK", SCTP_PR_SCTP_MASK},
+#else
+	// distinct placeholders, refused with ENOPROTOOPT by sctp_send(); the
+	// zero mask tells sctp.py that PR-SCTP policies are not compiled in
+	{"SCTP_PR_SCTP_NONE", 0},
+	{"SCTP_PR_SCTP_TTL", 1},
+	{"SCTP_PR_SCTP_RTX", 2},
+	{"SCTP_PR_SCTP_PRIO", 3},
+	{"SCTP_PR_SCTP_MASK", 0},
+#endif
+#ifdef SCTP_PR_STREAM_STATUS
+	{"SCTP_PR_SCTP_ALL", SCTP_PR_SCTP_ALL},
+#else
+	{"SCTP_PR_SCTP_ALL", 0},
+#endif
+#ifdef SCTP_STREAM_RESET_EVENT
+	{"SCTP_STREAM_RESET_EVENT", SCTP_STREAM_RESET_EVENT},
+	{"SCTP_ASSOC_RESET_EVENT", SCTP_ASSOC_RESET_EVENT},
+	{"SCTP_STREAM_CHANGE_EVENT", SCTP_STREAM_CHANGE_EVENT},
+	{"SCTP_STREAM_RESET_INCOMING_SSN", SCTP_STREAM_RESET_INCOMING_SSN},
+	{"SCTP_STREAM_RESET_OUTGOING_SSN", SCTP_STREAM_RESET_OUTGOING_SSN},
+	{"SCTP_STREAM_RESET_DENIED", SCTP_STREAM_RESET_DENIED},
+	{"SCTP_STREAM_RESET_FAILED", SCTP_STREAM_RESET_FAILED},
+	{"SCTP_ASSOC_RESET_DENIED", SCTP_ASSOC_RESET_DENIED},
+	{"SCTP_ASSOC_RESET_FAILED", SCTP_ASSOC_RESET_FAILED},
+	{"SCTP_STREAM_CHANGE_DENIED", SCTP_STREAM_CHANGE_DENIED},
+	{"SCTP_STREAM_CHANGE_FAILED", SCTP_STREAM_CHANGE_FAILED},
+#else
+	{"SCTP_STREAM_RESET_EVENT", -1},
+	{"SCTP_ASSOC_RESET_EVENT", -1},
+	{"SCTP_STREAM_CHANGE_EVENT", -1},
+	{"SCTP_STREAM_RESET_INCOMING_SSN", 0},
+	{"SCTP_STREAM_RESET_OUTGOING_SSN", 0},
+	{"SCTP_STREAM_RESET_DENIED", 0},
+	{"SCTP_STREAM_RESET_FAILED", 0},
+	{"SCTP_ASSOC_RESET_DENIED", 0},
+	{"SCTP_ASSOC_RESET_FAILED", 0},
+	{"SCTP_STREAM_CHANGE_DENIED", 0},
+	{"SCTP_STREAM_CHANGE_FAILED", 0},
+#endif
+#ifdef SCTP_ENABLE_STREAM_RESET
+	{"SCTP_ENABLE_RESET_STREAM_REQ", SCTP_ENABLE_RESET_STREAM_REQ},
+	{"SCTP_ENABLE_RESET_ASSOC_REQ", SCTP_ENABLE_RESET_ASSOC_REQ},
+	{"SCTP_ENABLE_CHANGE_ASSOC_REQ", SCTP_ENABLE_CHANGE_ASSOC_REQ},
+	{"SCTP_STREAM_RESET_INCOMING", SCTP_STREAM_RESET_INCOMING},
+	{"SCTP_STREAM_RESET_OUTGOING", SCTP_STREAM_RESET_OUTGOING},
+#else
+	{"SCTP_ENABLE_RESET_STREAM_REQ", 0},
+	{"SCTP_ENABLE_RESET_ASSOC_REQ", 0},
+	{"SCTP_ENABLE_CHANGE_ASSOC_REQ", 0},
+	{"SCTP_STREAM_RESET_INCOMING", 0},
+	{"SCTP_STREAM_RESET_OUTGOING", 0},
+#endif
 	{0, -1}
 };
 
@@ -578,7 +762,7 @@ static PyObject* set_assocparams(PyObject* dummy, PyObject* args)
 	v.sasoc_local_rwnd = Py23_PyLong_AsLong(olocal_rwnd);
 	v.sasoc_cookie_life = Py23_PyLong_AsLong(ocookie_life);
 
-	if (setsockopt(fd, SOL_SCTP, SCTP_ASSOCINFO, &v, sizeof(v))) {
+	if (setsockopt_assoc(fd, SCTP_ASSOCINFO, &v, sizeof(v), &(v.sasoc_assoc_id))) {
 		PyErr_SetFromErrno(PyExc_IOError);
 	} else {
 		PyDict_SetItemString(dict, "assocmaxrxt", Py23_PyLong_FromLong(v.sasoc_asocmaxrxt));
@@ -700,7 +884,7 @@ static PyObject* set_paddrparams(PyObject* dummy, PyObject* args)
 		return ret;
 	}
 
-	if (setsockopt(fd, SOL_SCTP, SCTP_PEER_ADDR_PARAMS, &v, sizeof(v))) {
+	if (setsockopt_assoc(fd, SCTP_PEER_ADDR_PARAMS, &v, sizeof(v), &(v.spp_assoc_id))) {
 		PyErr_SetFromErrno(PyExc_IOError);
 	} else {
 		PyDict_SetItemString(dict, "hbinterval", Py23_PyLong_FromLong(v.spp_hbinterval));
@@ -716,6 +900,367 @@ static PyObject* set_paddrparams(PyObject* dummy, PyObject* args)
 	return ret;
 }
 
+static PyObject* get_paddrthlds(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	PyObject* dict;
+	PyObject* oassoc_id;
+	PyObject* oaddresstuple;
+
+	const char* address;
+	int port;
+
+	int fd;
+	int ok;
+	int slen_dummy;
+
+	ok = PyArg_ParseTuple(args, "iO", &fd, &dict) && PyDict_Check(dict);
+	ok = ok && (oassoc_id = PyDict_GetItemString(dict, "assoc_id"));
+	ok = ok && (oaddresstuple = PyDict_GetItemString(dict, "sockaddr"));
+	ok = ok && Py23_PyLong_Check(oassoc_id);
+	ok = ok && PyArg_ParseTuple(oaddresstuple, "si", &address, &port);
+
+	if (! ok) {
+		return ret;
+	}
+
+#ifdef SCTP_PEER_ADDR_THLDS
+	struct sctp_paddrthlds v;
+	socklen_t lv = sizeof(v);
+
+	bzero(&v, sizeof(v));
+	v.spt_assoc_id = Py23_PyLong_AsLong(oassoc_id);
+
+	if (! to_sockaddr(address, port, (struct sockaddr*) &(v.spt_address), &slen_dummy)) {
+		PyErr_SetString(PyExc_ValueError, "address could not be translated");
+		return ret;
+	}
+
+	if (getsockopt(fd, SOL_SCTP, SCTP_PEER_ADDR_THLDS, &v, &lv)) {
+		PyErr_SetFromErrno(PyExc_IOError);
+	} else {
+		PyDict_SetItemString(dict, "pathmaxrxt", Py23_PyLong_FromLong(v.spt_pathmaxrxt));
+		PyDict_SetItemString(dict, "pf_threshold", Py23_PyLong_FromLong(v.spt_pathpfthld));
+		ret = Py_None; Py_INCREF(ret);
+	}
+#else
+	errno = ENOPROTOOPT;
+	PyErr_SetFromErrno(PyExc_IOError);
+#endif
+
+	return ret;
+}
+
+static PyObject* set_paddrthlds(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	PyObject* dict;
+	PyObject* oassoc_id;
+	PyObject* oaddresstuple;
+	PyObject* opathmaxrxt;
+	PyObject* opf_threshold;
+
+	const char* address;
+	int port;
+
+	int fd;
+	int ok;
+	int slen_dummy;
+
+	ok = PyArg_ParseTuple(args, "iO", &fd, &dict) && PyDict_Check(dict);
+	ok = ok && (oassoc_id = PyDict_GetItemString(dict, "assoc_id"));
+	ok = ok && (oaddresstuple = PyDict_GetItemString(dict, "sockaddr"));
+	ok = ok && (opathmaxrxt = PyDict_GetItemString(dict, "pathmaxrxt"));
+	ok = ok && (opf_threshold = PyDict_GetItemString(dict, "pf_threshold"));
+	ok = ok && PyArg_ParseTuple(oaddresstuple, "si", &address, &port);
+	ok = ok && Py23_PyLong_Check(oassoc_id);
+	ok = ok && Py23_PyLong_Check(opathmaxrxt);
+	ok = ok && Py23_PyLong_Check(opf_threshold);
+
+	if (! ok) {
+		return ret;
+	}
+
+#ifdef SCTP_PEER_ADDR_THLDS
+	struct sctp_paddrthlds v;
+
+	bzero(&v, sizeof(v));
+	v.spt_assoc_id = Py23_PyLong_AsLong(oassoc_id);
+	v.spt_pathmaxrxt = Py23_PyLong_AsLong(opathmaxrxt);
+	v.spt_pathpfthld = Py23_PyLong_AsLong(opf_threshold);
+
+	if (! to_sockaddr(address, port, (struct sockaddr*) &(v.spt_address), &slen_dummy)) {
+		PyErr_SetString(PyExc_ValueError, "address could not be translated");
+		return ret;
+	}
+
+	if (setsockopt_assoc(fd, SCTP_PEER_ADDR_THLDS, &v, sizeof(v), &(v.spt_assoc_id))) {
+		PyErr_SetFromErrno(PyExc_IOError);
+	} else {
+		ret = Py_None; Py_INCREF(ret);
+	}
+#else
+	errno = ENOPROTOOPT;
+	PyErr_SetFromErrno(PyExc_IOError);
+#endif
+
+	return ret;
+}
+
+/* Failover profile: the RTO, heartbeat, retransmission and potentially-
+ * failed (RFC 7829) settings that together decide how fast a dead path
+ * is abandoned. They live in four socket options; apply_failover_profile()
+ * saves the current values of all of them, applies the profile, and puts
+ * the saved values back if any setsockopt() fails, so that an association
+ * is never left half-tuned. Zero means "unchanged", like for the options
+ * themselves, except for pf_threshold where 0 is meaningful (-1 is used). */
+
+#ifdef SCTP_PEER_ADDR_THLDS
+
+struct failover_profile {
+	uint32_t rto_initial;
+	uint32_t rto_min;
+	uint32_t rto_max;
+	uint32_t hbinterval;
+	int pathmaxrxt;
+	int assocmaxrxt;
+	int pf_threshold;
+};
+
+struct failover_saved {
+	sctp_assoc_t id;
+	struct sctp_rtoinfo rto;
+	struct sctp_paddrparams paddr;
+	struct sctp_paddrthlds thlds;
+	struct sctp_assocparams assoc;
+	int steps;        // number of options already applied
+};
+
+#define FAILOVER_STEPS 4
+
+static int failover_save(int fd, struct failover_saved* s)
+{
+	socklen_t l;
+
+	bzero(&s->rto, sizeof(s->rto));
+	s->rto.srto_assoc_id = s->id;
+	l = sizeof(s->rto);
+	if (getsockopt(fd, SOL_SCTP, SCTP_RTOINFO, &s->rto, &l)) {
+		return -1;
+	}
+
+	// wildcard address: the association (or endpoint) defaults
+	bzero(&s->paddr, sizeof(s->paddr));
+	s->paddr.spp_assoc_id = s->id;
+	s->paddr.spp_address.ss_family = AF_INET;
+	l = sizeof(s->paddr);
+	if (getsockopt(fd, SOL_SCTP, SCTP_PEER_ADDR_PARAMS, &s->paddr, &l)) {
+		return -1;
+	}
+
+	bzero(&s->thlds, sizeof(s->thlds));
+	s->thlds.spt_assoc_id = s->id;
+	s->thlds.spt_address.ss_family = AF_INET;
+	l = sizeof(s->thlds);
+	if (getsockopt(fd, SOL_SCTP, SCTP_PEER_ADDR_THLDS, &s->thlds, &l)) {
+		return -1;
+	}
+
+	bzero(&s->assoc, sizeof(s->assoc));
+	s->assoc.sasoc_assoc_id = s->id;
+	l = sizeof(s->assoc);
+	if (getsockopt(fd, SOL_SCTP, SCTP_ASSOCINFO, &s->assoc, &l)) {
+		return -1;
+	}
+
+	s->steps = 0;
+	return 0;
+}
+
+/* Applies step "step" of either the profile p, or the saved values if p is NULL */
+static int failover_step(int fd, const struct failover_profile* p, const struct failover_saved* s, int step)
+{
+	struct sctp_rtoinfo rto;
+	struct sctp_paddrparams paddr;
+	struct sctp_paddrthlds thlds;
+	struct sctp_assocparams assoc;
+
+	switch (step) {
+	case 0:
+		bzero(&rto, sizeof(rto));
+		rto.srto_assoc_id = s->id;
+		rto.srto_initial = p ? p->rto_initial : s->rto.srto_initial;
+		rto.srto_min = p ? p->rto_min : s->rto.srto_min;
+		rto.srto_max = p ? p->rto_max : s->rto.srto_max;
+		return setsockopt(fd, SOL_SCTP, SCTP_RTOINFO, &rto, sizeof(rto));
+	case 1:
+		// pathmaxrxt is set before assocmaxrxt, which the kernel checks against it
+		bzero(&paddr, sizeof(paddr));
+		paddr.spp_assoc_id = s->id;
+		paddr.spp_address.ss_family = AF_INET;
+		paddr.spp_pathmaxrxt = p ? p->pathmaxrxt : s->paddr.spp_pathmaxrxt;
+		paddr.spp_hbinterval = p ? p->hbinterval : s->paddr.spp_hbinterval;
+		// the kernel only takes hbinterval along with SPP_HB_ENABLE
+		if (paddr.spp_hbinterval) {
+			paddr.spp_flags = SPP_HB_ENABLE;
+		}
+		if (setsockopt(fd, SOL_SCTP, SCTP_PEER_ADDR_PARAMS, &paddr, sizeof(paddr))) {
+			return -1;
+		}
+		if (! p && (s->paddr.spp_flags & SPP_HB_DISABLE)) {
+			paddr.spp_hbinterval = 0;
+			paddr.spp_pathmaxrxt = 0;
+			paddr.spp_flags = SPP_HB_DISABLE;
+			return setsockopt(fd, SOL_SCTP, SCTP_PEER_ADDR_PARAMS, &paddr, sizeof(paddr));
+		}
+		return 0;
+	case 2:
+		bzero(&thlds, sizeof(thlds));
+		thlds.spt_assoc_id = s->id;
+		thlds.spt_address.ss_family = AF_INET;
+		thlds.spt_pathmaxrxt = p && p->pathmaxrxt ? p->pathmaxrxt : s->thlds.spt_pathmaxrxt;
+		thlds.spt_pathpfthld = p && p->pf_threshold >= 0 ? p->pf_threshold : s->thlds.spt_pathpfthld;
+		return setsockopt(fd, SOL_SCTP, SCTP_PEER_ADDR_THLDS, &thlds, sizeof(thlds));
+	case 3:
+		bzero(&assoc, sizeof(assoc));
+		assoc.sasoc_assoc_id = s->id;
+		assoc.sasoc_asocmaxrxt = p ? p->assocmaxrxt : s->assoc.sasoc_asocmaxrxt;
+		return setsockopt(fd, SOL_SCTP, SCTP_ASSOCINFO, &assoc, sizeof(assoc));
+	}
+	return 0;
+}
+
+static void failover_rollback(int fd, struct failover_saved* s)
+{
+	// best effort, in reverse order
+	while (s->steps > 0) {
+		s->steps--;
+		failover_step(fd, 0, s, s->steps);
+	}
+}
+
+#endif
+
+static PyObject* apply_failover_profile(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	PyObject* dict;
+	int fd;
+	int assoc_id;
+	int all;
+
+	if (! PyArg_ParseTuple(args, "iiOi", &fd, &assoc_id, &dict, &all) || ! PyDict_Check(dict)) {
+		return ret;
+	}
+
+#ifdef SCTP_PEER_ADDR_THLDS
+	struct failover_profile p;
+	struct failover_saved* saved = 0;
+	sctp_assoc_t* ids = 0;
+	int count = 0;
+	int nsaved = 0;
+	int failed = 0;
+	int err = 0;
+	int x, step;
+
+	static const char* keys[] = {"rto_initial", "rto_min", "rto_max", "hbinterval",
+					"pathmaxrxt", "assocmaxrxt", "pf_threshold"};
+	long values[7];
+
+	for (x = 0; x < 7; ++x) {
+		PyObject* o = PyDict_GetItemString(dict, keys[x]);
+		if (! o || ! Py23_PyLong_Check(o)) {
+			PyErr_Format(PyExc_ValueError, "profile needs an integer %s", keys[x]);
+			return ret;
+		}
+		values[x] = Py23_PyLong_AsLong(o);
+	}
+
+	p.rto_initial = values[0];
+	p.rto_min = values[1];
+	p.rto_max = values[2];
+	p.hbinterval = values[3];
+	p.pathmaxrxt = values[4];
+	p.assocmaxrxt = values[5];
+	p.pf_threshold = values[6];
+
+	if ((p.rto_min && p.rto_max && p.rto_min > p.rto_max) ||
+			(p.rto_initial && p.rto_min && p.rto_initial < p.rto_min) ||
+			(p.rto_initial && p.rto_max && p.rto_initial > p.rto_max)) {
+		PyErr_SetString(PyExc_ValueError, "profile needs rto_min <= rto_initial <= rto_max");
+		return ret;
+	}
+	if (p.pathmaxrxt && p.pf_threshold > p.pathmaxrxt) {
+		PyErr_SetString(PyExc_ValueError, "profile needs pf_threshold <= pathmaxrxt");
+		return ret;
+	}
+
+	Py_BEGIN_ALLOW_THREADS
+
+	// socket-wide: the endpoint defaults, then every live association
+	if (all) {
+		count = get_assoc_id_list(fd, &ids);
+		if (count < 0) {
+			count = 0;
+		}
+	}
+	saved = calloc(count + 1, sizeof(struct failover_saved));
+	if (! saved) {
+		failed = 1;
+		err = ENOMEM;
+	}
+
+	for (x = 0; ! failed && x <= count; ++x) {
+		struct failover_saved* s = &saved[nsaved];
+		s->id = x == 0 ? assoc_id : ids[x - 1];
+		if (failover_save(fd, s)) {
+			if (x > 0 && (errno == EINVAL || errno == ENOENT)) {
+				// association went away meanwhile
+				continue;
+			}
+			failed = 1;
+			err = errno;
+			break;
+		}
+		nsaved++;
+	}
+
+	for (x = 0; ! failed && x < nsaved; ++x) {
+		for (step = 0; step < FAILOVER_STEPS; ++step) {
+			if (failover_step(fd, &p, &saved[x], step)) {
+				failed = 1;
+				err = errno;
+				break;
+			}
+			saved[x].steps++;
+		}
+	}
+
+	if (failed) {
+		for (x = 0; x < nsaved; ++x) {
+			failover_rollback(fd, &saved[x]);
+		}
+	}
+
+	Py_END_ALLOW_THREADS
+
+	free(saved);
+	free(ids);
+
+	if (failed) {
+		errno = err;
+		PyErr_SetFromErrno(PyExc_IOError);
+	} else {
+		ret = Py23_PyLong_FromLong(nsaved);
+	}
+#else
+	errno = ENOPROTOOPT;
+	PyErr_SetFromErrno(PyExc_IOError);
+#endif
+
+	return ret;
+}
+
 static PyObject* get_status(PyObject* dummy, PyObject* args)
 {
 	PyObject* ret = 0;
@@ -890,7 +1435,7 @@ static PyObject* set_rtoinfo(PyObject* dummy, PyObject* args)
 	v.srto_min = Py23_PyLong_AsLong(omin);
 	v.srto_max = Py23_PyLong_AsLong(omax);
 
-	if (setsockopt(fd, SOL_SCTP, SCTP_RTOINFO, &v, sizeof(v))) {
+	if (setsockopt_assoc(fd, SCTP_RTOINFO, &v, sizeof(v), &(v.srto_assoc_id))) {
 		PyErr_SetFromErrno(PyExc_IOError);
 	} else {
 		PyDict_SetItemString(dict, "initial", Py23_PyLong_FromLong(v.srto_initial));
@@ -978,48 +1523,330 @@ static PyObject* peeloff(PyObject* dummy, PyObject* args)
 	return ret;
 }
 
-static PyObject* get_events(PyObject* dummy, PyObject* args)
+/* Accepts up to max pending connections in one call, with the GIL released,
+ * as non-blocking close-on-exec descriptors. Stops at the first error; the
+ * error is raised only if nothing was accepted. On a blocking listening
+ * socket, only the first accept() may wait. */
+static PyObject* accept_many(PyObject* dummy, PyObject* args)
 {
 	PyObject* ret = 0;
-	int fd;
-	struct sctp_event_subscribe v;
-	socklen_t lv = sizeof(v);
+	int fd, max, count = 0, err = 0, blocking;
+	int* fds;
+	struct sockaddr_storage* addrs;
+	int x;
 
-	if (PyArg_ParseTuple(args, "i", &fd)) {
-		if (getsockopt(fd, SOL_SCTP, SCTP_EVENTS, &v, &lv)) {
-			PyErr_SetFromErrno(PyExc_IOError);
+	if (! PyArg_ParseTuple(args, "ii", &fd, &max)) {
+		return ret;
+	}
+	if (max <= 0) {
+		PyErr_SetString(PyExc_ValueError, "max must be positive");
+		return ret;
+	}
+
+	fds = (int*) malloc(max * sizeof(int));
+	addrs = (struct sockaddr_storage*) malloc(max * sizeof(struct sockaddr_storage));
+	if (! fds || ! addrs) {
+		free(fds);
+		free(addrs);
+		PyErr_SetString(PyExc_MemoryError, "Out of memory, malloc() failed");
+		return ret;
+	}
+
+	Py_BEGIN_ALLOW_THREADS
+	blocking = ! (fcntl(fd, F_GETFL) & O_NONBLOCK);
+	while (count < max) {
+		socklen_t len = sizeof(struct sockaddr_storage);
+		int afd;
+
+		if (count > 0 && blocking) {
+			struct pollfd p;
+			p.fd = fd;
+			p.events = POLLIN;
+			if (poll(&p, 1, 0) <= 0) {
+				break;
+			}
+		}
+#ifdef SOCK_CLOEXEC
+		afd = accept4(fd, (struct sockaddr*) &addrs[count], &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+		afd = accept(fd, (struct sockaddr*) &addrs[count], &len);
+		if (afd >= 0) {
+			set_nonblock(afd, 1);
+			fcntl(afd, F_SETFD, FD_CLOEXEC);
+		}
+#endif
+		if (afd < 0) {
+			err = errno;
+			break;
+		}
+		fds[count++] = afd;
+	}
+	Py_END_ALLOW_THREADS
+
+	if (count == 0 && err != EAGAIN && err != EWOULDBLOCK) {
+		errno = err;
+		PyErr_SetFromErrno(PyExc_IOError);
+		goto out;
+	}
+
+	ret = PyList_New(count);
+	for(x = 0; ret && x < count; ++x) {
+		char caddr[256];
+		int family, slen, port;
+		PyObject* oaddr;
+		PyObject* item;
+
+		if (from_sockaddr((struct sockaddr*) &addrs[x], &family, &slen, &port, caddr, sizeof(caddr))) {
+			oaddr = Py_BuildValue("(si)", caddr, port);
 		} else {
-			ret = PyDict_New();
-			PyDict_SetItemString(ret, "_data_io", PyBool_FromLong(v.sctp_data_io_event));
-			PyDict_SetItemString(ret, "_association", PyBool_FromLong(v.sctp_association_event));
-			PyDict_SetItemString(ret, "_address", PyBool_FromLong(v.sctp_address_event));
-			PyDict_SetItemString(ret, "_send_failure", PyBool_FromLong(v.sctp_send_failure_event));
-			PyDict_SetItemString(ret, "_peer_error", PyBool_FromLong(v.sctp_peer_error_event));
-			PyDict_SetItemString(ret, "_shutdown", PyBool_FromLong(v.sctp_shutdown_event));
-			PyDict_SetItemString(ret, "_partial_delivery", PyBool_FromLong(v.sctp_partial_delivery_event));
-			PyDict_SetItemString(ret, "_adaptation_layer", PyBool_FromLong(v.sctp_adaptation_layer_event));
+			oaddr = Py_None;
+			Py_INCREF(Py_None);
+		}
+		item = Py_BuildValue("(iN)", fds[x], oaddr);
+		if (! item) {
+			Py_CLEAR(ret);
+			break;
+		}
+		PyList_SET_ITEM(ret, x, item);
+	}
+	if (! ret) {
+		// nobody is going to own them
+		for(x = 0; x < count; ++x) {
+			close(fds[x]);
 		}
 	}
+
+out:
+	free(fds);
+	free(addrs);
 	return ret;
 }
 
-static PyObject* set_events(PyObject* dummy, PyObject* args)
+/* Descriptor passing over AF_UNIX sockets (SCM_RIGHTS), for handing live
+ * associations to other processes; see sctp_handoff.py. Python 2 has no
+ * sendmsg(), hence these. */
+
+#define MAX_PASSED_FDS 64
+
+static PyObject* send_fds(PyObject* dummy, PyObject* args)
 {
 	PyObject* ret = 0;
 	int fd;
-	PyObject *ov, *o_data_io, *o_association, *o_address, *o_send_failure;
-	PyObject *o_peer_error, *o_shutdown, *o_partial_delivery, *o_adaptation_layer;
-	struct sctp_event_subscribe v;
-	int ok = PyArg_ParseTuple(args, "iO", &fd, &ov) && PyDict_Check(ov);
+	Py_buffer data;
+	PyObject* ofds;
+	PyObject* seq = 0;
+	int fds[MAX_PASSED_FDS];
+	Py_ssize_t count, x;
+	char control[CMSG_SPACE(sizeof(fds))];
+	struct msghdr m;
+	struct iovec iov;
+	struct cmsghdr* c;
+	ssize_t sent;
+	int err;
+
+	if (! PyArg_ParseTuple(args, "is*O", &fd, &data, &ofds)) {
+		return ret;
+	}
 
-	ok = ok && (o_data_io = PyDict_GetItemString(ov, "_data_io"));
-	ok = ok && (o_association = PyDict_GetItemString(ov, "_association"));
-	ok = ok && (o_address = PyDict_GetItemString(ov, "_address"));
-	ok = ok && (o_send_failure = PyDict_GetItemString(ov, "_send_failure"));
-	ok = ok && (o_peer_error = PyDict_GetItemString(ov, "_peer_error"));
-	ok = ok && (o_shutdown = PyDict_GetItemString(ov, "_shutdown"));
-	ok = ok && (o_partial_delivery = PyDict_GetItemString(ov, "_partial_delivery"));
-	ok = ok && (o_adaptation_layer = PyDict_GetItemString(ov, "_adaptation_layer"));
+	seq = PySequence_Fast(ofds, "descriptors must be a sequence of integers");
+	if (! seq) {
+		goto out;
+	}
+	count = PySequence_Fast_GET_SIZE(seq);
+	if (count > MAX_PASSED_FDS) {
+		PyErr_Format(PyExc_ValueError, "at most %d descriptors per message", MAX_PASSED_FDS);
+		goto out;
+	}
+	for(x = 0; x < count; ++x) {
+		fds[x] = PyObject_AsFileDescriptor(PySequence_Fast_GET_ITEM(seq, x));
+		if (fds[x] < 0) {
+			goto out;
+		}
+	}
+	if (data.len == 0) {
+		// a message without data would not carry the descriptors
+		PyErr_SetString(PyExc_ValueError, "descriptors need at least one byte of data");
+		goto out;
+	}
+
+	bzero(&m, sizeof(m));
+	iov.iov_base = data.buf;
+	iov.iov_len = data.len;
+	m.msg_iov = &iov;
+	m.msg_iovlen = 1;
+	if (count > 0) {
+		bzero(control, sizeof(control));
+		m.msg_control = control;
+		m.msg_controllen = CMSG_SPACE(count * sizeof(int));
+		c = CMSG_FIRSTHDR(&m);
+		c->cmsg_level = SOL_SOCKET;
+		c->cmsg_type = SCM_RIGHTS;
+		c->cmsg_len = CMSG_LEN(count * sizeof(int));
+		memcpy(CMSG_DATA(c), fds, count * sizeof(int));
+	}
+
+	Py_BEGIN_ALLOW_THREADS
+	sent = sendmsg(fd, &m, 0);
+	err = errno;
+	Py_END_ALLOW_THREADS
+
+	if (sent < 0) {
+		errno = err;
+		PyErr_SetFromErrno(PyExc_IOError);
+		goto out;
+	}
+	ret = PyLong_FromSsize_t(sent);
+
+out:
+	Py_XDECREF(seq);
+	PyBuffer_Release(&data);
+	return ret;
+}
+
+static PyObject* recv_fds(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	PyObject* ofds;
+	PyObject* odata;
+	int fd, maxfds = MAX_PASSED_FDS;
+	Py_ssize_t maxlen;
+	char* buf;
+	char control[CMSG_SPACE(MAX_PASSED_FDS * sizeof(int))];
+	int fds[MAX_PASSED_FDS];
+	int count = 0;
+	struct msghdr m;
+	struct iovec iov;
+	struct cmsghdr* c;
+	ssize_t size;
+	int flags = 0;
+	int err;
+	int x;
+
+	if (! PyArg_ParseTuple(args, "in|i", &fd, &maxlen, &maxfds)) {
+		return ret;
+	}
+	if (maxlen <= 0 || maxfds < 0 || maxfds > MAX_PASSED_FDS) {
+		PyErr_Format(PyExc_ValueError, "maxlen must be positive and maxfds at most %d", MAX_PASSED_FDS);
+		return ret;
+	}
+	buf = malloc(maxlen);
+	if (! buf) {
+		PyErr_SetString(PyExc_MemoryError, "Out of memory, malloc() failed");
+		return ret;
+	}
+
+	bzero(&m, sizeof(m));
+	iov.iov_base = buf;
+	iov.iov_len = maxlen;
+	m.msg_iov = &iov;
+	m.msg_iovlen = 1;
+	m.msg_control = control;
+	m.msg_controllen = CMSG_SPACE(maxfds * sizeof(int));
+#ifdef MSG_CMSG_CLOEXEC
+	flags = MSG_CMSG_CLOEXEC;
+#endif
+
+	Py_BEGIN_ALLOW_THREADS
+	size = recvmsg(fd, &m, flags);
+	err = errno;
+	Py_END_ALLOW_THREADS
+
+	if (size < 0) {
+		free(buf);
+		errno = err;
+		PyErr_SetFromErrno(PyExc_IOError);
+		return ret;
+	}
+
+	for(c = CMSG_FIRSTHDR(&m); c; c = CMSG_NXTHDR(&m, c)) {
+		if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS) {
+			int n = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+			if (n > MAX_PASSED_FDS - count) {
+				n = MAX_PASSED_FDS - count;
+			}
+			memcpy(fds + count, CMSG_DATA(c), n * sizeof(int));
+			count += n;
+		}
+	}
+
+	if (m.msg_flags & (MSG_CTRUNC | MSG_TRUNC)) {
+		// a partial handoff is of no use to anybody
+		for(x = 0; x < count; ++x) {
+			close(fds[x]);
+		}
+		free(buf);
+		errno = EMSGSIZE;
+		PyErr_SetFromErrno(PyExc_IOError);
+		return ret;
+	}
+
+	odata = PyBytes_FromStringAndSize(buf, size);
+	free(buf);
+	ofds = PyList_New(count);
+	if (! odata || ! ofds) {
+		for(x = 0; x < count; ++x) {
+			close(fds[x]);
+		}
+		Py_XDECREF(odata);
+		Py_XDECREF(ofds);
+		return ret;
+	}
+	for(x = 0; x < count; ++x) {
+		PyList_SET_ITEM(ofds, x, Py23_PyLong_FromLong(fds[x]));
+	}
+	return Py_BuildValue("(NN)", odata, ofds);
+}
+
+static PyObject* get_events(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	int fd;
+	struct sctp_event_subscribe v;
+	socklen_t lv = sizeof(v);
+
+	if (PyArg_ParseTuple(args, "i", &fd)) {
+		if (getsockopt(fd, SOL_SCTP, SCTP_EVENTS, &v, &lv)) {
+			PyErr_SetFromErrno(PyExc_IOError);
+		} else {
+			ret = PyDict_New();
+			PyDict_SetItemString(ret, "_data_io", PyBool_FromLong(v.sctp_data_io_event));
+			PyDict_SetItemString(ret, "_association", PyBool_FromLong(v.sctp_association_event));
+			PyDict_SetItemString(ret, "_address", PyBool_FromLong(v.sctp_address_event));
+			PyDict_SetItemString(ret, "_send_failure", PyBool_FromLong(v.sctp_send_failure_event));
+			PyDict_SetItemString(ret, "_peer_error", PyBool_FromLong(v.sctp_peer_error_event));
+			PyDict_SetItemString(ret, "_shutdown", PyBool_FromLong(v.sctp_shutdown_event));
+			PyDict_SetItemString(ret, "_partial_delivery", PyBool_FromLong(v.sctp_partial_delivery_event));
+			PyDict_SetItemString(ret, "_adaptation_layer", PyBool_FromLong(v.sctp_adaptation_layer_event));
+#ifdef SCTP_STREAM_RESET_EVENT
+			PyDict_SetItemString(ret, "_stream_reset", PyBool_FromLong(v.sctp_stream_reset_event));
+			PyDict_SetItemString(ret, "_assoc_reset", PyBool_FromLong(v.sctp_assoc_reset_event));
+			PyDict_SetItemString(ret, "_stream_change", PyBool_FromLong(v.sctp_stream_change_event));
+#endif
+		}
+	}
+	return ret;
+}
+
+static PyObject* set_events(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	int fd;
+	PyObject *ov, *o_data_io, *o_association, *o_address, *o_send_failure;
+	PyObject *o_peer_error, *o_shutdown, *o_partial_delivery, *o_adaptation_layer;
+#ifdef SCTP_STREAM_RESET_EVENT
+	PyObject *o_stream_reset, *o_assoc_reset, *o_stream_change;
+#endif
+	struct sctp_event_subscribe v;
+	int ok = PyArg_ParseTuple(args, "iO", &fd, &ov) && PyDict_Check(ov);
+
+	ok = ok && (o_data_io = PyDict_GetItemString(ov, "_data_io"));
+	ok = ok && (o_association = PyDict_GetItemString(ov, "_association"));
+	ok = ok && (o_address = PyDict_GetItemString(ov, "_address"));
+	ok = ok && (o_send_failure = PyDict_GetItemString(ov, "_send_failure"));
+	ok = ok && (o_peer_error = PyDict_GetItemString(ov, "_peer_error"));
+	ok = ok && (o_shutdown = PyDict_GetItemString(ov, "_shutdown"));
+	ok = ok && (o_partial_delivery = PyDict_GetItemString(ov, "_partial_delivery"));
+	ok = ok && (o_adaptation_layer = PyDict_GetItemString(ov, "_adaptation_layer"));
 
 	ok = ok && (Py23_PyLong_Check(o_data_io) != 0);
 	ok = ok && (Py23_PyLong_Check(o_association) != 0);
@@ -1027,11 +1854,19 @@ static PyObject* set_events(PyObject* dummy, PyObject* args)
 	ok = ok && (Py23_PyLong_Check(o_send_failure) != 0);
 	ok = ok && (Py23_PyLong_Check(o_peer_error) != 0);
 	ok = ok && (Py23_PyLong_Check(o_shutdown) != 0);
-	ok = ok && (Py23_PyLong_Check(o_send_failure) != 0);
+	ok = ok && (Py23_PyLong_Check(o_partial_delivery) != 0);
 	ok = ok && (Py23_PyLong_Check(o_adaptation_layer) != 0);
 
 	if (ok) {
+		socklen_t lv = sizeof(v);
+
+		// start from the current mask, so that events left out of the
+		// dictionary keep their subscription
 		memset(&v, 0, sizeof(v));
+		if (getsockopt(fd, SOL_SCTP, SCTP_EVENTS, &v, &lv)) {
+			PyErr_SetFromErrno(PyExc_IOError);
+			return ret;
+		}
 		v.sctp_data_io_event = Py23_PyLong_AsLong(o_data_io);
 		v.sctp_association_event = Py23_PyLong_AsLong(o_association);
 		v.sctp_address_event = Py23_PyLong_AsLong(o_address);
@@ -1040,6 +1875,15 @@ static PyObject* set_events(PyObject* dummy, PyObject* args)
 		v.sctp_shutdown_event = Py23_PyLong_AsLong(o_shutdown);
 		v.sctp_partial_delivery_event = Py23_PyLong_AsLong(o_partial_delivery);
 		v.sctp_adaptation_layer_event = Py23_PyLong_AsLong(o_adaptation_layer);
+#ifdef SCTP_STREAM_RESET_EVENT
+		/* RFC 6525 events are optional in the dictionary */
+		if ((o_stream_reset = PyDict_GetItemString(ov, "_stream_reset")))
+			v.sctp_stream_reset_event = PyObject_IsTrue(o_stream_reset);
+		if ((o_assoc_reset = PyDict_GetItemString(ov, "_assoc_reset")))
+			v.sctp_assoc_reset_event = PyObject_IsTrue(o_assoc_reset);
+		if ((o_stream_change = PyDict_GetItemString(ov, "_stream_change")))
+			v.sctp_stream_change_event = PyObject_IsTrue(o_stream_change);
+#endif
 		
 		if (setsockopt(fd, SOL_SCTP, SCTP_EVENTS, &v, sizeof(v))) {
 			PyErr_SetFromErrno(PyExc_IOError);
@@ -1081,6 +1925,71 @@ static PyObject* set_maxseg(PyObject* dummy, PyObject* args)
 	return ret;
 }
 
+static PyObject* get_partial_delivery_point(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	int fd;
+	uint32_t v;
+	socklen_t lv = sizeof(v);
+
+	if (PyArg_ParseTuple(args, "i", &fd)) {
+		if (getsockopt(fd, SOL_SCTP, SCTP_PARTIAL_DELIVERY_POINT, &v, &lv)) {
+			PyErr_SetFromErrno(PyExc_IOError);
+		} else {
+			ret = PyLong_FromUnsignedLong(v);
+		}
+	}
+	return ret;
+}
+
+static PyObject* set_partial_delivery_point(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	int fd;
+	unsigned int v;
+
+	if (PyArg_ParseTuple(args, "iI", &fd, &v)) {
+		uint32_t v32 = v;
+		if (setsockopt(fd, SOL_SCTP, SCTP_PARTIAL_DELIVERY_POINT, &v32, sizeof(v32))) {
+			PyErr_SetFromErrno(PyExc_IOError);
+		} else {
+			ret = Py_None; Py_INCREF(ret);
+		}
+	}
+	return ret;
+}
+
+static PyObject* get_fragment_interleave(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	int fd, v;
+	socklen_t lv = sizeof(v);
+
+	if (PyArg_ParseTuple(args, "i", &fd)) {
+		if (getsockopt(fd, SOL_SCTP, SCTP_FRAGMENT_INTERLEAVE, &v, &lv)) {
+			PyErr_SetFromErrno(PyExc_IOError);
+		} else {
+			ret = Py23_PyLong_FromLong(v);
+		}
+	}
+	return ret;
+}
+
+static PyObject* set_fragment_interleave(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	int fd, v;
+
+	if (PyArg_ParseTuple(args, "ii", &fd, &v)) {
+		if (setsockopt(fd, SOL_SCTP, SCTP_FRAGMENT_INTERLEAVE, &v, sizeof(v))) {
+			PyErr_SetFromErrno(PyExc_IOError);
+		} else {
+			ret = Py_None; Py_INCREF(ret);
+		}
+	}
+	return ret;
+}
+
 static PyObject* get_disable_fragments(PyObject* dummy, PyObject* args)
 {
 	PyObject* ret = 0;
@@ -1236,478 +2145,3811 @@ static PyObject* set_rcvbuf(PyObject* dummy, PyObject* args)
 	return ret;
 }
 
-static int to_sockaddr(const char *caddr, int port, struct sockaddr* saddr, int* slen)
+static PyObject* get_pr_supported(PyObject* dummy, PyObject* args)
 {
-	int ret = 1;
-
-	*slen = 0;
-
-#ifdef DEBUG
-	printf("[DEBUG to_sockaddr] converting caddr: %s, port: %d\n", caddr, port);
-#endif
+	PyObject* ret = 0;
+	int fd, assoc_id;
 
-	if (strcmp(caddr, "") == 0) {
-		saddr->sa_family = AF_INET;
-		((struct sockaddr_in*) saddr)->sin_addr.s_addr = INADDR_ANY;
-	} else if (strcmp(caddr, "<broadcast>") == 0) {
-		saddr->sa_family = AF_INET;
-		((struct sockaddr_in*) saddr)->sin_addr.s_addr = INADDR_BROADCAST;
-	} else if (inet_pton(AF_INET6, caddr, &(((struct sockaddr_in6*)saddr)->sin6_addr)) > 0) {
-		saddr->sa_family = AF_INET6;
-	} else if (inet_pton(AF_INET, caddr, &(((struct sockaddr_in*)saddr)->sin_addr)) > 0) {
-		saddr->sa_family = AF_INET;
-	} else {
-		saddr->sa_family = -1;
-		ret = 0;
+	if (! PyArg_ParseTuple(args, "ii", &fd, &assoc_id)) {
+		return ret;
 	}
 
-	if (saddr->sa_family == AF_INET) {
-		((struct sockaddr_in*) saddr)->sin_port = htons(port);
-		*slen = sizeof(struct sockaddr_in);
-	} else if (saddr->sa_family == AF_INET6) {
-		((struct sockaddr_in6*) saddr)->sin6_port = htons(port);
-		*slen = sizeof(struct sockaddr_in6);
-	}
+#ifdef SCTP_PR_SUPPORTED
+	struct sctp_assoc_value v;
+	socklen_t lv = sizeof(v);
 
-#ifdef DEBUG
-	printf("[DEBUG to_sockaddr] sockaddr result is family: 0x%x, s_addr: 0x%x, port: 0x%x\n", 
-			((struct sockaddr_in*)saddr)->sin_family,
-			((struct sockaddr_in*)saddr)->sin_addr.s_addr,
-			((struct sockaddr_in*)saddr)->sin_port);
-#endif
-	return ret;
-}
+	bzero(&v, sizeof(v));
+	v.assoc_id = assoc_id;
 
-static int from_sockaddr(struct sockaddr* saddr, int* family, int* slen, int* port, char* caddr, int cnt)
-{
-	int ret = 0;
-	*family = saddr->sa_family;
-	if (*family == AF_INET) {
-		*slen = sizeof(struct sockaddr_in);
-		if (inet_ntop(AF_INET, &(((struct sockaddr_in*) saddr)->sin_addr), caddr, cnt)) {
-			*port = ntohs(((struct sockaddr_in*) saddr)->sin_port);
-			ret = 1;
-		}
-	} else if (*family == AF_INET6) {
-		*slen = sizeof(struct sockaddr_in6);
-		if (inet_ntop(AF_INET6, &(((struct sockaddr_in6*) saddr)->sin6_addr), caddr, cnt)) {
-			*port = ntohs(((struct sockaddr_in6*) saddr)->sin6_port);
-			ret = 1;
-		}
+	if (getsockopt(fd, SOL_SCTP, SCTP_PR_SUPPORTED, &v, &lv)) {
+		PyErr_SetFromErrno(PyExc_IOError);
+	} else {
+		ret = PyBool_FromLong(v.assoc_value);
 	}
+#else
+	errno = ENOPROTOOPT;
+	PyErr_SetFromErrno(PyExc_IOError);
+#endif
 	return ret;
 }
 
-static PyObject* _sockaddr_test(PyObject* dummy, PyObject* args)
+static PyObject* set_pr_supported(PyObject* dummy, PyObject* args)
 {
 	PyObject* ret = 0;
-	PyObject* addrtupleret = 0;
-	char *caddr;
-	int port;
-	struct sockaddr_storage saddr;
-	int slen;
-	int family;
-	char caddr2[256];
+	int fd, assoc_id, value;
 
-	if (! PyArg_ParseTuple(args, "(si)", &caddr, &port)) {
+	if (! PyArg_ParseTuple(args, "iii", &fd, &assoc_id, &value)) {
 		return ret;
 	}
 
-	printf("DEBUG: addr=%s, port=%d\n", caddr, port);
+#ifdef SCTP_PR_SUPPORTED
+	struct sctp_assoc_value v;
 
-	if (! to_sockaddr(caddr, port, (struct sockaddr*) &saddr, &slen)) {
-		PyErr_SetString(PyExc_ValueError, "address could not be translated");
-		return ret;
-	}
-	port = 0;
-	caddr = 0;
+	bzero(&v, sizeof(v));
+	v.assoc_id = assoc_id;
+	v.assoc_value = value;
 
-	if (! from_sockaddr((struct sockaddr*) &saddr, &family, &slen, &port, caddr2, sizeof(caddr2))) {
-		PyErr_SetString(PyExc_ValueError, "address could not be de-translated");
-		return ret;
+	if (setsockopt_assoc(fd, SCTP_PR_SUPPORTED, &v, sizeof(v), &(v.assoc_id))) {
+		PyErr_SetFromErrno(PyExc_IOError);
+	} else {
+		ret = Py_None; Py_INCREF(ret);
 	}
-
-	ret = PyTuple_New(4);
-	addrtupleret = PyTuple_New(2);
-	PyTuple_SetItem(ret, 0, Py23_PyUnicode_FromFormat("family %d, size %d, address %s.%d", family, slen, caddr2, port));
-	PyTuple_SetItem(ret, 1, Py23_PyLong_FromLong(family));
-	PyTuple_SetItem(ret, 2, Py23_PyLong_FromLong(slen));
-	PyTuple_SetItem(ret, 3, addrtupleret);
-	PyTuple_SetItem(addrtupleret, 0, PyUnicode_FromString(caddr2));
-	PyTuple_SetItem(addrtupleret, 1, Py23_PyLong_FromLong(port));
-
+#else
+	errno = ENOPROTOOPT;
+	PyErr_SetFromErrno(PyExc_IOError);
+#endif
 	return ret;
 }
 
-static PyObject* set_peer_primary(PyObject* dummy, PyObject* args)
+static PyObject* get_default_prinfo(PyObject* dummy, PyObject* args)
 {
 	PyObject* ret = 0;
+	PyObject* dict;
+	PyObject* oassoc_id;
 	int fd;
-	int l;
-	int assoc_id;
-	char* addr;
-	int port;
-	struct sctp_setpeerprim ssp;
+	int ok;
 
-	if (! PyArg_ParseTuple(args, "ii(si)", &fd, &assoc_id, &addr, &port)) {
-		return ret;
-	}
+	ok = PyArg_ParseTuple(args, "iO", &fd, &dict) && PyDict_Check(dict);
+	ok = ok && (oassoc_id = PyDict_GetItemString(dict, "assoc_id"));
+	ok = ok && Py23_PyLong_Check(oassoc_id);
 
-	bzero(&ssp, sizeof(ssp));
-	ssp.sspp_assoc_id = assoc_id;
-	if (! to_sockaddr(addr, port, (struct sockaddr*) &(ssp.sspp_addr), &l)) {
-		PyErr_SetString(PyExc_ValueError, "Invalid address");
+	if (! ok) {
 		return ret;
 	}
 
-	if (setsockopt(fd, SOL_SCTP, SCTP_SET_PEER_PRIMARY_ADDR, &ssp, sizeof(ssp))) {
+#ifdef SCTP_DEFAULT_PRINFO
+	struct sctp_default_prinfo v;
+	socklen_t lv = sizeof(v);
+
+	bzero(&v, sizeof(v));
+	v.pr_assoc_id = Py23_PyLong_AsLong(oassoc_id);
+
+	if (getsockopt(fd, SOL_SCTP, SCTP_DEFAULT_PRINFO, &v, &lv)) {
 		PyErr_SetFromErrno(PyExc_IOError);
 	} else {
+		PyDict_SetItemString(dict, "policy", Py23_PyLong_FromLong(v.pr_policy));
+		PyDict_SetItemString(dict, "value", PyLong_FromUnsignedLong(v.pr_value));
 		ret = Py_None; Py_INCREF(ret);
 	}
-
+#else
+	errno = ENOPROTOOPT;
+	PyErr_SetFromErrno(PyExc_IOError);
+#endif
 	return ret;
 }
 
-static PyObject* set_primary(PyObject* dummy, PyObject* args)
+static PyObject* set_default_prinfo(PyObject* dummy, PyObject* args)
 {
 	PyObject* ret = 0;
+	PyObject* dict;
+	PyObject* oassoc_id;
+	PyObject* opolicy;
+	PyObject* ovalue;
 	int fd;
-	int l;
-	int assoc_id;
-	char* addr;
-	struct sctp_prim ssp;
-	int port;
+	int ok;
 
-	if (! PyArg_ParseTuple(args, "ii(si)", &fd, &assoc_id, &addr, &port)) {
+	ok = PyArg_ParseTuple(args, "iO", &fd, &dict) && PyDict_Check(dict);
+	ok = ok && (oassoc_id = PyDict_GetItemString(dict, "assoc_id"));
+	ok = ok && (opolicy = PyDict_GetItemString(dict, "policy"));
+	ok = ok && (ovalue = PyDict_GetItemString(dict, "value"));
+	ok = ok && Py23_PyLong_Check(oassoc_id);
+	ok = ok && Py23_PyLong_Check(opolicy);
+	ok = ok && (Py23_PyLong_Check(ovalue) || PyLong_Check(ovalue));
+
+	if (! ok) {
 		return ret;
 	}
 
-	bzero(&ssp, sizeof(ssp));
-	ssp.ssp_assoc_id = assoc_id;
-	if (! to_sockaddr(addr, port, (struct sockaddr*) &(ssp.ssp_addr), &l)) {
-		PyErr_SetString(PyExc_ValueError, "Invalid address");
+#ifdef SCTP_DEFAULT_PRINFO
+	struct sctp_default_prinfo v;
+
+	bzero(&v, sizeof(v));
+	v.pr_assoc_id = Py23_PyLong_AsLong(oassoc_id);
+	v.pr_policy = Py23_PyLong_AsLong(opolicy);
+	v.pr_value = PyLong_AsUnsignedLongMask(ovalue);
+
+	if (setsockopt_assoc(fd, SCTP_DEFAULT_PRINFO, &v, sizeof(v), &(v.pr_assoc_id))) {
+		PyErr_SetFromErrno(PyExc_IOError);
+	} else {
+		ret = Py_None; Py_INCREF(ret);
+	}
+#else
+	errno = ENOPROTOOPT;
+	PyErr_SetFromErrno(PyExc_IOError);
+#endif
+	return ret;
+}
+
+#ifdef SCTP_PR_ASSOC_STATUS
+static PyObject* get_prstatus(PyObject* args, int optname)
+{
+	PyObject* ret = 0;
+	PyObject* dict;
+	PyObject* oassoc_id;
+	PyObject* osid;
+	PyObject* opolicy;
+	int fd;
+	struct sctp_prstatus v;
+	socklen_t lv = sizeof(v);
+	int ok;
+
+	ok = PyArg_ParseTuple(args, "iO", &fd, &dict) && PyDict_Check(dict);
+	ok = ok && (oassoc_id = PyDict_GetItemString(dict, "assoc_id"));
+	ok = ok && (osid = PyDict_GetItemString(dict, "sid"));
+	ok = ok && (opolicy = PyDict_GetItemString(dict, "policy"));
+	ok = ok && Py23_PyLong_Check(oassoc_id);
+	ok = ok && Py23_PyLong_Check(osid);
+	ok = ok && Py23_PyLong_Check(opolicy);
+
+	if (! ok) {
 		return ret;
 	}
 
-	if (setsockopt(fd, SOL_SCTP, SCTP_PRIMARY_ADDR, &ssp, sizeof(ssp))) {
+	bzero(&v, sizeof(v));
+	v.sprstat_assoc_id = Py23_PyLong_AsLong(oassoc_id);
+	v.sprstat_sid = Py23_PyLong_AsLong(osid);
+	v.sprstat_policy = Py23_PyLong_AsLong(opolicy);
+
+	if (getsockopt(fd, SOL_SCTP, optname, &v, &lv)) {
 		PyErr_SetFromErrno(PyExc_IOError);
 	} else {
+		PyDict_SetItemString(dict, "abandoned_unsent", PyLong_FromUnsignedLongLong(v.sprstat_abandoned_unsent));
+		PyDict_SetItemString(dict, "abandoned_sent", PyLong_FromUnsignedLongLong(v.sprstat_abandoned_sent));
 		ret = Py_None; Py_INCREF(ret);
 	}
 
 	return ret;
 }
+#endif
 
-static PyObject* bindx(PyObject* dummy, PyObject* args)
+static PyObject* get_pr_assoc_status(PyObject* dummy, PyObject* args)
+{
+#ifdef SCTP_PR_ASSOC_STATUS
+	return get_prstatus(args, SCTP_PR_ASSOC_STATUS);
+#else
+	errno = ENOPROTOOPT;
+	PyErr_SetFromErrno(PyExc_IOError);
+	return 0;
+#endif
+}
+
+static PyObject* get_pr_stream_status(PyObject* dummy, PyObject* args)
+{
+#ifdef SCTP_PR_STREAM_STATUS
+	return get_prstatus(args, SCTP_PR_STREAM_STATUS);
+#else
+	errno = ENOPROTOOPT;
+	PyErr_SetFromErrno(PyExc_IOError);
+	return 0;
+#endif
+}
+
+static PyObject* get_reconfig_supported(PyObject* dummy, PyObject* args)
 {
 	PyObject* ret = 0;
-	int fd;
-	PyObject* addrs;
-	struct sockaddr saddr;
-	struct sockaddr* saddrs;
-	int saddr_len, saddrs_len;
-	int addrcount;
-	int flags;
-	int x;
+	int fd, assoc_id;
 
-	if (! PyArg_ParseTuple(args, "iOi", &fd, &addrs, &flags)) {
+	if (! PyArg_ParseTuple(args, "ii", &fd, &assoc_id)) {
 		return ret;
 	}
 
-	if (! PySequence_Check(addrs)) {
-		PyErr_SetString(PyExc_ValueError, "Second parameter must be a sequence of address/port tuples");
-		return ret;
+#ifdef SCTP_RECONFIG_SUPPORTED
+	struct sctp_assoc_value v;
+	socklen_t lv = sizeof(v);
+
+	bzero(&v, sizeof(v));
+	v.assoc_id = assoc_id;
+
+	if (getsockopt(fd, SOL_SCTP, SCTP_RECONFIG_SUPPORTED, &v, &lv)) {
+		PyErr_SetFromErrno(PyExc_IOError);
+	} else {
+		ret = PyBool_FromLong(v.assoc_value);
 	}
+#else
+	errno = ENOPROTOOPT;
+	PyErr_SetFromErrno(PyExc_IOError);
+#endif
+	return ret;
+}
 
-	addrcount = PySequence_Length(addrs);
-	if (addrcount <= 0) {
-		PyErr_SetString(PyExc_ValueError, "Second parameter must be a non-empty sequence");
+static PyObject* set_reconfig_supported(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	int fd, assoc_id, value;
+
+	if (! PyArg_ParseTuple(args, "iii", &fd, &assoc_id, &value)) {
 		return ret;
 	}
 
-	saddrs_len = 0;
-	saddrs = (struct sockaddr*) malloc(saddrs_len);
+#ifdef SCTP_RECONFIG_SUPPORTED
+	struct sctp_assoc_value v;
 
-	for(x = 0; x < addrcount; ++x) {
-		const char* caddr;
-		int iport;
+	bzero(&v, sizeof(v));
+	v.assoc_id = assoc_id;
+	v.assoc_value = value;
 
-		PyObject* otuple = PySequence_GetItem(addrs, x);
+	if (setsockopt_assoc(fd, SCTP_RECONFIG_SUPPORTED, &v, sizeof(v), &(v.assoc_id))) {
+		PyErr_SetFromErrno(PyExc_IOError);
+	} else {
+		ret = Py_None; Py_INCREF(ret);
+	}
+#else
+	errno = ENOPROTOOPT;
+	PyErr_SetFromErrno(PyExc_IOError);
+#endif
+	return ret;
+}
 
-		if (! PyArg_ParseTuple(otuple, "si", &caddr, &iport)) {
-			free(saddrs);
-			return ret;
-		}
-		
-		if (! to_sockaddr(caddr, iport, &saddr, &saddr_len)) {
-			PyErr_Format(PyExc_ValueError, "Invalid address: %s", caddr);
-			free(saddrs);
-			return ret;
-		}
+static PyObject* get_enable_stream_reset(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	int fd, assoc_id;
 
-		if (saddr_len == 0) {
-			PyErr_Format(PyExc_ValueError, "Invalid address family: %s", caddr);
-			free(saddrs);
-			return ret;
-		}
+	if (! PyArg_ParseTuple(args, "ii", &fd, &assoc_id)) {
+		return ret;
+	}
 
-		saddrs = realloc(saddrs, saddrs_len + saddr_len);
-		memcpy( ((char*) saddrs) + saddrs_len, &saddr, saddr_len);
-		saddrs_len += saddr_len;
-		
-#ifdef DEBUG
-        printf("[DEBUG bindx] x: %d, caddr: %s, iport: %d, saddrs_len: %d\n",
-               x, caddr, iport, saddrs_len);
+#ifdef SCTP_ENABLE_STREAM_RESET
+	struct sctp_assoc_value v;
+	socklen_t lv = sizeof(v);
+
+	bzero(&v, sizeof(v));
+	v.assoc_id = assoc_id;
+
+	if (getsockopt(fd, SOL_SCTP, SCTP_ENABLE_STREAM_RESET, &v, &lv)) {
+		PyErr_SetFromErrno(PyExc_IOError);
+	} else {
+		ret = Py23_PyLong_FromLong(v.assoc_value);
+	}
+#else
+	errno = ENOPROTOOPT;
+	PyErr_SetFromErrno(PyExc_IOError);
 #endif
+	return ret;
+}
+
+static PyObject* set_enable_stream_reset(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	int fd, assoc_id, value;
 
+	if (! PyArg_ParseTuple(args, "iii", &fd, &assoc_id, &value)) {
+		return ret;
 	}
 
-	if (sctp_bindx(fd, saddrs, addrcount, flags)) {
+#ifdef SCTP_ENABLE_STREAM_RESET
+	struct sctp_assoc_value v;
+
+	bzero(&v, sizeof(v));
+	v.assoc_id = assoc_id;
+	v.assoc_value = value;
+
+	if (setsockopt_assoc(fd, SCTP_ENABLE_STREAM_RESET, &v, sizeof(v), &(v.assoc_id))) {
 		PyErr_SetFromErrno(PyExc_IOError);
 	} else {
 		ret = Py_None; Py_INCREF(ret);
 	}
-
-	free(saddrs);
+#else
+	errno = ENOPROTOOPT;
+	PyErr_SetFromErrno(PyExc_IOError);
+#endif
 	return ret;
 }
 
-static PyObject* connectx(PyObject* dummy, PyObject* args)
+static PyObject* reset_streams(PyObject* dummy, PyObject* args)
 {
 	PyObject* ret = 0;
-	PyObject* dict;
-	int fd;
-	PyObject* addrs;
-	struct sockaddr saddr;
-	struct sockaddr* saddrs;
-	sctp_assoc_t id;
-	int saddr_len, saddrs_len;
-	int addrcount;
-	int x;
+	PyObject* streams;
+	int fd, assoc_id, flags;
 
-	if (! PyArg_ParseTuple(args, "iOO", &fd, &addrs, &dict)) {
+	if (! PyArg_ParseTuple(args, "iiiO", &fd, &assoc_id, &flags, &streams)) {
 		return ret;
 	}
 
-	if (! PySequence_Check(addrs)) {
-		PyErr_SetString(PyExc_ValueError, "Second parameter must be a sequence of address/port tuples");
+	if (! PySequence_Check(streams)) {
+		PyErr_SetString(PyExc_ValueError, "Fourth parameter must be a sequence of stream numbers");
 		return ret;
 	}
 
-	addrcount = PySequence_Length(addrs);
-	if (addrcount <= 0) {
-		PyErr_SetString(PyExc_ValueError, "Second parameter must be a non-empty sequence");
+#ifdef SCTP_RESET_STREAMS
+	struct sctp_reset_streams* v;
+	Py_ssize_t count = PySequence_Length(streams);
+	size_t lv;
+	Py_ssize_t x;
+
+	if (count < 0 || count > 65535) {
+		PyErr_SetString(PyExc_ValueError, "Too many streams");
 		return ret;
 	}
 
-	saddrs_len = 0;
-	saddrs = (struct sockaddr*) malloc(saddrs_len);
+	lv = sizeof(*v) + count * sizeof(uint16_t);
+	v = (struct sctp_reset_streams*) malloc(lv);
+	if (! v) {
+		PyErr_SetString(PyExc_MemoryError, "Out of memory, malloc() failed");
+		return ret;
+	}
 
-	for(x = 0; x < addrcount; ++x) {
-		const char* caddr;
-		int iport;
+	bzero(v, lv);
+	v->srs_assoc_id = assoc_id;
+	v->srs_flags = flags;
+	v->srs_number_streams = count;
 
-		PyObject* otuple = PySequence_GetItem(addrs, x);
+	for(x = 0; x < count; ++x) {
+		PyObject* ostream = PySequence_GetItem(streams, x);
+		long stream = -1;
 
-		if (! PyArg_ParseTuple(otuple, "si", &caddr, &iport)) {
-			free(saddrs);
-			return ret;
-		}
-		
-		if (! to_sockaddr(caddr, iport, &saddr, &saddr_len)) {
-			PyErr_Format(PyExc_ValueError, "Invalid address: %s", caddr);
-			free(saddrs);
-			return ret;
+		if (ostream) {
+			stream = Py23_PyLong_AsLong(ostream);
+			Py_DECREF(ostream);
 		}
 
-		if (saddr_len == 0) {
-			PyErr_Format(PyExc_ValueError, "Invalid address family: %s", caddr);
-			free(saddrs);
+		if (stream < 0 || stream > 65535) {
+			if (! PyErr_Occurred()) {
+				PyErr_Format(PyExc_ValueError, "Invalid stream number: %ld", stream);
+			}
+			free(v);
 			return ret;
 		}
 
-		saddrs = realloc(saddrs, saddrs_len + saddr_len);
-		memcpy( ((char*) saddrs) + saddrs_len, &saddr, saddr_len);
-		saddrs_len += saddr_len;
+		v->srs_stream_list[x] = stream;
 	}
 
-	if (sctp_connectx(fd, saddrs, addrcount, &id)) {
+	if (setsockopt(fd, SOL_SCTP, SCTP_RESET_STREAMS, v, lv)) {
 		PyErr_SetFromErrno(PyExc_IOError);
 	} else {
-		if(PyDict_Check(dict)) PyDict_SetItemString(dict, "assoc_id", Py23_PyLong_FromLong(id));
 		ret = Py_None; Py_INCREF(ret);
 	}
 
-	free(saddrs);
+	free(v);
+#else
+	errno = ENOPROTOOPT;
+	PyErr_SetFromErrno(PyExc_IOError);
+#endif
 	return ret;
 }
 
-static PyObject* getpaddrs(PyObject* dummy, PyObject* args)
+static PyObject* reset_assoc(PyObject* dummy, PyObject* args)
 {
 	PyObject* ret = 0;
-	int fd;
-	int assoc_id;
-	struct sockaddr* saddrs;
-	int count;
-	int x;
-	char addr[256];
+	int fd, assoc_id;
 
 	if (! PyArg_ParseTuple(args, "ii", &fd, &assoc_id)) {
 		return ret;
 	}
 
-	count = sctp_getpaddrs(fd, assoc_id, &saddrs);
+#ifdef SCTP_RESET_ASSOC
+	sctp_assoc_t v = assoc_id;
 
-	if (count < 0) {
+	if (setsockopt(fd, SOL_SCTP, SCTP_RESET_ASSOC, &v, sizeof(v))) {
 		PyErr_SetFromErrno(PyExc_IOError);
 	} else {
-		if (count == 0) {
-			saddrs = 0;
-		}
-		
-		ret = PyTuple_New(count);
-		char *p = (char*) saddrs;
+		ret = Py_None; Py_INCREF(ret);
+	}
+#else
+	errno = ENOPROTOOPT;
+	PyErr_SetFromErrno(PyExc_IOError);
+#endif
+	return ret;
+}
 
-		for(x = 0; x < count; ++x) {
-			int len;
-			int family;
-			int port;
-			PyObject* oaddr;
+static PyObject* add_streams(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	int fd, assoc_id, instrms, outstrms;
 
-			if (from_sockaddr((struct sockaddr*) p, &family, &len, &port, 
-										addr, sizeof(addr))) {
-				oaddr = PyTuple_New(2);
-				PyTuple_SetItem(oaddr, 0, PyUnicode_FromString(addr));
-				PyTuple_SetItem(oaddr, 1, Py23_PyLong_FromLong(port));
-				PyTuple_SetItem(ret, x, oaddr);
-			} else {
-				// something's wrong; not safe to continue
-				break;
-			}
-			
-			p += len;
-		}
+	if (! PyArg_ParseTuple(args, "iiii", &fd, &assoc_id, &instrms, &outstrms)) {
+		return ret;
+	}
 
-		sctp_freepaddrs(saddrs);
+#ifdef SCTP_ADD_STREAMS
+	struct sctp_add_streams v;
 
-		// If something went wrong, the remaining expected addresses will be set to None.
-		for(; x < count; ++x) {
-			PyTuple_SetItem(ret, x, Py_None);
-			Py_INCREF(Py_None);
+	bzero(&v, sizeof(v));
+	v.sas_assoc_id = assoc_id;
+	v.sas_instrms = instrms;
+	v.sas_outstrms = outstrms;
 
-		}
+	if (setsockopt(fd, SOL_SCTP, SCTP_ADD_STREAMS, &v, sizeof(v))) {
+		PyErr_SetFromErrno(PyExc_IOError);
+	} else {
+		ret = Py_None; Py_INCREF(ret);
 	}
-
+#else
+	errno = ENOPROTOOPT;
+	PyErr_SetFromErrno(PyExc_IOError);
+#endif
 	return ret;
 }
 
-static PyObject* getladdrs(PyObject* dummy, PyObject* args)
+/* Association statistics snapshot, a compact read-only record */
+
+static PyStructSequence_Field assoc_stats_fields[] = {
+	{"assoc_id", "association the counters refer to"},
+	{"timestamp", "CLOCK_MONOTONIC seconds of the snapshot (elapsed seconds in a delta)"},
+	{"obs_rto_sockaddr", "peer address of the maximum observed RTO"},
+	{"maxrto", "maximum observed RTO since the last call, in milisseconds"},
+	{"isacks", "SACKs received"},
+	{"osacks", "SACKs sent"},
+	{"opackets", "packets sent"},
+	{"ipackets", "packets received"},
+	{"rtxchunks", "retransmitted chunks"},
+	{"outofseqtsns", "TSNs received beyond the next expected"},
+	{"idupchunks", "duplicated chunks received"},
+	{"gapcnt", "gap acknowledgements received"},
+	{"ouodchunks", "unordered data chunks sent"},
+	{"iuodchunks", "unordered data chunks received"},
+	{"oodchunks", "ordered data chunks sent"},
+	{"iodchunks", "ordered data chunks received"},
+	{"octrlchunks", "control chunks sent"},
+	{"ictrlchunks", "control chunks received"},
+	{0}
+};
+
+/* fields from this index on are counters */
+#define ASSOC_STATS_FIRST_COUNTER 4
+#define ASSOC_STATS_NFIELDS ((int) (sizeof(assoc_stats_fields) / sizeof(assoc_stats_fields[0])) - 1)
+
+static PyStructSequence_Desc assoc_stats_desc = {
+	"_sctp.assoc_stats",
+	"SCTP association statistics snapshot (SCTP_GET_ASSOC_STATS)",
+	assoc_stats_fields,
+	ASSOC_STATS_NFIELDS
+};
+
+static PyTypeObject AssocStatsType;
+
+static double monotonic_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static PyObject* get_assoc_stats(PyObject* dummy, PyObject* args)
 {
 	PyObject* ret = 0;
-	int fd;
-	int assoc_id;
-	struct sockaddr* saddrs;
-	int count;
-	int x;
-	char addr[256];
+	int fd, assoc_id;
 
 	if (! PyArg_ParseTuple(args, "ii", &fd, &assoc_id)) {
 		return ret;
 	}
 
-	count = sctp_getladdrs(fd, assoc_id, &saddrs);
+#ifdef SCTP_GET_ASSOC_STATS
+	struct sctp_assoc_stats v;
+	socklen_t lv = sizeof(v);
+	PyObject* oaddr;
+	char caddr[256];
+	int family, len, port;
+	int x = 0;
 
-	if (count < 0) {
+	bzero(&v, sizeof(v));
+	v.sas_assoc_id = assoc_id;
+
+	if (getsockopt(fd, SOL_SCTP, SCTP_GET_ASSOC_STATS, &v, &lv)) {
 		PyErr_SetFromErrno(PyExc_IOError);
+		return ret;
+	}
+
+	if (from_sockaddr((struct sockaddr*) &(v.sas_obs_rto_ipaddr), &family, 
+				&len, &port, caddr, sizeof(caddr))) {
+		oaddr = PyTuple_New(2);
+		PyTuple_SetItem(oaddr, 0, PyUnicode_FromString(caddr));
+		PyTuple_SetItem(oaddr, 1, Py23_PyLong_FromLong(port));
 	} else {
-		if (count == 0) {
-			saddrs = 0;
-		}
-		
-		ret = PyTuple_New(count);
-		char *p = (char*) saddrs;
-	
-		for(x = 0; x < count; ++x) {
-			int len;
-			int family;
-			int port;
-			PyObject* oaddr;
+		// no RTO observed in this period
+		oaddr = Py_None;
+		Py_INCREF(Py_None);
+	}
 
-			if (from_sockaddr((struct sockaddr*) p, &family, &len, &port, 
-										addr, sizeof(addr))) {
-				oaddr = PyTuple_New(2);
-				PyTuple_SetItem(oaddr, 0, PyUnicode_FromString(addr));
-				PyTuple_SetItem(oaddr, 1, Py23_PyLong_FromLong(port));
-				PyTuple_SetItem(ret, x, oaddr);
-			} else {
-				// something's wrong; not safe to continue
-				break;
-			}
-			
-			p += len;
-		}
+	ret = PyStructSequence_New(&AssocStatsType);
+	if (! ret) {
+		Py_DECREF(oaddr);
+		return ret;
+	}
 
-		sctp_freeladdrs(saddrs);
+	PyStructSequence_SET_ITEM(ret, x++, Py23_PyLong_FromLong(v.sas_assoc_id));
+	PyStructSequence_SET_ITEM(ret, x++, PyFloat_FromDouble(monotonic_now()));
+	PyStructSequence_SET_ITEM(ret, x++, oaddr);
+	PyStructSequence_SET_ITEM(ret, x++, PyLong_FromUnsignedLongLong(v.sas_maxrto));
+	PyStructSequence_SET_ITEM(ret, x++, PyLong_FromUnsignedLongLong(v.sas_isacks));
+	PyStructSequence_SET_ITEM(ret, x++, PyLong_FromUnsignedLongLong(v.sas_osacks));
+	PyStructSequence_SET_ITEM(ret, x++, PyLong_FromUnsignedLongLong(v.sas_opackets));
+	PyStructSequence_SET_ITEM(ret, x++, PyLong_FromUnsignedLongLong(v.sas_ipackets));
+	PyStructSequence_SET_ITEM(ret, x++, PyLong_FromUnsignedLongLong(v.sas_rtxchunks));
+	PyStructSequence_SET_ITEM(ret, x++, PyLong_FromUnsignedLongLong(v.sas_outofseqtsns));
+	PyStructSequence_SET_ITEM(ret, x++, PyLong_FromUnsignedLongLong(v.sas_idupchunks));
+	PyStructSequence_SET_ITEM(ret, x++, PyLong_FromUnsignedLongLong(v.sas_gapcnt));
+	PyStructSequence_SET_ITEM(ret, x++, PyLong_FromUnsignedLongLong(v.sas_ouodchunks));
+	PyStructSequence_SET_ITEM(ret, x++, PyLong_FromUnsignedLongLong(v.sas_iuodchunks));
+	PyStructSequence_SET_ITEM(ret, x++, PyLong_FromUnsignedLongLong(v.sas_oodchunks));
+	PyStructSequence_SET_ITEM(ret, x++, PyLong_FromUnsignedLongLong(v.sas_iodchunks));
+	PyStructSequence_SET_ITEM(ret, x++, PyLong_FromUnsignedLongLong(v.sas_octrlchunks));
+	PyStructSequence_SET_ITEM(ret, x++, PyLong_FromUnsignedLongLong(v.sas_ictrlchunks));
+#else
+	errno = ENOPROTOOPT;
+	PyErr_SetFromErrno(PyExc_IOError);
+#endif
+	return ret;
+}
 
-		// If something went wrong, the remaining expected addresses will be set to None.
-		for(; x < count; ++x) {
-			PyTuple_SetItem(ret, x, Py_None);
-			Py_INCREF(Py_None);
+static PyObject* assoc_stats_delta(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	PyObject* onew;
+	PyObject* oold;
+	PyObject* item;
+	int x;
+
+	if (! PyArg_ParseTuple(args, "O!O!", &AssocStatsType, &onew, &AssocStatsType, &oold)) {
+		return ret;
+	}
+
+	ret = PyStructSequence_New(&AssocStatsType);
+	if (! ret) {
+		return ret;
+	}
+
+	for(x = 0; x < ASSOC_STATS_NFIELDS; ++x) {
+		if (x == 1 || x >= ASSOC_STATS_FIRST_COUNTER) {
+			item = PyNumber_Subtract(PyStructSequence_GET_ITEM(onew, x), 
+						PyStructSequence_GET_ITEM(oold, x));
+			if (! item) {
+				Py_DECREF(ret);
+				return 0;
+			}
+		} else {
+			// assoc_id and the observed maximum RTO are not cumulative
+			item = PyStructSequence_GET_ITEM(onew, x);
+			Py_INCREF(item);
+		}
+		PyStructSequence_SET_ITEM(ret, x, item);
+	}
+
+	return ret;
+}
+
+/* Fetches the list of association IDs of an one-to-many socket. Returns
+ * the count, or -1 with errno set. Does not touch Python objects, so it
+ * can be called with the GIL released. *ids must be freed by the caller. */
+static int get_assoc_id_list(int fd, sctp_assoc_t** ids)
+{
+	*ids = 0;
+
+#ifdef SCTP_GET_ASSOC_ID_LIST
+	struct sctp_assoc_ids* v = 0;
+	uint32_t number;
+	socklen_t lv = sizeof(number);
+	int attempt;
+
+	if (getsockopt(fd, SOL_SCTP, SCTP_GET_ASSOC_NUMBER, &number, &lv)) {
+		return -1;
+	}
+
+	// associations may come up between the two calls; leave some room
+	for(attempt = 0; attempt < 8; ++attempt) {
+		number += 16 + number / 8;
+		lv = sizeof(struct sctp_assoc_ids) + number * sizeof(sctp_assoc_t);
+		v = (struct sctp_assoc_ids*) malloc(lv);
+		if (! v) {
+			errno = ENOMEM;
+			return -1;
+		}
+		if (getsockopt(fd, SOL_SCTP, SCTP_GET_ASSOC_ID_LIST, v, &lv) == 0) {
+			break;
+		}
+		free(v);
+		v = 0;
+		if (errno != EINVAL) {
+			return -1;
+		}
+	}
+
+	if (! v) {
+		return -1;
+	}
+
+	number = v->gaids_number_of_ids;
+	*ids = (sctp_assoc_t*) malloc((number ? number : 1) * sizeof(sctp_assoc_t));
+	if (! *ids) {
+		free(v);
+		errno = ENOMEM;
+		return -1;
+	}
+	memcpy(*ids, v->gaids_assoc_id, number * sizeof(sctp_assoc_t));
+	free(v);
+
+	return number;
+#else
+	errno = ENOPROTOOPT;
+	return -1;
+#endif
+}
+
+/* After a per-association setsockopt() failed, tells whether it was because
+   the association has gone meanwhile */
+static int assoc_gone(int fd, sctp_assoc_t id)
+{
+	struct sctp_status v;
+	socklen_t lv = sizeof(v);
+
+	bzero(&v, sizeof(v));
+	v.sstat_assoc_id = id;
+	return getsockopt(fd, SOL_SCTP, SCTP_STATUS, &v, &lv) && errno == EINVAL;
+}
+
+/* Tells whether the kernel reserves SCTP_CURRENT_ASSOC and SCTP_ALL_ASSOC,
+ * whatever the headers say: a UDP-style socket without associations takes
+ * SCTP_CURRENT_ASSOC for its default send parameters only if it does. The
+ * exported constants follow. Without SCTP support, the emulated values
+ * stay; they are harmless.
+ */
+static void probe_special_assoc(void)
+{
+	struct sctp_sndrcvinfo v;
+	struct ktuple* k;
+	int fd = socket(AF_INET, SOCK_SEQPACKET, IPPROTO_SCTP);
+
+	if (fd < 0) {
+		fd = socket(AF_INET6, SOCK_SEQPACKET, IPPROTO_SCTP);
+	}
+	if (fd >= 0) {
+		bzero(&v, sizeof(v));
+		v.sinfo_assoc_id = SCTP_CURRENT_ASSOC;
+		if (setsockopt(fd, SOL_SCTP, SCTP_DEFAULT_SEND_PARAM, &v, sizeof(v)) == 0) {
+			current_assoc = SCTP_CURRENT_ASSOC;
+			all_assoc = SCTP_ALL_ASSOC;
+		}
+		close(fd);
+	}
+
+	for(k = &(_constants[0]); k->key; ++k) {
+		if (strcmp(k->key, "SCTP_CURRENT_ASSOC") == 0) {
+			k->value = current_assoc;
+		} else if (strcmp(k->key, "SCTP_ALL_ASSOC") == 0) {
+			k->value = all_assoc;
+		}
+	}
+}
+
+/* setsockopt() of an option whose struct carries an assoc_id, at *pid.
+ * Every other id goes to the kernel as is, so on kernels that do not
+ * reserve 1 and 2 they name a single association. CURRENT_ASSOC and
+ * ALL_ASSOC (current_assoc and all_assoc) go to the kernel first where it
+ * reserves them. If it does not, or takes only SCTP_FUTURE_ASSOC for this
+ * option (EINVAL), the value is set here on the socket defaults (ALL only)
+ * and on every open association, skipping the ones that close meanwhile;
+ * an error there, EINVAL included, is the value's and is returned. *pid is
+ * restored. Must be called with the GIL held; releases it while iterating.
+ */
+static int setsockopt_assoc(int fd, int opt, void* v, socklen_t lv, sctp_assoc_t* pid)
+{
+	sctp_assoc_t id = *pid;
+	sctp_assoc_t* ids = 0;
+	int type = 0;
+	socklen_t ltype = sizeof(type);
+	int count = 0;
+	int err = 0;
+	int x;
+
+	if (id != current_assoc && id != all_assoc) {
+		return setsockopt(fd, SOL_SCTP, opt, v, lv);
+	}
+
+	if (current_assoc == SCTP_CURRENT_ASSOC) {
+		if (setsockopt(fd, SOL_SCTP, opt, v, lv) == 0) {
+			return 0;
+		}
+		if (errno != EINVAL) {
+			return -1;
+		}
+	}
+
+	if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &ltype) == 0 && type == SOCK_STREAM) {
+		// TCP-style sockets hold a single association and ignore ids
+		*pid = 0;
+		x = setsockopt(fd, SOL_SCTP, opt, v, lv);
+		*pid = id;
+		return x;
+	}
+
+	Py_BEGIN_ALLOW_THREADS
+
+	if (id == all_assoc) {
+		*pid = SCTP_FUTURE_ASSOC;
+		if (setsockopt(fd, SOL_SCTP, opt, v, lv)) {
+			err = errno;
+		}
+	}
+
+	if (! err) {
+		count = get_assoc_id_list(fd, &ids);
+		if (count < 0) {
+			err = errno;
+		}
+	}
+
+	for(x = 0; ! err && x < count; ++x) {
+		*pid = ids[x];
+		if (setsockopt(fd, SOL_SCTP, opt, v, lv)) {
+			err = errno;
+			if ((err == EINVAL || err == ENOENT) && assoc_gone(fd, ids[x])) {
+				err = 0;
+			}
+		}
+	}
+
+	free(ids);
+
+	Py_END_ALLOW_THREADS
+
+	*pid = id;
+	if (err) {
+		errno = err;
+		return -1;
+	}
+	return 0;
+}
+
+static int same_sockaddr(const struct sockaddr* a, const struct sockaddr* b)
+{
+	if (a->sa_family != b->sa_family) {
+		return 0;
+	}
+	if (a->sa_family == AF_INET) {
+		const struct sockaddr_in* a4 = (const struct sockaddr_in*) a;
+		const struct sockaddr_in* b4 = (const struct sockaddr_in*) b;
+		return a4->sin_port == b4->sin_port && a4->sin_addr.s_addr == b4->sin_addr.s_addr;
+	} else if (a->sa_family == AF_INET6) {
+		const struct sockaddr_in6* a6 = (const struct sockaddr_in6*) a;
+		const struct sockaddr_in6* b6 = (const struct sockaddr_in6*) b;
+		return a6->sin6_port == b6->sin6_port && 
+			memcmp(&(a6->sin6_addr), &(b6->sin6_addr), sizeof(a6->sin6_addr)) == 0;
+	}
+	return 0;
+}
+
+/* Bulk status: one row per association, one row per peer address */
+
+struct status_row {
+	int32_t assoc_id;
+	int32_t state;
+	uint32_t rwnd;
+	uint32_t unackdata;
+	uint32_t penddata;
+	uint32_t instrms;
+	uint32_t outstrms;
+	uint32_t fragmentation_point;
+	int32_t primary_state;
+	uint32_t cwnd;
+	uint32_t srtt;
+	uint32_t rto;
+	uint32_t mtu;
+};
+
+struct path_row {
+	int32_t assoc_id;
+	int32_t state;
+	uint32_t cwnd;
+	uint32_t srtt;
+	uint32_t rto;
+	uint32_t mtu;
+	uint32_t primary;
+	struct sockaddr_storage addr;
+};
+
+static const char* status_columns[] = {
+	"assoc_id", "state", "rwnd", "unackdata", "penddata", "instrms", "outstrms",
+	"fragmentation_point", "primary_state", "cwnd", "srtt", "rto", "mtu", 0
+};
+
+static const char* path_columns[] = {
+	"path_assoc_id", "path_state", "path_cwnd", "path_srtt", "path_rto", "path_mtu",
+	"path_primary", 0
+};
+
+/* Sets dict[name] = bytes with the 32-bit column "col" of "count" rows */
+static int set_column(PyObject* dict, const char* name, const char* rows, size_t row_size, 
+			int count, int col)
+{
+	PyObject* obytes = PyBytes_FromStringAndSize(0, count * sizeof(uint32_t));
+	uint32_t* p;
+	int x;
+
+	if (! obytes) {
+		return 0;
+	}
+
+	p = (uint32_t*) PyBytes_AS_STRING(obytes);
+	for(x = 0; x < count; ++x) {
+		p[x] = ((const uint32_t*) (rows + x * row_size))[col];
+	}
+
+	PyDict_SetItemString(dict, name, obytes);
+	Py_DECREF(obytes);
+	return 1;
+}
+
+static PyObject* get_status_all(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	PyObject* oids;
+	PyObject* oaddrs;
+	int fd;
+	int with_paths;
+	sctp_assoc_t* ids = 0;
+	int count = 0;
+	struct status_row* rows = 0;
+	int nrows = 0;
+	struct path_row* paths = 0;
+	int npaths = 0;
+	int paths_alloc = 0;
+	int err = 0;
+	int x, y;
+
+	if (! PyArg_ParseTuple(args, "iOi", &fd, &oids, &with_paths)) {
+		return ret;
+	}
+
+	if (oids != Py_None) {
+		if (! PySequence_Check(oids)) {
+			PyErr_SetString(PyExc_ValueError, "Second parameter must be None or a sequence of assoc_ids");
+			return ret;
+		}
+		count = PySequence_Length(oids);
+		ids = (sctp_assoc_t*) malloc((count > 0 ? count : 1) * sizeof(sctp_assoc_t));
+		if (! ids) {
+			PyErr_SetString(PyExc_MemoryError, "Out of memory, malloc() failed");
+			return ret;
+		}
+		for(x = 0; x < count; ++x) {
+			PyObject* oid = PySequence_GetItem(oids, x);
+			if (! oid) {
+				free(ids);
+				return ret;
+			}
+			ids[x] = Py23_PyLong_AsLong(oid);
+			Py_DECREF(oid);
+		}
+		if (PyErr_Occurred()) {
+			free(ids);
+			return ret;
+		}
+	}
+
+	Py_BEGIN_ALLOW_THREADS
+
+	if (! ids) {
+		count = get_assoc_id_list(fd, &ids);
+		if (count < 0) {
+			err = errno;
+		}
+	}
+
+	if (! err) {
+		rows = (struct status_row*) malloc((count > 0 ? count : 1) * sizeof(struct status_row));
+		if (! rows) {
+			err = ENOMEM;
+		}
+	}
+
+	for(x = 0; ! err && x < count; ++x) {
+		struct sctp_status v;
+		socklen_t lv = sizeof(v);
+		struct status_row* r = &(rows[nrows]);
+
+		bzero(&v, sizeof(v));
+		v.sstat_assoc_id = ids[x];
+
+		if (getsockopt(fd, SOL_SCTP, SCTP_STATUS, &v, &lv)) {
+			if (oids == Py_None) {
+				// association went away in the meantime
+				continue;
+			}
+			// asked for by the caller (the association of a TCP-style socket)
+			err = errno;
+			break;
+		}
+
+		r->assoc_id = ids[x];
+		r->state = v.sstat_state;
+		r->rwnd = v.sstat_rwnd;
+		r->unackdata = v.sstat_unackdata;
+		r->penddata = v.sstat_penddata;
+		r->instrms = v.sstat_instrms;
+		r->outstrms = v.sstat_outstrms;
+		r->fragmentation_point = v.sstat_fragmentation_point;
+		r->primary_state = v.sstat_primary.spinfo_state;
+		r->cwnd = v.sstat_primary.spinfo_cwnd;
+		r->srtt = v.sstat_primary.spinfo_srtt;
+		r->rto = v.sstat_primary.spinfo_rto;
+		r->mtu = v.sstat_primary.spinfo_mtu;
+		++nrows;
+
+		if (with_paths) {
+			struct sockaddr* saddrs;
+			int naddrs = sctp_getpaddrs(fd, ids[x], &saddrs);
+			char* p = (char*) saddrs;
+
+			for(y = 0; y < naddrs; ++y) {
+				struct sctp_paddrinfo pv;
+				socklen_t lpv = sizeof(pv);
+				struct path_row* pr;
+				int len;
+
+				if (((struct sockaddr*) p)->sa_family == AF_INET) {
+					len = sizeof(struct sockaddr_in);
+				} else if (((struct sockaddr*) p)->sa_family == AF_INET6) {
+					len = sizeof(struct sockaddr_in6);
+				} else {
+					// not safe to continue
+					break;
+				}
+
+				if (npaths == paths_alloc) {
+					struct path_row* np;
+					paths_alloc = paths_alloc ? paths_alloc * 2 : 64;
+					np = (struct path_row*) realloc(paths, paths_alloc * sizeof(struct path_row));
+					if (! np) {
+						err = ENOMEM;
+						break;
+					}
+					paths = np;
+				}
+
+				bzero(&pv, sizeof(pv));
+				pv.spinfo_assoc_id = ids[x];
+				memcpy(&(pv.spinfo_address), p, len);
+				p += len;
+
+				if (getsockopt(fd, SOL_SCTP, SCTP_GET_PEER_ADDR_INFO, &pv, &lpv)) {
+					continue;
+				}
+
+				pr = &(paths[npaths++]);
+				bzero(&(pr->addr), sizeof(pr->addr));
+				memcpy(&(pr->addr), &(pv.spinfo_address), len);
+				pr->assoc_id = ids[x];
+				pr->state = pv.spinfo_state;
+				pr->cwnd = pv.spinfo_cwnd;
+				pr->srtt = pv.spinfo_srtt;
+				pr->rto = pv.spinfo_rto;
+				pr->mtu = pv.spinfo_mtu;
+				pr->primary = same_sockaddr((struct sockaddr*) &(pr->addr), 
+						(struct sockaddr*) &(v.sstat_primary.spinfo_address));
+			}
+
+			if (naddrs > 0) {
+				sctp_freepaddrs(saddrs);
+			}
+		}
+	}
+
+	Py_END_ALLOW_THREADS
+
+	free(ids);
+
+	if (err) {
+		free(rows);
+		free(paths);
+		errno = err;
+		PyErr_SetFromErrno(PyExc_IOError);
+		return ret;
+	}
+
+	ret = PyDict_New();
+	for(x = 0; ret && status_columns[x]; ++x) {
+		if (! set_column(ret, status_columns[x], (char*) rows, sizeof(struct status_row), nrows, x)) {
+			Py_CLEAR(ret);
+		}
+	}
+
+	if (ret && with_paths) {
+		for(x = 0; ret && path_columns[x]; ++x) {
+			if (! set_column(ret, path_columns[x], (char*) paths, sizeof(struct path_row), npaths, x)) {
+				Py_CLEAR(ret);
+			}
+		}
+
+		oaddrs = ret ? PyTuple_New(npaths) : 0;
+		for(x = 0; oaddrs && x < npaths; ++x) {
+			char caddr[256];
+			int family, len, port;
+			PyObject* oaddr;
+
+			if (from_sockaddr((struct sockaddr*) &(paths[x].addr), &family, &len, &port, 
+						caddr, sizeof(caddr))) {
+				oaddr = PyTuple_New(2);
+				PyTuple_SetItem(oaddr, 0, PyUnicode_FromString(caddr));
+				PyTuple_SetItem(oaddr, 1, Py23_PyLong_FromLong(port));
+			} else {
+				// something went wrong
+				oaddr = Py_None;
+				Py_INCREF(Py_None);
+			}
+			PyTuple_SetItem(oaddrs, x, oaddr);
+		}
+
+		if (oaddrs) {
+			PyDict_SetItemString(ret, "path_sockaddr", oaddrs);
+			Py_DECREF(oaddrs);
+		}
+	}
+
+	free(rows);
+	free(paths);
+	return ret;
+}
+
+/* /proc/net/sctp readers. The files are read in one go with the GIL
+ * released, and parsed in C: snmp into a name -> counter dictionary, the
+ * eps/assocs/remaddr tables into columns, see proc_read_table(). */
+
+#define PROC_MAX_COLUMNS 64
+
+/* Reads a whole (proc) file into a NUL-terminated malloc()ed buffer.
+ * Returns 0 and sets errno on error. */
+static char* read_whole_file(const char* path, size_t* size)
+{
+	size_t alloc = 65536;
+	size_t used = 0;
+	char* buf = 0;
+	int err = 0;
+	int fd;
+
+	Py_BEGIN_ALLOW_THREADS
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		err = errno;
+	} else {
+		buf = (char*) malloc(alloc);
+		while (buf) {
+			ssize_t n;
+			if (used + 1 >= alloc) {
+				char* nbuf = (char*) realloc(buf, alloc * 2);
+				if (! nbuf) {
+					free(buf);
+					buf = 0;
+					err = ENOMEM;
+					break;
+				}
+				buf = nbuf;
+				alloc *= 2;
+			}
+			n = read(fd, buf + used, alloc - used - 1);
+			if (n < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				err = errno;
+				free(buf);
+				buf = 0;
+				break;
+			} else if (n == 0) {
+				buf[used] = 0;
+				break;
+			}
+			used += n;
+		}
+		if (! buf && ! err) {
+			err = ENOMEM;
+		}
+		close(fd);
+	}
+
+	Py_END_ALLOW_THREADS
+
+	errno = err;
+	*size = used;
+	return buf;
+}
+
+/* Splits s in place into whitespace-separated tokens, up to the end of line. 
+ * Returns the number of tokens, *next points to the following line. */
+static int split_line(char* s, char*** tokens, int* alloc, char** next)
+{
+	int n = 0;
+
+	for (;;) {
+		while (*s == ' ' || *s == '\t' || *s == '\r') {
+			++s;
+		}
+		if (*s == 0 || *s == '\n') {
+			break;
+		}
+		if (n == *alloc) {
+			char** nt;
+			*alloc = *alloc ? *alloc * 2 : 64;
+			nt = (char**) realloc(*tokens, *alloc * sizeof(char*));
+			if (! nt) {
+				return -1;
+			}
+			*tokens = nt;
+		}
+		(*tokens)[n++] = s;
+		while (*s && *s != ' ' && *s != '\t' && *s != '\r' && *s != '\n') {
+			++s;
+		}
+		if (*s == '\n') {
+			*s++ = 0;
+			*next = s;
+			return n;
+		} else if (*s) {
+			*s++ = 0;
+		}
+	}
+
+	*next = (*s == '\n') ? s + 1 : s;
+	return n;
+}
+
+static PyObject* proc_read_snmp(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	PyObject* counters;
+	const char* path;
+	char* buf;
+	char* line;
+	char* next;
+	char** tokens = 0;
+	int talloc = 0;
+	size_t size;
+	double timestamp;
+
+	if (! PyArg_ParseTuple(args, "s", &path)) {
+		return ret;
+	}
+
+	buf = read_whole_file(path, &size);
+	timestamp = monotonic_now();
+	if (! buf) {
+		PyErr_SetFromErrnoWithFilename(PyExc_IOError, path);
+		return ret;
+	}
+
+	counters = PyDict_New();
+	for(line = buf; *line; line = next) {
+		int n = split_line(line, &tokens, &talloc, &next);
+		PyObject* o;
+		if (n < 0) {
+			break;
+		}
+		if (n != 2) {
+			continue;
+		}
+		o = PyLong_FromUnsignedLongLong(strtoull(tokens[1], 0, 10));
+		PyDict_SetItemString(counters, tokens[0], o);
+		Py_DECREF(o);
+	}
+
+	free(tokens);
+	free(buf);
+
+	ret = Py_BuildValue("(dN)", timestamp, counters);
+	return ret;
+}
+
+/* Parses a /proc/net/sctp table (eps, assocs, remaddr...) guided by its header,
+ * so it copes with the columns added along kernel versions. Returns a
+ * (timestamp, columns) tuple where columns is a dictionary indexed by header
+ * name. Numeric columns are bytes objects with native int64 values (the
+ * pointer columns ENDPT, ASSOC and SOCK are hexadecimal); ADDR is a list of
+ * strings; LADDRS and RADDRS are lists of tuples of address strings, and the
+ * extra PRIMARY column holds the RADDRS entry the kernel marks with "*". */
+static PyObject* proc_read_table(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	PyObject* columns;
+	const char* path;
+	char* buf;
+	char* line;
+	char* next;
+	char** tokens = 0;
+	int talloc = 0;
+	size_t size;
+	double timestamp;
+
+	char* names[PROC_MAX_COLUMNS];
+	int ncols = 0;
+	int is_hex[PROC_MAX_COLUMNS];
+	int is_str[PROC_MAX_COLUMNS];
+	int64_t* values[PROC_MAX_COLUMNS];
+	PyObject* lists[PROC_MAX_COLUMNS];
+	PyObject* primary = 0;
+	int laddrs = -1;
+	int raddrs = -1;
+	int n_pre, n_suf;
+	int rows = 0;
+	int rows_alloc = 0;
+	int err = 0;
+	int x, n;
+
+	if (! PyArg_ParseTuple(args, "s", &path)) {
+		return ret;
+	}
+
+	buf = read_whole_file(path, &size);
+	timestamp = monotonic_now();
+	if (! buf) {
+		PyErr_SetFromErrnoWithFilename(PyExc_IOError, path);
+		return ret;
+	}
+
+	n = split_line(buf, &tokens, &talloc, &next);
+	for(x = 0; x < n && ncols < PROC_MAX_COLUMNS; ++x) {
+		if (strcmp(tokens[x], "<->") == 0) {
+			continue;
+		}
+		names[ncols] = tokens[x];
+		is_hex[ncols] = strcmp(tokens[x], "ENDPT") == 0 || strcmp(tokens[x], "ASSOC") == 0 ||
+				strcmp(tokens[x], "SOCK") == 0;
+		is_str[ncols] = strcmp(tokens[x], "ADDR") == 0 || strcmp(tokens[x], "LADDRS") == 0 ||
+				strcmp(tokens[x], "RADDRS") == 0;
+		values[ncols] = 0;
+		lists[ncols] = is_str[ncols] ? PyList_New(0) : 0;
+		if (strcmp(tokens[x], "LADDRS") == 0) {
+			laddrs = ncols;
+		} else if (strcmp(tokens[x], "RADDRS") == 0) {
+			raddrs = ncols;
+			primary = PyList_New(0);
+		}
+		++ncols;
+	}
+
+	// columns before and after the variable-length address lists
+	if (laddrs >= 0) {
+		n_pre = laddrs;
+		n_suf = ncols - (raddrs >= 0 ? raddrs : laddrs) - 1;
+	} else {
+		n_pre = ncols;
+		n_suf = 0;
+	}
+
+	for(line = next; *line && ! err; line = next) {
+		int ntok = split_line(line, &tokens, &talloc, &next);
+		int mid_end, sep, t, c;
+
+		if (ntok < 0) {
+			err = ENOMEM;
+			break;
+		}
+		if (ntok < n_pre + n_suf || ntok == 0) {
+			continue;
+		}
+		if (laddrs < 0 && ntok != ncols) {
+			continue;
+		}
+
+		if (rows == rows_alloc) {
+			rows_alloc = rows_alloc ? rows_alloc * 2 : 1024;
+			for(c = 0; c < ncols; ++c) {
+				if (! is_str[c]) {
+					int64_t* nv = (int64_t*) realloc(values[c], rows_alloc * sizeof(int64_t));
+					if (! nv) {
+						err = ENOMEM;
+						break;
+					}
+					values[c] = nv;
+				}
+			}
+			if (err) {
+				break;
+			}
+		}
+
+		// address lists span tokens [n_pre, sep) and (sep, mid_end)
+		mid_end = ntok - n_suf;
+		for(sep = n_pre; sep < mid_end && strcmp(tokens[sep], "<->"); ++sep);
+
+		for(c = 0; c < ncols; ++c) {
+			if (c == laddrs || c == raddrs) {
+				int start = (c == laddrs) ? n_pre : sep + 1;
+				int end = (c == laddrs) ? sep : mid_end;
+				PyObject* oaddrs = PyTuple_New(end > start ? end - start : 0);
+				PyObject* oprimary = 0;
+
+				for(t = start; t < end; ++t) {
+					const char* a = tokens[t];
+					if (*a == '*') {
+						oprimary = PyUnicode_FromString(++a);
+					}
+					PyTuple_SetItem(oaddrs, t - start, PyUnicode_FromString(a));
+				}
+				PyList_Append(lists[c], oaddrs);
+				Py_DECREF(oaddrs);
+
+				if (c == raddrs) {
+					if (! oprimary) {
+						oprimary = PyUnicode_FromString("");
+					}
+					PyList_Append(primary, oprimary);
+				}
+				Py_XDECREF(oprimary);
+				continue;
+			}
+
+			t = (c < n_pre) ? c : ntok - (ncols - c);
+			if (is_str[c]) {
+				PyObject* o = PyUnicode_FromString(tokens[t]);
+				PyList_Append(lists[c], o);
+				Py_DECREF(o);
+			} else if (is_hex[c]) {
+				values[c][rows] = (int64_t) strtoull(tokens[t], 0, 16);
+			} else {
+				values[c][rows] = strtoll(tokens[t], 0, 10);
+			}
+		}
+		++rows;
+	}
+
+	free(tokens);
+
+	if (err) {
+		errno = err;
+		PyErr_SetFromErrno(PyExc_IOError);
+	} else {
+		columns = PyDict_New();
+		for(x = 0; x < ncols; ++x) {
+			if (is_str[x]) {
+				PyDict_SetItemString(columns, names[x], lists[x]);
+			} else {
+				PyObject* o = PyBytes_FromStringAndSize((char*) values[x], rows * sizeof(int64_t));
+				PyDict_SetItemString(columns, names[x], o);
+				Py_DECREF(o);
+			}
+		}
+		if (primary) {
+			PyDict_SetItemString(columns, "PRIMARY", primary);
+		}
+		ret = Py_BuildValue("(dN)", timestamp, columns);
+	}
+
+	for(x = 0; x < ncols; ++x) {
+		free(values[x]);
+		Py_XDECREF(lists[x]);
+	}
+	Py_XDECREF(primary);
+	free(buf);
+
+	return ret;
+}
+
+static int to_sockaddr(const char *caddr, int port, struct sockaddr* saddr, int* slen)
+{
+	int ret = 1;
+
+	*slen = 0;
+
+#ifdef DEBUG
+	printf("[DEBUG to_sockaddr] converting caddr: %s, port: %d\n", caddr, port);
+#endif
+
+	if (strcmp(caddr, "") == 0) {
+		saddr->sa_family = AF_INET;
+		((struct sockaddr_in*) saddr)->sin_addr.s_addr = INADDR_ANY;
+	} else if (strcmp(caddr, "<broadcast>") == 0) {
+		saddr->sa_family = AF_INET;
+		((struct sockaddr_in*) saddr)->sin_addr.s_addr = INADDR_BROADCAST;
+	} else if (inet_pton(AF_INET6, caddr, &(((struct sockaddr_in6*)saddr)->sin6_addr)) > 0) {
+		saddr->sa_family = AF_INET6;
+	} else if (inet_pton(AF_INET, caddr, &(((struct sockaddr_in*)saddr)->sin_addr)) > 0) {
+		saddr->sa_family = AF_INET;
+	} else {
+		saddr->sa_family = -1;
+		ret = 0;
+	}
+
+	if (saddr->sa_family == AF_INET) {
+		((struct sockaddr_in*) saddr)->sin_port = htons(port);
+		*slen = sizeof(struct sockaddr_in);
+	} else if (saddr->sa_family == AF_INET6) {
+		((struct sockaddr_in6*) saddr)->sin6_port = htons(port);
+		*slen = sizeof(struct sockaddr_in6);
+	}
+
+#ifdef DEBUG
+	printf("[DEBUG to_sockaddr] sockaddr result is family: 0x%x, s_addr: 0x%x, port: 0x%x\n", 
+			((struct sockaddr_in*)saddr)->sin_family,
+			((struct sockaddr_in*)saddr)->sin_addr.s_addr,
+			((struct sockaddr_in*)saddr)->sin_port);
+#endif
+	return ret;
+}
+
+static int from_sockaddr(struct sockaddr* saddr, int* family, int* slen, int* port, char* caddr, int cnt)
+{
+	int ret = 0;
+	*family = saddr->sa_family;
+	if (*family == AF_INET) {
+		*slen = sizeof(struct sockaddr_in);
+		if (inet_ntop(AF_INET, &(((struct sockaddr_in*) saddr)->sin_addr), caddr, cnt)) {
+			*port = ntohs(((struct sockaddr_in*) saddr)->sin_port);
+			ret = 1;
+		}
+	} else if (*family == AF_INET6) {
+		*slen = sizeof(struct sockaddr_in6);
+		if (inet_ntop(AF_INET6, &(((struct sockaddr_in6*) saddr)->sin6_addr), caddr, cnt)) {
+			*port = ntohs(((struct sockaddr_in6*) saddr)->sin6_port);
+			ret = 1;
+		}
+	}
+	return ret;
+}
+
+static PyObject* _sockaddr_test(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	PyObject* addrtupleret = 0;
+	char *caddr;
+	int port;
+	struct sockaddr_storage saddr;
+	int slen;
+	int family;
+	char caddr2[256];
+
+	if (! PyArg_ParseTuple(args, "(si)", &caddr, &port)) {
+		return ret;
+	}
+
+	printf("DEBUG: addr=%s, port=%d\n", caddr, port);
+
+	if (! to_sockaddr(caddr, port, (struct sockaddr*) &saddr, &slen)) {
+		PyErr_SetString(PyExc_ValueError, "address could not be translated");
+		return ret;
+	}
+	port = 0;
+	caddr = 0;
+
+	if (! from_sockaddr((struct sockaddr*) &saddr, &family, &slen, &port, caddr2, sizeof(caddr2))) {
+		PyErr_SetString(PyExc_ValueError, "address could not be de-translated");
+		return ret;
+	}
+
+	ret = PyTuple_New(4);
+	addrtupleret = PyTuple_New(2);
+	PyTuple_SetItem(ret, 0, Py23_PyUnicode_FromFormat("family %d, size %d, address %s.%d", family, slen, caddr2, port));
+	PyTuple_SetItem(ret, 1, Py23_PyLong_FromLong(family));
+	PyTuple_SetItem(ret, 2, Py23_PyLong_FromLong(slen));
+	PyTuple_SetItem(ret, 3, addrtupleret);
+	PyTuple_SetItem(addrtupleret, 0, PyUnicode_FromString(caddr2));
+	PyTuple_SetItem(addrtupleret, 1, Py23_PyLong_FromLong(port));
+
+	return ret;
+}
+
+/* getpaddrs() as it was before AddressSet: a tuple of (address, port) tuples,
+   all built up front. Kept as the reference of bench/overhead.py. */
+static PyObject* _getpaddrs_tuple(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	int fd;
+	int assoc_id;
+	struct sockaddr* saddrs;
+	int count;
+	int x;
+	char addr[256];
+	char *p;
+
+	if (! PyArg_ParseTuple(args, "ii", &fd, &assoc_id)) {
+		return ret;
+	}
+
+	count = sctp_getpaddrs(fd, assoc_id, &saddrs);
+
+	if (count < 0) {
+		PyErr_SetFromErrno(PyExc_IOError);
+		return ret;
+	}
+
+	ret = PyTuple_New(count);
+	p = (char*) saddrs;
+
+	for(x = 0; ret && x < count; ++x) {
+		int len;
+		int family;
+		int port;
+
+		if (! from_sockaddr((struct sockaddr*) p, &family, &len, &port, addr, sizeof(addr))) {
+			PyErr_SetString(PyExc_ValueError, "address could not be de-translated");
+			Py_CLEAR(ret);
+			break;
+		}
+		PyTuple_SET_ITEM(ret, x, Py_BuildValue("(si)", addr, port));
+		p += len;
+	}
+
+	if (count > 0) {
+		sctp_freepaddrs(saddrs);
+	}
+	return ret;
+}
+
+static PyObject* set_peer_primary(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	int fd;
+	int l;
+	int assoc_id;
+	char* addr;
+	int port;
+	struct sctp_setpeerprim ssp;
+
+	if (! PyArg_ParseTuple(args, "ii(si)", &fd, &assoc_id, &addr, &port)) {
+		return ret;
+	}
+
+	bzero(&ssp, sizeof(ssp));
+	ssp.sspp_assoc_id = assoc_id;
+	if (! to_sockaddr(addr, port, (struct sockaddr*) &(ssp.sspp_addr), &l)) {
+		PyErr_SetString(PyExc_ValueError, "Invalid address");
+		return ret;
+	}
+
+	if (setsockopt(fd, SOL_SCTP, SCTP_SET_PEER_PRIMARY_ADDR, &ssp, sizeof(ssp))) {
+		PyErr_SetFromErrno(PyExc_IOError);
+	} else {
+		ret = Py_None; Py_INCREF(ret);
+	}
+
+	return ret;
+}
+
+static PyObject* set_primary(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	int fd;
+	int l;
+	int assoc_id;
+	char* addr;
+	struct sctp_prim ssp;
+	int port;
+
+	if (! PyArg_ParseTuple(args, "ii(si)", &fd, &assoc_id, &addr, &port)) {
+		return ret;
+	}
+
+	bzero(&ssp, sizeof(ssp));
+	ssp.ssp_assoc_id = assoc_id;
+	if (! to_sockaddr(addr, port, (struct sockaddr*) &(ssp.ssp_addr), &l)) {
+		PyErr_SetString(PyExc_ValueError, "Invalid address");
+		return ret;
+	}
+
+	if (setsockopt(fd, SOL_SCTP, SCTP_PRIMARY_ADDR, &ssp, sizeof(ssp))) {
+		PyErr_SetFromErrno(PyExc_IOError);
+	} else {
+		ret = Py_None; Py_INCREF(ret);
+	}
+
+	return ret;
+}
+
+/* AddressSet: an immutable, ordered set of IPv4/IPv6 socket addresses,
+ * packed back to back exactly as sctp_bindx()/sctp_connectx() take them
+ * and sctp_getpaddrs()/sctp_getladdrs() return them. Entries are
+ * normalized (family, port, address and IPv6 scope only), so comparing
+ * two addresses is a memcmp(), and a hash of the entries indexes them for
+ * membership tests; address/port tuples are only built when entries are
+ * read from Python. Being immutable, a set can be passed to the kernel with
+ * the GIL released.
+ *
+ * For compatibility with the tuples getpaddrs() and getladdrs() used to
+ * return, comparisons and hash() are those of the tuple of the entries, in
+ * order: a set is equal to the tuple of the same address/port tuples. */
+
+#if PY_MAJOR_VERSION < 3
+typedef long Py_hash_t;
+#endif
+
+typedef struct {
+	PyObject_HEAD
+	int count;
+	int len;         // bytes used in addrs
+	int alloc;       // bytes allocated in addrs
+	int cap;         // entries allocated in offsets
+	int* offsets;    // offset of every entry in addrs
+	char* addrs;
+	int* index;      // open addressing hash: entry number + 1, 0 if free
+	int index_cap;   // slots in index, a power of two, at least twice count
+	int hashed;
+	Py_hash_t hash;  // hash() of the tuple of the entries, once hashed
+} AddressSetObject;
+
+static PyTypeObject AddressSetType = { PyVarObject_HEAD_INIT(NULL, 0) };
+static PyNumberMethods addrset_as_number;
+static PySequenceMethods addrset_as_sequence;
+
+#define AddressSet_Check(o) PyObject_TypeCheck(o, &AddressSetType)
+
+static int sockaddr_size(const struct sockaddr* sa)
+{
+	if (sa->sa_family == AF_INET) {
+		return sizeof(struct sockaddr_in);
+	} else if (sa->sa_family == AF_INET6) {
+		return sizeof(struct sockaddr_in6);
+	}
+	return 0;
+}
+
+static AddressSetObject* addrset_new(void)
+{
+	return (AddressSetObject*) AddressSetType.tp_alloc(&AddressSetType, 0);
+}
+
+static int addrset_reserve(AddressSetObject* s, int count, int len)
+{
+	// geometric growth, so that building a set is linear in its size
+	if (len > s->alloc) {
+		int n = s->alloc ? s->alloc : 4 * sizeof(struct sockaddr_in6);
+		char* p;
+		while (n < len) {
+			n *= 2;
+		}
+		p = realloc(s->addrs, n);
+		if (! p) {
+			PyErr_NoMemory();
+			return 0;
+		}
+		s->addrs = p;
+		s->alloc = n;
+	}
+	if (count > s->cap) {
+		int n = s->cap ? s->cap : 4;
+		int* p;
+		while (n < count) {
+			n *= 2;
+		}
+		p = realloc(s->offsets, n * sizeof(int));
+		if (! p) {
+			PyErr_NoMemory();
+			return 0;
+		}
+		s->offsets = p;
+		s->cap = n;
+	}
+	return 1;
+}
+
+/* Copies the fields of sa that make the address into a zeroed n.
+ * Returns the size of the address, or 0 for unknown families. */
+static int sockaddr_normalize(const struct sockaddr* sa, struct sockaddr_storage* n)
+{
+	int size = sockaddr_size(sa);
+
+	bzero(n, sizeof(*n));
+	if (sa->sa_family == AF_INET) {
+		const struct sockaddr_in* in = (const struct sockaddr_in*) sa;
+		struct sockaddr_in* out = (struct sockaddr_in*) n;
+		out->sin_family = AF_INET;
+		out->sin_port = in->sin_port;
+		out->sin_addr = in->sin_addr;
+	} else if (sa->sa_family == AF_INET6) {
+		const struct sockaddr_in6* in = (const struct sockaddr_in6*) sa;
+		struct sockaddr_in6* out = (struct sockaddr_in6*) n;
+		out->sin6_family = AF_INET6;
+		out->sin6_port = in->sin6_port;
+		out->sin6_addr = in->sin6_addr;
+		out->sin6_scope_id = in->sin6_scope_id;
+	}
+	return size;
+}
+
+// FNV-1a over a normalized address
+static unsigned int sockaddr_hash(const struct sockaddr* sa, int size)
+{
+	const unsigned char* p = (const unsigned char*) sa;
+	unsigned int h = 2166136261u;
+	int x;
+
+	for (x = 0; x < size; ++x) {
+		h = (h ^ p[x]) * 16777619u;
+	}
+	return h;
+}
+
+/* Returns the entry number of the normalized address sa, or -1 */
+static int addrset_find(const AddressSetObject* s, const struct sockaddr* sa, int size)
+{
+	unsigned int mask;
+	unsigned int i;
+	int e;
+
+	if (! s->index_cap) {
+		return -1;
+	}
+	mask = s->index_cap - 1;
+	for (i = sockaddr_hash(sa, size) & mask; (e = s->index[i]) != 0; i = (i + 1) & mask) {
+		const struct sockaddr* o = (const struct sockaddr*) (s->addrs + s->offsets[e - 1]);
+		if (o->sa_family == sa->sa_family && memcmp(o, sa, size) == 0) {
+			return e - 1;
+		}
+	}
+	return -1;
+}
+
+static void addrset_index_put(AddressSetObject* s, int x)
+{
+	const struct sockaddr* sa = (const struct sockaddr*) (s->addrs + s->offsets[x]);
+	unsigned int mask = s->index_cap - 1;
+	unsigned int i = sockaddr_hash(sa, sockaddr_size(sa)) & mask;
+
+	while (s->index[i]) {
+		i = (i + 1) & mask;
+	}
+	s->index[i] = x + 1;
+}
+
+/* Makes room in the index for count entries, keeping it at most half
+ * full; the entries already in the set are indexed again on growth */
+static int addrset_index_reserve(AddressSetObject* s, int count)
+{
+	int n = s->index_cap ? s->index_cap : 8;
+	int* p;
+	int x;
+
+	if (s->index_cap && 2 * count <= s->index_cap) {
+		return 1;
+	}
+	while (n < 2 * count) {
+		n *= 2;
+	}
+	p = calloc(n, sizeof(int));
+	if (! p) {
+		PyErr_NoMemory();
+		return 0;
+	}
+	free(s->index);
+	s->index = p;
+	s->index_cap = n;
+	for (x = 0; x < s->count; ++x) {
+		addrset_index_put(s, x);
+	}
+	return 1;
+}
+
+/* Appends a copy of sa, normalized; duplicates are ignored.
+ * Returns 0 with an exception set on error. */
+static int addrset_append(AddressSetObject* s, const struct sockaddr* sa)
+{
+	struct sockaddr_storage n;
+	int size = sockaddr_normalize(sa, &n);
+
+	if (size == 0) {
+		PyErr_Format(PyExc_ValueError, "Invalid address family: %d", sa->sa_family);
+		return 0;
+	}
+
+	if (addrset_find(s, (struct sockaddr*) &n, size) >= 0) {
+		return 1;
+	}
+
+	if (! addrset_reserve(s, s->count + 1, s->len + size) ||
+			! addrset_index_reserve(s, s->count + 1)) {
+		return 0;
+	}
+	memcpy(s->addrs + s->len, &n, size);
+	s->offsets[s->count] = s->len;
+	addrset_index_put(s, s->count);
+	s->count++;
+	s->len += size;
+	return 1;
+}
+
+static int addrset_append_tuple(AddressSetObject* s, PyObject* otuple)
+{
+	struct sockaddr_storage saddr;
+	const char* caddr;
+	int iport;
+	int slen;
+
+	if (! PyTuple_Check(otuple)) {
+		PyErr_SetString(PyExc_TypeError, "Addresses must be (address, port) tuples");
+		return 0;
+	}
+	if (! PyArg_ParseTuple(otuple, "si", &caddr, &iport)) {
+		return 0;
+	}
+
+	bzero(&saddr, sizeof(saddr));
+	if (! to_sockaddr(caddr, iport, (struct sockaddr*) &saddr, &slen)) {
+		PyErr_Format(PyExc_ValueError, "Invalid address: %s", caddr);
+		return 0;
+	}
+
+	return addrset_append(s, (struct sockaddr*) &saddr);
+}
+
+/* Appends the entries of another AddressSet, or of an iterable of
+ * address/port tuples */
+static int addrset_extend(AddressSetObject* s, PyObject* o)
+{
+	PyObject* it;
+	PyObject* item;
+	int x;
+
+	if (AddressSet_Check(o)) {
+		AddressSetObject* other = (AddressSetObject*) o;
+		for (x = 0; x < other->count; ++x) {
+			if (! addrset_append(s, (struct sockaddr*) (other->addrs + other->offsets[x]))) {
+				return 0;
+			}
+		}
+		return 1;
+	}
+
+	it = PyObject_GetIter(o);
+	if (! it) {
+		return 0;
+	}
+	while ((item = PyIter_Next(it))) {
+		int ok = addrset_append_tuple(s, item);
+		Py_DECREF(item);
+		if (! ok) {
+			Py_DECREF(it);
+			return 0;
+		}
+	}
+	Py_DECREF(it);
+	return ! PyErr_Occurred();
+}
+
+/* Returns a new reference to an AddressSet holding the addresses of o,
+ * which is o itself if it already is an AddressSet */
+static AddressSetObject* addrset_from_arg(PyObject* o)
+{
+	AddressSetObject* s;
+
+	if (AddressSet_Check(o)) {
+		Py_INCREF(o);
+		return (AddressSetObject*) o;
+	}
+
+	s = addrset_new();
+	if (s && ! addrset_extend(s, o)) {
+		Py_DECREF(s);
+		s = 0;
+	}
+	return s;
+}
+
+/* Builds an AddressSet from an array of count packed sockaddrs, as
+ * returned by sctp_getpaddrs()/sctp_getladdrs() */
+static AddressSetObject* addrset_from_packed(const char* p, int count)
+{
+	AddressSetObject* s = addrset_new();
+	int x;
+
+	if (! s) {
+		return s;
+	}
+	for (x = 0; x < count; ++x) {
+		int size = sockaddr_size((const struct sockaddr*) p);
+		if (size == 0) {
+			// something's wrong; not safe to continue
+			break;
+		}
+		if (! addrset_append(s, (const struct sockaddr*) p)) {
+			Py_DECREF(s);
+			return 0;
+		}
+		p += size;
+	}
+	return s;
+}
+
+static PyObject* addrset_tp_new(PyTypeObject* type, PyObject* args, PyObject* kwds)
+{
+	PyObject* o = 0;
+	AddressSetObject* s;
+
+	if (! PyArg_ParseTuple(args, "|O:AddressSet", &o)) {
+		return 0;
+	}
+
+	s = (AddressSetObject*) type->tp_alloc(type, 0);
+	if (s && o && ! addrset_extend(s, o)) {
+		Py_DECREF(s);
+		s = 0;
+	}
+	return (PyObject*) s;
+}
+
+static void addrset_dealloc(AddressSetObject* s)
+{
+	free(s->addrs);
+	free(s->offsets);
+	free(s->index);
+	Py_TYPE(s)->tp_free((PyObject*) s);
+}
+
+static Py_ssize_t addrset_length(AddressSetObject* s)
+{
+	return s->count;
+}
+
+static PyObject* addrset_item(AddressSetObject* s, Py_ssize_t i)
+{
+	char caddr[256];
+	int family, len, port;
+
+	if (i < 0 || i >= s->count) {
+		PyErr_SetString(PyExc_IndexError, "AddressSet index out of range");
+		return 0;
+	}
+
+	if (! from_sockaddr((struct sockaddr*) (s->addrs + s->offsets[i]), &family, &len, &port,
+				caddr, sizeof(caddr))) {
+		PyErr_SetString(PyExc_ValueError, "address could not be de-translated");
+		return 0;
+	}
+
+	return Py_BuildValue("(Ni)", PyUnicode_FromString(caddr), port);
+}
+
+static int addrset_contains(AddressSetObject* s, PyObject* o)
+{
+	struct sockaddr_storage saddr, n;
+	const char* caddr;
+	int iport;
+	int slen;
+
+	bzero(&saddr, sizeof(saddr));
+	if (! PyTuple_Check(o) || ! PyArg_ParseTuple(o, "si", &caddr, &iport) ||
+			! to_sockaddr(caddr, iport, (struct sockaddr*) &saddr, &slen)) {
+		// not an address, so not in the set
+		PyErr_Clear();
+		return 0;
+	}
+
+	slen = sockaddr_normalize((struct sockaddr*) &saddr, &n);
+	return slen && addrset_find(s, (struct sockaddr*) &n, slen) >= 0;
+}
+
+static PyObject* addrset_richcompare(PyObject* a, PyObject* b, int op)
+{
+	AddressSetObject* sa = (AddressSetObject*) a;
+	AddressSetObject* sb = (AddressSetObject*) b;
+	PyObject* ta;
+	PyObject* tb;
+	PyObject* ret;
+
+	if (! AddressSet_Check(a) || (! AddressSet_Check(b) && ! PyTuple_Check(b))) {
+		Py_INCREF(Py_NotImplemented);
+		return Py_NotImplemented;
+	}
+
+	if (AddressSet_Check(b) && (op == Py_EQ || op == Py_NE)) {
+		// same entries in the same order: the packed arrays are the same
+		int equal = sa->count == sb->count && sa->len == sb->len &&
+				memcmp(sa->addrs, sb->addrs, sa->len) == 0;
+		if (equal == (op == Py_EQ)) {
+			Py_RETURN_TRUE;
+		}
+		Py_RETURN_FALSE;
+	}
+
+	// anything else compares as the tuple of the entries
+	ta = PySequence_Tuple(a);
+	tb = PySequence_Tuple(b);
+	ret = (ta && tb) ? PyObject_RichCompare(ta, tb, op) : 0;
+	Py_XDECREF(ta);
+	Py_XDECREF(tb);
+	return ret;
+}
+
+static Py_hash_t addrset_hash(AddressSetObject* s)
+{
+	if (! s->hashed) {
+		PyObject* t = PySequence_Tuple((PyObject*) s);
+		if (! t) {
+			return -1;
+		}
+		s->hash = PyObject_Hash(t);
+		Py_DECREF(t);
+		if (s->hash == -1) {
+			return -1;
+		}
+		s->hashed = 1;
+	}
+	return s->hash;
+}
+
+static PyObject* addrset_repr(AddressSetObject* s)
+{
+	PyObject* ret = 0;
+	PyObject* list = PySequence_List((PyObject*) s);
+
+	if (list) {
+#if PY_MAJOR_VERSION >= 3
+		ret = PyUnicode_FromFormat("AddressSet(%R)", list);
+#else
+		PyObject* r = PyObject_Repr(list);
+		if (r) {
+			ret = PyString_FromFormat("AddressSet(%s)", PyString_AsString(r));
+			Py_DECREF(r);
+		}
+#endif
+		Py_DECREF(list);
+	}
+	return ret;
+}
+
+/* Set operations, linear in the size of both sets thanks to the index.
+ * Results keep the order of the left operand, then of the right one. */
+
+#define ADDRSET_UNION        0
+#define ADDRSET_DIFFERENCE   1
+#define ADDRSET_INTERSECTION 2
+
+static PyObject* addrset_combine(PyObject* a, PyObject* b, int op)
+{
+	AddressSetObject* sa;
+	AddressSetObject* sb;
+	AddressSetObject* ret;
+	int x;
+
+	if (! AddressSet_Check(a)) {
+		Py_INCREF(Py_NotImplemented);
+		return Py_NotImplemented;
+	}
+	sa = (AddressSetObject*) a;
+
+	sb = addrset_from_arg(b);
+	if (! sb) {
+		return 0;
+	}
+
+	ret = addrset_new();
+	if (! ret) {
+		Py_DECREF(sb);
+		return 0;
+	}
+
+	if (op == ADDRSET_UNION) {
+		if (! addrset_reserve(ret, sa->count, sa->len)) {
+			goto error;
+		}
+		memcpy(ret->addrs, sa->addrs, sa->len);
+		memcpy(ret->offsets, sa->offsets, sa->count * sizeof(int));
+		ret->count = sa->count;
+		ret->len = sa->len;
+		if (! addrset_index_reserve(ret, sa->count) || ! addrset_extend(ret, (PyObject*) sb)) {
+			goto error;
+		}
+	} else {
+		for (x = 0; x < sa->count; ++x) {
+			const struct sockaddr* e = (const struct sockaddr*) (sa->addrs + sa->offsets[x]);
+			int found = addrset_find(sb, e, sockaddr_size(e)) >= 0;
+			if (found == (op == ADDRSET_INTERSECTION) && ! addrset_append(ret, e)) {
+				goto error;
+			}
+		}
+	}
+
+	Py_DECREF(sb);
+	return (PyObject*) ret;
+
+error:
+	Py_DECREF(sb);
+	Py_DECREF(ret);
+	return 0;
+}
+
+static PyObject* addrset_union(PyObject* a, PyObject* b)
+{
+	return addrset_combine(a, b, ADDRSET_UNION);
+}
+
+static PyObject* addrset_difference(PyObject* a, PyObject* b)
+{
+	return addrset_combine(a, b, ADDRSET_DIFFERENCE);
+}
+
+static PyObject* addrset_intersection(PyObject* a, PyObject* b)
+{
+	return addrset_combine(a, b, ADDRSET_INTERSECTION);
+}
+
+static PyObject* addrset_packed(AddressSetObject* s, PyObject* dummy)
+{
+	return PyBytes_FromStringAndSize(s->addrs, s->len);
+}
+
+static PyMethodDef addrset_methods[] =
+{
+	{"union", (PyCFunction) addrset_union, METH_O,
+		"union(other) -> AddressSet with the addresses of both sets"},
+	{"difference", (PyCFunction) addrset_difference, METH_O,
+		"difference(other) -> AddressSet with the addresses not in other"},
+	{"intersection", (PyCFunction) addrset_intersection, METH_O,
+		"intersection(other) -> AddressSet with the addresses also in other"},
+	{"packed", (PyCFunction) addrset_packed, METH_NOARGS,
+		"packed() -> bytes, the packed sockaddr array"},
+	{ NULL, NULL, 0, NULL }
+};
+
+static PyObject* bindx(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	int fd;
+	PyObject* addrs;
+	AddressSetObject* set;
+	int flags;
+
+	if (! PyArg_ParseTuple(args, "iOi", &fd, &addrs, &flags)) {
+		return ret;
+	}
+
+	set = addrset_from_arg(addrs);
+	if (! set) {
+		return ret;
+	}
+
+	if (set->count <= 0) {
+		PyErr_SetString(PyExc_ValueError, "Second parameter must be a non-empty sequence");
+	} else if (sctp_bindx(fd, (struct sockaddr*) set->addrs, set->count, flags)) {
+		PyErr_SetFromErrno(PyExc_IOError);
+	} else {
+		ret = Py_None; Py_INCREF(ret);
+	}
+
+	Py_DECREF(set);
+	return ret;
+}
+
+#ifndef SOCK_CLOEXEC
+/* Sets or clears O_NONBLOCK, returning the previous flags, or -1 */
+static int set_nonblock(int fd, int nonblock)
+{
+	int flags = fcntl(fd, F_GETFL);
+	if (flags < 0) {
+		return -1;
+	}
+	if (fcntl(fd, F_SETFL, nonblock ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK)) < 0) {
+		return -1;
+	}
+	return flags;
+}
+#endif
+
+/* Non-blocking handshakes need a socket that is non-blocking already: the
+ * flag belongs to the open file, shared with every other user of the socket,
+ * so it is not toggled behind their back. Sets an exception if not. */
+static int check_nonblock(int fd)
+{
+	int flags = fcntl(fd, F_GETFL);
+	if (flags < 0) {
+		PyErr_SetFromErrno(PyExc_IOError);
+		return 0;
+	}
+	if (! (flags & O_NONBLOCK)) {
+		PyErr_SetString(PyExc_ValueError, "the socket must be in non-blocking mode");
+		return 0;
+	}
+	return 1;
+}
+
+static PyObject* connectx(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	PyObject* dict;
+	int fd;
+	PyObject* addrs;
+	AddressSetObject* set;
+	sctp_assoc_t id = 0;
+	int nonblock = 0;
+	int result;
+	int err;
+
+	if (! PyArg_ParseTuple(args, "iOO|i", &fd, &addrs, &dict, &nonblock)) {
+		return ret;
+	}
+	if (nonblock && ! check_nonblock(fd)) {
+		return ret;
+	}
+
+	set = addrset_from_arg(addrs);
+	if (! set) {
+		return ret;
+	}
+
+	if (set->count <= 0) {
+		PyErr_SetString(PyExc_ValueError, "Second parameter must be a non-empty sequence");
+		Py_DECREF(set);
+		return ret;
+	}
+
+	Py_BEGIN_ALLOW_THREADS
+	result = sctp_connectx(fd, (struct sockaddr*) set->addrs, set->count, &id);
+	err = errno;
+	Py_END_ALLOW_THREADS
+
+	// lksctp fills the association ID in even when the handshake is still in progress
+	if (result && ! (nonblock && err == EINPROGRESS)) {
+		errno = err;
+		PyErr_SetFromErrno(PyExc_IOError);
+	} else {
+		ret = Py23_PyLong_FromLong(id);
+		if(ret && PyDict_Check(dict)) PyDict_SetItemString(dict, "assoc_id", ret);
+	}
+
+	Py_DECREF(set);
+	return ret;
+}
+
+static PyObject* connectx_many(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	int fd;
+	PyObject* peers;
+	AddressSetObject** sets;
+	sctp_assoc_t* ids;
+	int* errs;
+	Py_ssize_t count;
+	Py_ssize_t x;
+
+	if (! PyArg_ParseTuple(args, "iO", &fd, &peers)) {
+		return ret;
+	}
+
+	if (! PySequence_Check(peers)) {
+		PyErr_SetString(PyExc_ValueError, "Second parameter must be a sequence of address lists");
+		return ret;
+	}
+	if (! check_nonblock(fd)) {
+		return ret;
+	}
+
+	count = PySequence_Length(peers);
+	if (count < 0) {
+		return ret;
+	}
+	sets = calloc(count + 1, sizeof(AddressSetObject*));
+	ids = calloc(count + 1, sizeof(sctp_assoc_t));
+	errs = calloc(count + 1, sizeof(int));
+	if (! sets || ! ids || ! errs) {
+		PyErr_NoMemory();
+		goto out;
+	}
+
+	for (x = 0; x < count; ++x) {
+		PyObject* addrs = PySequence_GetItem(peers, x);
+		if (! addrs) {
+			goto out;
+		}
+		sets[x] = addrset_from_arg(addrs);
+		Py_DECREF(addrs);
+		if (! sets[x]) {
+			goto out;
+		}
+		if (sets[x]->count <= 0) {
+			PyErr_SetString(PyExc_ValueError, "Address lists must not be empty");
+			goto out;
+		}
+	}
+
+	// all handshakes are started before any completes; completion is
+	// reported by SCTP_ASSOC_CHANGE notifications
+	Py_BEGIN_ALLOW_THREADS
+	for (x = 0; x < count; ++x) {
+		if (sctp_connectx(fd, (struct sockaddr*) sets[x]->addrs, sets[x]->count, &ids[x]) &&
+				errno != EINPROGRESS) {
+			errs[x] = errno;
+		}
+	}
+	Py_END_ALLOW_THREADS
+
+	ret = PyList_New(count);
+	for (x = 0; ret && x < count; ++x) {
+		PyObject* o = Py_BuildValue("(ii)", (int) ids[x], errs[x]);
+		if (! o) {
+			Py_CLEAR(ret);
+			break;
+		}
+		PyList_SET_ITEM(ret, x, o);
+	}
+
+out:
+	if (sets) {
+		for (x = 0; x < count; ++x) {
+			Py_XDECREF(sets[x]);
+		}
+	}
+	free(sets);
+	free(ids);
+	free(errs);
+	return ret;
+}
+
+static PyObject* getpaddrs(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	int fd;
+	int assoc_id;
+	struct sockaddr* saddrs;
+	int count;
+
+	if (! PyArg_ParseTuple(args, "ii", &fd, &assoc_id)) {
+		return ret;
+	}
+
+	count = sctp_getpaddrs(fd, assoc_id, &saddrs);
+
+	if (count < 0) {
+		PyErr_SetFromErrno(PyExc_IOError);
+	} else {
+		ret = (PyObject*) addrset_from_packed((char*) saddrs, count);
+		if (count > 0) {
+			sctp_freepaddrs(saddrs);
+		}
+	}
+
+	return ret;
+}
+
+static PyObject* getladdrs(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	int fd;
+	int assoc_id;
+	struct sockaddr* saddrs;
+	int count;
+
+	if (! PyArg_ParseTuple(args, "ii", &fd, &assoc_id)) {
+		return ret;
+	}
+
+	count = sctp_getladdrs(fd, assoc_id, &saddrs);
+
+	if (count < 0) {
+		PyErr_SetFromErrno(PyExc_IOError);
+	} else {
+		ret = (PyObject*) addrset_from_packed((char*) saddrs, count);
+		if (count > 0) {
+			sctp_freeladdrs(saddrs);
+		}
+	}
+
+	return ret;
+}
+
+/* Latency statistics.
+ *
+ * Log-bucketed histograms (HDR-style: 2^LAT_SUB_BITS linear sub-buckets per 
+ * power of two, so the relative error is at most 1/8) kept around the 
+ * syscalls of sctp_send_msg() and sctp_recv_msg(). The statistics block is
+ * wrapped in a PyCapsule owned by the Python socket object, and is passed as
+ * an optional last argument; when it is not passed, the only cost is one 
+ * pointer test. Updates happen with the GIL held, so no locking is needed. */
+
+#define LAT_SUB_BITS 3
+#define LAT_SUB (1 << LAT_SUB_BITS)
+#define LAT_BUCKETS ((64 - LAT_SUB_BITS + 1) * LAT_SUB)
+#define LAT_CAPSULE "_sctp.latency_stats"
+
+struct lat_histogram {
+	uint64_t count;
+	uint64_t sum;
+	uint64_t min;
+	uint64_t max;
+	uint64_t buckets[LAT_BUCKETS];
+};
+
+struct lat_stats {
+	struct lat_histogram send_ns;
+	struct lat_histogram send_bytes;
+	struct lat_histogram recv_ns;
+	struct lat_histogram recv_bytes;
+	struct lat_histogram recv_gap_ns;
+	uint64_t send_eagain;
+	uint64_t send_errors;
+	uint64_t recv_eagain;
+	uint64_t recv_errors;
+	uint64_t last_recv;
+};
+
+static uint64_t monotonic_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int lat_bucket(uint64_t v)
+{
+	int msb;
+
+	if (v < 2 * LAT_SUB) {
+		return (int) v;
+	}
+
+	msb = 63 - __builtin_clzll(v);
+	return (msb - LAT_SUB_BITS + 1) * LAT_SUB + (int) ((v >> (msb - LAT_SUB_BITS)) - LAT_SUB);
+}
+
+static uint64_t lat_bucket_floor(int index)
+{
+	int e;
+
+	if (index < 2 * LAT_SUB) {
+		return index;
+	}
+
+	e = index / LAT_SUB - 1;
+	return (uint64_t) (LAT_SUB + index % LAT_SUB) << e;
+}
+
+static void lat_record(struct lat_histogram* h, uint64_t v)
+{
+	if (h->count == 0 || v < h->min) {
+		h->min = v;
+	}
+	if (v > h->max) {
+		h->max = v;
+	}
+	h->count++;
+	h->sum += v;
+	h->buckets[lat_bucket(v)]++;
+}
+
+static void lat_record_call(struct lat_stats* st, int is_send, uint64_t start, int size, int err)
+{
+	uint64_t end = monotonic_ns();
+
+	if (is_send) {
+		lat_record(&(st->send_ns), end - start);
+		if (size >= 0) {
+			lat_record(&(st->send_bytes), size);
+		} else if (err == EAGAIN || err == EWOULDBLOCK) {
+			st->send_eagain++;
+		} else {
+			st->send_errors++;
+		}
+	} else {
+		lat_record(&(st->recv_ns), end - start);
+		if (size >= 0) {
+			lat_record(&(st->recv_bytes), size);
+			if (st->last_recv) {
+				lat_record(&(st->recv_gap_ns), end - st->last_recv);
+			}
+			st->last_recv = end;
+		} else if (err == EAGAIN || err == EWOULDBLOCK) {
+			st->recv_eagain++;
+		} else {
+			st->recv_errors++;
+		}
+	}
+}
+
+static void set_u64(PyObject* dict, const char* name, uint64_t v)
+{
+	PyObject* o = PyLong_FromUnsignedLongLong(v);
+	PyDict_SetItemString(dict, name, o);
+	Py_DECREF(o);
+}
+
+static PyObject* lat_histogram_dict(const struct lat_histogram* h)
+{
+	PyObject* dict = PyDict_New();
+	PyObject* obuckets = PyList_New(0);
+	int x;
+
+	for(x = 0; x < LAT_BUCKETS; ++x) {
+		if (h->buckets[x]) {
+			PyObject* item = Py_BuildValue("(KK)", (unsigned long long) lat_bucket_floor(x), 
+							(unsigned long long) h->buckets[x]);
+			PyList_Append(obuckets, item);
+			Py_DECREF(item);
+		}
+	}
+
+	set_u64(dict, "count", h->count);
+	set_u64(dict, "sum", h->sum);
+	set_u64(dict, "min", h->min);
+	set_u64(dict, "max", h->max);
+	PyDict_SetItemString(dict, "buckets", obuckets);
+	Py_DECREF(obuckets);
+
+	return dict;
+}
+
+static void lat_capsule_free(PyObject* capsule)
+{
+	free(PyCapsule_GetPointer(capsule, LAT_CAPSULE));
+}
+
+/* Returns the statistics block behind an optional argument, or 0 */
+static struct lat_stats* lat_from_arg(PyObject* ostats)
+{
+	if (! ostats || ostats == Py_None) {
+		return 0;
+	}
+	return (struct lat_stats*) PyCapsule_GetPointer(ostats, LAT_CAPSULE);
+}
+
+static PyObject* latency_stats_new(PyObject* dummy, PyObject* args)
+{
+	struct lat_stats* st;
+
+	if (! PyArg_ParseTuple(args, "")) {
+		return 0;
+	}
+
+	st = (struct lat_stats*) calloc(1, sizeof(struct lat_stats));
+	if (! st) {
+		PyErr_SetString(PyExc_MemoryError, "Out of memory, malloc() failed");
+		return 0;
+	}
+
+	return PyCapsule_New(st, LAT_CAPSULE, lat_capsule_free);
+}
+
+static PyObject* latency_stats_read(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	PyObject* ostats;
+	PyObject* o;
+	struct lat_stats* st;
+	int reset;
+
+	if (! PyArg_ParseTuple(args, "Oi", &ostats, &reset)) {
+		return ret;
+	}
+
+	st = lat_from_arg(ostats);
+	if (! st) {
+		if (! PyErr_Occurred()) {
+			PyErr_SetString(PyExc_ValueError, "Invalid latency statistics object");
+		}
+		return ret;
+	}
+
+	ret = PyDict_New();
+	o = lat_histogram_dict(&(st->send_ns));
+	PyDict_SetItemString(ret, "send_ns", o);
+	Py_DECREF(o);
+	o = lat_histogram_dict(&(st->send_bytes));
+	PyDict_SetItemString(ret, "send_bytes", o);
+	Py_DECREF(o);
+	o = lat_histogram_dict(&(st->recv_ns));
+	PyDict_SetItemString(ret, "recv_ns", o);
+	Py_DECREF(o);
+	o = lat_histogram_dict(&(st->recv_bytes));
+	PyDict_SetItemString(ret, "recv_bytes", o);
+	Py_DECREF(o);
+	o = lat_histogram_dict(&(st->recv_gap_ns));
+	PyDict_SetItemString(ret, "recv_gap_ns", o);
+	Py_DECREF(o);
+	set_u64(ret, "send_eagain", st->send_eagain);
+	set_u64(ret, "send_errors", st->send_errors);
+	set_u64(ret, "recv_eagain", st->recv_eagain);
+	set_u64(ret, "recv_errors", st->recv_errors);
+
+	if (reset) {
+		bzero(st, sizeof(struct lat_stats));
+	}
+
+	return ret;
+}
+
+/* pcapng traffic recording.
+ *
+ * Messages sent and received through sctp_send_msg()/sctp_recv_msg() are
+ * recorded as synthetic IP/SCTP packets with one DATA chunk (LINKTYPE_RAW),
+ * carrying stream, SSN, PPID and TSN, plus a comment with the assoc_id. The
+ * send/receive paths only format the record into a memory buffer under a
+ * mutex; a background thread writes full buffers to disk and rotates files
+ * by size and/or age. When the writer cannot keep up, records are dropped and
+ * counted, so the data path never blocks on disk. SCTP checksums are left
+ * zeroed (Wireshark does not verify them by default).
+ *
+ * The local and peer addresses of each descriptor are looked up once and
+ * kept by the writer until the Socket is closed (pcap_forget()); descriptors
+ * closed by other means keep stale addresses if reused. A message that is
+ * delivered (or sent, with SCTP_EXPLICIT_EOR) in pieces gets the B flag on
+ * its first piece only: the writer remembers the streams whose last record
+ * had no EOR. In a forked child, the writers stop recording. */
+
+#define PCAP_CAPSULE "_sctp.pcap_writer"
+#define PCAP_LINKTYPE_RAW 101
+#define PCAP_MAX_FRAGMENT 65000
+#define PCAP_DIR_IN 1
+#define PCAP_DIR_OUT 2
+// eor argument of pcap_record(): the message ends unless SCTP_EXPLICIT_EOR is on
+#define PCAP_EOR_IMPLICIT -1
+
+struct pcap_endpoint {
+	int known;
+	int have_peer;
+	int explicit_eor;
+	struct sockaddr_storage local;
+	struct sockaddr_storage peer;
+};
+
+// a stream whose last recorded message piece had no EOR
+struct pcap_flow {
+	int fd;
+	int assoc_id;
+	uint16_t stream;
+	uint8_t dir;
+	uint8_t unordered;
+};
+
+struct pcap_writer {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pthread_t thread;
+	int running;
+	int stop;
+
+	// double buffer: producers fill "active", the thread writes "flushing"
+	char* active;
+	char* flushing;
+	size_t used;
+	size_t size;
+
+	char* prefix;
+	uint64_t max_bytes;
+	double max_seconds;
+	uint32_t snaplen;
+
+	FILE* file;
+	char filename[1024];
+	uint64_t file_bytes;
+	double file_opened;
+	unsigned int file_seq;
+	int error;
+
+	uint64_t packets;
+	uint64_t bytes;
+	uint64_t dropped;
+	uint64_t files;
+
+	// used by pcap_record() and pcap_forget() only, under the GIL
+	struct pcap_endpoint* endpoints; // indexed by descriptor
+	int nendpoints;
+	struct pcap_flow* flows;
+	size_t nflows;
+	size_t maxflows;
+
+	struct pcap_writer* next;
+};
+
+// all open writers, for pcap_forget() and the fork handler
+static struct pcap_writer* pcap_writers = 0;
+
+static double realtime_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static size_t pad4(size_t n)
+{
+	return (n + 3) & ~((size_t) 3);
+}
+
+static char* put16(char* p, uint16_t v)
+{
+	memcpy(p, &v, 2);
+	return p + 2;
+}
+
+static char* put32(char* p, uint32_t v)
+{
+	memcpy(p, &v, 4);
+	return p + 4;
+}
+
+/* Opens the next file and writes the Section Header and Interface Description
+ * blocks. Called by the writer thread only. */
+static int pcap_open_file(struct pcap_writer* w)
+{
+	char hdr[48];
+	char stamp[32];
+	char name[sizeof(w->filename)];
+	char* p = hdr;
+	time_t t = time(0);
+	struct tm tm;
+
+	localtime_r(&t, &tm);
+	strftime(stamp, sizeof(stamp), "%Y%m%d%H%M%S", &tm);
+	snprintf(name, sizeof(name), "%s-%s-%u.pcapng", w->prefix, stamp, ++w->file_seq);
+
+	w->file = fopen(name, "wb");
+
+	pthread_mutex_lock(&(w->lock));
+	if (w->file) {
+		strcpy(w->filename, name);
+		w->files++;
+	} else {
+		w->error = errno;
+	}
+	pthread_mutex_unlock(&(w->lock));
+
+	if (! w->file) {
+		return 0;
+	}
+
+	// Section Header Block
+	p = put32(p, 0x0A0D0D0A);
+	p = put32(p, 28);
+	p = put32(p, 0x1A2B3C4D);
+	p = put16(p, 1);
+	p = put16(p, 0);
+	p = put32(p, 0xFFFFFFFF);
+	p = put32(p, 0xFFFFFFFF);
+	p = put32(p, 28);
+
+	// Interface Description Block
+	p = put32(p, 1);
+	p = put32(p, 20);
+	p = put16(p, PCAP_LINKTYPE_RAW);
+	p = put16(p, 0);
+	p = put32(p, w->snaplen);
+	p = put32(p, 20);
+
+	fwrite(hdr, 1, p - hdr, w->file);
+	w->file_bytes = p - hdr;
+	w->file_opened = monotonic_now();
+	return 1;
+}
+
+static void* pcap_thread(void* arg)
+{
+	struct pcap_writer* w = (struct pcap_writer*) arg;
+	int stop = 0;
+
+	while (! stop) {
+		char* buf;
+		size_t len;
+		struct timespec deadline;
+
+		pthread_mutex_lock(&(w->lock));
+		if (! w->used && ! w->stop) {
+			// wake up at least every 200ms so idle files get flushed and rotated
+			clock_gettime(CLOCK_REALTIME, &deadline);
+			deadline.tv_nsec += 200000000;
+			if (deadline.tv_nsec >= 1000000000) {
+				deadline.tv_sec++;
+				deadline.tv_nsec -= 1000000000;
+			}
+			pthread_cond_timedwait(&(w->cond), &(w->lock), &deadline);
+		}
+		buf = w->active;
+		len = w->used;
+		w->active = w->flushing;
+		w->flushing = buf;
+		w->used = 0;
+		stop = w->stop;
+		pthread_mutex_unlock(&(w->lock));
+
+		if (w->file && w->max_seconds > 0 && monotonic_now() - w->file_opened >= w->max_seconds) {
+			fclose(w->file);
+			w->file = 0;
+		}
+
+		// write whole blocks, rotating by size at block boundaries
+		while (len) {
+			size_t seg = 0;
+
+			if (w->file && w->max_bytes && w->file_bytes >= w->max_bytes) {
+				fclose(w->file);
+				w->file = 0;
+			}
+			if (! w->file && ! pcap_open_file(w)) {
+				// the rest of the buffer is lost: count its records
+				uint64_t lost = 0;
+				while (seg < len) {
+					uint32_t lblock;
+					memcpy(&lblock, buf + seg + 4, 4);
+					seg += lblock;
+					lost++;
+				}
+				pthread_mutex_lock(&(w->lock));
+				w->dropped += lost;
+				pthread_mutex_unlock(&(w->lock));
+				break;
+			}
+
+			do {
+				uint32_t lblock;
+				memcpy(&lblock, buf + seg + 4, 4);
+				seg += lblock;
+			} while (seg < len && ! (w->max_bytes && w->file_bytes + seg >= w->max_bytes));
+
+			if (fwrite(buf, 1, seg, w->file) != seg) {
+				pthread_mutex_lock(&(w->lock));
+				w->error = errno;
+				pthread_mutex_unlock(&(w->lock));
+			}
+			w->file_bytes += seg;
+			buf += seg;
+			len -= seg;
+		}
+
+		if (w->file) {
+			fflush(w->file);
+		}
+	}
+
+	if (w->file) {
+		fclose(w->file);
+		w->file = 0;
+	}
+
+	return 0;
+}
+
+/* Writes the IP + SCTP common header + DATA chunk header of a fragment.
+ * Addresses are sockaddr_in or sockaddr_in6 of the same family. */
+static char* pcap_headers(char* p, int dir, const struct sockaddr* local, const struct sockaddr* peer,
+			size_t payload, uint8_t chunk_flags, uint32_t tsn, uint16_t stream, 
+			uint16_t ssn, uint32_t ppid)
+{
+	const struct sockaddr* src = (dir == PCAP_DIR_OUT) ? local : peer;
+	const struct sockaddr* dst = (dir == PCAP_DIR_OUT) ? peer : local;
+	size_t sctp_len = 12 + 16 + pad4(payload);
+	uint16_t sport, dport;
+
+	if (local->sa_family == AF_INET6) {
+		const struct sockaddr_in6* s6 = (const struct sockaddr_in6*) src;
+		const struct sockaddr_in6* d6 = (const struct sockaddr_in6*) dst;
+		p = put32(p, htonl(0x60000000));
+		p = put16(p, htons(sctp_len));
+		*p++ = IPPROTO_SCTP;
+		*p++ = 64;
+		memcpy(p, &(s6->sin6_addr), 16);
+		memcpy(p + 16, &(d6->sin6_addr), 16);
+		p += 32;
+		sport = s6->sin6_port;
+		dport = d6->sin6_port;
+	} else {
+		const struct sockaddr_in* s4 = (const struct sockaddr_in*) src;
+		const struct sockaddr_in* d4 = (const struct sockaddr_in*) dst;
+		uint32_t sum = 0;
+		char* ip = p;
+		int x;
+
+		*p++ = 0x45;
+		*p++ = 0;
+		p = put16(p, htons(20 + sctp_len));
+		p = put32(p, htonl(0x4000)); // id 0, DF
+		*p++ = 64;
+		*p++ = IPPROTO_SCTP;
+		p = put16(p, 0);
+		memcpy(p, &(s4->sin_addr), 4);
+		memcpy(p + 4, &(d4->sin_addr), 4);
+		p += 8;
+		for(x = 0; x < 20; x += 2) {
+			sum += ((uint8_t) ip[x] << 8) | (uint8_t) ip[x + 1];
+		}
+		sum = (sum & 0xFFFF) + (sum >> 16);
+		sum = (sum & 0xFFFF) + (sum >> 16);
+		put16(ip + 10, htons(~sum & 0xFFFF));
+		sport = s4->sin_port;
+		dport = d4->sin_port;
+	}
+
+	// SCTP common header, zero verification tag and checksum
+	p = put16(p, sport);
+	p = put16(p, dport);
+	p = put32(p, 0);
+	p = put32(p, 0);
+
+	// DATA chunk
+	*p++ = 0;
+	*p++ = chunk_flags;
+	p = put16(p, htons(16 + payload));
+	p = put32(p, htonl(tsn));
+	p = put16(p, htons(stream));
+	p = put16(p, htons(ssn));
+	p = put32(p, ppid); // already in network order
+	return p;
+}
+
+static void pcap_endpoint_local(struct pcap_endpoint* e, int fd)
+{
+	socklen_t l = sizeof(e->local);
+
+	bzero(e, sizeof(*e));
+	if (getsockname(fd, (struct sockaddr*) &(e->local), &l) ||
+			(e->local.ss_family != AF_INET && e->local.ss_family != AF_INET6)) {
+		bzero(&(e->local), sizeof(e->local));
+		e->local.ss_family = AF_INET;
+	}
+#ifdef SCTP_EXPLICIT_EOR
+	{
+		int v = 0;
+		l = sizeof(v);
+		if (! getsockopt(fd, SOL_SCTP, SCTP_EXPLICIT_EOR, &v, &l)) {
+			e->explicit_eor = v != 0;
+		}
+	}
+#endif
+	e->known = 1;
+}
+
+static void pcap_endpoint_peer(struct pcap_endpoint* e, int fd)
+{
+	socklen_t l = sizeof(e->peer);
+
+	if (getpeername(fd, (struct sockaddr*) &(e->peer), &l) ||
+			(e->peer.ss_family != AF_INET && e->peer.ss_family != AF_INET6)) {
+		bzero(&(e->peer), sizeof(e->peer));
+		e->peer.ss_family = 0;
+	}
+	e->have_peer = 1;
+}
+
+/* Returns the cached addresses of fd, or 0 if the cache cannot grow */
+static struct pcap_endpoint* pcap_endpoint(struct pcap_writer* w, int fd)
+{
+	if (fd < 0) {
+		return 0;
+	}
+	if (fd >= w->nendpoints) {
+		int n = w->nendpoints ? w->nendpoints : 64;
+		struct pcap_endpoint* e;
+
+		while (n <= fd) {
+			n *= 2;
+		}
+		e = (struct pcap_endpoint*) realloc(w->endpoints, n * sizeof(*e));
+		if (! e) {
+			return 0;
+		}
+		bzero(e + w->nendpoints, (n - w->nendpoints) * sizeof(*e));
+		w->endpoints = e;
+		w->nendpoints = n;
+	}
+	if (! w->endpoints[fd].known) {
+		pcap_endpoint_local(&(w->endpoints[fd]), fd);
+	}
+	return &(w->endpoints[fd]);
+}
+
+/* Returns whether a record of the flow begins a message, that is, whether
+ * the previous one ended with EOR, and remembers whether this one does */
+static int pcap_flow_begins(struct pcap_writer* w, int fd, int assoc_id, uint16_t stream,
+			int dir, int unordered, int eor)
+{
+	size_t x;
+
+	for(x = 0; x < w->nflows; ++x) {
+		struct pcap_flow* f = &(w->flows[x]);
+		if (f->fd == fd && f->assoc_id == assoc_id && f->stream == stream && 
+				f->dir == dir && f->unordered == unordered) {
+			if (eor) {
+				w->flows[x] = w->flows[--w->nflows];
+			}
+			return 0;
+		}
+	}
+
+	if (! eor) {
+		if (w->nflows == w->maxflows) {
+			size_t n = w->maxflows ? 2 * w->maxflows : 16;
+			struct pcap_flow* f = (struct pcap_flow*) realloc(w->flows, n * sizeof(*f));
+			if (! f) {
+				// the next piece will show as a new message
+				return 1;
+			}
+			w->flows = f;
+			w->maxflows = n;
+		}
+		w->flows[w->nflows].fd = fd;
+		w->flows[w->nflows].assoc_id = assoc_id;
+		w->flows[w->nflows].stream = stream;
+		w->flows[w->nflows].dir = dir;
+		w->flows[w->nflows].unordered = unordered;
+		w->nflows++;
+	}
+	return 1;
+}
+
+/* Drops what the writers know about fd; called when a Socket is closed or
+ * detached, and when its SCTP_EXPLICIT_EOR setting changes */
+static void pcap_forget(int fd)
+{
+	struct pcap_writer* w;
+	size_t x;
+
+	for(w = pcap_writers; w; w = w->next) {
+		if (fd >= 0 && fd < w->nendpoints) {
+			w->endpoints[fd].known = 0;
+			w->endpoints[fd].have_peer = 0;
+		}
+		for(x = 0; x < w->nflows; ) {
+			if (w->flows[x].fd == fd) {
+				w->flows[x] = w->flows[--w->nflows];
+			} else {
+				++x;
+			}
+		}
+	}
+}
+
+/* The writer thread does not exist in a forked child: stop recording there,
+ * with a fresh mutex in case the thread held it at fork time */
+static void pcap_atfork_child(void)
+{
+	struct pcap_writer* w;
+
+	for(w = pcap_writers; w; w = w->next) {
+		pthread_mutex_init(&(w->lock), 0);
+		pthread_cond_init(&(w->cond), 0);
+		w->running = 0;
+		w->stop = 1;
+	}
+}
+
+/* Records one message, or one piece of it, split in as many DATA chunks as
+ * needed. eor is 1 if the message ends here, 0 if not, PCAP_EOR_IMPLICIT if
+ * it does unless the socket uses SCTP_EXPLICIT_EOR. Called with the GIL held;
+ * only takes the writer mutex. */
+static void pcap_record(struct pcap_writer* w, int fd, int dir, const struct sockaddr* peer,
+			const char* data, size_t len, int unordered, int eor, uint16_t stream, 
+			uint16_t ssn, uint32_t ppid, uint32_t tsn, int assoc_id)
+{
+	struct pcap_endpoint uncached;
+	struct pcap_endpoint* e;
+	struct sockaddr_storage slocal, speer;
+	size_t off = 0;
+	char comment[96];
+	size_t lcomment;
+	double now = realtime_now();
+	uint64_t usec = (uint64_t) (now * 1e6);
+	int begins;
+
+	e = pcap_endpoint(w, fd);
+	if (! e) {
+		e = &uncached;
+		pcap_endpoint_local(e, fd);
+	}
+	memcpy(&slocal, &(e->local), sizeof(slocal));
+	bzero(&speer, sizeof(speer));
+	if (peer && (peer->sa_family == AF_INET || peer->sa_family == AF_INET6)) {
+		memcpy(&speer, peer, peer->sa_family == AF_INET ? sizeof(struct sockaddr_in) : 
+							sizeof(struct sockaddr_in6));
+	} else {
+		if (! e->have_peer) {
+			pcap_endpoint_peer(e, fd);
+		}
+		memcpy(&speer, &(e->peer), sizeof(speer));
+		if (! speer.ss_family) {
+			speer.ss_family = slocal.ss_family;
+		}
+	}
+
+	if (eor == PCAP_EOR_IMPLICIT) {
+		eor = ! e->explicit_eor;
+	}
+	begins = pcap_flow_begins(w, fd, assoc_id, stream, dir, unordered != 0, eor);
+
+	if (slocal.ss_family != speer.ss_family) {
+		// e.g. IPv4 peer on an IPv6 socket; log the peer as a v4-mapped address
+		if (speer.ss_family == AF_INET) {
+			struct sockaddr_in v4;
+			struct sockaddr_in6* v6 = (struct sockaddr_in6*) &speer;
+			memcpy(&v4, &speer, sizeof(v4));
+			bzero(&speer, sizeof(speer));
+			v6->sin6_family = AF_INET6;
+			v6->sin6_port = v4.sin_port;
+			v6->sin6_addr.s6_addr[10] = 0xFF;
+			v6->sin6_addr.s6_addr[11] = 0xFF;
+			memcpy(&(v6->sin6_addr.s6_addr[12]), &(v4.sin_addr), 4);
+		} else {
+			bzero(&speer, sizeof(speer));
+			speer.ss_family = slocal.ss_family;
+		}
+	}
+
+	lcomment = snprintf(comment, sizeof(comment), "assoc_id=%d", assoc_id);
+
+	do {
+		size_t chunk = len - off;
+		size_t iplen = (slocal.ss_family == AF_INET6) ? 40 : 20;
+		size_t pktlen, caplen, need;
+		uint8_t chunk_flags = 0;
+		char* p;
+
+		if (chunk > PCAP_MAX_FRAGMENT) {
+			chunk = PCAP_MAX_FRAGMENT;
+		}
+		if (off == 0 && begins) {
+			chunk_flags |= 0x02; // B
+		}
+		if (off + chunk == len && eor) {
+			chunk_flags |= 0x01; // E
+		}
+		if (unordered) {
+			chunk_flags |= 0x04; // U
+		}
+
+		pktlen = iplen + 12 + 16 + pad4(chunk);
+		caplen = (w->snaplen && pktlen > w->snaplen) ? w->snaplen : pktlen;
+		need = 28 + pad4(caplen) + 8 + 4 + pad4(lcomment) + 4 + 4;
+
+		pthread_mutex_lock(&(w->lock));
+		if (w->used + need > w->size || ! w->running) {
+			w->dropped++;
+			pthread_mutex_unlock(&(w->lock));
+			return;
+		}
+
+		p = w->active + w->used;
+		bzero(p, need);
+		p = put32(p, 6);
+		p = put32(p, need);
+		p = put32(p, 0);
+		p = put32(p, (uint32_t) (usec >> 32));
+		p = put32(p, (uint32_t) usec);
+		p = put32(p, caplen);
+		p = put32(p, pktlen);
+
+		{
+			char pkt[40 + 12 + 16];
+			char* end = pcap_headers(pkt, dir, (struct sockaddr*) &slocal, (struct sockaddr*) &speer,
+						 chunk, chunk_flags, tsn, stream, ssn, ppid);
+			size_t lhdr = end - pkt;
+			if (lhdr > caplen) {
+				lhdr = caplen;
+			}
+			memcpy(p, pkt, lhdr);
+			if (caplen > lhdr) {
+				size_t ldata = caplen - lhdr;
+				if (ldata > chunk) {
+					ldata = chunk;
+				}
+				memcpy(p + lhdr, data + off, ldata);
+			}
+			p += pad4(caplen);
+		}
+
+		// options: epb_flags (direction), comment, end of options
+		p = put16(p, 2);
+		p = put16(p, 4);
+		p = put32(p, dir);
+		p = put16(p, 1);
+		p = put16(p, lcomment);
+		memcpy(p, comment, lcomment);
+		p += pad4(lcomment);
+		p = put32(p, 0);
+		p = put32(p, need);
+
+		w->used += need;
+		w->packets++;
+		w->bytes += chunk;
+		if (w->used > w->size / 2) {
+			pthread_cond_signal(&(w->cond));
+		}
+		pthread_mutex_unlock(&(w->lock));
+
+		off += chunk;
+		tsn++;
+	} while (off < len);
+}
+
+static void pcap_stop(struct pcap_writer* w)
+{
+	if (w->running) {
+		pthread_mutex_lock(&(w->lock));
+		w->stop = 1;
+		w->running = 0;
+		pthread_cond_signal(&(w->cond));
+		pthread_mutex_unlock(&(w->lock));
+
+		Py_BEGIN_ALLOW_THREADS
+		pthread_join(w->thread, 0);
+		Py_END_ALLOW_THREADS
+	}
+}
+
+static void pcap_capsule_free(PyObject* capsule)
+{
+	struct pcap_writer* w = (struct pcap_writer*) PyCapsule_GetPointer(capsule, PCAP_CAPSULE);
+
+	if (w) {
+		struct pcap_writer** pw;
+
+		pcap_stop(w);
+		for(pw = &pcap_writers; *pw; pw = &((*pw)->next)) {
+			if (*pw == w) {
+				*pw = w->next;
+				break;
+			}
+		}
+		pthread_mutex_destroy(&(w->lock));
+		pthread_cond_destroy(&(w->cond));
+		free(w->endpoints);
+		free(w->flows);
+		free(w->active);
+		free(w->flushing);
+		free(w->prefix);
+		free(w);
+	}
+}
+
+/* Returns the writer behind an optional argument, or 0 */
+static struct pcap_writer* pcap_from_arg(PyObject* owriter)
+{
+	if (! owriter || owriter == Py_None) {
+		return 0;
+	}
+	return (struct pcap_writer*) PyCapsule_GetPointer(owriter, PCAP_CAPSULE);
+}
+
+static PyObject* pcap_open(PyObject* dummy, PyObject* args)
+{
+	struct pcap_writer* w;
+	const char* prefix;
+	unsigned long long max_bytes;
+	double max_seconds;
+	Py_ssize_t buffer_size;
+	unsigned int snaplen;
+	static int atfork = 0;
+
+	if (! PyArg_ParseTuple(args, "sKdnI", &prefix, &max_bytes, &max_seconds, &buffer_size, &snaplen)) {
+		return 0;
+	}
+
+	if (! atfork) {
+		if (pthread_atfork(0, 0, pcap_atfork_child)) {
+			PyErr_SetFromErrno(PyExc_OSError);
+			return 0;
+		}
+		atfork = 1;
+	}
+
+	if (buffer_size < 65536) {
+		PyErr_SetString(PyExc_ValueError, "buffer size must be at least 64KB");
+		return 0;
+	}
+
+	w = (struct pcap_writer*) calloc(1, sizeof(struct pcap_writer));
+	if (w) {
+		w->active = (char*) malloc(buffer_size);
+		w->flushing = (char*) malloc(buffer_size);
+		w->prefix = strdup(prefix);
+	}
+	if (! w || ! w->active || ! w->flushing || ! w->prefix) {
+		if (w) {
+			free(w->active);
+			free(w->flushing);
+			free(w->prefix);
+			free(w);
+		}
+		PyErr_SetString(PyExc_MemoryError, "Out of memory, malloc() failed");
+		return 0;
+	}
+
+	w->size = buffer_size;
+	w->max_bytes = max_bytes;
+	w->max_seconds = max_seconds;
+	w->snaplen = snaplen;
+	pthread_mutex_init(&(w->lock), 0);
+	pthread_cond_init(&(w->cond), 0);
+
+	if (pthread_create(&(w->thread), 0, pcap_thread, w)) {
+		pthread_mutex_destroy(&(w->lock));
+		pthread_cond_destroy(&(w->cond));
+		free(w->active);
+		free(w->flushing);
+		free(w->prefix);
+		free(w);
+		PyErr_SetFromErrno(PyExc_OSError);
+		return 0;
+	}
+	w->running = 1;
+	w->next = pcap_writers;
+	pcap_writers = w;
+
+	return PyCapsule_New(w, PCAP_CAPSULE, pcap_capsule_free);
+}
+
+static PyObject* pcap_close(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	PyObject* owriter;
+	struct pcap_writer* w;
+
+	if (! PyArg_ParseTuple(args, "O", &owriter)) {
+		return ret;
+	}
+
+	w = pcap_from_arg(owriter);
+	if (! w) {
+		if (! PyErr_Occurred()) {
+			PyErr_SetString(PyExc_ValueError, "Invalid pcap writer object");
+		}
+		return ret;
+	}
+
+	pcap_stop(w);
+
+	ret = Py_None; Py_INCREF(ret);
+	return ret;
+}
+
+static PyObject* pcap_stats(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	PyObject* owriter;
+	PyObject* o;
+	struct pcap_writer* w;
+
+	if (! PyArg_ParseTuple(args, "O", &owriter)) {
+		return ret;
+	}
+
+	w = pcap_from_arg(owriter);
+	if (! w) {
+		if (! PyErr_Occurred()) {
+			PyErr_SetString(PyExc_ValueError, "Invalid pcap writer object");
+		}
+		return ret;
+	}
+
+	ret = PyDict_New();
+	pthread_mutex_lock(&(w->lock));
+	set_u64(ret, "packets", w->packets);
+	set_u64(ret, "bytes", w->bytes);
+	set_u64(ret, "dropped", w->dropped);
+	set_u64(ret, "files", w->files);
+	set_u64(ret, "error", w->error);
+	o = PyUnicode_FromString(w->filename);
+	pthread_mutex_unlock(&(w->lock));
+	PyDict_SetItemString(ret, "filename", o);
+	Py_DECREF(o);
+	o = PyBool_FromLong(w->running);
+	PyDict_SetItemString(ret, "running", o);
+	Py_DECREF(o);
+
+	return ret;
+}
+
+/* Parses the destination of a send: an (address, port) tuple, an association
+ * ID, or NULL for the peer of a TCP-style socket. *sto_len is left at zero
+ * when no address is to be passed to the kernel. */
+static int send_dest(PyObject* oto, long* assoc_id, struct sockaddr_storage* sto, int* sto_len)
+{
+	char *to = "";
+	int port = 0;
+
+	*assoc_id = -1;
+	*sto_len = 0;
+
+	if (! oto) {
+		// default destination
+	} else if (Py23_PyLong_Check(oto)) {
+		*assoc_id = Py23_PyLong_AsLong(oto);
+		if (*assoc_id == -1 && PyErr_Occurred()) {
+			return 0;
+		}
+	} else if (! PyTuple_Check(oto)) {
+		PyErr_SetString(PyExc_TypeError, "Destination must be an (address, port) tuple or an assoc_id");
+		return 0;
+	} else if (! PyArg_ParseTuple(oto, "si", &to, &port)) {
+		return 0;
+	}
+
+	if (*assoc_id < 0 && strlen(to) > 0) {
+		if (! to_sockaddr(to, port, (struct sockaddr*) sto, sto_len)) {
+			PyErr_SetString(PyExc_ValueError, "Invalid Address");
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* sctp_sendmsg() with sendmsg() flags, which libsctp does not take */
+static ssize_t sendmsg_sndrcv(int fd, const char* msg, size_t msg_len, const struct sockaddr* to,
+				socklen_t tolen, const struct sctp_sndrcvinfo* sinfo, int msg_flags)
+{
+	struct msghdr m;
+	struct iovec iov;
+	char cbuf[CMSG_SPACE(sizeof(struct sctp_sndrcvinfo))];
+	struct cmsghdr* c;
+
+	bzero(&m, sizeof(m));
+	bzero(cbuf, sizeof(cbuf));
+	iov.iov_base = (void*) msg;
+	iov.iov_len = msg_len;
+	m.msg_name = (void*) to;
+	m.msg_namelen = tolen;
+	m.msg_iov = &iov;
+	m.msg_iovlen = 1;
+	m.msg_control = cbuf;
+	m.msg_controllen = sizeof(cbuf);
+
+	c = CMSG_FIRSTHDR(&m);
+	c->cmsg_level = IPPROTO_SCTP;
+	c->cmsg_type = SCTP_SNDRCV;
+	c->cmsg_len = CMSG_LEN(sizeof(struct sctp_sndrcvinfo));
+	memcpy(CMSG_DATA(c), sinfo, sizeof(struct sctp_sndrcvinfo));
+
+	return sendmsg(fd, &m, msg_flags);
+}
+
+/* The send syscall proper, for a destination parsed by send_dest(); it does
+ * not touch Python objects and is called with the GIL released. msg_flags
+ * are sendmsg() flags, e.g. MSG_DONTWAIT. */
+static ssize_t send_raw(int fd, const char* msg, size_t msg_len, long assoc_id,
+			const struct sockaddr_storage* sto, int sto_len, int ppid, int flags,
+			int stream, unsigned int ttl, int context, int msg_flags)
+{
+	struct sctp_sndrcvinfo sinfo;
+
+	bzero(&sinfo, sizeof(sinfo));
+	sinfo.sinfo_stream = stream;
+	sinfo.sinfo_flags = flags;
+	sinfo.sinfo_ppid = ppid;
+	sinfo.sinfo_context = context;
+	sinfo.sinfo_timetolive = ttl;
+	if (assoc_id >= 0) {
+		sinfo.sinfo_assoc_id = assoc_id;
+		return sctp_send(fd, msg, msg_len, &sinfo, msg_flags);
+	}
+	if (msg_flags) {
+		return sendmsg_sndrcv(fd, msg, msg_len, sto_len ? (struct sockaddr*) sto : 0, sto_len,
+					&sinfo, msg_flags);
+	}
+	// no address: the special case that must pass NULL
+	return sctp_sendmsg(fd, msg, msg_len, sto_len ? (struct sockaddr*) sto : 0, sto_len, 
+				ppid, flags, stream, ttl, context);
+}
+
+/* send_raw() that waits for room in the send buffer, whether the socket is
+ * blocking or not: every attempt is MSG_DONTWAIT, and poll() waits in
+ * between. timeout in milliseconds, negative to wait forever. */
+static int send_wait(int fd, const char* msg, size_t msg_len, long assoc_id,
+			const struct sockaddr_storage* sto, int sto_len, int ppid, int flags,
+			int stream, unsigned int ttl, int context, int timeout, ssize_t* sent)
+{
+	struct pollfd p;
+	int r;
+
+	for(;;) {
+		*sent = send_raw(fd, msg, msg_len, assoc_id, sto, sto_len, ppid, flags, stream, ttl, 
+					context, MSG_DONTWAIT);
+		if (*sent >= 0) {
+			return 0;
+		}
+		if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			return errno;
+		}
+		p.fd = fd;
+		p.events = POLLOUT;
+		r = poll(&p, 1, timeout);
+		if (r < 0) {
+			return errno;
+		}
+		if (r == 0) {
+			return ETIMEDOUT;
+		}
+	}
+}
+
+// sctp_sendmsg() flag ending a message on a socket with SCTP_EXPLICIT_EOR on
+#ifdef SCTP_EOR
+#define SEND_EOR SCTP_EOR
+#else
+#define SEND_EOR MSG_EOR
+#endif
+
+/* Sends a message to an (address, port) tuple, to an association ID, or to
+ * the peer of a TCP-style socket when oto is NULL. Shared by sctp_send_msg(),
+ * Socket.sctp_send() and, with wait set, Socket._send_chunk(): the message
+ * then waits for room in the send buffer as in send_wait(). */
+static PyObject* send_msg(int fd, const char* msg, Py_ssize_t msg_len, PyObject* oto, int ppid,
+				int flags, int stream, unsigned int ttl, int context,
+				struct lat_stats* stats, struct pcap_writer* writer, int wait, int timeout)
+{
+	ssize_t size_sent;
+	long assoc_id;
+	struct sockaddr_storage sto;
+	int sto_len;
+
+	uint64_t start = 0;
+	int err;
+
+	if (! send_dest(oto, &assoc_id, &sto, &sto_len)) {
+		return 0;
+	}
+
+	if (msg_len <= 0 && (! (flags & MSG_EOF))) {
+		PyErr_SetString(PyExc_ValueError, "Empty messages are not allowed, except if coupled with the MSG_EOF flag.");
+		return 0;
+	}
+
+	if (stats) {
+		start = monotonic_ns();
+	}
+
+	for(;;) {
+		Py_BEGIN_ALLOW_THREADS
+		if (wait) {
+			err = send_wait(fd, msg, msg_len, assoc_id, &sto, sto_len, ppid, flags, stream, 
+					ttl, context, timeout, &size_sent);
+		} else {
+			size_sent = send_raw(fd, msg, msg_len, assoc_id, &sto, sto_len, ppid, flags, stream, 
+						ttl, context, 0);
+			err = errno;
+		}
+		Py_END_ALLOW_THREADS
+
+		if (! wait || err != EINTR) {
+			break;
+		}
+		if (PyErr_CheckSignals()) {
+			return 0;
+		}
+	}
+
+	if (stats) {
+		lat_record_call(stats, 1, start, size_sent, err);
+	}
+
+	if (size_sent < 0) {
+		errno = err;
+		PyErr_SetFromErrno(PyExc_IOError);
+		return 0;
+	}
+
+	if (writer && size_sent > 0) {
+		// the kernel assigns SSN and TSN, so they are unknown here
+		pcap_record(writer, fd, PCAP_DIR_OUT, sto_len ? (struct sockaddr*) &sto : 0, msg, size_sent, 
+				flags & MSG_UNORDERED, (flags & SEND_EOR) ? 1 : PCAP_EOR_IMPLICIT, 
+				stream, 0, ppid, 0, assoc_id);
+	}
+
+	return PyLong_FromSsize_t(size_sent);
+}
+
+static PyObject* sctp_send_msg(PyObject* dummy, PyObject* args)
+{
+	Py_buffer msgbuf;
+	int fd, flags, stream, context;
+	unsigned int ttl;
+	int ppid;
+	PyObject *oto;
+
+	PyObject *ostats = 0;
+	struct lat_stats* stats;
+
+	PyObject *owriter = 0;
+	struct pcap_writer* writer;
+
+	PyObject *ret = 0;
+
+	// any bytes-like object, so messages can be built in a reusable bytearray
+	if (! PyArg_ParseTuple(args, "is*OiiiIi|OO", &fd, &msgbuf, &oto, 
+					&ppid, &flags, &stream, &ttl, &context, &ostats, &owriter)) {
+		return ret;
+	}
+
+	stats = lat_from_arg(ostats);
+	writer = pcap_from_arg(owriter);
+	if (! PyErr_Occurred()) {
+		ret = send_msg(fd, (const char*) msgbuf.buf, msgbuf.len, oto, ppid, flags, stream, ttl, 
+				context, stats, writer, 0, 0);
+	}
+
+	PyBuffer_Release(&msgbuf);
+	return ret;
+}
+
+/* Chunked transmission of a file descriptor, for Socket._send_file().
+ * Every chunk goes out as one message, or, with eor set, as one piece of a
+ * single message, on a socket where SCTP_EXPLICIT_EOR is on; the last piece
+ * then carries the EOR flag. */
+
+/* Reads from src until buf holds size bytes or the source ends. *left, when
+ * not negative, is what may still be read. Returns 0 or an errno value, with
+ * the progress kept in *have so that the read can be resumed. */
+static int fill_chunk(int src, char* buf, Py_ssize_t size, Py_ssize_t* have, long long* offset,
+			long long* left, int* eof)
+{
+	ssize_t n;
+	size_t want;
+
+	while (*have < size && ! *eof) {
+		want = size - *have;
+		if (*left >= 0 && (long long) want > *left) {
+			want = *left;
+		}
+		if (want == 0) {
+			*eof = 1;
+			break;
+		}
+		if (*offset >= 0) {
+			n = pread(src, buf + *have, want, (off_t) *offset);
+		} else {
+			n = read(src, buf + *have, want);
+		}
+		if (n < 0) {
+			return errno;
+		}
+		if (n == 0) {
+			*eof = 1;
+			break;
+		}
+		*have += n;
+		if (*offset >= 0) {
+			*offset += n;
+		}
+		if (*left >= 0) {
+			*left -= n;
+		}
+	}
+	return 0;
+}
+
+static PyObject* send_file(int fd, int src, long long offset, long long left, Py_ssize_t chunk,
+				PyObject* oto, int ppid, int flags, int stream, unsigned int ttl, 
+				int context, int eor, int timeout, struct lat_stats* stats, 
+				struct pcap_writer* writer)
+{
+	int send_flags;
+	long assoc_id;
+	struct sockaddr_storage sto;
+	int sto_len;
+
+	char* buf;
+	char* cur;
+	char* nxt = 0;
+	char* tmp;
+	Py_ssize_t len = 0, nlen = 0;
+	int eof = 0;
+	long long total = 0;
+	ssize_t sent;
+	uint64_t start = 0;
+	int err;
+
+	if (chunk <= 0) {
+		PyErr_SetString(PyExc_ValueError, "chunk size must be positive");
+		return 0;
+	}
+	if (! send_dest(oto, &assoc_id, &sto, &sto_len)) {
+		return 0;
+	}
+
+	// with EOR, the next chunk is read ahead to know which one is the last
+	buf = malloc(eor ? 2 * chunk : chunk);
+	if (! buf) {
+		PyErr_SetString(PyExc_MemoryError, "Out of memory, malloc() failed");
+		return 0;
+	}
+	cur = buf;
+	if (eor) {
+		nxt = buf + chunk;
+	}
+
+	for(;;) {
+		sent = 0;
+		send_flags = flags;
+
+		Py_BEGIN_ALLOW_THREADS
+		err = fill_chunk(src, cur, chunk, &len, &offset, &left, &eof);
+		if (! err && eor && ! eof) {
+			err = fill_chunk(src, nxt, chunk, &nlen, &offset, &left, &eof);
+		}
+		if (! err && len > 0) {
+			if (stats) {
+				start = monotonic_ns();
+			}
+			if (eor && eof && ! nlen) {
+				send_flags |= SEND_EOR;
+			}
+			err = send_wait(fd, cur, len, assoc_id, &sto, sto_len, ppid, send_flags, 
+					stream, ttl, context, timeout, &sent);
+		}
+		Py_END_ALLOW_THREADS
+
+		if (stats && len > 0 && err != EINTR && err != ETIMEDOUT) {
+			lat_record_call(stats, 1, start, err ? -1 : sent, err);
+		}
+		if (sent > 0) {
+			if (writer) {
+				pcap_record(writer, fd, PCAP_DIR_OUT, sto_len ? (struct sockaddr*) &sto : 0, 
+						cur, sent, flags & MSG_UNORDERED, 
+						eor ? (send_flags & SEND_EOR) != 0 : PCAP_EOR_IMPLICIT, 
+						stream, 0, ppid, 0, assoc_id);
+			}
+			total += sent;
+			len = 0;
+			if (eor) {
+				tmp = cur;
+				cur = nxt;
+				nxt = tmp;
+				len = nlen;
+				nlen = 0;
+			}
+		}
+
+		if (err && err != EINTR) {
+			free(buf);
+			errno = err;
+			return PyErr_SetFromErrno(PyExc_IOError);
+		}
+		if (eof && ! len) {
+			break;
+		}
+		// long transfers stay interruptible
+		if (PyErr_CheckSignals()) {
+			free(buf);
+			return 0;
+		}
+	}
+
+	free(buf);
+	return PyLong_FromLongLong(total);
+}
+
+static PyObject* get_explicit_eor(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	int fd;
+
+	if (PyArg_ParseTuple(args, "i", &fd)) {
+#ifdef SCTP_EXPLICIT_EOR
+		int v;
+		socklen_t lv = sizeof(v);
 
+		if (getsockopt(fd, SOL_SCTP, SCTP_EXPLICIT_EOR, &v, &lv)) {
+			PyErr_SetFromErrno(PyExc_IOError);
+		} else {
+			ret = PyBool_FromLong(v);
 		}
+#else
+		errno = ENOPROTOOPT;
+		PyErr_SetFromErrno(PyExc_IOError);
+#endif
 	}
-
 	return ret;
 }
 
-static PyObject* sctp_send_msg(PyObject* dummy, PyObject* args)
+static PyObject* set_explicit_eor(PyObject* dummy, PyObject* args)
 {
-	Py_ssize_t msg_len;
-	int fd, size_sent, flags, stream, ttl, context;
-	int ppid;
-	const char *msg;
-	char *to;
-	int port;
-
-	struct sockaddr_storage sto;
-	struct sockaddr_storage *psto = &sto;
-	int sto_len;
-
-	PyObject *ret = 0;
-
-	if (! PyArg_ParseTuple(args, "is#(si)iiiii", &fd, &msg, &msg_len, &to, &port, 
-					&ppid, &flags, &stream, &ttl, &context)) {
-		return ret;
-	}
-
-	if (msg_len <= 0 && (! (flags & MSG_EOF))) {
-		PyErr_SetString(PyExc_ValueError, "Empty messages are not allowed, except if coupled with the MSG_EOF flag.");
-		return ret;
-	}
+	PyObject* ret = 0;
+	int fd, v;
 
-	if (strlen(to) == 0) {
-		// special case: should pass NULL 
-		sto_len = 0;
-		psto = 0;
-	} else {
-		if (! to_sockaddr(to, port, (struct sockaddr*) psto, &sto_len)) {
-			PyErr_SetString(PyExc_ValueError, "Invalid Address");
-			return ret;
+	if (PyArg_ParseTuple(args, "ii", &fd, &v)) {
+#ifdef SCTP_EXPLICIT_EOR
+		if (setsockopt(fd, SOL_SCTP, SCTP_EXPLICIT_EOR, &v, sizeof(v))) {
+			PyErr_SetFromErrno(PyExc_IOError);
+		} else {
+			// recorded messages end differently now
+			pcap_forget(fd);
+			ret = Py_None; Py_INCREF(ret);
 		}
-	}
-
-	Py_BEGIN_ALLOW_THREADS
-	size_sent = sctp_sendmsg(fd, msg, msg_len, (struct sockaddr*) psto, sto_len, ppid, 
-					flags, stream, ttl, context);
-	Py_END_ALLOW_THREADS
-
-	if (size_sent < 0) {
+#else
+		errno = ENOPROTOOPT;
 		PyErr_SetFromErrno(PyExc_IOError);
-		return ret;
+#endif
 	}
-
-	ret = Py23_PyLong_FromLong(size_sent);
 	return ret;
 }
 
@@ -1808,6 +6050,12 @@ void interpret_notification(PyObject* dict, const void *pnotif, int size)
 		const struct sctp_pdapi_event* n = &(notif->sn_pdapi_event);
 		PyDict_SetItemString(dict, "indication", Py23_PyLong_FromLong(n->pdapi_indication));
 		PyDict_SetItemString(dict, "assoc_id", Py23_PyLong_FromLong(n->pdapi_assoc_id));
+#ifdef HAVE_SCTP_PDAPI_STREAM
+		// added along with I-DATA; identifies the aborted message. Probed
+		// by setup.py and the Makefile, as no macro comes with the fields.
+		PyDict_SetItemString(dict, "stream", Py23_PyLong_FromLong(n->pdapi_stream));
+		PyDict_SetItemString(dict, "seq", Py23_PyLong_FromLong(n->pdapi_seq));
+#endif
 		}
 		break;
 	case SCTP_ADAPTATION_INDICATION:
@@ -1817,14 +6065,51 @@ void interpret_notification(PyObject* dict, const void *pnotif, int size)
 		PyDict_SetItemString(dict, "assoc_id", Py23_PyLong_FromLong(n->sai_assoc_id));
 		}
 		break;
+#ifdef SCTP_STREAM_RESET_EVENT
+	case SCTP_STREAM_RESET_EVENT:
+		{
+		const struct sctp_stream_reset_event* n = &(notif->sn_strreset_event);
+		int count = (size - (int) sizeof(struct sctp_stream_reset_event)) / (int) sizeof(uint16_t);
+		PyObject* ostreams;
+		int x;
+
+		if (count < 0) {
+			count = 0;
+		}
+
+		ostreams = PyTuple_New(count);
+		for(x = 0; x < count; ++x) {
+			PyTuple_SetItem(ostreams, x, Py23_PyLong_FromLong(n->strreset_stream_list[x]));
+		}
+
+		PyDict_SetItemString(dict, "assoc_id", Py23_PyLong_FromLong(n->strreset_assoc_id));
+		PyDict_SetItemString(dict, "stream_list", ostreams);
+		}
+		break;
+	case SCTP_ASSOC_RESET_EVENT:
+		{
+		const struct sctp_assoc_reset_event* n = &(notif->sn_assocreset_event);
+		PyDict_SetItemString(dict, "assoc_id", Py23_PyLong_FromLong(n->assocreset_assoc_id));
+		PyDict_SetItemString(dict, "local_tsn", PyLong_FromUnsignedLong(n->assocreset_local_tsn));
+		PyDict_SetItemString(dict, "remote_tsn", PyLong_FromUnsignedLong(n->assocreset_remote_tsn));
+		}
+		break;
+	case SCTP_STREAM_CHANGE_EVENT:
+		{
+		const struct sctp_stream_change_event* n = &(notif->sn_strchange_event);
+		PyDict_SetItemString(dict, "assoc_id", Py23_PyLong_FromLong(n->strchange_assoc_id));
+		PyDict_SetItemString(dict, "instrms", Py23_PyLong_FromLong(n->strchange_instrms));
+		PyDict_SetItemString(dict, "outstrms", Py23_PyLong_FromLong(n->strchange_outstrms));
+		}
+		break;
+#endif
 	}
 }
 
-static PyObject* sctp_recv_msg(PyObject* dummy, PyObject* args)
+/* Receives a message or a notification, as a (fromaddr, flags, msg, dict)
+ * tuple. Shared by sctp_recv_msg() and Socket.sctp_recv(). */
+static PyObject* recv_msg(int fd, size_t max_len, struct lat_stats* stats, struct pcap_writer* writer)
 {
-	int fd;
-	size_t max_len;
-
 	struct sockaddr_storage sfrom;
 	socklen_t sfrom_len = sizeof(sfrom);
 	int family;
@@ -1836,13 +6121,12 @@ static PyObject* sctp_recv_msg(PyObject* dummy, PyObject* args)
 	int flags = 0;
 	struct sctp_sndrcvinfo sinfo;
 
-	PyObject* notification = PyDict_New();
+	uint64_t start = 0;
+	int err;
+
+	PyObject* notification;
 	PyObject* ret = 0;
 	PyObject* oaddr = 0;
-	
-	if (! PyArg_ParseTuple(args, "in", &fd, &max_len)) {
-		return ret;
-	}
 
 	msg = malloc(max_len);
 	if (! msg) {
@@ -1853,21 +6137,39 @@ static PyObject* sctp_recv_msg(PyObject* dummy, PyObject* args)
 	bzero(&sfrom, sizeof(sfrom));
 	bzero(&sinfo, sizeof(sinfo));
 
+	if (stats) {
+		start = monotonic_ns();
+	}
+
 	Py_BEGIN_ALLOW_THREADS
 	size = sctp_recvmsg(fd, msg, max_len, (struct sockaddr*) &sfrom, &sfrom_len, &sinfo, &flags);
+	err = errno;
 	Py_END_ALLOW_THREADS
 
+	if (stats) {
+		lat_record_call(stats, 0, start, size, err);
+	}
+
 	if (size < 0) {
 		free(msg);
+		errno = err;
 		PyErr_SetFromErrno(PyExc_IOError);
 		return ret;
 	}
 
+	notification = PyDict_New();
+
 	if (flags & MSG_NOTIFICATION) {
 		interpret_notification(notification, msg, size);
 		size = -1;
 	} else {
 		interpret_sndrcvinfo(notification, &sinfo);
+		if (writer && size > 0) {
+			pcap_record(writer, fd, PCAP_DIR_IN, (struct sockaddr*) &sfrom, msg, size, 
+					sinfo.sinfo_flags & SCTP_UNORDERED, flags & MSG_EOR, 
+					sinfo.sinfo_stream, sinfo.sinfo_ssn, sinfo.sinfo_ppid, 
+					sinfo.sinfo_tsn, sinfo.sinfo_assoc_id);
+		}
 	}
 
 	if (from_sockaddr((struct sockaddr*) &sfrom, &family, &len, &port, cfrom, sizeof(cfrom))) {
@@ -1895,3 +6197,709 @@ static PyObject* sctp_recv_msg(PyObject* dummy, PyObject* args)
 	return ret;
 }
 
+static PyObject* sctp_recv_msg(PyObject* dummy, PyObject* args)
+{
+	int fd;
+	size_t max_len;
+
+	PyObject* ostats = 0;
+	struct lat_stats* stats;
+
+	PyObject* owriter = 0;
+	struct pcap_writer* writer;
+
+	if (! PyArg_ParseTuple(args, "in|OO", &fd, &max_len, &ostats, &owriter)) {
+		return 0;
+	}
+
+	stats = lat_from_arg(ostats);
+	writer = pcap_from_arg(owriter);
+	if (PyErr_Occurred()) {
+		return 0;
+	}
+
+	return recv_msg(fd, max_len, stats, writer);
+}
+
+/* Socket: base type of sctp.sctpsocket. It keeps the descriptor and the
+ * per-socket sctp_send() defaults in C, so sctp_send() and sctp_recv() cost
+ * one method call, without attribute lookups or fileno() calls. The Python
+ * socket it wraps is kept (_sk) for everything else, and close() goes
+ * through this type so the descriptor is never used after being closed. */
+
+typedef struct {
+	PyObject_HEAD
+	int fd;                     // -1 once closed or detached
+	int family;
+	int style;
+	PyObject* sk;               // underlying Python socket
+	unsigned int ttl;
+	int pr_policy;
+	int streamid;
+	long long adaptation;       // default ppid, -1 until read from the kernel
+	PyObject* latency;          // latency_stats_new() capsule, or None
+	PyObject* pcap;             // pcap_open() capsule, or None
+} SocketObject;
+
+static PyTypeObject SocketType = { PyVarObject_HEAD_INIT(NULL, 0) };
+
+// sctp.py notification classes, see register_notification_types()
+static PyObject* notification_factory = 0;
+static PyObject* notification_base = 0;
+static PyObject* sndrcvinfo_class = 0;
+
+static PyObject* socket_tp_new(PyTypeObject* type, PyObject* args, PyObject* kwargs)
+{
+	SocketObject* self = (SocketObject*) type->tp_alloc(type, 0);
+
+	if (self) {
+		self->fd = -1;
+		self->adaptation = -1;
+	}
+	return (PyObject*) self;
+}
+
+static int socket_tp_init(SocketObject* self, PyObject* args, PyObject* kwargs)
+{
+	static char* kwlist[] = {"family", "style", "sk", 0};
+	int family, style, fd;
+	PyObject* sk;
+
+	if (! PyArg_ParseTupleAndKeywords(args, kwargs, "iiO:Socket", kwlist, &family, &style, &sk)) {
+		return -1;
+	}
+	fd = PyObject_AsFileDescriptor(sk);
+	if (fd < 0) {
+		return -1;
+	}
+
+	Py_INCREF(sk);
+	Py_XDECREF(self->sk);
+	self->sk = sk;
+	self->fd = fd;
+	self->family = family;
+	self->style = style;
+	self->adaptation = -1;
+	return 0;
+}
+
+static void socket_dealloc(SocketObject* self)
+{
+	Py_XDECREF(self->sk);
+	Py_XDECREF(self->latency);
+	Py_XDECREF(self->pcap);
+	Py_TYPE(self)->tp_free((PyObject*) self);
+}
+
+static int socket_adaptation(SocketObject* self, int* ppid)
+{
+	if (self->adaptation < 0) {
+		uint32_t v;
+		socklen_t lv = sizeof(v);
+
+		if (getsockopt(self->fd, SOL_SCTP, SCTP_ADAPTATION_LAYER, &v, &lv)) {
+			PyErr_SetFromErrno(PyExc_IOError);
+			return 0;
+		}
+		self->adaptation = v;
+	}
+	*ppid = (int) htonl((uint32_t) self->adaptation);
+	return 1;
+}
+
+/* Optional integer argument: absent or None leaves *v alone */
+static int opt_int(PyObject* o, long* v)
+{
+	if (! o || o == Py_None) {
+		return 1;
+	}
+	*v = PyLong_AsLong(o);
+	return ! (*v == -1 && PyErr_Occurred());
+}
+
+#define SEND_NARGS 10
+
+static char* send_kwlist[] = {"msg", "to", "ppid", "flags", "stream", "timetolive", "context",
+				"record_file_prefix", "datalogging", "pr_policy", 0};
+
+/* Resolves the sctp_send() arguments ppid, flags, stream, timetolive,
+ * context and pr_policy (any may be NULL or None) against the socket
+ * defaults. *nppid is in network byte order. */
+static int socket_send_params(SocketObject* self, PyObject* oppid, PyObject* oflags, 
+				PyObject* ostream, PyObject* ottl, PyObject* ocontext, 
+				PyObject* opolicy, int* nppid, long* flags, long* stream, 
+				long* ttl, long* context)
+{
+	long ppid = -1;
+	long pr_policy = self->pr_policy;
+
+	*flags = 0;
+	*stream = self->streamid;
+	*ttl = self->ttl;
+	*context = 0;
+	if (! opt_int(oppid, &ppid) || ! opt_int(oflags, flags) || ! opt_int(ostream, stream) || 
+			! opt_int(ottl, ttl) || ! opt_int(ocontext, context) || 
+			! opt_int(opolicy, &pr_policy)) {
+		return 0;
+	}
+	if (oppid && oppid != Py_None) {
+		if (ppid < 0 || ppid > 0xffffffffL) {
+			PyErr_SetString(PyExc_OverflowError, "ppid must be an unsigned 32-bit integer");
+			return 0;
+		}
+		*nppid = (int) htonl((uint32_t) ppid);
+	} else if (! socket_adaptation(self, nppid)) {
+		return 0;
+	}
+	if (pr_policy) {
+#ifdef SCTP_PR_SCTP_MASK
+		*flags = (*flags & ~SCTP_PR_SCTP_MASK) | pr_policy;
+#else
+		errno = ENOPROTOOPT;
+		PyErr_SetFromErrno(PyExc_IOError);
+		return 0;
+#endif
+	}
+	return 1;
+}
+
+/* Socket.sctp_send() after argument collection; argv[i] is NULL when the
+ * argument send_kwlist[i] was not passed */
+static PyObject* socket_send(SocketObject* self, PyObject** argv)
+{
+	Py_buffer msgbuf;
+	PyObject* oto = argv[1];
+	long flags, stream, ttl, context;
+	int nppid;
+	struct pcap_writer* writer;
+	PyObject* owriter = 0;
+	PyObject* ret = 0;
+
+	if (! argv[0]) {
+		PyErr_SetString(PyExc_TypeError, "sctp_send() missing required argument 'msg'");
+		return 0;
+	}
+	if (! socket_send_params(self, argv[2], argv[3], argv[4], argv[5], argv[6], argv[9], 
+				&nppid, &flags, &stream, &ttl, &context)) {
+		return 0;
+	}
+
+	writer = pcap_from_arg(self->pcap);
+	if (! writer && argv[8] && PyObject_IsTrue(argv[8]) > 0) {
+		// rare: log into the default writer, built on the Python side
+		owriter = PyObject_CallMethod((PyObject*) self, "_default_pcap", "O", 
+				argv[7] ? argv[7] : Py_None);
+		if (! owriter) {
+			return 0;
+		}
+		writer = pcap_from_arg(owriter);
+	}
+	if (PyErr_Occurred()) {
+		Py_XDECREF(owriter);
+		return 0;
+	}
+
+	// "s*" as sctp_send_msg() and _send_chunk(): str is sent UTF-8 encoded
+	if (! PyArg_Parse(argv[0], "s*", &msgbuf)) {
+		Py_XDECREF(owriter);
+		return 0;
+	}
+	ret = send_msg(self->fd, (const char*) msgbuf.buf, msgbuf.len, oto, nppid, flags, stream, 
+			(unsigned int) ttl, context, lat_from_arg(self->latency), writer, 0, 0);
+	PyBuffer_Release(&msgbuf);
+	Py_XDECREF(owriter);
+	return ret;
+}
+
+/* Socket._send_chunk(msg, to, ppid, flags, stream, timetolive, context, timeout):
+ * sctp_send() for sctpsocket.sctp_sendfile(), which waits up to timeout
+ * milliseconds (negative: forever) for room in the send buffer, without
+ * changing the blocking mode of the socket */
+static PyObject* socket_send_chunk(SocketObject* self, PyObject* args)
+{
+	Py_buffer msgbuf;
+	PyObject *oto, *oppid, *oflags, *ostream, *ottl, *ocontext;
+	long flags, stream, ttl, context;
+	int nppid, timeout;
+	struct lat_stats* stats;
+	struct pcap_writer* writer;
+	PyObject* ret = 0;
+
+	if (! PyArg_ParseTuple(args, "s*OOOOOOi", &msgbuf, &oto, &oppid, &oflags, &ostream, &ottl, 
+				&ocontext, &timeout)) {
+		return 0;
+	}
+	stats = lat_from_arg(self->latency);
+	writer = pcap_from_arg(self->pcap);
+	if (! PyErr_Occurred() && socket_send_params(self, oppid, oflags, ostream, ottl, ocontext, 0, 
+				&nppid, &flags, &stream, &ttl, &context)) {
+		ret = send_msg(self->fd, (const char*) msgbuf.buf, msgbuf.len, oto, nppid, flags, stream, 
+				(unsigned int) ttl, context, stats, writer, 1, timeout);
+	}
+	PyBuffer_Release(&msgbuf);
+	return ret;
+}
+
+/* Socket._send_file(src, offset, count, chunk_size, to, ppid, flags, stream,
+ * timetolive, context, eor, timeout): send_file() of descriptor src for
+ * sctpsocket.sctp_sendfile(), with the sctp_send() defaults of the socket.
+ * Negative offset and count read from the current position to the end. */
+static PyObject* socket_send_file(SocketObject* self, PyObject* args)
+{
+	int src, eor, timeout, nppid;
+	long long offset, count;
+	Py_ssize_t chunk;
+	PyObject *oto, *oppid, *oflags, *ostream, *ottl, *ocontext;
+	long flags, stream, ttl, context;
+	struct lat_stats* stats;
+	struct pcap_writer* writer;
+
+	if (! PyArg_ParseTuple(args, "iLLnOOOOOOii", &src, &offset, &count, &chunk, &oto, &oppid, 
+				&oflags, &ostream, &ottl, &ocontext, &eor, &timeout)) {
+		return 0;
+	}
+	stats = lat_from_arg(self->latency);
+	writer = pcap_from_arg(self->pcap);
+	if (PyErr_Occurred() || ! socket_send_params(self, oppid, oflags, ostream, ottl, ocontext, 0, 
+				&nppid, &flags, &stream, &ttl, &context)) {
+		return 0;
+	}
+	return send_file(self->fd, src, offset, count, chunk, oto, nppid, flags, stream, 
+				(unsigned int) ttl, context, eor, timeout, stats, writer);
+}
+
+static PyObject* socket_recv(SocketObject* self, PyObject* omaxlen)
+{
+	Py_ssize_t max_len;
+	struct lat_stats* stats;
+	struct pcap_writer* writer;
+	PyObject* ret;
+	PyObject* raw;
+	PyObject* notif;
+	long flags;
+
+	if (! omaxlen) {
+		PyErr_SetString(PyExc_TypeError, "sctp_recv() missing required argument 'maxlen'");
+		return 0;
+	}
+	max_len = PyNumber_AsSsize_t(omaxlen, PyExc_OverflowError);
+	if (max_len == -1 && PyErr_Occurred()) {
+		return 0;
+	}
+	stats = lat_from_arg(self->latency);
+	writer = pcap_from_arg(self->pcap);
+	if (PyErr_Occurred()) {
+		return 0;
+	}
+
+	ret = recv_msg(self->fd, max_len, stats, writer);
+	if (! ret || ! notification_factory) {
+		return ret;
+	}
+
+	// same as sctp.sctpsocket.sctp_recv() used to do in Python
+	raw = PyTuple_GET_ITEM(ret, 3);
+	flags = PyLong_AsLong(PyTuple_GET_ITEM(ret, 1));
+	if (flags & MSG_NOTIFICATION) {
+		notif = PyObject_CallFunctionObjArgs(notification_factory, raw, NULL);
+		if (notif && Py_TYPE(notif) == (PyTypeObject*) notification_base) {
+			// raw notification class, means we do not know the exact type
+			PyObject* o = PyObject_GetAttrString((PyObject*) self, 
+						"unexpected_event_raises_exception");
+			int raises = o ? PyObject_IsTrue(o) : -1;
+			Py_XDECREF(o);
+			if (raises) {
+				if (raises > 0) {
+					PyErr_SetString(PyExc_IOError, "An unknown event notification has arrived");
+				}
+				Py_CLEAR(notif);
+			}
+		}
+	} else {
+		notif = PyObject_CallFunctionObjArgs(sndrcvinfo_class, raw, NULL);
+	}
+	if (! notif) {
+		Py_DECREF(ret);
+		return 0;
+	}
+	// the tuple is ours alone, fresh from recv_msg()
+	PyTuple_SET_ITEM(ret, 3, notif);
+	Py_DECREF(raw);
+	return ret;
+}
+
+#if PY_VERSION_HEX >= 0x03070000
+
+/* Collects the arguments of a METH_FASTCALL | METH_KEYWORDS call into
+ * argv[0..n) by position, then by keyword; absent ones are left NULL */
+static int fast_args(PyObject* const* args, Py_ssize_t nargs, PyObject* kwnames, 
+			char** names, int n, PyObject** argv, const char* fname)
+{
+	Py_ssize_t i, k;
+
+	memset(argv, 0, n * sizeof(PyObject*));
+	if (nargs > n) {
+		PyErr_Format(PyExc_TypeError, "%s() takes at most %d arguments (%zd given)", fname, n, nargs);
+		return 0;
+	}
+	for(i = 0; i < nargs; ++i) {
+		argv[i] = args[i];
+	}
+	if (! kwnames) {
+		return 1;
+	}
+	for(k = 0; k < PyTuple_GET_SIZE(kwnames); ++k) {
+		PyObject* key = PyTuple_GET_ITEM(kwnames, k);
+		for(i = 0; i < n; ++i) {
+			if (PyUnicode_CompareWithASCIIString(key, names[i]) == 0) {
+				break;
+			}
+		}
+		if (i == n) {
+			PyErr_Format(PyExc_TypeError, "%s() got an unexpected keyword argument '%U'", fname, key);
+			return 0;
+		}
+		if (argv[i]) {
+			PyErr_Format(PyExc_TypeError, "%s() got multiple values for argument '%s'", fname, names[i]);
+			return 0;
+		}
+		argv[i] = args[nargs + k];
+	}
+	return 1;
+}
+
+static PyObject* socket_sctp_send(SocketObject* self, PyObject* const* args, Py_ssize_t nargs, 
+					PyObject* kwnames)
+{
+	PyObject* argv[SEND_NARGS];
+
+	if (! fast_args(args, nargs, kwnames, send_kwlist, SEND_NARGS, argv, "sctp_send")) {
+		return 0;
+	}
+	return socket_send(self, argv);
+}
+
+static PyObject* socket_sctp_recv(SocketObject* self, PyObject* const* args, Py_ssize_t nargs, 
+					PyObject* kwnames)
+{
+	static char* kwlist[] = {"maxlen", 0};
+	PyObject* omaxlen;
+
+	if (! fast_args(args, nargs, kwnames, kwlist, 1, &omaxlen, "sctp_recv")) {
+		return 0;
+	}
+	return socket_recv(self, omaxlen);
+}
+
+#define SOCKET_CALL_FLAGS (METH_FASTCALL | METH_KEYWORDS)
+
+#else
+
+static PyObject* socket_sctp_send(SocketObject* self, PyObject* args, PyObject* kwargs)
+{
+	PyObject* argv[SEND_NARGS] = {0};
+
+	if (! PyArg_ParseTupleAndKeywords(args, kwargs, "|OOOOOOOOOO:sctp_send", send_kwlist, 
+			&argv[0], &argv[1], &argv[2], &argv[3], &argv[4], &argv[5], &argv[6], 
+			&argv[7], &argv[8], &argv[9])) {
+		return 0;
+	}
+	return socket_send(self, argv);
+}
+
+static PyObject* socket_sctp_recv(SocketObject* self, PyObject* args, PyObject* kwargs)
+{
+	static char* kwlist[] = {"maxlen", 0};
+	PyObject* omaxlen = 0;
+
+	if (! PyArg_ParseTupleAndKeywords(args, kwargs, "|O:sctp_recv", kwlist, &omaxlen)) {
+		return 0;
+	}
+	return socket_recv(self, omaxlen);
+}
+
+#define SOCKET_CALL_FLAGS (METH_VARARGS | METH_KEYWORDS)
+
+#endif
+
+static PyObject* socket_fileno(SocketObject* self, PyObject* noargs)
+{
+	return Py23_PyLong_FromLong(self->fd);
+}
+
+/* close() and detach() of the Python socket, forgetting the descriptor */
+static PyObject* socket_release(SocketObject* self, const char* method)
+{
+	pcap_forget(self->fd);
+	self->fd = -1;
+	if (! self->sk) {
+		Py_INCREF(Py_None);
+		return Py_None;
+	}
+	return PyObject_CallMethod(self->sk, (char*) method, 0);
+}
+
+static PyObject* socket_close(SocketObject* self, PyObject* noargs)
+{
+	return socket_release(self, "close");
+}
+
+static PyObject* socket_detach(SocketObject* self, PyObject* noargs)
+{
+	return socket_release(self, "detach");
+}
+
+/* Doc strings of the Socket methods; sctp.py documents the rest of
+   sctpsocket */
+
+PyDoc_STRVAR(socket_sctp_send_doc,
+	"sctp_send(msg, to=('', 0), ppid=None, flags=0, stream=None, timetolive=None, context=0,\n"
+	"          record_file_prefix='RECORD_sctp_traffic', datalogging=False, pr_policy=None) -> bytes sent\n"
+	"\n"
+	"Sends a SCTP message. While send()/sendto() can also be used, this method also\n"
+	"accepts some SCTP-exclusive metadata. Parameters:\n"
+	"\n"
+	"msg: the message to be sent, any bytes-like object (bytes, bytearray,\n"
+	"     memoryview...). A message encoded into a reusable bytearray, for\n"
+	"     instance by sigtran.m3ua_encode(), is sent without a copy.\n"
+	"\n"
+	"to: an address/port tuple identifying the destination, or the assoc_id for the\n"
+	"    association. It can (and generally must) be omitted for TCP-style sockets.\n"
+	"    Sending by assoc_id (UDP-style sockets) needs the association to exist.\n"
+	"\n"
+	"ppid: adaptation layer value, a 32-bit metadata that is sent along the message.\n"
+	"      Default to 0.\n"
+	"\n"
+	"flags: a bitmap of MSG_* flags. For example, MSG_UNORDERED indicates that\n"
+	"       message can be delivered out-of-order, and MSG_EOF + empty message\n"
+	"       shuts down the association. Defaults to no flags set.\n"
+	"\n"
+	"       It does NOT include flags like MSG_DONTROUTE or other low-level flags\n"
+	"       that are supported by sendto().\n"
+	"\n"
+	"stream: stream number where the message will sent by.\n"
+	"        If not set use default value.\n"
+	"\n"
+	"timetolive: time to live of the message in milisseconds. Zero means infinite\n"
+	"            TTL. If TTL expires, the message is discarded. Discarding policy\n"
+	"            changes whether implementation implements the PR-SCTP extension or not.\n"
+	"            If not set use default value.\n"
+	"\n"
+	"            When a PR-SCTP policy is in effect, this is the policy value instead:\n"
+	"            lifetime in milisseconds (PR_SCTP_TTL), maximum retransmissions\n"
+	"            (PR_SCTP_RTX) or priority (PR_SCTP_PRIO).\n"
+	"\n"
+	"context: an opaque 32-bit integer that will be returned in some notification events,\n"
+	"         if the event is directly related to this message transmission. So the\n"
+	"         application can know exactly which message triggered which event.\n"
+	"         Defaults to 0.\n"
+	"\n"
+	"pr_policy: PR-SCTP policy for this message, one of the PR_SCTP_* constants.\n"
+	"           If not set use default value (see pr_policy property). Any policy\n"
+	"           but PR_SCTP_NONE raises IOError(ENOPROTOOPT) if pysctp was built\n"
+	"           without PR-SCTP support.\n"
+	"\n"
+	"datalogging: if True, and the socket is not already recording (see datalogging\n"
+	"             property), this message is recorded by the default pcap_writer()\n"
+	"             of record_file_prefix.\n"
+	"\n"
+	"The method returns the number of bytes sent. Ideally it is going to be exacly the\n"
+	"size of the message. Transmission errors will trigger an exception.\n"
+	"\n"
+	"WARNING: the maximum message size that can be sent via SCTP is limited\n"
+	"both by the implementation and by the transmission buffer (SO_SNDBUF).\n"
+	"The application must configure this buffer accordingly.");
+
+PyDoc_STRVAR(socket_sctp_recv_doc,
+	"sctp_recv(maxlen) -> (fromaddr, flags, msg, notif)\n"
+	"\n"
+	"Receives an SCTP message and/or a SCTP notification event. The notifications\n"
+	"that can be received are regulated by \"events\" property and its subproperties.\n"
+	"See event_subscribe() class for details.\n"
+	"\n"
+	"It is important to know that sctp_recv() can return either on data messages or\n"
+	"on subscribed events. If the application just wants data, it must unsubscribe\n"
+	"the other events.\n"
+	"\n"
+	"Parameters:\n"
+	"\n"
+	"maxlen: the maximum message size that can be received. If bigger messages are\n"
+	"        received, they will be received in fragments (non-atomically). The\n"
+	"        application must choose this carefully if it wants to keep the\n"
+	"        atomicity of messages!\n"
+	"\n"
+	"Returns: (fromaddr, flags, msg, notif)\n"
+	"\n"
+	"fromaddr: address/port pair. For some applications, association ID will be more\n"
+	"          useful to identify the related association. Fortunately, assoc_id is\n"
+	"          a attribute of most notifications received via \"notif\" (see below)\n"
+	"\n"
+	"flags: a bitmap of lower-level recvmsg() flags (FLAG_* flags).\n"
+	"\n"
+	"       FLAG_NOTIFICATION indicates that an event notification was\n"
+	"       returned, instead of a data message.\n"
+	"\n"
+	"       FLAG_EOR indicates that this is the final fragment of a data message.\n"
+	"       Ideally, all messages will come with this flag set.\n"
+	"\n"
+	"       WARNING: message data-related flags like MSG_UNORDERED are returned\n"
+	"       inside sndrcvinfo() notifications, and NOT here!\n"
+	"\n"
+	"msg: the actual data message. Since SCTP does not allow empty messages,\n"
+	"     an empty \"msg\" always means something special, either:\n"
+	"\n"
+	"     a) that \"notif\" contains an event notification, if \"flags\" has\n"
+	"        FLAG_NOTIFICATION set;\n"
+	"\n"
+	"     b) that association is closing (for TCP-style sockets only)\n"
+	"\n"
+	"notif: notification event object. If \"msg\" is a data message, it will contain\n"
+	"       a sndrcvinfo() object that contains metadata about the message. If\n"
+	"       \"flags\" has FLAG_NOTIFICATION set, it will contain some notification()\n"
+	"       subclass.\n"
+	"\n"
+	"       sndrcvinfo() is ALWAYS returned when a data message is received, but\n"
+	"       it will only contain useful data IF events.data_io is subscribed True.\n"
+	"\n"
+	"WARNING: the maximum message size that can be received via SCTP is limited:\n"
+	"\n"
+	"* by the underlying implementation. Check your operating system.\n"
+	"\n"
+	"* by the \"maxlen\" parameter passed. If message is bigger, it will be received\n"
+	"  in several fragments. The last fragment will have FLAG_EOR flag set.\n"
+	"\n"
+	"* by the socket's reception buffer (SO_RCVBUF). The application must configure\n"
+	"  this buffer accordingly, otherwise the message will be truncated.");
+
+static PyMethodDef socket_methods[] = {
+	{"sctp_send", (PyCFunction) (void(*)(void)) socket_sctp_send, SOCKET_CALL_FLAGS, 
+		socket_sctp_send_doc},
+	{"sctp_recv", (PyCFunction) (void(*)(void)) socket_sctp_recv, SOCKET_CALL_FLAGS, 
+		socket_sctp_recv_doc},
+	{"fileno", (PyCFunction) socket_fileno, METH_NOARGS, "fileno() -> descriptor, -1 once closed"},
+	{"close", (PyCFunction) socket_close, METH_NOARGS, "close() closes the underlying socket"},
+	{"detach", (PyCFunction) socket_detach, METH_NOARGS, 
+		"detach() detaches the underlying socket and returns its descriptor"},
+	{"_send_chunk", (PyCFunction) socket_send_chunk, METH_VARARGS, 
+		"_send_chunk(msg, to, ppid, flags, stream, timetolive, context, timeout) -> bytes sent"},
+	{"_send_file", (PyCFunction) socket_send_file, METH_VARARGS, 
+		"_send_file(src, offset, count, chunk_size, to, ppid, flags, stream, timetolive, context,\n"
+		"eor, timeout) -> bytes sent"},
+	{ NULL, NULL, 0, NULL }
+};
+
+static PyMemberDef socket_members[] = {
+	{"_sk", T_OBJECT, offsetof(SocketObject, sk), READONLY, "underlying Python socket"},
+	{"_family", T_INT, offsetof(SocketObject, family), READONLY, ""},
+	{"_style", T_INT, offsetof(SocketObject, style), READONLY, ""},
+	{"_ttl", T_UINT, offsetof(SocketObject, ttl), 0, "default timetolive"},
+	{"_pr_policy", T_INT, offsetof(SocketObject, pr_policy), 0, "default PR-SCTP policy"},
+	{"_streamid", T_INT, offsetof(SocketObject, streamid), 0, "default stream"},
+	{"_adaptation", T_LONGLONG, offsetof(SocketObject, adaptation), 0, 
+		"default ppid (adaptation layer indication), -1 if not known yet"},
+	{"_latency", T_OBJECT, offsetof(SocketObject, latency), 0, ""},
+	{"_pcap", T_OBJECT, offsetof(SocketObject, pcap), 0, ""},
+	{ NULL, 0, 0, 0, NULL }
+};
+
+static PyObject* register_notification_types(PyObject* dummy, PyObject* args)
+{
+	PyObject *factory, *base, *info;
+
+	if (! PyArg_ParseTuple(args, "OOO", &factory, &base, &info)) {
+		return 0;
+	}
+	if (! PyType_Check(base)) {
+		PyErr_SetString(PyExc_TypeError, "the notification base class must be a class");
+		return 0;
+	}
+
+	Py_INCREF(factory);
+	Py_INCREF(base);
+	Py_INCREF(info);
+	Py_XDECREF(notification_factory);
+	Py_XDECREF(notification_base);
+	Py_XDECREF(sndrcvinfo_class);
+	notification_factory = factory;
+	notification_base = base;
+	sndrcvinfo_class = info;
+
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+/* Registers the few object types _sctp exposes, see module init */
+
+static int init_types(PyObject* module)
+{
+	if (AssocStatsType.tp_name == 0) {
+#if PY_MAJOR_VERSION >= 3
+		if (PyStructSequence_InitType2(&AssocStatsType, &assoc_stats_desc) < 0) {
+			return -1;
+		}
+#else
+		PyStructSequence_InitType(&AssocStatsType, &assoc_stats_desc);
+#endif
+	}
+	Py_INCREF(&AssocStatsType);
+	if (PyModule_AddObject(module, "assoc_stats", (PyObject*) &AssocStatsType) < 0) {
+		Py_DECREF(&AssocStatsType);
+		return -1;
+	}
+
+	if (AddressSetType.tp_name == 0) {
+		addrset_as_sequence.sq_length = (lenfunc) addrset_length;
+		addrset_as_sequence.sq_item = (ssizeargfunc) addrset_item;
+		addrset_as_sequence.sq_contains = (objobjproc) addrset_contains;
+		addrset_as_number.nb_or = addrset_union;
+		addrset_as_number.nb_subtract = addrset_difference;
+		addrset_as_number.nb_and = addrset_intersection;
+
+		AddressSetType.tp_name = "_sctp.AddressSet";
+		AddressSetType.tp_doc = "AddressSet([(address, port), ...]): immutable, ordered set of packed "
+			"socket addresses; compares and hashes as the tuple of its entries";
+		AddressSetType.tp_basicsize = sizeof(AddressSetObject);
+		AddressSetType.tp_flags = Py_TPFLAGS_DEFAULT;
+#if PY_MAJOR_VERSION < 3
+		AddressSetType.tp_flags |= Py_TPFLAGS_CHECKTYPES;
+#endif
+		AddressSetType.tp_new = addrset_tp_new;
+		AddressSetType.tp_dealloc = (destructor) addrset_dealloc;
+		AddressSetType.tp_repr = (reprfunc) addrset_repr;
+		AddressSetType.tp_richcompare = addrset_richcompare;
+		AddressSetType.tp_hash = (hashfunc) addrset_hash;
+		AddressSetType.tp_as_sequence = &addrset_as_sequence;
+		AddressSetType.tp_as_number = &addrset_as_number;
+		AddressSetType.tp_methods = addrset_methods;
+		if (PyType_Ready(&AddressSetType) < 0) {
+			return -1;
+		}
+	}
+	Py_INCREF(&AddressSetType);
+	if (PyModule_AddObject(module, "AddressSet", (PyObject*) &AddressSetType) < 0) {
+		Py_DECREF(&AddressSetType);
+		return -1;
+	}
+
+	if (SocketType.tp_name == 0) {
+		SocketType.tp_name = "_sctp.Socket";
+		SocketType.tp_doc = "Socket(family, style, sk): SCTP socket core, base of sctp.sctpsocket";
+		SocketType.tp_basicsize = sizeof(SocketObject);
+		SocketType.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
+		SocketType.tp_new = socket_tp_new;
+		SocketType.tp_init = (initproc) socket_tp_init;
+		SocketType.tp_dealloc = (destructor) socket_dealloc;
+		SocketType.tp_methods = socket_methods;
+		SocketType.tp_members = socket_members;
+		if (PyType_Ready(&SocketType) < 0) {
+			return -1;
+		}
+	}
+	Py_INCREF(&SocketType);
+	if (PyModule_AddObject(module, "Socket", (PyObject*) &SocketType) < 0) {
+		Py_DECREF(&SocketType);
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,645 @@
+/* SCTP bindings for Python
+ *
+ * _sigtran.c: SIGTRAN message codecs (M3UA, RFC 4666)
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation; either version 2.1 of the License, or (at your
+ * option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Messages are never copied on reception: m3ua_parse() validates the common
+ * header and the parameter TLVs of a received buffer (bytes, bytearray,
+ * memoryview...) and returns an M3UAMessage holding the tag, offset and
+ * length of each parameter, plus a reference to the buffer. Parameter values
+ * are handed out as memoryview slices or integers.
+ *
+ * Encoders write straight into a caller-supplied writable buffer (typically
+ * a bytearray reused for every message), that sctp_send() accepts as is. */
+
+#include "_codec.h"
+
+#define M3UA_VERSION 1
+#define M3UA_HEADER 8
+#define M3UA_PARAM_HEADER 4
+#define M3UA_PROTOCOL_DATA_FIXED 12
+#define M3UA_MAX_PARAM (0xffff - M3UA_PARAM_HEADER)
+
+#define CLASS_TRANSFER 1
+#define TYPE_DATA 1
+
+#define TAG_ROUTING_CONTEXT 0x0006
+#define TAG_CORRELATION_ID 0x0013
+#define TAG_NETWORK_APPEARANCE 0x0200
+#define TAG_PROTOCOL_DATA 0x0210
+
+static ktuple _constants[] =
+{
+	{"PPID_M3UA", 3},
+	{"CLASS_MGMT", 0},
+	{"CLASS_TRANSFER", CLASS_TRANSFER},
+	{"CLASS_SSNM", 2},
+	{"CLASS_ASPSM", 3},
+	{"CLASS_ASPTM", 4},
+	{"CLASS_RKM", 9},
+	// MGMT
+	{"ERR", 0},
+	{"NTFY", 1},
+	// TRANSFER
+	{"DATA", TYPE_DATA},
+	// SSNM
+	{"DUNA", 1},
+	{"DAVA", 2},
+	{"DAUD", 3},
+	{"SCON", 4},
+	{"DUPU", 5},
+	{"DRST", 6},
+	// ASPSM
+	{"ASPUP", 1},
+	{"ASPDN", 2},
+	{"BEAT", 3},
+	{"ASPUP_ACK", 4},
+	{"ASPDN_ACK", 5},
+	{"BEAT_ACK", 6},
+	// ASPTM
+	{"ASPAC", 1},
+	{"ASPIA", 2},
+	{"ASPAC_ACK", 3},
+	{"ASPIA_ACK", 4},
+	// RKM
+	{"REG_REQ", 1},
+	{"REG_RSP", 2},
+	{"DEREG_REQ", 3},
+	{"DEREG_RSP", 4},
+	// parameter tags, common (RFC 4666 3.2) then M3UA-specific
+	{"TAG_INFO_STRING", 0x0004},
+	{"TAG_ROUTING_CONTEXT", TAG_ROUTING_CONTEXT},
+	{"TAG_DIAGNOSTIC_INFORMATION", 0x0007},
+	{"TAG_HEARTBEAT_DATA", 0x0009},
+	{"TAG_TRAFFIC_MODE_TYPE", 0x000b},
+	{"TAG_ERROR_CODE", 0x000c},
+	{"TAG_STATUS", 0x000d},
+	{"TAG_ASP_IDENTIFIER", 0x0011},
+	{"TAG_AFFECTED_POINT_CODE", 0x0012},
+	{"TAG_CORRELATION_ID", TAG_CORRELATION_ID},
+	{"TAG_NETWORK_APPEARANCE", TAG_NETWORK_APPEARANCE},
+	{"TAG_USER_CAUSE", 0x0204},
+	{"TAG_CONGESTION_INDICATIONS", 0x0205},
+	{"TAG_CONCERNED_DESTINATION", 0x0206},
+	{"TAG_ROUTING_KEY", 0x0207},
+	{"TAG_REGISTRATION_RESULT", 0x0208},
+	{"TAG_DEREGISTRATION_RESULT", 0x0209},
+	{"TAG_LOCAL_ROUTING_KEY_IDENTIFIER", 0x020a},
+	{"TAG_DESTINATION_POINT_CODE", 0x020b},
+	{"TAG_SERVICE_INDICATORS", 0x020c},
+	{"TAG_ORIGINATING_POINT_CODE_LIST", 0x020e},
+	{"TAG_PROTOCOL_DATA", TAG_PROTOCOL_DATA},
+	{"TAG_REGISTRATION_STATUS", 0x0212},
+	{"TAG_DEREGISTRATION_STATUS", 0x0213},
+	{0, -1}
+};
+
+/* M3UA message object */
+
+struct m3ua_param {
+	uint16_t tag;
+	uint16_t len;     // value length, without TLV header and padding
+	uint32_t off;     // value offset in the buffer
+};
+
+typedef struct {
+	CODEC_MESSAGE_HEAD          // elements: parameters
+	unsigned char version;
+	unsigned char msg_class;
+	unsigned char msg_type;
+	unsigned int length;
+	struct m3ua_param params[1];
+} M3UAMessageObject;
+
+static PyTypeObject M3UAMessageType = { PyVarObject_HEAD_INIT(NULL, 0) };
+static PySequenceMethods m3ua_as_sequence;
+
+/* Validates the TLVs of a message of "len" bytes at p. Fills "out" if not
+ * NULL, and returns the number of parameters, or -1 with ValueError set. */
+static Py_ssize_t m3ua_scan(const uint8_t* p, uint32_t len, Py_ssize_t base, struct m3ua_param* out)
+{
+	uint32_t pos = M3UA_HEADER;
+	Py_ssize_t n = 0;
+
+	while (pos < len) {
+		uint16_t tag, plen;
+
+		if (len - pos < M3UA_PARAM_HEADER) {
+			PyErr_Format(PyExc_ValueError, "truncated M3UA parameter header at offset %u", pos);
+			return -1;
+		}
+		tag = get_u16(p + pos);
+		plen = get_u16(p + pos + 2);
+		if (plen < M3UA_PARAM_HEADER || plen > len - pos) {
+			PyErr_Format(PyExc_ValueError, "M3UA parameter 0x%04x at offset %u has invalid length %u",
+					tag, pos, plen);
+			return -1;
+		}
+		if (out) {
+			out[n].tag = tag;
+			out[n].len = plen - M3UA_PARAM_HEADER;
+			out[n].off = (uint32_t) (base + pos + M3UA_PARAM_HEADER);
+		}
+		++n;
+		// padding of the last parameter may be missing
+		pos += (plen + 3) & ~3;
+	}
+
+	return n;
+}
+
+static PyObject* m3ua_parse(PyObject* dummy, PyObject* args)
+{
+	Py_ssize_t base;
+	Py_buffer view;
+	const uint8_t* p;
+	uint32_t len;
+	Py_ssize_t n;
+	M3UAMessageObject* m;
+
+	p = codec_get_message(args, &view, &base, M3UA_HEADER, "M3UA");
+	if (! p) {
+		return 0;
+	}
+	if (p[0] != M3UA_VERSION) {
+		PyErr_Format(PyExc_ValueError, "unsupported M3UA version %d", p[0]);
+		goto error;
+	}
+	len = get_u32(p + 4);
+	if (len < M3UA_HEADER || len > (uint64_t) (view.len - base)) {
+		PyErr_Format(PyExc_ValueError, "M3UA message length %u does not fit in %zd bytes",
+				len, view.len - base);
+		goto error;
+	}
+
+	n = m3ua_scan(p, len, base, 0);
+	if (n < 0) {
+		goto error;
+	}
+
+	m = PyObject_NewVar(M3UAMessageObject, &M3UAMessageType, n);
+	if (! m) {
+		goto error;
+	}
+	m3ua_scan(p, len, base, m->params);
+	m->view = view;
+	m->mview = 0;
+	m->base = base;
+	m->version = p[0];
+	m->msg_class = p[2];
+	m->msg_type = p[3];
+	m->length = len;
+
+	return (PyObject*) m;
+
+error:
+	PyBuffer_Release(&view);
+	return 0;
+}
+
+static PyObject* m3ua_item(M3UAMessageObject* self, Py_ssize_t i)
+{
+	const struct m3ua_param* prm;
+
+	if (i < 0 || i >= Py_SIZE(self)) {
+		PyErr_SetString(PyExc_IndexError, "M3UA parameter index out of range");
+		return 0;
+	}
+	prm = &(self->params[i]);
+	return Py_BuildValue("(iki)", prm->tag, (unsigned long) prm->off, prm->len);
+}
+
+static const struct m3ua_param* m3ua_find(M3UAMessageObject* self, int tag)
+{
+	Py_ssize_t i;
+
+	for(i = 0; i < Py_SIZE(self); ++i) {
+		if (self->params[i].tag == tag) {
+			return &(self->params[i]);
+		}
+	}
+	return 0;
+}
+
+static PyObject* m3ua_find_method(M3UAMessageObject* self, PyObject* args)
+{
+	int tag;
+	Py_ssize_t i;
+
+	if (! PyArg_ParseTuple(args, "i", &tag)) {
+		return 0;
+	}
+	for(i = 0; i < Py_SIZE(self); ++i) {
+		if (self->params[i].tag == tag) {
+			return PyLong_FromSsize_t(i);
+		}
+	}
+	return Py23_PyLong_FromLong(-1);
+}
+
+static PyObject* m3ua_get(M3UAMessageObject* self, PyObject* args)
+{
+	int tag;
+	PyObject* dflt = Py_None;
+	const struct m3ua_param* prm;
+
+	if (! PyArg_ParseTuple(args, "i|O", &tag, &dflt)) {
+		return 0;
+	}
+	prm = m3ua_find(self, tag);
+	if (! prm) {
+		Py_INCREF(dflt);
+		return dflt;
+	}
+	return codec_message_slice((CodecMessageObject*) self, prm->off, prm->len);
+}
+
+static PyObject* m3ua_get_u32(M3UAMessageObject* self, PyObject* args)
+{
+	int tag;
+	PyObject* dflt = Py_None;
+	const struct m3ua_param* prm;
+
+	if (! PyArg_ParseTuple(args, "i|O", &tag, &dflt)) {
+		return 0;
+	}
+	prm = m3ua_find(self, tag);
+	if (! prm) {
+		Py_INCREF(dflt);
+		return dflt;
+	}
+	if (prm->len < 4) {
+		PyErr_Format(PyExc_ValueError, "M3UA parameter 0x%04x is too short for an integer", tag);
+		return 0;
+	}
+	return PyLong_FromUnsignedLong(get_u32((const uint8_t*) self->view.buf + prm->off));
+}
+
+static PyObject* m3ua_protocol_data(M3UAMessageObject* self, PyObject* noargs)
+{
+	const struct m3ua_param* prm = m3ua_find(self, TAG_PROTOCOL_DATA);
+	const uint8_t* p;
+	PyObject* data;
+
+	if (! prm) {
+		Py_INCREF(Py_None);
+		return Py_None;
+	}
+	if (prm->len < M3UA_PROTOCOL_DATA_FIXED) {
+		PyErr_SetString(PyExc_ValueError, "M3UA Protocol Data parameter is too short");
+		return 0;
+	}
+	p = (const uint8_t*) self->view.buf + prm->off;
+	data = codec_message_slice((CodecMessageObject*) self, prm->off + M3UA_PROTOCOL_DATA_FIXED, prm->len - M3UA_PROTOCOL_DATA_FIXED);
+	if (! data) {
+		return 0;
+	}
+	return Py_BuildValue("(kkiiiiN)", (unsigned long) get_u32(p), (unsigned long) get_u32(p + 4),
+				p[8], p[9], p[10], p[11], data);
+}
+
+static PyMethodDef m3ua_methods[] = {
+	{"find", (PyCFunction) m3ua_find_method, METH_VARARGS,
+		"find(tag) -> index of the first parameter with this tag, or -1"},
+	{"get", (PyCFunction) m3ua_get, METH_VARARGS,
+		"get(tag[, default]) -> memoryview of the value of the first parameter with this tag"},
+	{"get_u32", (PyCFunction) m3ua_get_u32, METH_VARARGS,
+		"get_u32(tag[, default]) -> first 32-bit integer of the value of a parameter"},
+	{"protocol_data", (PyCFunction) m3ua_protocol_data, METH_NOARGS,
+		"protocol_data() -> (opc, dpc, si, ni, mp, sls, memoryview of user data), or None"},
+	{ NULL, NULL, 0, NULL }
+};
+
+static PyMemberDef m3ua_members[] = {
+	{"version", T_UBYTE, offsetof(M3UAMessageObject, version), READONLY, ""},
+	{"msg_class", T_UBYTE, offsetof(M3UAMessageObject, msg_class), READONLY, ""},
+	{"msg_type", T_UBYTE, offsetof(M3UAMessageObject, msg_type), READONLY, ""},
+	{"length", T_UINT, offsetof(M3UAMessageObject, length), READONLY, "message length, header included"},
+	{"offset", T_PYSSIZET, offsetof(M3UAMessageObject, base), READONLY, "offset of the message in the buffer"},
+	{"buffer", T_OBJECT, offsetof(M3UAMessageObject, view) + offsetof(Py_buffer, obj), READONLY, ""},
+	{ NULL, 0, 0, 0, NULL }
+};
+
+/* Encoders */
+
+static void put_header(uint8_t* p, int msg_class, int msg_type, uint32_t len)
+{
+	p[0] = M3UA_VERSION;
+	p[1] = 0;
+	p[2] = msg_class;
+	p[3] = msg_type;
+	put_u32(p + 4, len);
+}
+
+/* Writes a TLV whose value is "head" followed by "data", zero padded. Returns
+ * the padded size. */
+static Py_ssize_t put_param(uint8_t* p, int tag, const void* head, Py_ssize_t lhead,
+				const void* data, Py_ssize_t ldata)
+{
+	Py_ssize_t len = M3UA_PARAM_HEADER + lhead + ldata;
+	Py_ssize_t padded = (len + 3) & ~3;
+
+	put_u16(p, tag);
+	put_u16(p + 2, len);
+	if (lhead) {
+		memcpy(p + M3UA_PARAM_HEADER, head, lhead);
+	}
+	if (ldata) {
+		memcpy(p + M3UA_PARAM_HEADER + lhead, data, ldata);
+	}
+	memset(p + len, 0, padded - len);
+	return padded;
+}
+
+static Py_ssize_t param_size(Py_ssize_t len)
+{
+	return (M3UA_PARAM_HEADER + len + 3) & ~3;
+}
+
+#define MAX_ENCODE_PARAMS 64
+
+static PyObject* m3ua_encode(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	PyObject* obuf;
+	Py_ssize_t offset;
+	int msg_class, msg_type;
+	PyObject* oparams;
+	PyObject* seq = 0;
+	Py_buffer values[MAX_ENCODE_PARAMS];
+	uint8_t ints[MAX_ENCODE_PARAMS][4];
+	int tags[MAX_ENCODE_PARAMS];
+	Py_ssize_t n = 0;
+	Py_ssize_t got = 0;
+	Py_ssize_t size = M3UA_HEADER;
+	Py_ssize_t pos;
+	struct encoder e;
+	Py_ssize_t i;
+
+	if (! PyArg_ParseTuple(args, "OniiO", &obuf, &offset, &msg_class, &msg_type, &oparams)) {
+		return ret;
+	}
+
+	seq = PySequence_Fast(oparams, "parameters must be a sequence of (tag, value) tuples");
+	if (! seq) {
+		return ret;
+	}
+	n = PySequence_Fast_GET_SIZE(seq);
+	if (n > MAX_ENCODE_PARAMS) {
+		PyErr_Format(PyExc_ValueError, "at most %d parameters per message", MAX_ENCODE_PARAMS);
+		goto out;
+	}
+
+	// values are integers (32-bit, big endian) or bytes-like objects
+	for(got = 0; got < n; ++got) {
+		PyObject* item = PySequence_Fast_GET_ITEM(seq, got);
+		PyObject* ovalue;
+
+		values[got].obj = 0;
+		if (! PyTuple_Check(item) || ! PyArg_ParseTuple(item, "iO", &(tags[got]), &ovalue)) {
+			if (! PyErr_Occurred() || PyErr_ExceptionMatches(PyExc_TypeError)) {
+				PyErr_Clear();
+				PyErr_SetString(PyExc_TypeError, "parameters must be (tag, value) tuples");
+			}
+			goto out;
+		}
+		if (PyLong_Check(ovalue)
+#if PY_MAJOR_VERSION < 3
+				|| PyInt_Check(ovalue)
+#endif
+				) {
+			unsigned long v = PyLong_AsUnsignedLongMask(ovalue);
+			if (v == (unsigned long) -1 && PyErr_Occurred()) {
+				goto out;
+			}
+			put_u32(ints[got], v);
+			size += param_size(4);
+			continue;
+		}
+		if (PyObject_GetBuffer(ovalue, &(values[got]), PyBUF_SIMPLE) < 0) {
+			goto out;
+		}
+		if (values[got].len > M3UA_MAX_PARAM) {
+			PyErr_Format(PyExc_ValueError, "M3UA parameter 0x%04x is too long", tags[got]);
+			++got;
+			goto out;
+		}
+		size += param_size(values[got].len);
+	}
+
+	if (! encoder_open(&e, obuf, offset, size)) {
+		goto out;
+	}
+	put_header(e.p, msg_class, msg_type, size);
+	pos = M3UA_HEADER;
+	for(i = 0; i < n; ++i) {
+		if (values[i].obj) {
+			pos += put_param(e.p + pos, tags[i], values[i].buf, values[i].len, 0, 0);
+		} else {
+			pos += put_param(e.p + pos, tags[i], ints[i], 4, 0, 0);
+		}
+	}
+	ret = encoder_close(&e, size);
+
+out:
+	for(i = 0; i < got; ++i) {
+		if (values[i].obj) {
+			PyBuffer_Release(&(values[i]));
+		}
+	}
+	Py_DECREF(seq);
+	return ret;
+}
+
+/* Optional 32-bit parameter: None, or an integer */
+static int opt_u32(PyObject* o, uint8_t* out)
+{
+	unsigned long v;
+
+	if (o == Py_None) {
+		return 0;
+	}
+	v = PyLong_AsUnsignedLongMask(o);
+	if (v == (unsigned long) -1 && PyErr_Occurred()) {
+		return -1;
+	}
+	put_u32(out, v);
+	return 1;
+}
+
+static PyObject* m3ua_encode_data(PyObject* dummy, PyObject* args)
+{
+	PyObject* ret = 0;
+	PyObject* obuf;
+	Py_ssize_t offset;
+	unsigned long opc, dpc;
+	int si, ni, mp, sls;
+	Py_buffer payload;
+	PyObject* orc = Py_None;
+	PyObject* ona = Py_None;
+	PyObject* ocorr = Py_None;
+	uint8_t rc[4], na[4], corr[4];
+	int has_rc, has_na, has_corr;
+	uint8_t fixed[M3UA_PROTOCOL_DATA_FIXED];
+	Py_ssize_t size = M3UA_HEADER;
+	Py_ssize_t pos = M3UA_HEADER;
+	struct encoder e;
+
+	if (! PyArg_ParseTuple(args, "Onkkiiiis*|OOO", &obuf, &offset, &opc, &dpc, &si, &ni,
+				&mp, &sls, &payload, &orc, &ona, &ocorr)) {
+		return ret;
+	}
+
+	has_rc = opt_u32(orc, rc);
+	has_na = opt_u32(ona, na);
+	has_corr = opt_u32(ocorr, corr);
+	if (has_rc < 0 || has_na < 0 || has_corr < 0) {
+		goto out;
+	}
+	if (payload.len > M3UA_MAX_PARAM - M3UA_PROTOCOL_DATA_FIXED) {
+		PyErr_SetString(PyExc_ValueError, "M3UA user data is too long");
+		goto out;
+	}
+
+	put_u32(fixed, opc);
+	put_u32(fixed + 4, dpc);
+	fixed[8] = si;
+	fixed[9] = ni;
+	fixed[10] = mp;
+	fixed[11] = sls;
+
+	size += (has_na + has_rc + has_corr) * param_size(4);
+	size += param_size(M3UA_PROTOCOL_DATA_FIXED + payload.len);
+	if (! encoder_open(&e, obuf, offset, size)) {
+		goto out;
+	}
+
+	// RFC 4666 3.3.1 order
+	put_header(e.p, CLASS_TRANSFER, TYPE_DATA, size);
+	if (has_na) {
+		pos += put_param(e.p + pos, TAG_NETWORK_APPEARANCE, na, 4, 0, 0);
+	}
+	if (has_rc) {
+		pos += put_param(e.p + pos, TAG_ROUTING_CONTEXT, rc, 4, 0, 0);
+	}
+	pos += put_param(e.p + pos, TAG_PROTOCOL_DATA, fixed, sizeof(fixed), payload.buf, payload.len);
+	if (has_corr) {
+		pos += put_param(e.p + pos, TAG_CORRELATION_ID, corr, 4, 0, 0);
+	}
+	ret = encoder_close(&e, size);
+
+out:
+	PyBuffer_Release(&payload);
+	return ret;
+}
+
+static PyMethodDef _sigtran_methods[] =
+{
+	{"m3ua_parse", m3ua_parse, METH_VARARGS,
+		"m3ua_parse(buffer[, offset]) -> M3UAMessage, without copying the buffer"},
+	{"m3ua_encode", m3ua_encode, METH_VARARGS,
+		"m3ua_encode(buf, offset, msg_class, msg_type, [(tag, value), ...]) -> bytes written\n"
+		"(or a bytes object if buf is None). Values are integers or bytes-like objects."},
+	{"m3ua_encode_data", m3ua_encode_data, METH_VARARGS,
+		"m3ua_encode_data(buf, offset, opc, dpc, si, ni, mp, sls, data[, routing_context,\n"
+		"network_appearance, correlation_id]) -> bytes written (or bytes if buf is None)"},
+	{ NULL, NULL, 0, NULL }
+};
+
+static int init_types(PyObject* module)
+{
+	if (M3UAMessageType.tp_name == 0) {
+		m3ua_as_sequence.sq_length = (lenfunc) codec_message_length;
+		m3ua_as_sequence.sq_item = (ssizeargfunc) m3ua_item;
+
+		M3UAMessageType.tp_name = "_sigtran.M3UAMessage";
+		M3UAMessageType.tp_doc = "Parsed M3UA message, a sequence of (tag, offset, length) parameters";
+		M3UAMessageType.tp_basicsize = offsetof(M3UAMessageObject, params);
+		M3UAMessageType.tp_itemsize = sizeof(struct m3ua_param);
+		M3UAMessageType.tp_flags = Py_TPFLAGS_DEFAULT;
+		M3UAMessageType.tp_dealloc = (destructor) codec_message_dealloc;
+		M3UAMessageType.tp_as_sequence = &m3ua_as_sequence;
+		M3UAMessageType.tp_methods = m3ua_methods;
+		M3UAMessageType.tp_members = m3ua_members;
+		if (PyType_Ready(&M3UAMessageType) < 0) {
+			return -1;
+		}
+	}
+	Py_INCREF(&M3UAMessageType);
+	if (PyModule_AddObject(module, "M3UAMessage", (PyObject*) &M3UAMessageType) < 0) {
+		Py_DECREF(&M3UAMessageType);
+		return -1;
+	}
+
+	return codec_add_constants(module, _constants);
+}
+
+#if PY_MAJOR_VERSION >= 3
+
+    static struct PyModuleDef moduledef = {
+            PyModuleDef_HEAD_INIT,
+            "_sigtran",
+	        "SIGTRAN message codecs",
+            -1,
+            _sigtran_methods,
+            NULL,
+            NULL,
+            NULL,
+            NULL
+    };
+
+    #define INITERROR return NULL
+
+    PyObject * PyInit__sigtran(void)
+
+#else
+
+    #define INITERROR return
+
+    void init_sigtran(void)
+
+#endif
+
+{
+#if PY_MAJOR_VERSION >= 3
+
+    PyObject *module = PyModule_Create(&moduledef);
+
+#else
+
+    PyObject *module = Py_InitModule4(
+        "_sigtran",
+        _sigtran_methods,
+        "SIGTRAN message codecs",
+        0,
+        PYTHON_API_VERSION);
+
+#endif
+
+    if (module == NULL)
+        INITERROR;
+
+    if (init_types(module) < 0) {
+        Py_DECREF(module);
+        INITERROR;
+    }
+
+#if PY_MAJOR_VERSION >= 3
+
+        return module;
+
+#endif
+}
@@ -0,0 +1,77 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Compares two sctp_bench.py JSON reports, case by case:
+
+python bench/compare.py before.json after.json [--threshold 10]
+
+Prints the relative change of every metric and exits with status 1 if
+any metric regressed more than threshold percent (throughput down, or
+latency up).
+"""
+
+import sys
+import json
+import argparse
+
+KEY = ("style", "size", "streams", "order", "nodelay")
+HIGHER_IS_BETTER = ("msgs_per_s", "mb_per_s")
+LOWER_IS_BETTER = ("rtt_p50_us", "rtt_p99_us", "rtt_p999_us")
+
+
+def load(path):
+    f = open(path)
+    report = json.load(f)
+    f.close()
+    return dict([(tuple([r[k] for k in KEY]), r) for r in report["results"]])
+
+
+def main():
+    p = argparse.ArgumentParser(description="compare pysctp benchmark reports")
+    p.add_argument("before")
+    p.add_argument("after")
+    p.add_argument("--threshold", type=float, default=10.0, help="regression threshold, percent")
+    args = p.parse_args()
+
+    before = load(args.before)
+    after = load(args.after)
+    regressions = 0
+
+    for key in sorted(set(before.keys()) & set(after.keys())):
+        b = before[key]
+        a = after[key]
+        line = ["%s/%dB/%ds/%s/nodelay=%d" % key]
+        for metric in HIGHER_IS_BETTER + LOWER_IS_BETTER:
+            if not b.get(metric):
+                continue
+            change = (a[metric] - b[metric]) * 100.0 / b[metric]
+            worse = change < -args.threshold if metric in HIGHER_IS_BETTER else change > args.threshold
+            if worse:
+                regressions += 1
+            line.append("%s %+.1f%%%s" % (metric, change, worse and " !" or ""))
+        print("  ".join(line))
+
+    missing = set(before.keys()) ^ set(after.keys())
+    if missing:
+        print("%d cases present in only one report" % len(missing))
+
+    print("%d regressions over %.1f%%" % (regressions, args.threshold))
+    return regressions and 1 or 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,207 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Message codec microbenchmarks (requires pyperf). No SCTP stack is needed.
+
+  m3ua_parse         _sigtran.m3ua_parse() of a DATA message
+  m3ua_parse_data    same, plus protocol_data()
+  m3ua_parse-ref     pure Python parse of the same message (struct)
+  m3ua_encode_data   _sigtran.m3ua_encode_data() into a reused bytearray
+  diameter_cer       _diameter.diameter_parse() of a CER, plus Origin-Host
+  diameter_cer-ref   pure Python decode of the same (top-level AVPs, struct)
+  diameter_ccr       _diameter.diameter_parse() of a Gy CCR, plus the lookups
+                     of a credit control server (Session-Id, request type and
+                     number, the Subscription-Id groups)
+  diameter_ccr-ref   the same with the pure Python decoder
+
+python bench/msgcodecs.py -o msgcodecs.json
+"""
+
+import os
+import sys
+import struct
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+import pyperf
+
+import _sigtran
+import _diameter as dia
+
+# ISUP-sized payload, Routing Context 1
+M3UA_PAYLOAD = b"\x01" * 40
+M3UA_DATA = _sigtran.m3ua_encode_data(None, 0, 1, 2, 5, 2, 0, 3, M3UA_PAYLOAD, 1)
+
+
+def m3ua_parse_py(msg):
+    # reference decoder, the straightforward way: copies every value
+    version, reserved, cls, typ, length = struct.unpack_from("!BBBBI", msg)
+    if version != 1 or length < 8 or length > len(msg):
+        raise ValueError("bad M3UA header")
+    params = []
+    pos = 8
+    while pos + 4 <= length:
+        tag, plen = struct.unpack_from("!HH", msg, pos)
+        if plen < 4 or pos + plen > length:
+            raise ValueError("bad M3UA parameter")
+        params.append((tag, msg[pos + 4:pos + plen]))
+        pos += (plen + 3) & ~3
+    return cls, typ, params
+
+
+def avp(code, data, flags=0x40, vendor=None):
+    if isinstance(data, int):
+        data = struct.pack("!I", data)
+    head = 8
+    if vendor is not None:
+        flags |= dia.AVP_FLAG_VENDOR
+        head = 12
+    out = struct.pack("!IB", code, flags) + struct.pack("!I", head + len(data))[1:]
+    if vendor is not None:
+        out += struct.pack("!I", vendor)
+    return out + data + b"\0" * (-len(data) % 4)
+
+
+def diameter_message(flags, code, app, avps):
+    body = b"".join(avps)
+    return (struct.pack("!I", 0x01000000 | (20 + len(body))) +
+            struct.pack("!I", (flags << 24) | code) + struct.pack("!III", app, 1, 1) + body)
+
+DIAMETER_CER = diameter_message(0x80, dia.CMD_CAPABILITIES_EXCHANGE, 0, [
+    avp(dia.AVP_ORIGIN_HOST, b"pcef1.epc.mnc001.mcc001.3gppnetwork.org"),
+    avp(dia.AVP_ORIGIN_REALM, b"epc.mnc001.mcc001.3gppnetwork.org"),
+    avp(dia.AVP_HOST_IP_ADDRESS, b"\0\1\x0a\0\0\1"),
+    avp(dia.AVP_VENDOR_ID, 0),
+    avp(dia.AVP_PRODUCT_NAME, b"pysctp", flags=0),
+    avp(dia.AVP_ORIGIN_STATE_ID, 1),
+    avp(dia.AVP_SUPPORTED_VENDOR_ID, 10415),
+    avp(dia.AVP_SUPPORTED_VENDOR_ID, 5535),
+    avp(dia.AVP_AUTH_APPLICATION_ID, 4),
+    avp(dia.AVP_INBAND_SECURITY_ID, 0),
+    avp(dia.AVP_VENDOR_SPECIFIC_APPLICATION_ID,
+        avp(dia.AVP_VENDOR_ID, 10415) + avp(dia.AVP_AUTH_APPLICATION_ID, 16777238)),
+    avp(dia.AVP_FIRMWARE_REVISION, 1, flags=0),
+])
+
+DIAMETER_CCR = diameter_message(0xc0, dia.CMD_CREDIT_CONTROL, 4, [
+    avp(dia.AVP_SESSION_ID, b"pcef1.epc.mnc001.mcc001.3gppnetwork.org;1634;15672;17"),
+    avp(dia.AVP_ORIGIN_HOST, b"pcef1.epc.mnc001.mcc001.3gppnetwork.org"),
+    avp(dia.AVP_ORIGIN_REALM, b"epc.mnc001.mcc001.3gppnetwork.org"),
+    avp(dia.AVP_DESTINATION_REALM, b"ocs.mnc001.mcc001.3gppnetwork.org"),
+    avp(dia.AVP_AUTH_APPLICATION_ID, 4),
+    avp(dia.AVP_SERVICE_CONTEXT_ID, b"32251@3gpp.org"),
+    avp(dia.AVP_CC_REQUEST_TYPE, 2),
+    avp(dia.AVP_CC_REQUEST_NUMBER, 3),
+    avp(dia.AVP_ORIGIN_STATE_ID, 1),
+    avp(dia.AVP_EVENT_TIMESTAMP, b"\xe3\xb0\xc4\x42"),
+    avp(dia.AVP_SUBSCRIPTION_ID, avp(dia.AVP_SUBSCRIPTION_ID_TYPE, 0) +
+        avp(dia.AVP_SUBSCRIPTION_ID_DATA, b"33612345678")),
+    avp(dia.AVP_SUBSCRIPTION_ID, avp(dia.AVP_SUBSCRIPTION_ID_TYPE, 1) +
+        avp(dia.AVP_SUBSCRIPTION_ID_DATA, b"208011234567890")),
+    avp(dia.AVP_USER_EQUIPMENT_INFO, avp(459, 0) + avp(460, b"\x35\x12\x34\x56\x78\x90\x12\x30")),
+    avp(dia.AVP_MULTIPLE_SERVICES_CREDIT_CONTROL,
+        avp(437, b"") + avp(432, 1) + avp(446, avp(420, 3600) + avp(412, 1 << 20) + avp(414, 1 << 20))),
+    avp(873, avp(874, avp(1, b"\x0a\0\0\1", vendor=10415) + avp(30, b"internet", vendor=10415),
+                      vendor=10415), flags=0xc0, vendor=10415),
+])
+
+
+def diameter_avps_py(msg, pos, end):
+    avps = []
+    while pos < end:
+        code, flags_len = struct.unpack_from("!II", msg, pos)
+        flags = flags_len >> 24
+        length = flags_len & 0xffffff
+        head = 8
+        vendor = 0
+        if flags & 0x80:
+            vendor, = struct.unpack_from("!I", msg, pos + 8)
+            head = 12
+        if length < head or pos + length > end:
+            raise ValueError("bad Diameter AVP")
+        avps.append((code, flags, vendor, msg[pos + head:pos + length]))
+        pos += (length + 3) & ~3
+    return avps
+
+
+def diameter_parse_py(msg):
+    # reference decoder, the straightforward way: copies every AVP
+    vl, fc, app, hbh, e2e = struct.unpack_from("!IIIII", msg)
+    length = vl & 0xffffff
+    if vl >> 24 != 1 or length < 20 or length > len(msg):
+        raise ValueError("bad Diameter header")
+    return fc >> 24, fc & 0xffffff, app, hbh, e2e, diameter_avps_py(msg, 20, length)
+
+
+def find_py(avps, code):
+    for a in avps:
+        if a[0] == code:
+            return a
+    return None
+
+
+def ccr_lookups(msg):
+    m = dia.diameter_parse(msg)
+    session = m.get(dia.AVP_SESSION_ID)
+    rtype = m.get_u32(dia.AVP_CC_REQUEST_TYPE)
+    rnum = m.get_u32(dia.AVP_CC_REQUEST_NUMBER)
+    subs = [m.group(i).get(dia.AVP_SUBSCRIPTION_ID_DATA) for i in m.find_all(dia.AVP_SUBSCRIPTION_ID)]
+    return m.ids(), session, rtype, rnum, subs
+
+
+def ccr_lookups_py(msg):
+    flags, code, app, hbh, e2e, avps = diameter_parse_py(msg)
+    session = find_py(avps, dia.AVP_SESSION_ID)[3]
+    rtype, = struct.unpack("!I", find_py(avps, dia.AVP_CC_REQUEST_TYPE)[3])
+    rnum, = struct.unpack("!I", find_py(avps, dia.AVP_CC_REQUEST_NUMBER)[3])
+    subs = []
+    for a in avps:
+        if a[0] == dia.AVP_SUBSCRIPTION_ID:
+            subs.append(find_py(diameter_avps_py(a[3], 0, len(a[3])), dia.AVP_SUBSCRIPTION_ID_DATA)[3])
+    return (hbh, e2e), session, rtype, rnum, subs
+
+
+def bench_diameter(runner):
+    parse = dia.diameter_parse
+    cer = DIAMETER_CER
+    runner.bench_func("diameter_cer", lambda: parse(cer).get(dia.AVP_ORIGIN_HOST))
+    runner.bench_func("diameter_cer-ref", lambda: find_py(diameter_parse_py(cer)[5], dia.AVP_ORIGIN_HOST))
+    runner.bench_func("diameter_ccr", ccr_lookups, DIAMETER_CCR)
+    runner.bench_func("diameter_ccr-ref", ccr_lookups_py, DIAMETER_CCR)
+
+
+def bench_m3ua(runner):
+    parse = _sigtran.m3ua_parse
+    msg = M3UA_DATA
+    runner.bench_func("m3ua_parse", parse, msg)
+    runner.bench_func("m3ua_parse_data", lambda: parse(msg).protocol_data())
+    runner.bench_func("m3ua_parse-ref", m3ua_parse_py, msg)
+
+    buf = bytearray(256)
+    encode = _sigtran.m3ua_encode_data
+    runner.bench_func("m3ua_encode_data", encode, buf, 0, 1, 2, 5, 2, 0, 3, M3UA_PAYLOAD, 1)
+
+
+def main():
+    runner = pyperf.Runner()
+    runner.metadata["description"] = "pysctp message codecs"
+    bench_m3ua(runner)
+    bench_diameter(runner)
+
+if __name__ == '__main__':
+    main()
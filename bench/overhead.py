@@ -0,0 +1,189 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Per-call binding overhead microbenchmarks (requires pyperf).
+
+Every binding entry point is timed next to a reference doing the same
+system call through the standard socket module, so the difference is the
+cost added by the binding (argument parsing, result construction...):
+
+  send_msg        _sctp.sctp_send_msg()      vs  socket.send()
+  sctp_send       sctpsocket.sctp_send()     vs  _sctp.sctp_send_msg()
+  recv_msg        _sctp.sctp_recv_msg()      vs  socket.recv()
+  sctp_recv       sctpsocket.sctp_recv()     vs  _sctp.sctp_recv_msg()
+  getattr         sctpsocket.gettimeout      vs  socket.gettimeout
+  get_nodelay     _sctp.get_nodelay()        vs  socket.getsockopt()
+  set_nodelay     _sctp.set_nodelay()        vs  socket.setsockopt()
+  getpaddrs       _sctp.getpaddrs()          vs  _sctp._getpaddrs_tuple()
+  getpaddrs_list  list(_sctp.getpaddrs())    vs  list(_sctp._getpaddrs_tuple())
+
+Message calls run over an AF_UNIX SOCK_SEQPACKET socketpair (the SCTP
+ancillary data is ignored there), with the receive queue pre-filled
+outside of the timed region, so no SCTP stack work is measured. Socket
+option calls need an SCTP loopback association and are skipped when the
+kernel has no SCTP. Benchmark names are "<entry>" and "<entry>-ref".
+
+_sctp._getpaddrs_tuple() is getpaddrs() as it was before AddressSet, a
+tuple of (address, port) tuples built up front. getpaddrs compares the
+calls themselves; getpaddrs_list also reads every address, which the
+AddressSet does lazily.
+
+python bench/overhead.py -o overhead.json
+python bench/overhead_check.py overhead.json            # against the baseline
+python bench/overhead_check.py --update overhead.json   # store a new baseline
+"""
+
+import os
+import sys
+import socket
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+import pyperf
+
+import _sctp
+import sctp
+
+MSG = b"x" * 64
+BATCH = 64
+SCTP_NODELAY = 3 # Linux value; not exported by the socket module
+
+
+def bare_sctpsocket(sk):
+    # sctpsocket.__init__ reads SCTP options, which fail on a socketpair
+    s = sctp.sctpsocket_tcp.__new__(sctp.sctpsocket_tcp)
+    _sctp.Socket.__init__(s, socket.AF_UNIX, sctp.TCP_STYLE, sk)
+    s.unexpected_event_raises_exception = False
+    return s
+
+
+def drain(sk, n):
+    for i in range(n):
+        sk.recv(len(MSG))
+
+
+def fill(sk, n):
+    for i in range(n):
+        sk.send(MSG)
+
+
+def time_send(loops, a, b, send):
+    total = 0.0
+    timer = pyperf.perf_counter
+    while loops > 0:
+        n = min(loops, BATCH)
+        t0 = timer()
+        for i in range(n):
+            send()
+        total += timer() - t0
+        drain(b, n)
+        loops -= n
+    return total
+
+
+def time_recv(loops, a, b, recv):
+    total = 0.0
+    timer = pyperf.perf_counter
+    while loops > 0:
+        n = min(loops, BATCH)
+        fill(a, n)
+        t0 = timer()
+        for i in range(n):
+            recv()
+        total += timer() - t0
+        loops -= n
+    return total
+
+
+def time_call(loops, call):
+    timer = pyperf.perf_counter
+    t0 = timer()
+    for i in range(loops):
+        call()
+    return timer() - t0
+
+
+def sctp_loopback():
+    try:
+        srv = socket.socket(socket.AF_INET, socket.SOCK_STREAM, sctp.IPPROTO_SCTP)
+    except (IOError, OSError):
+        return None
+    srv.bind(("127.0.0.1", 0))
+    srv.listen(1)
+    cli = socket.socket(socket.AF_INET, socket.SOCK_STREAM, sctp.IPPROTO_SCTP)
+    cli.connect(srv.getsockname())
+    conn, _ = srv.accept()
+    return srv, cli, conn
+
+
+def main():
+    runner = pyperf.Runner()
+    runner.metadata["description"] = "pysctp per-call binding overhead"
+
+    a, b = socket.socketpair(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+    fa = a.fileno()
+    fb = b.fileno()
+    sa = bare_sctpsocket(a)
+    sb = bare_sctpsocket(b)
+    to = ("", 0)
+    n = len(MSG) + 16
+
+    runner.bench_time_func("send_msg", time_send, a, b,
+        lambda: _sctp.sctp_send_msg(fa, MSG, to, 0, 0, 0, 0, 0))
+    runner.bench_time_func("send_msg-ref", time_send, a, b,
+        lambda: a.send(MSG))
+    runner.bench_time_func("sctp_send", time_send, a, b,
+        lambda: sa.sctp_send(MSG, ppid=0, stream=0, timetolive=0))
+    runner.bench_time_func("sctp_send-ref", time_send, a, b,
+        lambda: _sctp.sctp_send_msg(fa, MSG, to, 0, 0, 0, 0, 0))
+
+    runner.bench_time_func("recv_msg", time_recv, a, b,
+        lambda: _sctp.sctp_recv_msg(fb, n))
+    runner.bench_time_func("recv_msg-ref", time_recv, a, b,
+        lambda: b.recv(n))
+    runner.bench_time_func("sctp_recv", time_recv, a, b,
+        lambda: sb.sctp_recv(n))
+    runner.bench_time_func("sctp_recv-ref", time_recv, a, b,
+        lambda: _sctp.sctp_recv_msg(fb, n))
+
+    runner.bench_time_func("getattr", time_call, lambda: sa.gettimeout)
+    runner.bench_time_func("getattr-ref", time_call, lambda: a.gettimeout)
+
+    lo = sctp_loopback()
+    if lo:
+        srv, cli, conn = lo
+        fc = cli.fileno()
+        runner.bench_time_func("get_nodelay", time_call,
+            lambda: _sctp.get_nodelay(fc))
+        runner.bench_time_func("get_nodelay-ref", time_call,
+            lambda: cli.getsockopt(sctp.IPPROTO_SCTP, SCTP_NODELAY))
+        runner.bench_time_func("set_nodelay", time_call,
+            lambda: _sctp.set_nodelay(fc, 1))
+        runner.bench_time_func("set_nodelay-ref", time_call,
+            lambda: cli.setsockopt(sctp.IPPROTO_SCTP, SCTP_NODELAY, 1))
+        runner.bench_time_func("getpaddrs", time_call,
+            lambda: _sctp.getpaddrs(fc, 0))
+        runner.bench_time_func("getpaddrs-ref", time_call,
+            lambda: _sctp._getpaddrs_tuple(fc, 0))
+        runner.bench_time_func("getpaddrs_list", time_call,
+            lambda: list(_sctp.getpaddrs(fc, 0)))
+        runner.bench_time_func("getpaddrs_list-ref", time_call,
+            lambda: list(_sctp._getpaddrs_tuple(fc, 0)))
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,105 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Computes the binding overhead (entry time minus reference time, in ns)
+from an overhead.py pyperf result, and checks it against a stored baseline:
+
+python bench/overhead_check.py overhead.json [--threshold 15] [--min-ns 20]
+python bench/overhead_check.py --update overhead.json
+
+Baselines are machine-dependent; they are kept in bench/baselines/, one
+file per machine (--baseline), default named after the host. An entry
+regresses if its overhead grew more than threshold percent AND more than
+min-ns nanoseconds, which keeps noise on tiny overheads from failing the
+check. Exits with status 1 on regressions.
+"""
+
+import os
+import sys
+import json
+import platform
+import argparse
+
+import pyperf
+
+BASELINES = os.path.join(os.path.dirname(os.path.abspath(__file__)), "baselines")
+
+
+def overheads(path):
+    suite = pyperf.BenchmarkSuite.load(path)
+    means = dict([(b.get_name(), b.mean()) for b in suite.get_benchmarks()])
+    ret = {}
+    for name, mean in means.items():
+        ref = means.get(name + "-ref")
+        if ref is not None:
+            ret[name] = {"ns": round((mean - ref) * 1e9, 1),
+                         "call_ns": round(mean * 1e9, 1),
+                         "ref_ns": round(ref * 1e9, 1)}
+    return ret
+
+
+def main():
+    p = argparse.ArgumentParser(description="check pysctp binding overhead against a baseline")
+    p.add_argument("result", help="pyperf JSON written by overhead.py")
+    p.add_argument("--baseline", default=os.path.join(BASELINES, platform.node() + ".json"))
+    p.add_argument("--update", action="store_true", help="store the result as the new baseline")
+    p.add_argument("--threshold", type=float, default=15.0, help="percent")
+    p.add_argument("--min-ns", type=float, default=20.0)
+    args = p.parse_args()
+
+    current = overheads(args.result)
+
+    if args.update:
+        if not os.path.isdir(os.path.dirname(args.baseline)):
+            os.makedirs(os.path.dirname(args.baseline))
+        f = open(args.baseline, "w")
+        json.dump({"python": platform.python_version(), "kernel": platform.release(),
+                   "overhead": current}, f, indent=1, sort_keys=True)
+        f.write("\n")
+        f.close()
+        print("baseline written to %s" % args.baseline)
+        return 0
+
+    if not os.path.exists(args.baseline):
+        print("no baseline %s, run with --update first" % args.baseline)
+        for name in sorted(current.keys()):
+            print("%-12s %8.1f ns" % (name, current[name]["ns"]))
+        return 0
+
+    f = open(args.baseline)
+    baseline = json.load(f)["overhead"]
+    f.close()
+
+    regressions = 0
+    for name in sorted(current.keys()):
+        new = current[name]["ns"]
+        old = baseline.get(name, {}).get("ns")
+        if old is None:
+            print("%-12s %8.1f ns  (new)" % (name, new))
+            continue
+        worse = new - old > args.min_ns and new > old * (1 + args.threshold / 100.0)
+        if worse:
+            regressions += 1
+        print("%-12s %8.1f ns  baseline %8.1f ns  %+7.1f ns%s" %
+              (name, new, old, new - old, worse and "  REGRESSION" or ""))
+
+    print("%d regressions" % regressions)
+    return regressions and 1 or 0
+
+if __name__ == '__main__':
+    sys.exit(main())
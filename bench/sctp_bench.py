@@ -0,0 +1,242 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Throughput and latency benchmark over 127.0.0.1.
+
+Every case runs a fresh server in a forked process, and measures from the
+client side:
+
+* throughput: "count" messages are sent back to back, round-robin over the
+  streams; the server acknowledges once it received all of them.
+  Reported as msgs_per_s and mb_per_s.
+
+* latency: "rtt_count" messages are echoed one at a time by the server.
+  Reported as rtt_p50_us, rtt_p99_us and rtt_p999_us (microseconds).
+
+The case matrix is style (tcp = one-to-one, udp = one-to-many) x message
+size x number of streams x ordered/unordered x nodelay on/off. Results
+are written as JSON, to be compared across releases with compare.py:
+
+python bench/sctp_bench.py -o before.json
+python bench/sctp_bench.py -o after.json
+python bench/compare.py before.json after.json
+"""
+
+import os
+import sys
+import json
+import time
+import socket
+import platform
+import argparse
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+import sctp
+
+try:
+    now = time.perf_counter
+except AttributeError:
+    now = time.time
+
+SIZES = (16, 256, 1024, 4096, 16384, 65536)
+STREAMS = (1, 8, 64)
+MAXLEN = 65536 + 1024
+
+
+def make_socket(style, streams, nodelay):
+    if style == "tcp":
+        sk = sctp.sctpsocket_tcp(socket.AF_INET)
+    else:
+        sk = sctp.sctpsocket_udp(socket.AF_INET)
+    sk.initparams.max_instreams = max(streams, 1)
+    sk.initparams.num_ostreams = max(streams, 1)
+    sk.events.clear()
+    sk.events.data_io = 1
+    sk.nodelay = nodelay
+    return sk
+
+
+def recv_msg(sk):
+    # reassembles partially delivered messages
+    parts = []
+    while True:
+        fromaddr, flags, msg, notif = sk.sctp_recv(MAXLEN)
+        if flags & sctp.FLAG_NOTIFICATION:
+            continue
+        parts.append(msg)
+        if flags & sctp.FLAG_EOR:
+            return fromaddr, notif, b"".join(parts)
+
+
+def serve(srv, case, count, rtt_count):
+    if case["style"] == "tcp":
+        sk, _ = srv.accept()
+        sk.events.clear()
+        sk.events.data_io = 1
+        sk.nodelay = case["nodelay"]
+        to = ("", 0)
+    else:
+        sk = srv
+
+    # throughput phase
+    for i in range(count):
+        fromaddr, notif, msg = recv_msg(sk)
+    if case["style"] == "udp":
+        to = fromaddr
+    sk.sctp_send(b"k", to=to, ppid=0, stream=0, timetolive=0)
+
+    # latency phase
+    for i in range(rtt_count):
+        fromaddr, notif, msg = recv_msg(sk)
+        sk.sctp_send(msg, to=to, ppid=0, flags=case["flags"], stream=notif.stream, timetolive=0)
+
+
+def run_case(case, count, rtt_count):
+    srv = make_socket(case["style"], case["streams"], case["nodelay"])
+    srv.bind(("127.0.0.1", 0))
+    srv.listen(5)
+    addr = srv.getsockname()[:2]
+
+    pid = os.fork()
+    if pid == 0:
+        code = 0
+        try:
+            serve(srv, case, count, rtt_count)
+        except Exception as e:
+            sys.stderr.write("server: %s\n" % e)
+            code = 1
+        os._exit(code)
+
+    srv.close()
+    cli = make_socket(case["style"], case["streams"], case["nodelay"])
+    if case["style"] == "tcp":
+        cli.connect(addr)
+        to = ("", 0)
+    else:
+        to = addr
+
+    msg = b"x" * case["size"]
+    flags = case["flags"]
+    streams = case["streams"]
+
+    try:
+        start = now()
+        for i in range(count):
+            cli.sctp_send(msg, to=to, ppid=0, flags=flags, stream=i % streams, timetolive=0)
+        recv_msg(cli)
+        elapsed = now() - start
+
+        rtts = []
+        for i in range(rtt_count):
+            t = now()
+            cli.sctp_send(msg, to=to, ppid=0, flags=flags, stream=i % streams, timetolive=0)
+            recv_msg(cli)
+            rtts.append(now() - t)
+    finally:
+        cli.close()
+        os.waitpid(pid, 0)
+
+    rtts.sort()
+    def pct(q):
+        if not rtts:
+            return 0.0
+        return round(rtts[min(len(rtts) - 1, int(q * len(rtts)))] * 1e6, 1)
+
+    result = dict(case)
+    del result["flags"]
+    result.update({
+        "count": count,
+        "msgs_per_s": round(count / elapsed, 1),
+        "mb_per_s": round(count * case["size"] / elapsed / 1e6, 3),
+        "rtt_count": rtt_count,
+        "rtt_p50_us": pct(0.50),
+        "rtt_p99_us": pct(0.99),
+        "rtt_p999_us": pct(0.999),
+    })
+    return result
+
+
+def case_name(case):
+    return "%(style)s/%(size)dB/%(streams)ds/%(order)s/nodelay=%(nodelay)d" % case
+
+
+def main():
+    p = argparse.ArgumentParser(description="pysctp loopback benchmark")
+    p.add_argument("-o", "--output", help="JSON output file (default stdout)")
+    p.add_argument("--styles", default="tcp,udp")
+    p.add_argument("--sizes", default=",".join([str(s) for s in SIZES]))
+    p.add_argument("--streams", default=",".join([str(s) for s in STREAMS]))
+    p.add_argument("--order", default="ordered,unordered")
+    p.add_argument("--nodelay", default="1,0")
+    p.add_argument("--count", type=int, default=5000, help="messages per throughput run")
+    p.add_argument("--rtt-count", type=int, default=1000, help="messages per latency run")
+    p.add_argument("--quick", action="store_true", help="small matrix and counts, for a smoke run")
+    args = p.parse_args()
+
+    if args.quick:
+        args.sizes = "16,4096"
+        args.streams = "1,8"
+        args.count = 500
+        args.rtt_count = 200
+
+    cases = []
+    for style in args.styles.split(","):
+        for size in [int(s) for s in args.sizes.split(",")]:
+            for streams in [int(s) for s in args.streams.split(",")]:
+                for order in args.order.split(","):
+                    for nodelay in [int(s) for s in args.nodelay.split(",")]:
+                        cases.append({
+                            "style": style,
+                            "size": size,
+                            "streams": streams,
+                            "order": order,
+                            "flags": order == "unordered" and sctp.MSG_UNORDERED or 0,
+                            "nodelay": nodelay,
+                        })
+
+    results = []
+    for case in cases:
+        r = run_case(case, args.count, args.rtt_count)
+        sys.stderr.write("%-40s %10.1f msg/s %9.3f MB/s  p50 %7.1f  p99 %7.1f  p999 %7.1f us\n" %
+                         (case_name(case), r["msgs_per_s"], r["mb_per_s"],
+                          r["rtt_p50_us"], r["rtt_p99_us"], r["rtt_p999_us"]))
+        results.append(r)
+
+    report = {
+        "meta": {
+            "time": time.strftime("%Y-%m-%dT%H:%M:%S"),
+            "host": platform.node(),
+            "kernel": platform.release(),
+            "python": platform.python_version(),
+            "sctp_module": os.path.abspath(sctp.__file__),
+        },
+        "results": results,
+    }
+
+    out = json.dumps(report, indent=1, sort_keys=True)
+    if args.output:
+        f = open(args.output, "w")
+        f.write(out + "\n")
+        f.close()
+    else:
+        print(out)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
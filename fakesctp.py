@@ -0,0 +1,188 @@
+# -*- coding: utf-8 -*-
+
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Scripted stand-ins for an sctpsocket, shared by the tests of the helper
+modules (test_pathmgr.py, test_pool.py, test_autotune.py), so that they
+run where the kernel has no SCTP.
+
+fake_socket() answers the sctpsocket calls those modules make from what
+the test put in its attributes, and records what they did to it. clock()
+replaces the time module of the module under test.
+"""
+
+import os
+
+import sctp
+
+
+class status_table(object):
+    """
+    What get_status_all(with_paths=True) returns, built from path rows
+    (assoc_id, addr, srtt, state, cwnd). The first row of an association is
+    its primary path, whose srtt and cwnd are also the association columns.
+    """
+    def __init__(self, *paths):
+        self.assoc_id = []
+        self.srtt = []
+        self.cwnd = []
+        self.path_assoc_id = []
+        self.path_sockaddr = []
+        self.path_srtt = []
+        self.path_state = []
+        self.path_cwnd = []
+        self.path_primary = []
+        for assoc_id, addr, srtt, state, cwnd in paths:
+            primary = assoc_id not in self.assoc_id
+            if primary:
+                self.assoc_id.append(assoc_id)
+                self.srtt.append(srtt)
+                self.cwnd.append(cwnd)
+            self.path_assoc_id.append(assoc_id)
+            self.path_sockaddr.append(addr)
+            self.path_srtt.append(srtt)
+            self.path_state.append(state)
+            self.path_cwnd.append(cwnd)
+            self.path_primary.append(primary)
+
+    def __len__(self):
+        return len(self.assoc_id)
+
+    def set_primary(self, assoc_id, addr):
+        a = self.assoc_id.index(assoc_id)
+        for i in range(len(self.path_assoc_id)):
+            if self.path_assoc_id[i] == assoc_id:
+                self.path_primary[i] = self.path_sockaddr[i] == addr
+                if self.path_primary[i]:
+                    self.srtt[a] = self.path_srtt[i]
+                    self.cwnd[a] = self.path_cwnd[i]
+
+
+class _counter(object):
+    def __init__(self, total):
+        self.sum = total
+
+
+def latency_stats(sent, received):
+    """
+    The byte counters of an sctp.latency_stats(), for latency_stats().
+    """
+    stats = sctp.latency_stats.__new__(sctp.latency_stats)
+    stats.send_bytes = _counter(sent)
+    stats.recv_bytes = _counter(received)
+    return stats
+
+
+class fake_events(object):
+    # subscriptions are plain attributes, and there is no kernel to flush to
+    def flush(self):
+        pass
+
+
+class fake_socket(object):
+    """
+    table: returned by get_status_all(); set_primary() moves its primary.
+    stats: returned by latency_stats().
+    received: sctp_recv() results, returned in order.
+    send_errors: errnos raised by the next sctp_send() calls, in order.
+    sent: (to, msg) of the sctp_send() calls that succeeded.
+    primaries: (assoc_id, addr) of the set_primary() calls.
+    sndbuf, rcvbuf: buffer sizes, clamped at buffer_limit when set.
+
+    fileno() is always readable, so that select() returns at once.
+    """
+    def __init__(self, sndbuf=64 << 10, rcvbuf=64 << 10, buffer_limit=64 << 20):
+        self.events = fake_events()
+        self.table = status_table()
+        self.stats = None
+        self.received = []
+        self.send_errors = []
+        self.sent = []
+        self.primaries = []
+        self.sndbuf = sndbuf
+        self.rcvbuf = rcvbuf
+        self.buffer_limit = buffer_limit
+        self._pipe = None
+
+    def fileno(self):
+        if self._pipe is None:
+            self._pipe = os.pipe()
+            os.write(self._pipe[1], b"x")
+        return self._pipe[0]
+
+    def setblocking(self, flag):
+        pass
+
+    def close(self):
+        if self._pipe is not None:
+            os.close(self._pipe[0])
+            os.close(self._pipe[1])
+            self._pipe = None
+
+    def sctp_recv(self, maxlen):
+        return self.received.pop(0)
+
+    def sctp_send(self, msg, to=None, **kwargs):
+        if self.send_errors:
+            e = self.send_errors.pop(0)
+            raise IOError(e, os.strerror(e))
+        self.sent.append((to, msg))
+        return len(msg)
+
+    def get_status_all(self, with_paths=False):
+        return self.table
+
+    def set_primary(self, assoc_id, addr):
+        self.primaries.append((assoc_id, addr))
+        self.table.set_primary(assoc_id, addr)
+
+    def latency_stats(self):
+        return self.stats
+
+    def get_sndbuf(self):
+        return self.sndbuf
+
+    def set_sndbuf(self, value):
+        self.sndbuf = min(value, self.buffer_limit)
+
+    def get_rcvbuf(self):
+        return self.rcvbuf
+
+    def set_rcvbuf(self, value):
+        self.rcvbuf = min(value, self.buffer_limit)
+
+
+class clock(object):
+    """
+    Time that only moves when told to, in place of the time module of the
+    module under test: install() returns the function restoring it.
+    """
+    def __init__(self, now=1000.0):
+        self.now = now
+
+    def time(self):
+        return self.now
+
+    def advance(self, seconds):
+        self.now += seconds
+
+    def install(self, module):
+        saved = module.time
+        module.time = self
+
+        def restore():
+            module.time = saved
+        return restore
@@ -46,6 +46,9 @@ remote_error():
 shutdown_event(): 
 pdapi_event(): 
 adaptation_event(): 
+stream_reset_event():
+assoc_reset_event():
+stream_change_event():
 
 Every SCTP socket has a number of properties. Two "complex" properties,
 that contain a number of sub-properties, are: 
@@ -70,9 +73,13 @@ import socket
 import _sctp
 
 import datetime
+import array
 import time
 import os
 import sys
+import errno
+import select
+import threading
 
 ####################################### CONSTANTS
 
@@ -90,10 +97,38 @@ MSG_FIN = _sctp.getconstant("MSG_FIN")
 MSG_SENDALL = _sctp.getconstant("MSG_SENDALL")
 MSG_ADDR_OVERRIDE = MSG_ADDR_OVER
 
+# PR-SCTP (RFC 3758/7496) policies, passed to sctp_send() along with "timetolive"
+PR_SCTP_NONE = _sctp.getconstant("SCTP_PR_SCTP_NONE")
+PR_SCTP_TTL = _sctp.getconstant("SCTP_PR_SCTP_TTL")
+PR_SCTP_RTX = _sctp.getconstant("SCTP_PR_SCTP_RTX")
+PR_SCTP_PRIO = _sctp.getconstant("SCTP_PR_SCTP_PRIO")
+PR_SCTP_MASK = _sctp.getconstant("SCTP_PR_SCTP_MASK")
+PR_SCTP_ALL = _sctp.getconstant("SCTP_PR_SCTP_ALL")
+
+# stream reconfiguration (RFC 6525) requests, see sctpsocket.enable_stream_reset
+ENABLE_RESET_STREAM_REQ = _sctp.getconstant("SCTP_ENABLE_RESET_STREAM_REQ")
+ENABLE_RESET_ASSOC_REQ = _sctp.getconstant("SCTP_ENABLE_RESET_ASSOC_REQ")
+ENABLE_CHANGE_ASSOC_REQ = _sctp.getconstant("SCTP_ENABLE_CHANGE_ASSOC_REQ")
+STREAM_RESET_INCOMING = _sctp.getconstant("SCTP_STREAM_RESET_INCOMING")
+STREAM_RESET_OUTGOING = _sctp.getconstant("SCTP_STREAM_RESET_OUTGOING")
+
+# RFC 6458 special assoc_ids, accepted by every set_*() option method of
+# UDP-style sockets: FUTURE_ASSOC sets the socket defaults, CURRENT_ASSOC every
+# open association and ALL_ASSOC both, in a single call. Where the kernel does
+# not take them for an option, _sctp walks the associations itself. Kernels
+# before Linux 5.1 do not reserve them at all, and 1 and 2 are ordinary
+# association ids there: CURRENT_ASSOC and ALL_ASSOC are then negative
+# values that _sctp always emulates.
+FUTURE_ASSOC = _sctp.getconstant("SCTP_FUTURE_ASSOC")
+CURRENT_ASSOC = _sctp.getconstant("SCTP_CURRENT_ASSOC")
+ALL_ASSOC = _sctp.getconstant("SCTP_ALL_ASSOC")
+
 # low-level (sendto/sendmsg) flags
 FLAG_NOTIFICATION = _sctp.getconstant("MSG_NOTIFICATION")
 FLAG_EOR = _sctp.getconstant("MSG_EOR")
 FLAG_DONTROUTE = _sctp.getconstant("MSG_DONTROUTE")
+# sctp_send() flag ending a message sent in pieces (see explicit_eor property)
+FLAG_SEND_EOR = _sctp.getconstant("SCTP_EOR")
 
 (HAVE_SCTP, HAVE_KERNEL_SCTP, HAVE_SCTP_MULTIBUF, HAVE_SCTP_NOCONNECT, \
  HAVE_SCTP_PRSCTP, HAVE_SCTP_ADDIP, HAVE_SCTP_CANSET_PRIMARY, HAVE_SCTP_SAT_NETWORK_CAPABILITY) = \
@@ -107,6 +142,14 @@ SOCK_STREAM = _sctp.getconstant("SOCK_STREAM")
 (STYLE_TCP, STYLE_UDP) = (SOCK_STREAM, SOCK_SEQPACKET)
 (TCP_STYLE, UDP_STYLE) = (STYLE_TCP, STYLE_UDP)
 
+# Linux doubles SO_SNDBUF/SO_RCVBUF requests to make room for its bookkeeping,
+# and getsockopt() returns the doubled value; other systems keep them as given.
+# set_sndbuf()/set_rcvbuf() compensate, so that get_*() returns what was set.
+BUFFER_DOUBLED = sys.platform.startswith("linux")
+
+# Default sctp_sendfile() chunk, in fragmentation points (DATA chunks).
+SENDFILE_SEGMENTS = 16
+
 
 ####################################### STRUCTURES FOR SCTP MESSAGES AND EVENTS
 
@@ -266,6 +309,9 @@ class notification(object):
 	type_SHUTDOWN_EVENT = _sctp.getconstant("SCTP_SHUTDOWN_EVENT")
 	type_PARTIAL_DELIVERY_EVENT = _sctp.getconstant("SCTP_PARTIAL_DELIVERY_EVENT")
 	type_ADAPTATION_INDICATION = _sctp.getconstant("SCTP_ADAPTATION_INDICATION")
+	type_STREAM_RESET_EVENT = _sctp.getconstant("SCTP_STREAM_RESET_EVENT")
+	type_ASSOC_RESET_EVENT = _sctp.getconstant("SCTP_ASSOC_RESET_EVENT")
+	type_STREAM_CHANGE_EVENT = _sctp.getconstant("SCTP_STREAM_CHANGE_EVENT")
 
 class assoc_change(notification):
 	"""
@@ -451,16 +497,83 @@ class pdapi_event(notification):
 	notification will be received only if user subscribed to receive
 	that (see event_subscribe class for details).
 
-	The indication can be one of the indication_* values.
+	The indication can be one of the indication_* values. "stream" and
+	"seq" identify the message, where the implementation reports them
+	(zero otherwise).
 	"""
 	def __init__(self, values=None):
 		self.indication = 0
 		self.assoc_id = 0
+		self.stream = 0
+		self.seq = 0
 		notification.__init__(self, values)
 
 	indication_PD_ABORTED = _sctp.getconstant("SCTP_PARTIAL_DELIVERY_ABORTED")
 	indication_PARTIAL_DELIVERY_ABORTED = indication_PD_ABORTED
 
+class stream_reset_event(notification):
+	"""
+	Stream reset event (RFC 6525). This event is received when a stream reset
+	request, sent either by us (see sctpsocket.reset_streams) or by the peer,
+	is completed.
+
+	stream_list: tuple of the streams affected. An empty tuple means all streams.
+
+	The "flags" attribute is a bitmap of the flags_* class constants, telling
+	the direction that was reset and whether the request was denied or failed.
+
+	The user should never need to instantiate this directly. This
+	notification will be received only if user subscribed to receive
+	that (see event_subscribe class for details).
+	"""
+	def __init__(self, values=None):
+		self.assoc_id = 0
+		self.stream_list = ()
+		notification.__init__(self, values)
+
+	flags_INCOMING_SSN = _sctp.getconstant("SCTP_STREAM_RESET_INCOMING_SSN")
+	flags_OUTGOING_SSN = _sctp.getconstant("SCTP_STREAM_RESET_OUTGOING_SSN")
+	flags_DENIED = _sctp.getconstant("SCTP_STREAM_RESET_DENIED")
+	flags_FAILED = _sctp.getconstant("SCTP_STREAM_RESET_FAILED")
+
+class assoc_reset_event(notification):
+	"""
+	Association reset event (RFC 6525). This event is received when an
+	association reset request (see sctpsocket.reset_assoc) is completed.
+	local_tsn and remote_tsn are the next TSNs to be used in each direction.
+
+	The user should never need to instantiate this directly. This
+	notification will be received only if user subscribed to receive
+	that (see event_subscribe class for details).
+	"""
+	def __init__(self, values=None):
+		self.assoc_id = 0
+		self.local_tsn = 0
+		self.remote_tsn = 0
+		notification.__init__(self, values)
+
+	flags_DENIED = _sctp.getconstant("SCTP_ASSOC_RESET_DENIED")
+	flags_FAILED = _sctp.getconstant("SCTP_ASSOC_RESET_FAILED")
+
+class stream_change_event(notification):
+	"""
+	Stream change event (RFC 6525). This event is received when the number
+	of streams of an association changes, e.g. after sctpsocket.add_streams().
+	instrms and outstrms are the new numbers of inbound and outbound streams.
+
+	The user should never need to instantiate this directly. This
+	notification will be received only if user subscribed to receive
+	that (see event_subscribe class for details).
+	"""
+	def __init__(self, values=None):
+		self.assoc_id = 0
+		self.instrms = 0
+		self.outstrms = 0
+		notification.__init__(self, values)
+
+	flags_DENIED = _sctp.getconstant("SCTP_STREAM_CHANGE_DENIED")
+	flags_FAILED = _sctp.getconstant("SCTP_STREAM_CHANGE_FAILED")
+
 #################################################### NOTIFICATION FACTORY
 
 notification_table = {
@@ -471,6 +584,9 @@ notification_table = {
 	notification.type_SHUTDOWN_EVENT: shutdown_event,
 	notification.type_PARTIAL_DELIVERY_EVENT: pdapi_event,
 	notification.type_ADAPTATION_INDICATION: adaptation_event,
+	notification.type_STREAM_RESET_EVENT: stream_reset_event,
+	notification.type_ASSOC_RESET_EVENT: assoc_reset_event,
+	notification.type_STREAM_CHANGE_EVENT: stream_change_event,
 }
 
 
@@ -506,6 +622,9 @@ def notification_factory(raw_notification):
 		o = notification_table[num_type](raw_notification)
 	return o
 
+# lets sctpsocket.sctp_recv() (_sctp.Socket) build the notification objects
+_sctp.register_notification_types(notification_factory, notification, sndrcvinfo)
+
 ########### EVENT SUBSCRIBING CLASS
 
 class event_subscribe(object):
@@ -539,6 +658,9 @@ class event_subscribe(object):
 	shutdown: refers to shutdon_event() 
 	partial_delivery: refers to pdapi_event()
 	adaptation_layer: refers to adaptation_event()
+	stream_reset: refers to stream_reset_event()
+	assoc_reset: refers to assoc_reset_event()
+	stream_change: refers to stream_change_event()
 
 	(*) sndrcvinfo is ALWAYS returned by sctp_recv() along with message data. The
 	    data_io property just controls whether sndrcvinfo() contains useful data.
@@ -551,6 +673,9 @@ class event_subscribe(object):
 	peererror = peer_error
 	partialdelivery = partial_delivery
 	adaptationlayer = adaptation_layer
+	streamreset = stream_reset
+	assocreset = assoc_reset
+	streamchange = stream_change
 	"""
 
 	def flush(self):
@@ -591,6 +716,15 @@ class event_subscribe(object):
 	def get_data_io(self):
 		return self.__get_property("_data_io")
 
+	def get_stream_reset(self):
+		return self.__get_property("_stream_reset")
+
+	def get_assoc_reset(self):
+		return self.__get_property("_assoc_reset")
+
+	def get_stream_change(self):
+		return self.__get_property("_stream_change")
+
 	def set_adaptation_layer(self, value):
 		self.__set_property("_adaptation_layer", value)
 
@@ -615,6 +749,15 @@ class event_subscribe(object):
 	def set_data_io(self, value):
 		self.__set_property("_data_io", value)
 
+	def set_stream_reset(self, value):
+		self.__set_property("_stream_reset", value)
+
+	def set_assoc_reset(self, value):
+		self.__set_property("_assoc_reset", value)
+
+	def set_stream_change(self, value):
+		self.__set_property("_stream_change", value)
+
 	def clear(self):
 		"""
 		Sets all event properties do False, except data_io what is set to True.
@@ -628,6 +771,9 @@ class event_subscribe(object):
 		self._shutdown = 0
 		self._partial_delivery = 0
 		self._adaptation_layer = 0
+		self._stream_reset = 0
+		self._assoc_reset = 0
+		self._stream_change = 0
 
 		if self.autoflush:
 			self.flush()
@@ -664,6 +810,15 @@ class event_subscribe(object):
 	adaptation_layer = property(get_adaptation_layer, set_adaptation_layer)
 	adaptationlayer = adaptation_layer
 
+	stream_reset = property(get_stream_reset, set_stream_reset)
+	streamreset = stream_reset
+
+	assoc_reset = property(get_assoc_reset, set_assoc_reset)
+	assocreset = assoc_reset
+
+	stream_change = property(get_stream_change, set_stream_change)
+	streamchange = stream_change
+
 
 ########## STRUCTURES EXCHANGED VIA set/getsockopt() 
 
@@ -810,6 +965,109 @@ class paddrparams(object):
 	flags_SACKDELAY_DISABLE = flags_SACKDELAY_DISABLED
 	flags_SACKDELAY_ENABLE  = flags_SACKDELAY_ENABLED
 
+class paddrthlds(object):
+	"""
+	Peer Address Thresholds object class (SCTP_PEER_ADDR_THLDS). This object can be
+	read from a SCTP socket using the get_paddrthlds() method, and *written* to the
+	socket using the set_paddrthlds() socket method.
+
+	assoc_id: the association ID where this info came from, or where this information
+		  is going to be applied to. Ignored/unreliable for TCP-style sockets 
+		  because they hold only one association.
+
+	sockaddr: the peer address this info came from, or where this information is
+		  going to be applied to. The wildcard address ("", 0) means every peer
+		  address of the association (or the socket defaults if assoc_id is zero
+		  on UDP-style sockets).
+
+	pathmaxrxt: maximum number of retransmissions before the peer address is
+		    considered unreachable (the same value as paddrparams.pathmaxrxt).
+		    Zero means "do not change it".
+
+	pf_threshold: number of retransmissions after which the peer address enters
+		      the Potentially-Failed state (RFC 7829): it stops being used for
+		      data, as if it had failed, but keeps being probed by heartbeats.
+		      Zero moves to PF at the first retransmission timeout; a value
+		      not below pathmaxrxt disables the PF state.
+	"""
+	def __init__(self):
+		self.assoc_id = 0
+		self.sockaddr = ("", 0)
+		self.pathmaxrxt = 0
+		self.pf_threshold = 0
+
+class failover_profile(object):
+	"""
+	A coherent set of the settings that decide how fast SCTP abandons a dead
+	path or association, applied all at once by sctpsocket.apply_failover_profile().
+	They are otherwise spread over rtoinfo(), paddrparams(), paddrthlds() and
+	assocparams(). Attributes left as None are not changed.
+
+	rto_initial, rto_min, rto_max: RTO bounds in milisseconds (rtoinfo).
+
+	hbinterval: heartbeat interval in milisseconds; it is how often an idle
+		    path is probed (paddrparams). Heartbeats are enabled.
+
+	pathmaxrxt: retransmissions before a peer address is considered unreachable
+		    (paddrparams/paddrthlds).
+
+	assocmaxrxt: retransmissions before the whole association is considered
+		     unreachable (assocparams). The kernel refuses values above the
+		     sum of pathmaxrxt of the peer addresses of multihomed peers.
+
+	pf_threshold: retransmissions before a peer address becomes Potentially
+		      Failed (RFC 7829) and traffic moves to another path (paddrthlds).
+
+	With the RFC 4960 defaults (rfc4960()), a failed primary path is left after
+	pathmaxrxt consecutive timeouts with exponential backoff from rto_initial,
+	which takes tens of seconds. fast() moves traffic away at the first timeout
+	(pf_threshold 0) with a low RTO ceiling, for about a second.
+	"""
+	def __init__(self, rto_initial=None, rto_min=None, rto_max=None, hbinterval=None,
+			pathmaxrxt=None, assocmaxrxt=None, pf_threshold=None):
+		self.rto_initial = rto_initial
+		self.rto_min = rto_min
+		self.rto_max = rto_max
+		self.hbinterval = hbinterval
+		self.pathmaxrxt = pathmaxrxt
+		self.assocmaxrxt = assocmaxrxt
+		self.pf_threshold = pf_threshold
+
+	@classmethod
+	def rfc4960(cls):
+		"""
+		The protocol defaults (RFC 4960 section 15), without PF.
+		"""
+		return cls(rto_initial=3000, rto_min=1000, rto_max=60000, hbinterval=30000,
+			pathmaxrxt=5, assocmaxrxt=10, pf_threshold=5)
+
+	@classmethod
+	def fast(cls):
+		"""
+		Fast failover: paths are left at the first timeout, dead peers are
+		detected within a few seconds.
+		"""
+		return cls(rto_initial=1000, rto_min=200, rto_max=1000, hbinterval=1000,
+			pathmaxrxt=3, assocmaxrxt=6, pf_threshold=0)
+
+	def _values(self):
+		d = {}
+		for k in ("rto_initial", "rto_min", "rto_max", "hbinterval", "pathmaxrxt",
+				"assocmaxrxt"):
+			v = getattr(self, k)
+			if v is None:
+				v = 0
+			d[k] = v
+		d["pf_threshold"] = self.pf_threshold
+		if self.pf_threshold is None:
+			d["pf_threshold"] = -1
+		return d
+
+	def __repr__(self):
+		return "failover_profile(%s)" % ", ".join(["%s=%r" % (k, getattr(self, k)) for k in
+			("rto_initial", "rto_min", "rto_max", "hbinterval", "pathmaxrxt",
+			"assocmaxrxt", "pf_threshold")])
+
 class paddrinfo(object):
 	"""
 	Peer Address information object class. The user should never need to 
@@ -901,6 +1159,510 @@ class status(object):
 	state_BOUND = _sctp.getconstant("SCTP_BOUND")
 	state_LISTEN = _sctp.getconstant("SCTP_LISTEN")
 
+class prinfo(object):
+	"""
+	Default PR-SCTP (partial reliability) parameters object class. This object can
+	be read from a SCTP socket using the get_default_prinfo() method, and *written*
+	to the socket using set_default_prinfo().
+
+	The kernel applies these defaults only to messages sent without explicit
+	metadata (e.g. send()/sendto()). Messages sent via sctp_send() always carry
+	their own policy, taken from the "pr_policy" and "timetolive" parameters or
+	from the socket's pr_policy and ttl properties.
+
+	assoc_id: the association ID where this info came from, or where this information
+		  is going to be applied to. Zero means the socket default.
+
+	policy: one of the policy_* class constants (PR_SCTP_* module constants)
+
+	value: meaning depends on policy: lifetime in milisseconds for policy_TTL,
+	       maximum number of retransmissions for policy_RTX, priority for
+	       policy_PRIO (lower value means higher priority).
+	"""
+	def __init__(self):
+		self.assoc_id = 0
+		self.policy = 0
+		self.value = 0
+
+	policy_NONE = PR_SCTP_NONE
+	policy_TTL = PR_SCTP_TTL
+	policy_RTX = PR_SCTP_RTX
+	policy_PRIO = PR_SCTP_PRIO
+
+class prstatus(object):
+	"""
+	PR-SCTP abandoned message counters. The user should never need to instantiate
+	this directly. It is received via get_prstatus() socket method call, and is
+	read-only.
+
+	assoc_id: the association ID the counters refer to.
+
+	sid: the stream the counters refer to, or None for the whole association.
+
+	policy: the policy being reported about, one of the PR_SCTP_* constants.
+		PR_SCTP_ALL sums the counters of every policy.
+
+	abandoned_unsent: number of messages abandoned before being ever sent
+
+	abandoned_sent: number of messages abandoned after being sent at least once
+	"""
+	def __init__(self):
+		self.assoc_id = 0
+		self.sid = None
+		self.policy = PR_SCTP_ALL
+		self.abandoned_unsent = 0
+		self.abandoned_sent = 0
+
+class status_table(object):
+	"""
+	Columnar status report of many associations at once, as returned by the
+	get_status_all() socket method. The user should never need to instantiate
+	this directly. It is read-only.
+
+	Every column is an array.array with one item per association, in the same
+	order: assoc_id, state, rwnd, unackdata, penddata, instrms, outstrms,
+	fragmentation_point, and primary_state, cwnd, srtt, rto, mtu, which refer
+	to the primary peer address. Associations that went away while the
+	snapshot was being taken are simply missing.
+
+	If the snapshot was taken with paths, there is also one row per peer address,
+	in the columns path_assoc_id, path_state, path_cwnd, path_srtt, path_rto,
+	path_mtu, path_primary (1 for the primary address) and path_sockaddr (a
+	tuple of address/port pairs).
+
+	len() returns the number of associations. row() and paths_of() build the 
+	usual status() and paddrinfo() objects, for the few associations one
+	wants to look at closely.
+	"""
+	signed_columns = ("assoc_id", "state", "primary_state", "path_assoc_id", "path_state")
+
+	def __init__(self, columns):
+		for name, value in columns.items():
+			if name != "path_sockaddr":
+				if name in self.signed_columns:
+					a = array.array("i")
+				else:
+					a = array.array("I")
+				if hasattr(a, "frombytes"):
+					a.frombytes(value)
+				else:
+					a.fromstring(value) # Python 2
+				value = a
+			self.__dict__[name] = value
+		self.with_paths = "path_assoc_id" in columns
+
+	def __len__(self):
+		return len(self.assoc_id)
+
+	def row(self, i):
+		"""
+		Returns the i-th association as a status() object.
+		"""
+		s = status()
+		s.assoc_id = self.assoc_id[i]
+		s.state = self.state[i]
+		s.rwnd = self.rwnd[i]
+		s.unackdata = self.unackdata[i]
+		s.penddata = self.penddata[i]
+		s.instrms = self.instrms[i]
+		s.outstrms = self.outstrms[i]
+		s.fragmentation_point = self.fragmentation_point[i]
+		s.primary.assoc_id = s.assoc_id
+		s.primary.state = self.primary_state[i]
+		s.primary.cwnd = self.cwnd[i]
+		s.primary.srtt = self.srtt[i]
+		s.primary.rto = self.rto[i]
+		s.primary.mtu = self.mtu[i]
+		if self.with_paths:
+			for p in self.paths_of(s.assoc_id):
+				if p.primary:
+					s.primary.sockaddr = p.sockaddr
+		return s
+
+	def paths_of(self, assoc_id):
+		"""
+		Returns a list of paddrinfo() objects, one per peer address of the
+		association. Each object has an extra "primary" boolean attribute.
+		Only available when the snapshot was taken with paths.
+		"""
+		if not self.with_paths:
+			raise ValueError("snapshot was taken without paths")
+		ret = []
+		for i in range(len(self.path_assoc_id)):
+			if self.path_assoc_id[i] != assoc_id:
+				continue
+			p = paddrinfo()
+			p.assoc_id = assoc_id
+			p.sockaddr = self.path_sockaddr[i]
+			p.state = self.path_state[i]
+			p.cwnd = self.path_cwnd[i]
+			p.srtt = self.path_srtt[i]
+			p.rto = self.path_rto[i]
+			p.mtu = self.path_mtu[i]
+			p.primary = bool(self.path_primary[i])
+			ret.append(p)
+		return ret
+
+class latency_histogram(object):
+	"""
+	Log-bucketed histogram, part of the result of sctpsocket.latency_stats().
+	The user should never need to instantiate this directly.
+
+	Relevant attributes:
+
+	count, sum, min, max: number of samples, their sum, smallest and largest value.
+
+	buckets: list of (lower_bound, count) tuples, for non-empty buckets only, in 
+		 ascending order. A bucket spans up to the next lower bound; bucket width
+		 is 1/8 of the lower bound, so any value derived from buckets is within
+		 12.5% of the real one.
+
+	Times are in nanoseconds, sizes in bytes.
+	"""
+	def __init__(self, values):
+		self.count = 0
+		self.sum = 0
+		self.min = 0
+		self.max = 0
+		self.buckets = []
+		self.__dict__.update(values)
+
+	def mean(self):
+		if not self.count:
+			return 0
+		return float(self.sum) / self.count
+
+	def percentile(self, p):
+		"""
+		Returns the lower bound of the bucket where the p-th percentile 
+		(0 < p <= 100) falls in.
+		"""
+		if not self.count:
+			return 0
+		threshold = self.count * p / 100.0
+		seen = 0
+		for lower, count in self.buckets:
+			seen += count
+			if seen >= threshold:
+				return max(lower, self.min)
+		return self.max
+
+class latency_stats(object):
+	"""
+	Snapshot of latency statistics of a socket, as returned by 
+	sctpsocket.latency_stats(). The user should never need to instantiate this 
+	directly.
+
+	Relevant attributes:
+
+	send_ns: latency_histogram() of time spent inside sctp_sendmsg(), e.g. 
+		 blocked because the send buffer is full
+	send_bytes: latency_histogram() of bytes per successful sctp_send() call
+	recv_ns: latency_histogram() of time spent inside sctp_recvmsg()
+	recv_bytes: latency_histogram() of bytes per successful sctp_recv() call 
+		    (notifications included)
+	recv_gap_ns: latency_histogram() of time between successive successful receptions
+	send_eagain, recv_eagain: number of calls that failed with EAGAIN/EWOULDBLOCK
+	send_errors, recv_errors: number of calls that failed with other errors
+
+	Failed calls are accounted in send_ns/recv_ns too.
+	"""
+	def __init__(self, values):
+		self.send_eagain = 0
+		self.send_errors = 0
+		self.recv_eagain = 0
+		self.recv_errors = 0
+		for k, v in values.items():
+			if isinstance(v, dict):
+				v = latency_histogram(v)
+			self.__dict__[k] = v
+
+# Association statistics snapshot (SCTP_GET_ASSOC_STATS). It is a compact,
+# read-only record built on the C side; see get_assoc_stats() and
+# assoc_stats_delta() for details.
+assoc_stats = _sctp.assoc_stats
+
+def assoc_stats_delta(new, old):
+	"""
+	Computes the difference between two assoc_stats snapshots of the same
+	association, e.g. to obtain rates. Every counter of the result is the
+	increment between "old" and "new", "timestamp" is the elapsed time in
+	seconds, while assoc_id, maxrto and obs_rto_sockaddr come from "new".
+	"""
+	return _sctp.assoc_stats_delta(new, old)
+
+class periodic_sampler(object):
+	"""
+	Base of the helpers that watch a socket (sctp_pathmgr.path_manager,
+	sctp_autotune.buffer_tuner): start() runs self.sample() every
+	self.interval seconds from a daemon thread, until stop().
+
+	An IOError or OSError raised by sample() is passed to
+	_sample_error(exception), which returns True to go on sampling. By
+	default it does not, and the thread ends: the socket was most likely
+	closed while being sampled.
+	"""
+	interval = 1.0
+	_thread = None
+
+	def _sample_error(self, e):
+		return False
+
+	def _run(self, stop):
+		while not stop.wait(self.interval):
+			try:
+				self.sample()
+			except (IOError, OSError) as e:
+				if not self._sample_error(e):
+					break
+
+	def start(self):
+		"""
+		Starts sampling in the background.
+		"""
+		if self._thread:
+			raise ValueError("%s already started" % type(self).__name__)
+		self._stop = threading.Event()
+		self._thread = threading.Thread(target=self._run, args=(self._stop,))
+		self._thread.daemon = True
+		self._thread.start()
+
+	def stop(self):
+		"""
+		Stops sampling in the background, waiting for a sample in progress.
+		"""
+		if self._thread:
+			self._stop.set()
+			self._thread.join()
+			self._thread = None
+
+# Immutable set of socket addresses, packed on the C side the way the kernel
+# takes them. Built from (address, port) tuples, e.g.
+# AddressSet([("10.0.0.1", 5000), ("10.0.1.1", 5000)]); it is a sequence of
+# such tuples, in insertion order and without duplicates, and supports
+# "in", union (|), difference (-) and intersection (&). It compares and
+# hashes as the tuple of its entries, as getpaddrs() results always did, so
+# == is order-sensitive: compare set(a) and set(b) to ignore the order.
+# bindx() and connectx() accept it, and getpaddrs() and getladdrs() return
+# it, so e.g. the addresses a multihomed endpoint gained are
+# sk.getladdrs() - old_addrs, without formatting any address.
+AddressSet = _sctp.AddressSet
+
+# SIGTRAN message codecs (M3UA), parsing in place over received buffers;
+# see the _sigtran module. Optional, as the module may not be built.
+try:
+	import _sigtran as sigtran
+except ImportError:
+	sigtran = None
+
+# Diameter message index (PPID_DIAMETER), same approach; see _diameter
+try:
+	import _diameter as diameter
+except ImportError:
+	diameter = None
+
+class pcap_writer(object):
+	"""
+	Records SCTP traffic of one or more sockets into pcapng files, loadable in
+	Wireshark. Each message sent by sctp_send() or received by sctp_recv() is
+	recorded as a synthetic IP/SCTP packet with a DATA chunk holding stream, 
+	SSN, PPID and TSN (the latter two are known only for received messages, and 
+	only if data_io events are on), plus a comment with the assoc_id.
+
+	Recording is done by the C side: the socket calls just copy the record into
+	a memory buffer, and a background thread writes it to disk. If the disk 
+	cannot keep up, records are dropped (see stats()) instead of slowing the 
+	socket down. A forked child process gets the writer stopped: open a new 
+	one there to record its traffic.
+
+	A message received in pieces (partial delivery), or sent in pieces with
+	explicit_eor, is recorded as one DATA chunk sequence: only the first piece
+	has the B(eginning) flag, only the last one the E(nd) flag.
+
+	Parameters:
+
+	prefix: file name prefix; files are named <prefix>-<YYYYmmddHHMMSS>-<n>.pcapng
+
+	max_bytes: a new file is started when the current one reaches this size.
+		   Zero means no limit.
+
+	max_seconds: a new file is started when the current one is this old. Zero
+		     means no limit.
+
+	buffer_size: size of each of the two memory buffers.
+
+	snaplen: maximum bytes of each packet to record. Zero means whole packets.
+
+	Attach a writer to a socket with sctpsocket.datalogging = writer.
+	"""
+	def __init__(self, prefix="RECORD_sctp_traffic", max_bytes=64*1024*1024, max_seconds=0,
+			buffer_size=4*1024*1024, snaplen=0):
+		self._writer = _sctp.pcap_open(prefix, max_bytes, max_seconds, buffer_size, snaplen)
+
+	def close(self):
+		"""
+		Writes pending records and closes the current file. Sockets that still
+		use the writer stop recording.
+		"""
+		_sctp.pcap_close(self._writer)
+
+	def stats(self):
+		"""
+		Returns a dictionary with "packets" and "bytes" recorded, "dropped" 
+		packets (buffer full, or lost with a file that could not be opened), 
+		number of "files" opened, current "filename", last "error" (errno) 
+		and whether the writer is "running".
+		"""
+		return _sctp.pcap_stats(self._writer)
+
+# Writers used by "datalogging = True", by file prefix
+_default_pcap_writers = {}
+
+def _default_pcap_writer(prefix):
+	w = _default_pcap_writers.get(prefix)
+	if w is None:
+		w = _default_pcap_writers[prefix] = pcap_writer(prefix)
+	return w
+
+######### /proc/net/sctp READERS
+
+PROC_NET_SCTP = "/proc/net/sctp"
+
+if hasattr(array, "typecodes") and "q" in array.typecodes:
+	_int64_code = "q"
+else:
+	# Python 2; long is 64 bits on LP64 platforms
+	_int64_code = "l"
+
+class snmp_stats(object):
+	"""
+	SCTP MIB counters, as read from /proc/net/sctp/snmp by proc_snmp(). Every
+	counter is an attribute with the kernel name (e.g. SctpOutSCTPPacks, 
+	SctpT3Retransmits). timestamp is a monotonic clock reading in seconds.
+
+	Instances returned by snmp_delta() hold increments instead, and timestamp
+	is the elapsed time; rate() and retransmission_ratio() are meaningful 
+	for them.
+	"""
+	def __init__(self, timestamp, counters):
+		self.timestamp = timestamp
+		self.counters = counters
+		self.__dict__.update(counters)
+
+	def rate(self, name):
+		"""
+		Returns the per-second rate of a counter of a delta.
+		"""
+		if self.timestamp <= 0:
+			return 0.0
+		return self.counters.get(name, 0) / float(self.timestamp)
+
+	def retransmission_ratio(self):
+		"""
+		Returns the ratio of retransmitted to transmitted DATA chunks of a delta.
+		"""
+		c = self.counters
+		sent = c.get("SctpOutOrderChunks", 0) + c.get("SctpOutUnorderChunks", 0)
+		if not sent:
+			return 0.0
+		return (c.get("SctpT3Retransmits", 0) + c.get("SctpFastRetransmits", 0)) / float(sent)
+
+def proc_snmp(path=PROC_NET_SCTP + "/snmp"):
+	"""
+	Returns the host-wide SCTP MIB counters as an snmp_stats() object.
+	"""
+	return snmp_stats(*_sctp.proc_read_snmp(path))
+
+def snmp_delta(new, old):
+	"""
+	Computes the increments between two snmp_stats snapshots. Gauges like
+	SctpCurrEstab are reported as differences too.
+	"""
+	counters = {}
+	for name, value in new.counters.items():
+		counters[name] = value - old.counters.get(name, 0)
+	return snmp_stats(new.timestamp - old.timestamp, counters)
+
+class proc_table(object):
+	"""
+	Columnar contents of a /proc/net/sctp table, as returned by proc_eps(),
+	proc_assocs() and proc_remaddr(). The user should never need to instantiate
+	this directly.
+
+	Each header column becomes an attribute, lowercased and with "-" replaced 
+	by "_" (e.g. assoc_id, tx_queue, rtxc). Numeric columns are array.array 
+	objects of 64-bit integers; addr is a list of strings, laddrs and raddrs
+	are lists of tuples of addresses, and primary is the list of primary remote 
+	addresses. Columns depend on kernel version; "columns" lists the available 
+	ones. timestamp is a monotonic clock reading in seconds. 
+	"""
+	def __init__(self, timestamp, columns):
+		self.timestamp = timestamp
+		self.columns = []
+		for name, value in columns.items():
+			name = name.lower().replace("-", "_")
+			if isinstance(value, bytes):
+				a = array.array(_int64_code)
+				if hasattr(a, "frombytes"):
+					a.frombytes(value)
+				else:
+					a.fromstring(value) # Python 2
+				value = a
+			self.__dict__[name] = value
+			self.columns.append(name)
+
+	def __len__(self):
+		for name in self.columns:
+			return len(self.__dict__[name])
+		return 0
+
+def proc_eps(path=PROC_NET_SCTP + "/eps"):
+	"""
+	Returns the SCTP endpoints of the host as a proc_table().
+	"""
+	return proc_table(*_sctp.proc_read_table(path))
+
+def proc_assocs(path=PROC_NET_SCTP + "/assocs"):
+	"""
+	Returns the SCTP associations of the host as a proc_table().
+	"""
+	return proc_table(*_sctp.proc_read_table(path))
+
+def proc_remaddr(path=PROC_NET_SCTP + "/remaddr"):
+	"""
+	Returns the remote addresses of all SCTP associations of the host as a proc_table().
+	"""
+	return proc_table(*_sctp.proc_read_table(path))
+
+def proc_table_delta(new, old, key="assoc_id", columns=("rtxc",)):
+	"""
+	Computes per-row increments of counter columns between two proc_table
+	snapshots (e.g. retransmissions per association), matching rows by the
+	"key" column. Rows not present in both snapshots are left out. Returns a
+	dictionary with the "key" column and the increments of "columns", as
+	arrays, plus "elapsed" seconds.
+	"""
+	index = {}
+	okey = getattr(old, key)
+	for i in range(len(okey)):
+		index[okey[i]] = i
+
+	nkey = getattr(new, key)
+	ret = {key: array.array(_int64_code), "elapsed": new.timestamp - old.timestamp}
+	pairs = []
+	for i in range(len(nkey)):
+		j = index.get(nkey[i])
+		if j is not None:
+			ret[key].append(nkey[i])
+			pairs.append((i, j))
+
+	for name in columns:
+		ncol = getattr(new, name)
+		ocol = getattr(old, name)
+		ret[name] = array.array(_int64_code, [ncol[i] - ocol[j] for i, j in pairs])
+
+	return ret
+
 ######### IMPLEMENTATION FEATURE LIST BITMAP
 
 def features():
@@ -931,7 +1693,24 @@ def features():
 
 #################### THE REAL THING :)
 
-class sctpsocket(object):
+def _socket_from_fd(family, fd):
+	"""
+	Wraps a non-blocking SCTP descriptor, as returned by _sctp.accept_many(),
+	into a Python socket that takes ownership of it.
+	"""
+	if sys.version_info[0] < 3:
+		# Python 2 can only duplicate it
+		sk = socket.fromfd(fd, family, SOCK_STREAM, IPPROTO_SCTP)
+		os.close(fd)
+		sk.setblocking(False)
+		return sk
+	nonblock = getattr(socket, "SOCK_NONBLOCK", 0)
+	sk = socket.socket(family, SOCK_STREAM | nonblock, IPPROTO_SCTP, fd)
+	if not nonblock:
+		sk.setblocking(False)
+	return sk
+
+class sctpsocket(_sctp.Socket):
 	"""
 	This is the base class for SCTP sockets. In general, the user will use sctpsocket_tcp()
 	and sctpsocket_udp(), althrough it can use directly this class because all required
@@ -942,6 +1721,11 @@ class sctpsocket(object):
 	and DELEGATES unknown method calls to that socket. So, we expect that sctpsocket 
 	objects can be used in most places where a regular socket is expected. 
 
+	It inherits from _sctp.Socket, which keeps the file descriptor and the sctp_send()
+	defaults (ttl, streamid, pr_policy, adaptation) in C and implements sctp_send(),
+	sctp_recv(), fileno(), close() and detach(). Closing the socket through sock()
+	instead of close() leaves a stale descriptor behind; don't.
+
 	Main methods:
 
 	bindx: allows to bind to a set of network interfaces (standard bind() allows
@@ -958,11 +1742,14 @@ class sctpsocket(object):
 	sctp_send: Sends a SCTP message.  Allows to pass some SCTP-specific parameters.
 		   If the specific parameters are not relevant, send() or sendto()
 		   can also be used for SCTP.
+	sctp_sendfile: Sends a file or a stream of bytes in chunks, in constant memory.
 	sctp_recv: Receives a SCTP messages. Returns SCTP-specific metadata along
 		   with the data. If the metadata is not relevant for the 
 		   application, recv()/recvfrom() and read() will also work.
+	sctp_recv_stream: Iterates over received data as bounded-size fragments.
 	peeloff: Detaches ("peels off") an association from an UDP-style socket.
 	accept: Overrides socket standard accept(), works the same way.
+	accept_many: Accepts a batch of pending connections in one call.
 	set_peer_primary: Sets the peer primary address 
 	set_primary: Set the local primary address
 
@@ -997,6 +1784,20 @@ class sctpsocket(object):
 		  (::ffff:0:0/96). The default is True. Otherwise, the application can receive
 		  either pure IPv6 or IPv4 addresses.
 
+	partial_delivery_point: Size, in bytes, from which the kernel starts handing
+				over a message before it is complete. Lower values bound
+				the memory a large message takes in the receive buffer.
+
+	fragment_interleave: 0 (default on most implementations) delivers the
+			     fragments of a partially delivered message in a row,
+			     holding back everything else on the socket; 1 lets
+			     other associations in between, and 2 other streams,
+			     too. Some implementations only tell 0 from non-zero.
+
+	explicit_eor: If True, a message may be sent in pieces, by several sctp_send()
+		      calls; it ends with the one that has FLAG_SEND_EOR. Not supported
+		      on Linux (IOError ENOPROTOOPT).
+
 	maxseg: Maximum segment size i.e. the size of a message chunk inside a datagram,
 	        in bytes. This value indirectly limits the size of the whole datagram, since
 		datagram = maxseg + a fixed overhead.
@@ -1006,6 +1807,18 @@ class sctpsocket(object):
 		   will be done. This property does not work for TCP-style sockets.
 
 	ttl: Default timetolive value to use with sctp_send. Default set to 0.
+	     Its meaning depends on the PR-SCTP policy in use (see pr_policy).
+
+	pr_policy: Default PR-SCTP policy to use with sctp_send, one of the PR_SCTP_*
+		   constants. Default is PR_SCTP_NONE, where a non-zero ttl is a plain
+		   lifetime. Other policies raise IOError(ENOPROTOOPT) if pysctp was
+		   built without PR-SCTP support.
+
+	pr_supported: If True, the PR-SCTP extension is negotiated for new associations.
+
+	reconfig_supported: If True, the stream reconfiguration extension (RFC 6525) is
+			    negotiated for new associations. Needed by reset_streams(),
+			    reset_assoc() and add_streams().
 
 	streamid: Default SCTP stream identifier value to use with sctp_send. Default set to 0.
 
@@ -1030,16 +1843,17 @@ class sctpsocket(object):
 		if not sk:
 			sk = socket.socket(family, style, IPPROTO_SCTP)
 
-		self._style = style
-		self._sk = sk
-		self._family = family
+		_sctp.Socket.__init__(self, family, style, sk)
 		self._ttl = 0
+		self._pr_policy = PR_SCTP_NONE
 		self._streamid = 0
+		self._latency = None
 
 		self.unexpected_event_raises_exception = False
-		self.initparams = initparams(self)
-		self.events = event_subscribe(self)
+		# "initparams" and "events" are built on first use, see __getattr__;
+		# they cost a getsockopt() each, for nothing on most accepted sockets
 
+		self._pcap = None
 		self.datalogging = False
 
 	def bindx(self, sockaddrs, action=BINDX_ADD):
@@ -1054,32 +1868,46 @@ class sctpsocket(object):
 		
 		Parameters:
 
-		sockaddr: List of (address, port) tuples.
+		sockaddr: List of (address, port) tuples, or an AddressSet.
 		action: BINDX_ADD or BINDX_REMOVE. Default is BINDX_ADD.
 
 		bindx() raises an exception if bindx() is not successful.
 		"""
 		_sctp.bindx(self._sk.fileno(), sockaddrs, action)
 
-	def connectx(self, sockaddrs, assoc_id=None):
+	def connectx(self, sockaddrs, assoc_id=None, nonblocking=False):
 		"""
 		Connects to a remote peer. It works like standard connect(), but accepts
 		a list of address/port pairs, in order to support the SCTP multihoming
 
 		Parameters:
 
-		sockaddrs: List of (address, port) tuples.
+		sockaddrs: List of (address, port) tuples, or an AddressSet.
+
+		assoc_id: optional dictionary; if passed, the association ID is also
+			  stored in it, under the "assoc_id" key.
+
+		nonblocking: if True, connectx() starts the handshake and returns
+			     without waiting for it to complete. The socket must be in
+			     non-blocking mode already (setblocking(False)), or
+			     ValueError is raised: O_NONBLOCK is shared by every user
+			     of the socket, so it is not switched temporarily.
+			     Completion is reported by an assoc_change() notification
+			     (state_COMM_UP or state_CANT_STR_ASSOC).
+
+		Returns the association ID, which is known as soon as the handshake
+		starts. See also sctpsocket_udp.connectx_many().
 
 		connectx() raises an exception if it is not successful. Warning: not all 
 		SCTP implementations support connectx(). It will raise an RuntimeError()
 		if not supported.
 		"""
 		if "connectx" in _sctp.__dict__:
-			_sctp.connectx(self._sk.fileno(), sockaddrs, assoc_id)
+			return _sctp.connectx(self._sk.fileno(), sockaddrs, assoc_id, nonblocking and 1 or 0)
 		else:
 			raise RuntimeError("Underlying SCTP implementation does not have connectx()")
 
-	def getpaddrs(self, assoc_id = 0): # -> tuple of sockaddrs as strings
+	def getpaddrs(self, assoc_id = 0): # -> AddressSet
 		"""
 		Gets a list of remote address/pair tuples from an specific association.
 
@@ -1088,12 +1916,12 @@ class sctpsocket(object):
 		assoc_id: Association ID of the association to be queried. If the socket is
 			  TCP-style, this parameter is ignored.
 
-		Returns: a list of address/port tuples.
+		Returns: an AddressSet, that is, a sequence of address/port tuples.
 		"""
 		
 		return _sctp.getpaddrs(self._sk.fileno(), assoc_id)
 
-	def getladdrs(self, assoc_id = 0): # -> tuple of sockaddrs as strings
+	def getladdrs(self, assoc_id = 0): # -> AddressSet
 		"""
 		Gets a list of local address/pair tuples from an specific association.
 
@@ -1103,7 +1931,7 @@ class sctpsocket(object):
 			  TCP-style, this parameter is ignored. If zero is passed for an
 			  UDP-style socket, it refers to the socket default local address.
 
-		Returns: a list of address/port tuples. 
+		Returns: an AddressSet, that is, a sequence of address/port tuples.
 		
 		Note that if you do not bind() explicitely (e.g. in client-side programs), 
 		this method will return only one wildcard address, which is useful only
@@ -1112,143 +1940,193 @@ class sctpsocket(object):
 
 		return _sctp.getladdrs(self._sk.fileno(), assoc_id)
 
-	def sctp_send(self, msg, to=("",0), ppid=None, flags=0, stream=None, timetolive=None, context=0,
-	                    record_file_prefix="RECORD_sctp_traffic", datalogging = False):
-		"""
-		Sends a SCTP message. While send()/sendto() can also be used, this method also
-		accepts some SCTP-exclusive metadata. Parameters:
-
-		msg: string containing the message to be sent.
-
-		to: an address/port tuple identifying the destination, or the assoc_id for the
-		    association. It can (and generally must) be omitted for TCP-style sockets.
-
-		    WARNING: identifying destination by Association ID not implemented yet!
+	# sctp_send() is implemented by _sctp.Socket, which documents it.
 
-		ppid: adaptation layer value, a 32-bit metadata that is sent along the message.
-		      Default to 0.
-
-		flags: a bitmap of MSG_* flags. For example, MSG_UNORDERED indicates that 
-		       message can be delivered out-of-order, and MSG_EOF + empty message 
-		       shuts down the association. Defaults to no flags set.
-
-		       It does NOT include flags like MSG_DONTROUTE or other low-level flags
-		       that are supported by sendto().
-
-		stream: stream number where the message will sent by.
-				If not set use default value.
-
-		timetolive: time to live of the message in milisseconds. Zero means infinite
-		            TTL. If TTL expires, the message is discarded. Discarding policy
-			    changes whether implementation implements the PR-SCTP extension or not.
-			    If not set use default value.
-
-		context: an opaque 32-bit integer that will be returned in some notification events,
-		         if the event is directly related to this message transmission. So the
-			 application can know exactly which message triggered which event.
-			 Defaults to 0.
-		
-		The method returns the number of bytes sent. Ideally it is going to be exacly the
-		size of the message. Transmission errors will trigger an exception.
-		
-
-		WARNING: the maximum message size that can be sent via SCTP is limited
-		both by the implementation and by the transmission buffer (SO_SNDBUF).
-		The application must configure this buffer accordingly.
+	def _default_pcap(self, record_file_prefix):
 		"""
-
-		if ppid is None:
-			ppid = self.adaptation
-
-		if timetolive is None:
-			timetolive = self._ttl
-
-		if stream is None:
-			stream = self._streamid
-
-		if datalogging == True or self.datalogging == True:
-			now = datetime.datetime.now()
-			recordfilename = record_file_prefix + "-" + now.strftime("%Y%m%d%H%M%S") + "-c2s."
-			i = 1
-			while os.path.exists(recordfilename+"%d"%i):
-				i = i + 1
-			recordlog = open(recordfilename+"%d"%i, 'w')
-			recordlog.write(msg)
-			recordlog.close()
-		return _sctp.sctp_send_msg(self._sk.fileno(), msg, to, ntohl(ppid), flags, stream, timetolive, context)
-
-	def sctp_recv(self, maxlen):
+		Writer used by sctp_send(datalogging=True) when the socket is not recording.
 		"""
-		Receives an SCTP message and/or a SCTP notification event. The notifications
-		that can be received are regulated by "events" property and its subproperties.
-		See event_subscribe() class for details.
-
-		It is important to know that sctp_recv() can return either on data messages or
-		on subscribed events. If the application just wants data, it must unsubscribe
-		the other events.
-
-		Parameters;
-
-		maxlen: the maximum message size that can be received. If bigger messages are
-		received, they will be received in fragments (non-atomically). The application 
-		must choose this carefully if it wants to keep the atomicity of messages!
+		return _default_pcap_writer(record_file_prefix)._writer
 
-		Returns: (fromaddr, flags, msg, notif)
-
-		fromaddr: address/port pair. For some applications, association ID will be more
-		          useful to identify the related association. Fortunately, assoc_id is
-			  a attribute of most notifications received via "notif" (see below)
-
-		flags: a bitmap of lower-level recvmsg() flags (FLAG_* flags).  
-		
-			FLAG_NOTIFICATION indicates that an event notification was 
-			returned, instead of a data message.
-
-		 	FLAG_EOR indicates that this is the final fragment of a data message.
-			Ideally, all messages will come with this flag set.
-
-		       WARNING: message data-related flags like MSG_UNORDERED are returned
-		       inside sndrcvinfo() notifications, and NOT here!
-
-		msg: the actual data message. Since SCTP does not allow empty messages,
-		     an empty "msg" always means something special, either:
+	def sctp_sendfile(self, source, to=("",0), ppid=None, flags=0, stream=None, timetolive=None,
+			  context=0, chunk_size=None, single_message=False, offset=None, count=None,
+			  timeout=None):
+		"""
+		Sends the contents of a file, or of a stream of bytes, in chunks, so that
+		payloads of any size go out in constant memory. Parameters:
 
-		    	a) that "notif" contains an event notificatoin, if "flags" has 
-			   FLAG_NOTIFICATION set;
+		source: a file descriptor, an object with fileno() (file, pipe, socket),
+			or an iterable of bytes-like objects. File descriptors are read
+			and sent by a single C call, with the GIL released.
 
-			b) that association is closing (for TCP-style sockets only)
+		to, ppid, flags, stream, timetolive, context: as in sctp_send(); they
+			apply to every chunk. The socket defaults apply, too.
 
-		notif: notification event object. If "msg" is a data message, it will contain
-		       a sndrcvinfo() object that contains metadata about the message. If 
-		       "flags" has FLAG_NOTIFICATION set, it will contain some notification()
-		       subclass.
+		chunk_size: bytes per message. The default is SENDFILE_SEGMENTS times
+			    the fragmentation point of the association (maxseg if it
+			    cannot be queried), so that no message ends in a runt DATA
+			    chunk, within a quarter of SO_SNDBUF.
 
-		       sndrcvinfo() is ALWAYS returned when a data message is received, but
-		       it will only contain useful data IF events.data_io is subscribed True.
+		single_message: if True, the whole transfer is one SCTP message: the
+				chunks are pieces of it and the last one carries EOR.
+				It needs SCTP_EXPLICIT_EOR (see explicit_eor property),
+				which is switched on for the transfer; IOError(ENOPROTOOPT)
+				is raised where it is not supported (Linux).
 
-		WARNING: the maximum message size that can be received via SCTP is limited:
+		offset: where to start reading a file. By default, files are read from
+			their current position (tell() for file objects, which are then
+			left after the data sent).
 
-		* by the underlying implementation. Check your operating system.
+		count: maximum number of bytes to send; None sends up to the end.
 
-		* by the "maxlen" parameter passed. If message is bigger, it will be received
-		  in several fragments. The last fragment will have FLAG_EOR flag set.
+		timeout: when the send buffer is full, the call waits for room, even
+			 if the socket is non-blocking (backpressure). timeout bounds
+			 each wait, in seconds; IOError(ETIMEDOUT) is then raised.
+			 None waits as long as needed. The blocking mode of the
+			 socket is left alone: chunks are sent with MSG_DONTWAIT,
+			 and poll() waits for room in between.
 
-		* by the socket's reception buffer (SO_SNDRCV). The application must configure 
-		  this buffer accordingly, otherwise the message will be truncacted.
+		Returns the number of bytes sent.
 		"""
-		(fromaddr, flags, msg, _notif) = _sctp.sctp_recv_msg(self._sk.fileno(), maxlen)
-
-		if (flags & FLAG_NOTIFICATION):
-			notif = notification_factory(_notif)
-			if (notif.__class__ == notification):
-				# Raw notification class, means we do not know the exact type
-				# of this notification
-				if self.unexpected_event_raises_exception:
-					raise IOError("An unknown event notification has arrived")
+		if chunk_size is None:
+			chunk_size = self._sendfile_chunk(to)
+		if timeout is None:
+			timeout = -1
 		else:
-			notif = sndrcvinfo(_notif)
-		
-		return (fromaddr, flags, msg, notif)
+			timeout = int(timeout * 1000)
+
+		fd = self._sk.fileno()
+		explicit_eor = None
+		if single_message:
+			explicit_eor = _sctp.get_explicit_eor(fd)
+			if not explicit_eor:
+				_sctp.set_explicit_eor(fd, True)
+
+		# ppid, stream and timetolive default as in sctp_send(), on the C side
+		try:
+			if isinstance(source, int) or hasattr(source, "fileno"):
+				return self._sendfile_fd(source, to, ppid, flags, stream, timetolive,
+							 context, chunk_size, single_message, offset, count,
+							 timeout)
+			return self._sendfile_iter(source, to, ppid, flags, stream, timetolive,
+						   context, chunk_size, single_message, count, timeout)
+		finally:
+			if explicit_eor is False:
+				_sctp.set_explicit_eor(fd, False)
+
+	def _sendfile_chunk(self, to):
+		frag = 0
+		try:
+			if isinstance(to, int) or self._style == TCP_STYLE:
+				frag = self.get_status(isinstance(to, int) and to or 0).fragmentation_point
+			if not frag:
+				frag = self.get_maxseg()
+		except (IOError, OSError, ValueError):
+			pass
+		frag = frag or 1452
+		return max(frag, min(frag * SENDFILE_SEGMENTS, self.get_sndbuf() // 4 // frag * frag))
+
+	def _sendfile_fd(self, source, to, ppid, flags, stream, ttl, context, chunk_size, eor,
+			 offset, count, timeout):
+		fileobj = None
+		if not isinstance(source, int):
+			fileobj = source
+			source = source.fileno()
+			if offset is None:
+				try:
+					offset = fileobj.tell()
+				except (IOError, OSError, AttributeError):
+					pass
+
+		sent = self._send_file(source, offset is None and -1 or offset,
+			count is None and -1 or count, chunk_size, to, ppid, flags, stream, ttl,
+			context, eor and 1 or 0, timeout)
+		if fileobj is not None and offset is not None:
+			# as socket.sendfile(), leave the file object after the data sent
+			fileobj.seek(offset + sent)
+		return sent
+
+	def _sendfile_iter(self, source, to, ppid, flags, stream, ttl, context, chunk_size, eor,
+			   count, timeout):
+		total = 0
+		buf = bytearray()
+		for data in source:
+			if count is not None:
+				data = data[:count - total - len(buf)]
+			buf += data
+			# with EOR, a full chunk is held back until it is known not to be the last
+			while len(buf) > chunk_size or (len(buf) == chunk_size and not eor):
+				total += self._send_chunk(buf[:chunk_size], to, ppid, flags, stream, ttl,
+							  context, timeout)
+				del buf[:chunk_size]
+			if count is not None and total + len(buf) >= count:
+				break
+		if buf:
+			total += self._send_chunk(buf, to, ppid, eor and flags | FLAG_SEND_EOR or flags,
+						  stream, ttl, context, timeout)
+		return total
+
+	# sctp_recv() is implemented by _sctp.Socket, which documents it.
+
+	def sctp_recv_stream(self, maxlen=65536, on_notification=None):
+		"""
+		Iterates over the data received as fragments of at most "maxlen" bytes,
+		so that messages of any size can be processed incrementally. Yields
+		(assoc_id, stream, data, eor) tuples; "eor" is True on the last fragment
+		of a message.
+
+		The kernel hands over a message before it is complete once it holds
+		partial_delivery_point bytes of it. With fragment_interleave at 0, the
+		fragments of one message then arrive in a row; at 1 or 2, fragments of
+		messages of other associations (1) or streams (2) may come in between,
+		and (assoc_id, stream) tell them apart. data_io events are subscribed,
+		since the identity comes with them.
+
+		Notifications are passed to on_notification(notif), or discarded if it
+		is None. A pdapi_event() with indication PARTIAL_DELIVERY_ABORTED ends
+		the message of its (assoc_id, stream) without a fragment marked eor;
+		without on_notification, it is yielded as (assoc_id, stream, None, True)
+		instead, so that the caller can drop what it has gathered. "stream" is
+		0 where the implementation does not report it (see pdapi_event).
+
+		data_io and partial_delivery events are subscribed for the duration of
+		the iteration, and unsubscribed again when it ends (or the generator is
+		closed) if they were not subscribed before.
+
+		The iteration ends when the peer closes a TCP-style socket, or when a
+		non-blocking socket has nothing more to return.
+		"""
+		events = self.events
+		data_io = events.data_io
+		partial_delivery = events.partial_delivery
+		if not data_io:
+			events.data_io = True
+		if not partial_delivery:
+			events.partial_delivery = True
+
+		try:
+			while True:
+				try:
+					fromaddr, flags, msg, notif = self.sctp_recv(maxlen)
+				except (IOError, OSError) as e:
+					if e.errno in (errno.EAGAIN, errno.EWOULDBLOCK):
+						return
+					raise
+				if flags & FLAG_NOTIFICATION:
+					if on_notification:
+						on_notification(notif)
+					elif isinstance(notif, pdapi_event) and \
+					     notif.indication == pdapi_event.indication_PARTIAL_DELIVERY_ABORTED:
+						yield (notif.assoc_id, notif.stream, None, True)
+					continue
+				if not msg:
+					return
+				yield (notif.assoc_id, notif.stream, msg, bool(flags & FLAG_EOR))
+		finally:
+			if not data_io:
+				events.data_io = False
+			if not partial_delivery:
+				events.partial_delivery = False
 
 	def peeloff(self, assoc_id): 
 		"""
@@ -1283,6 +2161,39 @@ class sctpsocket(object):
 		else:
 			raise IOError("sctpsocket.accept() failed for unknown reason")
 	
+	def accept_many(self, max=64):
+		"""
+		Accepts up to "max" pending connections at once. The accept queue is
+		drained by a single C call (accept4() where available) with the GIL
+		released, which is much cheaper than accept() in a loop under
+		connection storms. Once a connection has been accepted, it never
+		waits for more, even on a blocking socket.
+
+		Returns a list of (sctpsocket_tcp, fromaddr) pairs, empty if the
+		socket is non-blocking and nothing is pending. The new sockets are
+		non-blocking and close-on-exec.
+		"""
+		family = self._family
+		accepted = _sctp.accept_many(self._sk.fileno(), max)
+		ret = []
+		for i, (fd, fromaddr) in enumerate(accepted):
+			sk = None
+			try:
+				sk = _socket_from_fd(family, fd)
+				ret.append((sctpsocket_tcp(family, sk), fromaddr))
+			except:
+				# nothing owns the descriptors not wrapped yet
+				if sk is None:
+					os.close(fd)
+				else:
+					sk.close()
+				for fd, fromaddr in accepted[i + 1:]:
+					os.close(fd)
+				for sk, fromaddr in ret:
+					sk.close()
+				raise
+		return ret
+
 	def set_peer_primary(self, assoc_id, addr):
 		"""
 		Requests the remote peer to use our [addr] as the primary address. Parameters:
@@ -1376,6 +2287,8 @@ class sctpsocket(object):
 		See class documentation for more details. (adaptation property)
 		"""
 		_sctp.set_adaptation(self._sk.fileno(), rvalue)
+		# default ppid of sctp_send()
+		self._adaptation = rvalue
 
 	def get_sndbuf(self):
 		"""
@@ -1385,10 +2298,13 @@ class sctpsocket(object):
 
 	def set_sndbuf(self, rvalue):
 		"""
-		Sets the send buffer size in the kernel for this socket.
+		Sets the send buffer size in the kernel for this socket. The kernel
+		may clamp it (see net.core.wmem_max on Linux); read it back with
+		get_sndbuf().
 		"""
-		# Linux doubles the size, hence we divise it by 2
-		_sctp.set_sndbuf(self._sk.fileno(), rvalue//2)
+		if BUFFER_DOUBLED:
+			rvalue //= 2
+		_sctp.set_sndbuf(self._sk.fileno(), rvalue)
 
 	def get_rcvbuf(self):
 		"""
@@ -1398,10 +2314,13 @@ class sctpsocket(object):
 
 	def set_rcvbuf(self, rvalue):
 		"""
-		Sets the receive buffer size in the kernel for this socket.
+		Sets the receive buffer size in the kernel for this socket. The kernel
+		may clamp it (see net.core.rmem_max on Linux); read it back with
+		get_rcvbuf().
 		"""
-		# Linux doubles the size, hence we divise it by 2
-		_sctp.set_rcvbuf(self._sk.fileno(), rvalue//2)
+		if BUFFER_DOUBLED:
+			rvalue //= 2
+		_sctp.set_rcvbuf(self._sk.fileno(), rvalue)
 
 	def get_disable_fragments(self):
 		"""
@@ -1465,6 +2384,48 @@ class sctpsocket(object):
 		"""
 		_sctp.set_maxseg(self._sk.fileno(), rvalue)
 
+	def get_partial_delivery_point(self):
+		"""
+		Gets the partial delivery point, in bytes.
+		See class documentation for more details. (partial_delivery_point property)
+		"""
+		return _sctp.get_partial_delivery_point(self._sk.fileno())
+
+	def set_partial_delivery_point(self, rvalue):
+		"""
+		Sets the partial delivery point, in bytes.
+		See class documentation for more details. (partial_delivery_point property)
+		"""
+		_sctp.set_partial_delivery_point(self._sk.fileno(), rvalue)
+
+	def get_fragment_interleave(self):
+		"""
+		Gets the fragment interleave level (0, 1 or 2).
+		See class documentation for more details. (fragment_interleave property)
+		"""
+		return _sctp.get_fragment_interleave(self._sk.fileno())
+
+	def set_fragment_interleave(self, rvalue):
+		"""
+		Sets the fragment interleave level (0, 1 or 2).
+		See class documentation for more details. (fragment_interleave property)
+		"""
+		_sctp.set_fragment_interleave(self._sk.fileno(), rvalue)
+
+	def get_explicit_eor(self):
+		"""
+		Returns True if messages are ended explicitly (SCTP_EXPLICIT_EOR).
+		See class documentation for more details. (explicit_eor property)
+		"""
+		return _sctp.get_explicit_eor(self._sk.fileno())
+
+	def set_explicit_eor(self, rvalue):
+		"""
+		Sets whether messages are ended explicitly (SCTP_EXPLICIT_EOR).
+		See class documentation for more details. (explicit_eor property)
+		"""
+		_sctp.set_explicit_eor(self._sk.fileno(), rvalue)
+
 	def get_autoclose(self):
 		"""
 		Gets the timeout value (in seconds) for idle associations, after
@@ -1504,6 +2465,103 @@ class sctpsocket(object):
 
 		return s
 
+	def get_datalogging(self):
+		return self._pcap is not None
+
+	def set_datalogging(self, value):
+		"""
+		Enables or disables recording of the traffic sent and received by 
+		sctp_send() and sctp_recv(). Pass a pcap_writer() object to record into
+		it, True to record into a default writer (prefix RECORD_sctp_traffic, 
+		shared by all sockets), or False to stop. See pcap_writer docstring.
+		"""
+		if isinstance(value, pcap_writer):
+			self._pcap = value._writer
+		elif value:
+			self._pcap = _default_pcap_writer("RECORD_sctp_traffic")._writer
+		else:
+			self._pcap = None
+
+	def get_latency_tracking(self):
+		return self._latency is not None
+
+	def set_latency_tracking(self, enabled):
+		"""
+		Enables or disables latency statistics of sctp_send() and sctp_recv() calls.
+		Statistics are kept on the C side, around the system calls; disabling them
+		discards the statistics collected so far. They are disabled by default and,
+		when disabled, they have no measurable cost.
+		"""
+		if enabled:
+			if self._latency is None:
+				self._latency = _sctp.latency_stats_new()
+		else:
+			self._latency = None
+
+	def latency_stats(self, reset=False):
+		"""
+		Returns a latency_stats() object with the statistics collected since 
+		tracking was enabled, or since the last reset. See the latency_stats 
+		class docstring for details. Returns None if tracking is disabled; see
+		latency_tracking property.
+
+		Parameters:
+
+		reset: if True, statistics are cleared after being read.
+		"""
+		if self._latency is None:
+			return None
+		return latency_stats(_sctp.latency_stats_read(self._latency, reset and 1 or 0))
+
+	def get_status_all(self, with_paths = False):
+		"""
+		Returns a status_table() with the status of every association of the socket,
+		taken by a single C call with the GIL released. This is much cheaper than
+		calling get_status() in a loop when there are thousands of associations.
+		
+		Parameters:
+
+		with_paths: if True, also reports information about every peer address
+			    of every association (one SCTP_GET_PEER_ADDR_INFO per path).
+
+		Associations of UDP-style sockets that go away during the call are left
+		out. The association of a TCP-style socket is not: IOError is raised if
+		its status cannot be read.
+		"""
+		if self._style == TCP_STYLE:
+			ids = [0]
+		else:
+			ids = None
+
+		return status_table(_sctp.get_status_all(self._sk.fileno(), ids, with_paths and 1 or 0))
+
+	def get_assoc_stats(self, assoc_id = 0):
+		"""
+		Returns an assoc_stats snapshot of the SCTP association counters:
+		retransmitted chunks, gap acknowledgements, out-of-sequence and
+		duplicated TSNs, ordered/unordered data and control chunk counts,
+		SACKs and packets in each direction, plus the maximum RTO observed
+		since the previous call (and the peer address it was observed on).
+
+		Snapshots taken at different moments can be subtracted with
+		assoc_stats_delta() to compute rates cheaply.
+
+		Parameters:
+
+		assoc_id: the association ID of the association. Must be zero or not passed at all
+			  for TCP-style sockets.
+
+		Note that reading the statistics starts a new maxrto observation period.
+		"""
+		if self._style == TCP_STYLE:
+			if assoc_id != 0:
+				raise ValueError("assoc_id is ignored for TCP-style sockets, pass 0")
+		else:
+			if assoc_id == 0:
+				raise ValueError("assoc_id is needed for UDP-style sockets")
+
+		return _sctp.get_assoc_stats(self._sk.fileno(), assoc_id)
+
 	def get_paddrinfo(self, assoc_id, sockaddr):
 		"""
 		Returns a paddrinfo() object relative to an association/peer address pair. 
@@ -1562,7 +2620,8 @@ class sctpsocket(object):
 		o: assocparams() object containing the assoc_id of the association be
 		   affected, plus the association parameters. If assoc_id is zero and 
 		   socket is UDP style, it will set the default parameters for future
-		   associations.
+		   associations. CURRENT_ASSOC and ALL_ASSOC set every open association
+		   (and the defaults, for ALL_ASSOC) at once.
 
 		Warning: it seems not to work in TCP-style sockets, in client side.
 			 (we do not know the reason.)
@@ -1582,6 +2641,8 @@ class sctpsocket(object):
 		Parameters:
 
 		assoc_id: the association ID of the association. Must be zero for TCP-style sockets.
+			  For UDP-style sockets, FUTURE_ASSOC along with the wildcard address
+			  returns the socket defaults.
 
 		sockaddr: the address/port tuple. Due to the nature of the information, it can not
 			  be a wildcard (there is no "association-wide" information here); a concrete
@@ -1597,7 +2658,7 @@ class sctpsocket(object):
 			if assoc_id != 0:
 				raise ValueError("assoc_id is ignored for TCP-style sockets, pass 0")
 		else:
-			if assoc_id == 0:
+			if assoc_id == FUTURE_ASSOC and sockaddr[0]:
 				raise ValueError("assoc_id is needed for UDP-style sockets")
 		
 		s = paddrparams()
@@ -1612,7 +2673,8 @@ class sctpsocket(object):
 		Sets peer address parameters for a SCTP association. Parameters:
 
 		o: paddrparams() object containing the assoc_id/address of the peer to be
-		   affected, plus the address parameters.
+		   affected, plus the address parameters. With the wildcard address,
+		   assoc_id may also be FUTURE_ASSOC, CURRENT_ASSOC or ALL_ASSOC.
 
 		It is advisable not to create the paddrparams() object from scratch, but 
 		rather get it with get_paddrparms(), change whatever necessary and send it back.
@@ -1621,6 +2683,88 @@ class sctpsocket(object):
 		"""
 		_sctp.set_paddrparams(self._sk.fileno(), o.__dict__)
 
+	def get_paddrthlds(self, assoc_id = 0, sockaddr = ("", 0)):
+		"""
+		Returns a paddrthlds() object with the retransmission thresholds of a peer
+		address, or of all peer addresses of an association if sockaddr is the
+		wildcard. For more information, see paddrthlds() class docstring.
+
+		Parameters:
+
+		assoc_id: the association ID of the association. Must be zero for TCP-style 
+			  sockets. Zero on UDP-style sockets refers to the socket defaults.
+
+		sockaddr: the address/port tuple, or the wildcard ("", 0).
+		"""
+		if self._style == TCP_STYLE:
+			if assoc_id != 0:
+				raise ValueError("assoc_id is ignored for TCP-style sockets, pass 0")
+
+		s = paddrthlds()
+		s.assoc_id = assoc_id
+		s.sockaddr = sockaddr
+		_sctp.get_paddrthlds(self._sk.fileno(), s.__dict__)
+
+		return s
+
+	def set_paddrthlds(self, o):
+		"""
+		Sets the retransmission thresholds of a peer address, or of all peer
+		addresses of an association. Parameters:
+
+		o: paddrthlds() object containing the assoc_id/address to be affected,
+		   plus the thresholds. With the wildcard address, assoc_id may also be
+		   FUTURE_ASSOC, CURRENT_ASSOC or ALL_ASSOC.
+
+		The kernel refuses pf_threshold above pathmaxrxt.
+		"""
+		_sctp.set_paddrthlds(self._sk.fileno(), o.__dict__)
+
+	def apply_failover_profile(self, profile, assoc_id = None):
+		"""
+		Applies a failover_profile() (RTO bounds, heartbeat interval, path and
+		association maximum retransmissions, PF threshold) as a whole: if any
+		of the underlying socket options fails, the options already changed
+		are restored and IOError is raised. Parameters:
+
+		profile: the failover_profile() to apply.
+
+		assoc_id: the association to change. None means socket-wide: the socket
+			  defaults, used by future associations, and every association
+			  currently open on the socket (each one restored on failure).
+			  For TCP-style sockets, pass None or 0.
+
+		Returns the number of associations (or socket defaults) changed.
+		"""
+		all = assoc_id is None
+		if self._style == TCP_STYLE:
+			if assoc_id:
+				raise ValueError("assoc_id is ignored for TCP-style sockets, pass 0")
+			all = False
+		return _sctp.apply_failover_profile(self._sk.fileno(), assoc_id or 0, profile._values(),
+						    all and 1 or 0)
+
+	def get_failover_profile(self, assoc_id = 0):
+		"""
+		Returns the failover_profile() currently in effect for an association, or
+		for the socket defaults if assoc_id is zero on an UDP-style socket.
+		"""
+		fd = self._sk.fileno()
+		rto = rtoinfo()
+		rto.assoc_id = assoc_id
+		_sctp.get_rtoinfo(fd, rto.__dict__)
+		assoc = assocparams()
+		assoc.assoc_id = assoc_id
+		_sctp.get_assocparams(fd, assoc.__dict__)
+		paddr = paddrparams()
+		paddr.assoc_id = assoc_id
+		_sctp.get_paddrparams(fd, paddr.__dict__)
+		thlds = self.get_paddrthlds(assoc_id)
+
+		return failover_profile(rto_initial=rto.initial, rto_min=rto.min, rto_max=rto.max,
+			hbinterval=paddr.hbinterval, pathmaxrxt=thlds.pathmaxrxt,
+			assocmaxrxt=assoc.assocmaxrxt, pf_threshold=thlds.pf_threshold)
+
 	def get_rtoinfo(self, assoc_id = 0):
 		"""
 		Returns a RTO information structure for a SCTP association. For more information
@@ -1647,13 +2791,157 @@ class sctpsocket(object):
 		o: rtoinfo() object containing the assoc_id of the association to be
 		   affected, plus the RTO parameters. If an assoc_id of zero is passed
 		   for UDP-style socket, the information will affect the socket defaults,
-		   not any particular association.
+		   not any particular association. CURRENT_ASSOC affects every open
+		   association, ALL_ASSOC the defaults as well.
 
 		It is advisable not to create rtoinfo() from scratch, but rather get it
 		from get_rtoinfo(), change whatever necessary and send it back.
 		"""
 		_sctp.set_rtoinfo(self._sk.fileno(), o.__dict__)
 
+	def get_prstatus(self, assoc_id = 0, sid = None, policy = PR_SCTP_ALL):
+		"""
+		Returns a prstatus() object with the number of messages abandoned by
+		PR-SCTP, either for the whole association or for one of its streams.
+		For more information about the returned data, see prstatus() class docstring.
+
+		Parameters:
+
+		assoc_id: the association ID of the association. Must be zero or not passed at all
+			  for TCP-style sockets.
+
+		sid: the outbound stream to be queried, or None for the whole association.
+
+		policy: the PR_SCTP_* policy to be queried. PR_SCTP_ALL sums every policy.
+		"""
+		s = prstatus()
+		s.assoc_id = assoc_id
+		s.policy = policy
+		if sid is None:
+			s.sid = 0
+			_sctp.get_pr_assoc_status(self._sk.fileno(), s.__dict__)
+			s.sid = None
+		else:
+			s.sid = sid
+			_sctp.get_pr_stream_status(self._sk.fileno(), s.__dict__)
+
+		return s
+
+	def get_default_prinfo(self, assoc_id = 0):
+		"""
+		Returns the default PR-SCTP parameters the kernel applies to messages
+		sent without explicit metadata. For more information about the returned 
+		data, see prinfo() class docstring.
+
+		Parameters:
+
+		assoc_id: the association ID of the association. Must be zero or not passed at all
+			  for TCP-style sockets. If zero is passed for UDP-style sockets, the
+			  information refers to the socket defaults.
+		"""
+		s = prinfo()
+		s.assoc_id = assoc_id
+		_sctp.get_default_prinfo(self._sk.fileno(), s.__dict__)
+
+		return s
+
+	def set_default_prinfo(self, o):
+		"""
+		Sets the default PR-SCTP parameters. Parameters:
+
+		o: prinfo() object containing the assoc_id of the association to be
+		   affected (or FUTURE_ASSOC, CURRENT_ASSOC, ALL_ASSOC), plus the policy
+		   and its value.
+		"""
+		_sctp.set_default_prinfo(self._sk.fileno(), o.__dict__)
+
+	def get_pr_supported(self):
+		"""
+		Returns True if the PR-SCTP extension is enabled for new associations.
+		"""
+		return _sctp.get_pr_supported(self._sk.fileno(), 0)
+
+	def set_pr_supported(self, rvalue):
+		"""
+		Enables or disables the PR-SCTP extension for new associations.
+		"""
+		_sctp.set_pr_supported(self._sk.fileno(), 0, rvalue)
+
+	def get_reconfig_supported(self):
+		"""
+		Returns True if the stream reconfiguration extension is enabled for
+		new associations.
+		"""
+		return _sctp.get_reconfig_supported(self._sk.fileno(), 0)
+
+	def set_reconfig_supported(self, rvalue):
+		"""
+		Enables or disables the stream reconfiguration extension (RFC 6525)
+		for new associations.
+		"""
+		_sctp.set_reconfig_supported(self._sk.fileno(), 0, rvalue)
+
+	def get_enable_stream_reset(self, assoc_id = 0):
+		"""
+		Returns the bitmap of reconfiguration requests (ENABLE_*_REQ constants)
+		this endpoint accepts from the peer.
+
+		Parameters:
+
+		assoc_id: the association ID of the association. Must be zero or not passed at all
+			  for TCP-style sockets. If zero is passed for UDP-style sockets, the
+			  information refers to the socket defaults.
+		"""
+		return _sctp.get_enable_stream_reset(self._sk.fileno(), assoc_id)
+
+	def set_enable_stream_reset(self, value, assoc_id = 0):
+		"""
+		Sets which reconfiguration requests this endpoint accepts from the peer.
+		Parameters:
+
+		value: a bitmap of ENABLE_RESET_STREAM_REQ, ENABLE_RESET_ASSOC_REQ and
+		       ENABLE_CHANGE_ASSOC_REQ.
+
+		assoc_id: the association to be affected, zero (FUTURE_ASSOC) for the
+			  socket defaults, CURRENT_ASSOC or ALL_ASSOC for many at once.
+		"""
+		_sctp.set_enable_stream_reset(self._sk.fileno(), assoc_id, value)
+
+	def reset_streams(self, assoc_id = 0, streams = (), flags = STREAM_RESET_OUTGOING):
+		"""
+		Requests the reset of stream sequence numbers on a live association.
+		The result is reported by a stream_reset_event() notification.
+		Parameters:
+
+		assoc_id: the association to be affected. Pass zero for TCP-style sockets.
+
+		streams: list of stream numbers to be reset. Empty means all streams.
+
+		flags: STREAM_RESET_OUTGOING and/or STREAM_RESET_INCOMING.
+		"""
+		_sctp.reset_streams(self._sk.fileno(), assoc_id, flags, streams)
+
+	def reset_assoc(self, assoc_id = 0):
+		"""
+		Requests the reset of the TSNs of a live association. The result is
+		reported by an assoc_reset_event() notification.
+		"""
+		_sctp.reset_assoc(self._sk.fileno(), assoc_id)
+
+	def add_streams(self, assoc_id = 0, instrms = 0, outstrms = 0):
+		"""
+		Adds inbound and/or outbound streams to a live association, without
+		tearing it down. The result is reported by a stream_change_event()
+		notification. Parameters:
+
+		assoc_id: the association to be affected. Pass zero for TCP-style sockets.
+
+		instrms: number of inbound streams to be added
+
+		outstrms: number of outbound streams to be added
+		"""
+		_sctp.add_streams(self._sk.fileno(), assoc_id, instrms, outstrms)
+
 	def get_ttl(self):
 		"""
 		Read default time to live value, 0 mean infinite
@@ -1662,13 +2950,31 @@ class sctpsocket(object):
 
 	def set_ttl(self, newVal):
 		"""
-		Write default time to live
+		Write default time to live, or default PR-SCTP policy value
 		"""
-		if not isinstance(newVal, int) or newVal < 0 or newVal > 255:
-			raise ValueError('TTL shall be >= 0 and <= 255')
+		if not isinstance(newVal, int) or newVal < 0 or newVal > 0xFFFFFFFF:
+			raise ValueError('TTL shall be a valid unsigned 32bits integer')
 
 		self._ttl = newVal
 
+	def get_pr_policy(self):
+		"""
+		Read default PR-SCTP policy
+		"""
+		return self._pr_policy
+
+	def set_pr_policy(self, newVal):
+		"""
+		Write default PR-SCTP policy
+		"""
+		if newVal not in (PR_SCTP_NONE, PR_SCTP_TTL, PR_SCTP_RTX, PR_SCTP_PRIO):
+			raise ValueError('pr_policy shall be one of the PR_SCTP_* policies')
+		if newVal != PR_SCTP_NONE and not PR_SCTP_MASK:
+			# built without the PR-SCTP headers, sctp_send() would refuse it
+			raise IOError(errno.ENOPROTOOPT, "PR-SCTP policies are not supported by this build")
+
+		self._pr_policy = newVal
+
 	def get_streamid(self):
 		"""
 		Read default stream identifier
@@ -1697,7 +3003,16 @@ class sctpsocket(object):
 		Delegation trick that routes every unknown attribute to the underlying
 		Python socket (self._sk). This will allow a sctpsocket() to be used in most
 		places where a standard socket or file is expected.
+
+		It also builds the "initparams" and "events" attributes the first time
+		they are read; they then live in the instance dictionary.
 		"""
+		if name == "initparams":
+			self.initparams = initparams(self)
+			return self.initparams
+		if name == "events":
+			self.events = event_subscribe(self)
+			return self.events
 		return getattr(self._sk, name)
 
 	# properties
@@ -1707,9 +3022,17 @@ class sctpsocket(object):
 	disable_fragments = property(get_disable_fragments, set_disable_fragments)
 	mappedv4 = property(get_mappedv4, set_mappedv4)
 	maxseg = property(get_maxseg, set_maxseg)
+	explicit_eor = property(get_explicit_eor, set_explicit_eor)
+	partial_delivery_point = property(get_partial_delivery_point, set_partial_delivery_point)
+	fragment_interleave = property(get_fragment_interleave, set_fragment_interleave)
 	autoclose = property(get_autoclose, set_autoclose)
 	ttl = property(get_ttl, set_ttl)
+	pr_policy = property(get_pr_policy, set_pr_policy)
+	pr_supported = property(get_pr_supported, set_pr_supported)
+	reconfig_supported = property(get_reconfig_supported, set_reconfig_supported)
 	streamid = property(get_streamid, set_streamid)
+	latency_tracking = property(get_latency_tracking, set_latency_tracking)
+	datalogging = property(get_datalogging, set_datalogging)
 
 class sctpsocket_tcp(sctpsocket):
 	"""
@@ -1811,3 +3134,88 @@ class sctpsocket_udp(sctpsocket):
 		"""
 		raise IOError("UDP-style sockets have no accept() operation")
 
+	def accept_many(self, *params):
+		"""
+		Stub method to block unappropriate calling.
+		"""
+		raise IOError("UDP-style sockets have no accept() operation")
+
+	def connectx_many(self, peers, timeout=None, on_message=None):
+		"""
+		Establishes associations to many peers at once. All handshakes are
+		started (non-blocking connectx()) before waiting for any of them, so
+		the total time is about one handshake, not the sum of them. The
+		socket must be in non-blocking mode (setblocking(False)), see
+		connectx().
+
+		Parameters:
+
+		peers: list of peers; each peer is a list of (address, port) tuples,
+		       as passed to connectx().
+
+		timeout: maximum time in seconds to wait for the handshakes. None
+			 waits until every handshake completed or failed.
+
+		on_message: messages and notifications received while waiting that
+			    are not the completion of a handshake are passed to
+			    on_message(fromaddr, flags, msg, notif), or discarded if
+			    it is None.
+
+		Returns a list with one entry per peer: the association ID if the
+		association is up, or an IOError() instance if it failed (ETIMEDOUT
+		if it did not complete within timeout; the kernel keeps trying to
+		establish it, and an eventual assoc_change() is then received as
+		usual).
+
+		Completion is detected by assoc_change() notifications, so the
+		association events are subscribed to and left subscribed.
+		"""
+		if "connectx_many" not in _sctp.__dict__:
+			raise RuntimeError("Underlying SCTP implementation does not have connectx()")
+
+		self.events.association = True
+		self.events.flush()
+
+		started = _sctp.connectx_many(self._sk.fileno(), peers)
+		results = [None] * len(started)
+		pending = {}
+		for i in range(len(started)):
+			assoc_id, err = started[i]
+			if err:
+				results[i] = IOError(err, os.strerror(err))
+			else:
+				pending[assoc_id] = i
+
+		if timeout is not None:
+			deadline = time.time() + timeout
+		while pending:
+			wait = None
+			if timeout is not None:
+				wait = deadline - time.time()
+				if wait <= 0:
+					break
+			if not select.select([self._sk], [], [], wait)[0]:
+				break
+			try:
+				fromaddr, flags, msg, notif = self.sctp_recv(65536)
+			except (IOError, OSError) as e:
+				if e.errno in (errno.EAGAIN, errno.EWOULDBLOCK):
+					continue
+				raise
+			if flags & FLAG_NOTIFICATION and isinstance(notif, assoc_change) and \
+					notif.assoc_id in pending:
+				i = pending.pop(notif.assoc_id)
+				if notif.state in (assoc_change.state_COMM_UP, assoc_change.state_RESTART):
+					results[i] = notif.assoc_id
+				else:
+					results[i] = IOError(errno.ECONNREFUSED,
+						"association %d could not be established (state %d, error %d)" %
+						(notif.assoc_id, notif.state, notif.error))
+			elif on_message:
+				on_message(fromaddr, flags, msg, notif)
+
+		for assoc_id, i in pending.items():
+			results[i] = IOError(errno.ETIMEDOUT, "association %d not established after %ss" %
+						(assoc_id, timeout))
+		return results
+
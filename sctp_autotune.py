@@ -0,0 +1,206 @@
+# SCTP bindings for Python
+# -*- coding: utf-8 -*-
+#
+# Bandwidth-delay product driven socket buffer sizing
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Automatic socket buffer sizing for SCTP sockets.
+
+SO_SNDBUF and SO_RCVBUF are static. On long fat links they keep the
+associations window-limited, and on short links they waste memory.
+buffer_tuner() periodically estimates the bandwidth-delay product (BDP) of
+a socket and resizes both buffers toward a multiple of it, within the
+bounds of a buffer_policy(). Here the send buffer may grow to 32 MB, and
+every change is logged:
+
+import sctp, sctp_autotune
+
+sk = sctp.sctpsocket_udp(socket.AF_INET)
+tuner = sctp_autotune.buffer_tuner(sk, sctp_autotune.buffer_policy(max_sndbuf=32 << 20))
+tuner.on_change = lambda name, old, new: log.info("%s %d -> %d", name, old, new)
+tuner.start()
+
+Each sample takes two estimates. Both come from one get_status_all() call
+and the socket latency statistics; the tuner switches latency tracking on.
+
+- window: the congestion windows of the primary paths, summed over the
+  associations. It bounds what the senders may have in flight.
+- rate: the bytes passed to sctp_send() (or returned by sctp_recv()) per
+  second since the previous sample, times the largest smoothed RTT.
+
+The send buffer follows the larger of the two estimates. The receive buffer
+follows the rate. When the rate fills "saturation" of the usable part of a
+buffer, the buffer itself may be the limit, and a larger BDP could not show
+up. The buffer is then doubled instead.
+
+Growing happens at once. Shrinking waits until the target has been lower
+for "shrink_samples" consecutive samples. Changes smaller than "hysteresis"
+are not made. Sizes are in sctpsocket.set_sndbuf() units, and the kernel
+may clamp them (net.core.wmem_max and rmem_max on Linux). The changes
+reported are the values actually read back.
+
+On Linux, the receive window an association advertises is sized from the
+receive buffer when the association is established. A larger rcvbuf
+therefore benefits mostly the associations that come up afterwards.
+"""
+
+import time
+
+import sctp
+
+# The kernel charges socket buffers with the payload plus its metadata
+# (sk_buff, chunk headers), about as much again for small messages; only
+# about this fraction of a buffer holds data.
+USABLE = 0.5
+
+class buffer_policy(object):
+	"""
+	Sizing policy of a buffer_tuner(). Attributes:
+
+	bdp_multiple: buffers are sized to hold bdp_multiple times the BDP worth
+		      of data (on top of the kernel overhead, see USABLE).
+
+	min_sndbuf, max_sndbuf, min_rcvbuf, max_rcvbuf: bounds, in bytes.
+
+	saturation: a buffer is considered limiting when the rate-based BDP
+		    reaches this fraction of its usable size; it is then doubled.
+
+	hysteresis: relative changes smaller than this are not made.
+
+	shrink_samples: number of consecutive samples the target must stay below
+			the current size before a buffer shrinks.
+	"""
+	def __init__(self, bdp_multiple=2.0, min_sndbuf=64 << 10, max_sndbuf=16 << 20,
+			min_rcvbuf=64 << 10, max_rcvbuf=16 << 20, saturation=0.75,
+			hysteresis=0.25, shrink_samples=5):
+		self.bdp_multiple = bdp_multiple
+		self.min_sndbuf = min_sndbuf
+		self.max_sndbuf = max_sndbuf
+		self.min_rcvbuf = min_rcvbuf
+		self.max_rcvbuf = max_rcvbuf
+		self.saturation = saturation
+		self.hysteresis = hysteresis
+		self.shrink_samples = shrink_samples
+
+class buffer_tuner(sctp.periodic_sampler):
+	"""
+	Resizes the send and receive buffers of an SCTP socket toward a multiple
+	of its bandwidth-delay product. See module docstring.
+
+	on_change, if set, is called as on_change(name, old, new) after each change
+	("sndbuf" or "rcvbuf", sizes in bytes). Errors of the socket calls are
+	passed to on_error(exception) if set, and stop the background thread
+	otherwise (the socket may be closed).
+
+	"estimates" holds the figures of the last sample: window (bytes), srtt
+	(seconds), send_rate and recv_rate (bytes per second), send_bdp and
+	recv_bdp (bytes).
+	"""
+	def __init__(self, sk, policy=None, interval=1.0):
+		self.sk = sk
+		self.policy = policy or buffer_policy()
+		self.interval = interval
+		self.on_change = None
+		self.on_error = None
+		self.estimates = {}
+		self._last = None
+		self._below = {"sndbuf": 0, "rcvbuf": 0}
+
+		sk.latency_tracking = True
+
+	def sample(self):
+		"""
+		Estimates the BDP and resizes the buffers where needed. Returns the
+		list of (name, old, new) changes made. start() calls it every
+		"interval" seconds; applications with a main loop of their own may call
+		it from there instead. Rates are averaged since the previous call, so
+		calls far apart smooth out bursts, and the first call sees no rate.
+		"""
+		t = self.sk.get_status_all()
+		stats = self.sk.latency_stats()
+		now = time.time()
+
+		sent = received = 0
+		if stats is not None:
+			sent = stats.send_bytes.sum
+			received = stats.recv_bytes.sum
+
+		window = sum(t.cwnd)
+		srtt = len(t) and max(t.srtt) / 1000.0 or 0.0
+
+		send_rate = recv_rate = 0.0
+		if self._last is not None:
+			then, last_sent, last_received = self._last
+			# counters go backwards when someone resets the statistics
+			if now > then and sent >= last_sent and received >= last_received:
+				send_rate = (sent - last_sent) / (now - then)
+				recv_rate = (received - last_received) / (now - then)
+		self._last = (now, sent, received)
+
+		send_bdp = send_rate * srtt
+		recv_bdp = recv_rate * srtt
+		self.estimates = {"window": window, "srtt": srtt, "send_rate": send_rate,
+				  "recv_rate": recv_rate, "send_bdp": max(window, send_bdp),
+				  "recv_bdp": recv_bdp}
+
+		changes = []
+		p = self.policy
+		for name, bdp, rate_bdp, lo, hi in (
+				("sndbuf", max(window, send_bdp), send_bdp, p.min_sndbuf, p.max_sndbuf),
+				("rcvbuf", recv_bdp, recv_bdp, p.min_rcvbuf, p.max_rcvbuf)):
+			change = self._tune(name, bdp, rate_bdp, lo, hi)
+			if change:
+				changes.append(change)
+				if self.on_change:
+					self.on_change(*change)
+
+		return changes
+
+	def _tune(self, name, bdp, rate_bdp, lo, hi):
+		p = self.policy
+		current = getattr(self.sk, "get_" + name)()
+
+		target = bdp * p.bdp_multiple / USABLE
+		if rate_bdp >= current * USABLE * p.saturation:
+			# the buffer may be what limits the rate
+			target = max(target, current * 2)
+		target = int(min(max(target, lo), hi))
+
+		if target > current:
+			self._below[name] = 0
+			if target < current * (1 + p.hysteresis) and current >= lo:
+				return None
+		elif target < current * (1 - p.hysteresis) or current > hi:
+			self._below[name] += 1
+			if self._below[name] < p.shrink_samples and current <= hi:
+				return None
+			self._below[name] = 0
+		else:
+			self._below[name] = 0
+			return None
+
+		getattr(self.sk, "set_" + name)(target)
+		new = getattr(self.sk, "get_" + name)()
+		if new == current:
+			# clamped by the kernel
+			return None
+		return (name, current, new)
+
+	def _sample_error(self, e):
+		if self.on_error:
+			self.on_error(e)
+			return True
+		return False
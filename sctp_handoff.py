@@ -0,0 +1,284 @@
+# SCTP bindings for Python
+# -*- coding: utf-8 -*-
+#
+# Association handoff to worker processes
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Handoff of live associations from a front process to worker processes.
+
+A single Python process runs out of CPU long before SCTP does. Instead of
+sharing the listening port between processes, a front process accepts
+(TCP-style) or peels off (UDP-style) the associations and passes them to
+workers over AF_UNIX channels, as file descriptors (SCM_RIGHTS). Along with
+the descriptor goes what the worker would otherwise query again: the
+association ID, the peer addresses, the negotiated streams, the event
+subscriptions and the sctp_send() defaults. A front process with one
+worker:
+
+import sctp, sctp_handoff
+
+chan, worker_chan = sctp_handoff.channel()
+if os.fork() == 0:
+	chan.close()
+	while True:
+		sk, info = sctp_handoff.recv_socket(worker_chan)
+		if sk is None:
+			break	# front process gone
+		serve(sk, info.outstrms)
+	os._exit(0)
+
+worker_chan.close()
+while True:
+	for sk, fromaddr in srv.accept_many():
+		sctp_handoff.send_socket(chan, sk, extra={"from": fromaddr})
+
+The front process closes its copy of each socket once it is sent, unless
+told otherwise. The metadata is a snapshot taken at handoff time; peer
+addresses added or removed later are reported to the worker as usual, by
+paddr_change() notifications.
+
+Running this module starts an example worker-pool echo server:
+python sctp_handoff.py --help
+"""
+
+import os
+import sys
+import errno
+import json
+import socket
+
+import sctp
+import _sctp
+
+# Handoff messages are JSON; this bounds the "extra" metadata, too.
+MAX_MESSAGE = 65536
+
+def channel():
+	"""
+	Returns a pair of connected AF_UNIX sockets to pass associations over,
+	one for each side. SOCK_SEQPACKET keeps one handoff per message.
+	"""
+	return socket.socketpair(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+
+class handoff_info(object):
+	"""
+	Metadata of a handed-off association, as returned by recv_socket().
+
+	assoc_id: association ID in the front process. The socket itself is
+		  TCP-style, so pass 0 where an assoc_id is expected.
+
+	paddrs: AddressSet of the peer addresses at handoff time.
+
+	instrms, outstrms: negotiated number of inbound and outbound streams.
+
+	extra: the "extra" object passed to send_socket(), or None.
+	"""
+	def __init__(self, values):
+		self.assoc_id = values["assoc_id"]
+		self.paddrs = sctp.AddressSet([tuple(a) for a in values["paddrs"]])
+		self.instrms = values["instrms"]
+		self.outstrms = values["outstrms"]
+		self.extra = values.get("extra")
+
+def describe(sk, assoc_id=0, extra=None):
+	"""
+	Returns the handoff metadata of an association as a dictionary that
+	JSON can serialise. "sk" is a TCP-style socket, or the UDP-style socket
+	the association (assoc_id) belongs to. "extra" is passed along as is.
+	"""
+	st = sk.get_status(assoc_id)
+	events = sk.events
+	return {
+		"family": sk._family,
+		"blocking": sk.gettimeout() is None,
+		"assoc_id": st.assoc_id,
+		"paddrs": list(sk.getpaddrs(assoc_id)),
+		"instrms": st.instrms,
+		"outstrms": st.outstrms,
+		"events": dict((k, v) for k, v in events.__dict__.items() if k.startswith("_")),
+		"ttl": sk._ttl,
+		"streamid": sk._streamid,
+		"pr_policy": sk._pr_policy,
+		"adaptation": sk._adaptation,
+		"unexpected_event_raises_exception": sk.unexpected_event_raises_exception,
+		"extra": extra,
+	}
+
+def _send(chan, fd, values):
+	data = json.dumps(values).encode("utf-8")
+	if len(data) > MAX_MESSAGE:
+		raise ValueError("handoff metadata larger than %d bytes" % MAX_MESSAGE)
+	_sctp.send_fds(chan.fileno(), data, [fd])
+
+def send_socket(chan, sk, extra=None, close=True):
+	"""
+	Passes a TCP-style socket (accepted, peeled off or connected) and its
+	metadata over "chan". The socket is closed afterwards if "close" is
+	true; the association lives on in the receiving process.
+	"""
+	if sk._style != sctp.TCP_STYLE:
+		raise ValueError("pass UDP-style associations with send_assoc()")
+	_send(chan, sk.fileno(), describe(sk, 0, extra))
+	if close:
+		sk.close()
+
+def send_assoc(chan, sk, assoc_id, extra=None):
+	"""
+	Peels association "assoc_id" off the UDP-style socket "sk" and passes it
+	over "chan". The metadata is read before the peeloff, so that it refers
+	to the same association ID the front process knows.
+	"""
+	values = describe(sk, assoc_id, extra)
+	peeled = sk.peeloff(assoc_id)
+	try:
+		values["blocking"] = peeled.gettimeout() is None
+		_send(chan, peeled.fileno(), values)
+	finally:
+		peeled.close()
+
+def _rebuild(values, fd):
+	family = values["family"]
+	sk = sctp.sctpsocket_tcp(family, sctp._socket_from_fd(family, fd))
+	if values["blocking"]:
+		sk.setblocking(True)
+
+	sk._ttl = values["ttl"]
+	sk._streamid = values["streamid"]
+	sk._pr_policy = values["pr_policy"]
+	sk._adaptation = values["adaptation"]
+	sk.unexpected_event_raises_exception = values["unexpected_event_raises_exception"]
+
+	# the subscriptions belong to the socket, and came along with it
+	events = sctp.event_subscribe.__new__(sctp.event_subscribe)
+	events.__dict__.update(values["events"])
+	events.container = sk
+	events.autoflush = True
+	sk.events = events
+	return sk
+
+def recv_socket(chan):
+	"""
+	Receives a socket passed by send_socket() or send_assoc(). Returns a
+	(sctpsocket_tcp, handoff_info) pair, or (None, None) when the other side
+	of the channel has been closed. The socket is close-on-exec, and blocking
+	or not as it was in the front process.
+	"""
+	data, fds = _sctp.recv_fds(chan.fileno(), MAX_MESSAGE, 1)
+	if not data:
+		return None, None
+	if not fds:
+		raise IOError("handoff message without a descriptor")
+	try:
+		values = json.loads(data.decode("utf-8"))
+	except ValueError:
+		os.close(fds[0])
+		raise
+	return _rebuild(values, fds[0]), handoff_info(values)
+
+#################### EXAMPLE WORKER POOL
+
+def _worker(chan, index):
+	import select
+
+	poll = select.poll()
+	poll.register(chan.fileno(), select.POLLIN)
+	socks = {}
+	while True:
+		for fd, ev in poll.poll():
+			if fd == chan.fileno():
+				sk, info = recv_socket(chan)
+				if sk is None:
+					return
+				sk.setblocking(False)
+				socks[sk.fileno()] = sk
+				poll.register(sk.fileno(), select.POLLIN)
+				sys.stderr.write("worker %d: association %d from %s, %d/%d streams\n" %
+					(index, info.assoc_id, list(info.paddrs), info.instrms, info.outstrms))
+				continue
+			sk = socks[fd]
+			try:
+				fromaddr, flags, msg, notif = sk.sctp_recv(MAX_MESSAGE)
+			except (IOError, OSError) as e:
+				if e.errno == errno.EAGAIN:
+					continue
+				msg, flags = b"", 0
+			if flags & sctp.FLAG_NOTIFICATION:
+				continue
+			if not msg:
+				poll.unregister(fd)
+				del socks[fd]
+				sk.close()
+				continue
+			sk.sctp_send(msg, stream=notif.stream)
+
+def main(argv=None):
+	import argparse
+	import select
+
+	p = argparse.ArgumentParser(description="example echo server: associations are accepted "
+				    "by this process and handed off to a pool of worker processes")
+	p.add_argument("--bind", default="127.0.0.1", help="comma-separated local addresses")
+	p.add_argument("--port", type=int, default=10001)
+	p.add_argument("--workers", type=int, default=4, help="number of worker processes")
+	args = p.parse_args(argv)
+
+	addrs = [(a, args.port) for a in args.bind.split(",")]
+	family = ":" in addrs[0][0] and socket.AF_INET6 or socket.AF_INET
+
+	srv = sctp.sctpsocket_tcp(family)
+	srv.bindx(addrs)
+	srv.listen(128)
+
+	chans = []
+	pids = []
+	for i in range(args.workers):
+		chan, worker_chan = channel()
+		pid = os.fork()
+		if pid == 0:
+			srv.close()
+			chan.close()
+			for c in chans:
+				c.close()
+			try:
+				_worker(worker_chan, i)
+			finally:
+				os._exit(0)
+		worker_chan.close()
+		chans.append(chan)
+		pids.append(pid)
+
+	sys.stderr.write("listening on %s with %d workers\n" % (addrs, args.workers))
+	poll = select.poll()
+	poll.register(srv.fileno(), select.POLLIN)
+	n = 0
+	try:
+		while True:
+			poll.poll()
+			for sk, fromaddr in srv.accept_many():
+				send_socket(chans[n % len(chans)], sk, extra={"from": list(fromaddr)})
+				n += 1
+	except KeyboardInterrupt:
+		pass
+	finally:
+		for c in chans:
+			c.close()
+		for pid in pids:
+			os.waitpid(pid, 0)
+		srv.close()
+	return 0
+
+if __name__ == '__main__':
+	sys.exit(main())
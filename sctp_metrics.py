@@ -0,0 +1,306 @@
+# SCTP bindings for Python
+# -*- coding: utf-8 -*-
+#
+# OpenMetrics exporter
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+OpenMetrics (Prometheus) exporter for SCTP sockets.
+
+Sockets are registered in a registry, that renders the metrics of all of
+them in OpenMetrics text format, either on demand (render()) or served over
+HTTP by a background thread (start_http_server()). Exporting one socket on
+the usual exporter port:
+
+import sctp, sctp_metrics
+
+sk = sctp.sctpsocket_udp(socket.AF_INET)
+sctp_metrics.register(sk, "s1ap")
+sctp_metrics.start_http_server(9464)
+
+Per-association metrics (state, rwnd, unackdata, penddata, streams) and
+per-path metrics (state, srtt, rto, cwnd, mtu, primary) are taken by one
+sctpsocket.get_status_all() call per socket, so a scrape costs a few
+syscalls per association and no per-association Python objects. The
+library's own send/recv counters and syscall time histograms come from
+the socket latency statistics (see sctpsocket.latency_tracking), which
+register() enables by default.
+
+The registry keeps only weak references to sockets, so collected sockets
+disappear from the output. A closed socket is reported once more, with
+sctp_socket_up 0, and then dropped from the registry.
+"""
+
+import errno
+import threading
+import weakref
+
+try:
+	from http.server import HTTPServer, BaseHTTPRequestHandler
+except ImportError:
+	# Python 2
+	from BaseHTTPServer import HTTPServer, BaseHTTPRequestHandler
+
+CONTENT_TYPE = "application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+# Upper bounds (seconds) of the exported syscall time histogram buckets
+TIME_BUCKETS = (0.00001, 0.0001, 0.001, 0.01, 0.1, 1.0, 10.0)
+
+def _escape(value):
+	return str(value).replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n")
+
+def _labels(**labels):
+	return "{" + ",".join(["%s=\"%s\"" % (k, _escape(v)) for k, v in sorted(labels.items())]) + "}"
+
+class _family(object):
+	"""
+	Samples of a metric family, rendered together as OpenMetrics requires.
+	"""
+	def __init__(self, name, mtype, help, unit=None):
+		self.name = name
+		self.mtype = mtype
+		self.help = help
+		self.unit = unit
+		self.samples = []
+
+	def add(self, suffix, labels, value):
+		self.samples.append((self.name + suffix, labels, value))
+
+	def render(self, out):
+		if not self.samples:
+			return
+		out.append("# TYPE %s %s" % (self.name, self.mtype))
+		if self.unit:
+			out.append("# UNIT %s %s" % (self.name, self.unit))
+		out.append("# HELP %s %s" % (self.name, self.help))
+		for name, labels, value in self.samples:
+			out.append("%s%s %s" % (name, labels, value))
+
+class registry(object):
+	"""
+	Set of SCTP sockets whose metrics are exported together.
+	"""
+	def __init__(self):
+		self._lock = threading.Lock()
+		self._sockets = weakref.WeakKeyDictionary()
+		self._server = None
+		self._thread = None
+
+	def register(self, sk, name=None, with_paths=True, latency=True):
+		"""
+		Adds an sctpsocket to the registry.
+
+		Parameters:
+
+		name: value of the "socket" label. Default is "fd<file descriptor>".
+
+		with_paths: export per-path metrics too.
+
+		latency: enables latency tracking of the socket (see
+			 sctpsocket.latency_tracking) so send/recv counters are
+			 exported. If False, they are exported only if tracking
+			 was enabled by other means.
+		"""
+		if name is None:
+			name = "fd%d" % sk.fileno()
+		if latency:
+			sk.latency_tracking = True
+		self._lock.acquire()
+		try:
+			self._sockets[sk] = (name, with_paths)
+		finally:
+			self._lock.release()
+
+	def unregister(self, sk):
+		self._lock.acquire()
+		try:
+			self._sockets.pop(sk, None)
+		finally:
+			self._lock.release()
+
+	def collect(self):
+		"""
+		Returns the list of metric families of all registered sockets.
+		"""
+		self._lock.acquire()
+		try:
+			sockets = list(self._sockets.items())
+			# closed sockets are reported down by this scrape, then forgotten
+			for sk, v in sockets:
+				if sk.fileno() < 0:
+					del self._sockets[sk]
+		finally:
+			self._lock.release()
+
+		f = {}
+		def family(name, mtype, help, unit=None):
+			if name not in f:
+				f[name] = _family(name, mtype, help, unit)
+			return f[name]
+
+		up = family("sctp_socket_up", "gauge", "1 if the socket status could be read")
+		status_errno = family("sctp_socket_status_errno", "gauge",
+				      "errno of the failed status read, 0 if it succeeded")
+		assocs = family("sctp_socket_associations", "gauge", "Number of associations")
+		a_state = family("sctp_assoc_state", "gauge", "Association state (SCTP_STATUS)")
+		a_rwnd = family("sctp_assoc_rwnd_bytes", "gauge", "Peer receive window", "bytes")
+		a_unack = family("sctp_assoc_unackdata", "gauge", "Unacknowledged DATA chunks")
+		a_pend = family("sctp_assoc_penddata", "gauge", "DATA chunks pending receipt")
+		a_in = family("sctp_assoc_instrms", "gauge", "Inbound streams")
+		a_out = family("sctp_assoc_outstrms", "gauge", "Outbound streams")
+		p_state = family("sctp_path_state", "gauge", "Peer address state")
+		p_primary = family("sctp_path_primary", "gauge", "1 for the primary peer address")
+		p_srtt = family("sctp_path_srtt_seconds", "gauge", "Smoothed round-trip time", "seconds")
+		p_rto = family("sctp_path_rto_seconds", "gauge", "Retransmission timeout", "seconds")
+		p_cwnd = family("sctp_path_cwnd_bytes", "gauge", "Congestion window", "bytes")
+		p_mtu = family("sctp_path_mtu_bytes", "gauge", "Path MTU", "bytes")
+
+		calls = {}
+		for d in ("send", "recv"):
+			calls[d] = (family("sctp_%s_calls" % d, "counter", "sctp_%s() calls" % d),
+				family("sctp_%s_bytes" % d, "counter", "Bytes %s by sctp_%s()" % (d == "send" and "sent" or "received", d), "bytes"),
+				family("sctp_%s_eagain" % d, "counter", "sctp_%s() calls failed with EAGAIN" % d),
+				family("sctp_%s_errors" % d, "counter", "sctp_%s() calls failed with other errors" % d),
+				family("sctp_%s_syscall_seconds" % d, "histogram", "Time spent in the sctp_%s() syscall" % d, "seconds"))
+
+		for sk, (name, with_paths) in sockets:
+			sl = _labels(socket=name)
+			if sk.fileno() < 0:
+				up.add("", sl, 0)
+				status_errno.add("", sl, errno.EBADF)
+				continue
+			try:
+				t = sk.get_status_all(with_paths)
+			except (IOError, OSError, ValueError) as e:
+				up.add("", sl, 0)
+				status_errno.add("", sl, getattr(e, "errno", None) or 0)
+				continue
+			up.add("", sl, 1)
+			status_errno.add("", sl, 0)
+			assocs.add("", sl, len(t))
+
+			for i in range(len(t)):
+				al = _labels(socket=name, assoc_id=t.assoc_id[i])
+				a_state.add("", al, t.state[i])
+				a_rwnd.add("", al, t.rwnd[i])
+				a_unack.add("", al, t.unackdata[i])
+				a_pend.add("", al, t.penddata[i])
+				a_in.add("", al, t.instrms[i])
+				a_out.add("", al, t.outstrms[i])
+
+			if with_paths:
+				for i in range(len(t.path_assoc_id)):
+					addr = t.path_sockaddr[i] or ("", 0)
+					pl = _labels(socket=name, assoc_id=t.path_assoc_id[i],
+						     address="%s:%d" % addr)
+					p_state.add("", pl, t.path_state[i])
+					p_primary.add("", pl, t.path_primary[i])
+					p_srtt.add("", pl, t.path_srtt[i] / 1000.0)
+					p_rto.add("", pl, t.path_rto[i] / 1000.0)
+					p_cwnd.add("", pl, t.path_cwnd[i])
+					p_mtu.add("", pl, t.path_mtu[i])
+
+			st = sk.latency_stats()
+			if st is None:
+				continue
+			for d in ("send", "recv"):
+				fcalls, fbytes, feagain, ferrors, fhist = calls[d]
+				h = getattr(st, d + "_ns")
+				fcalls.add("_total", sl, h.count)
+				fbytes.add("_total", sl, getattr(st, d + "_bytes").sum)
+				feagain.add("_total", sl, getattr(st, d + "_eagain"))
+				ferrors.add("_total", sl, getattr(st, d + "_errors"))
+				# log buckets are much finer than TIME_BUCKETS; a log bucket
+				# is counted below a bound if it starts below it
+				for bound in TIME_BUCKETS:
+					n = 0
+					for lower, count in h.buckets:
+						if lower < bound * 1e9:
+							n += count
+					fhist.add("_bucket", _labels(socket=name, le=repr(bound)), n)
+				fhist.add("_bucket", _labels(socket=name, le="+Inf"), h.count)
+				fhist.add("_count", sl, h.count)
+				fhist.add("_sum", sl, h.sum / 1e9)
+
+		return [f[k] for k in sorted(f.keys())]
+
+	def render(self):
+		"""
+		Returns the OpenMetrics text exposition of all registered sockets.
+		"""
+		out = []
+		for family in self.collect():
+			family.render(out)
+		out.append("# EOF")
+		return "\n".join(out) + "\n"
+
+	def start_http_server(self, port, addr=""):
+		"""
+		Serves the metrics over HTTP, on any path, from a daemon thread.
+		Returns the HTTPServer object. Only one server per registry.
+		"""
+		if self._server:
+			raise ValueError("HTTP server already started")
+
+		reg = self
+
+		class handler(BaseHTTPRequestHandler):
+			def do_GET(self):
+				try:
+					body = reg.render().encode("utf-8")
+				except Exception as e:
+					self.send_error(500, str(e))
+					return
+				self.send_response(200)
+				self.send_header("Content-Type", CONTENT_TYPE)
+				self.send_header("Content-Length", str(len(body)))
+				self.end_headers()
+				self.wfile.write(body)
+
+			def log_message(self, *args):
+				pass
+
+		self._server = HTTPServer((addr, port), handler)
+		self._thread = threading.Thread(target=self._server.serve_forever)
+		self._thread.daemon = True
+		self._thread.start()
+		return self._server
+
+	def stop_http_server(self):
+		if self._server:
+			self._server.shutdown()
+			self._server.server_close()
+			self._thread.join()
+			self._server = None
+			self._thread = None
+
+# Default registry and shortcuts
+
+REGISTRY = registry()
+
+def register(sk, name=None, with_paths=True, latency=True):
+	REGISTRY.register(sk, name, with_paths, latency)
+
+def unregister(sk):
+	REGISTRY.unregister(sk)
+
+def render():
+	return REGISTRY.render()
+
+def start_http_server(port, addr=""):
+	return REGISTRY.start_http_server(port, addr)
+
+def stop_http_server():
+	REGISTRY.stop_http_server()
@@ -0,0 +1,253 @@
+# SCTP bindings for Python
+# -*- coding: utf-8 -*-
+#
+# Latency-aware multihoming path manager
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Latency-aware path manager for multihomed SCTP associations.
+
+The kernel moves traffic away from the primary path only when the path
+fails. path_manager() periodically samples srtt and cwnd of every peer
+address of every association of a socket, and makes the faster path the
+primary (sctpsocket.set_primary()) when it is consistently faster, with
+hysteresis controlled by a per-association path_policy(). Here one
+association switches only to paths twice as fast as its primary:
+
+import sctp, sctp_pathmgr
+
+sk = sctp.sctpsocket_udp(socket.AF_INET)
+pm = sctp_pathmgr.path_manager(sk)
+pm.set_policy(assoc_id, sctp_pathmgr.path_policy(ratio=0.5))
+pm.start()
+
+while True:
+	fromaddr, flags, msg, notif = sk.sctp_recv(2048)
+	pm.handle_notification(notif)
+	...
+
+Sampling uses sctpsocket.get_status_all(with_paths=True), that is, one
+C call per socket per interval. path_manager subscribes to paddr_change
+events but does not read the socket itself; the application must pass
+the notifications it receives to handle_notification().
+"""
+
+import threading
+import time
+
+import sctp
+
+class path_policy(object):
+	"""
+	Path selection policy of an association. Attributes:
+
+	ratio: a path is "faster" when its srtt is at most ratio * primary srtt.
+
+	min_delta: ... and when it is at least min_delta milliseconds faster,
+		   which avoids flapping between paths with tiny RTTs.
+
+	samples: number of consecutive samples a path must be faster before
+		 it is made primary.
+
+	hold_down: minimum time in seconds between two switches of the same
+		   association, and after a paddr_change event.
+
+	min_cwnd: paths with a smaller congestion window (bytes) are not eligible.
+
+	enabled: if False, the association is left alone.
+	"""
+	def __init__(self, ratio=0.7, min_delta=5, samples=3, hold_down=30.0, min_cwnd=0,
+			enabled=True):
+		self.ratio = ratio
+		self.min_delta = min_delta
+		self.samples = samples
+		self.hold_down = hold_down
+		self.min_cwnd = min_cwnd
+		self.enabled = enabled
+
+class _assoc_state(object):
+	def __init__(self):
+		self.candidate = None
+		self.streak = 0
+		self.last_change = 0.0
+		self.down = set()
+
+class path_manager(sctp.periodic_sampler):
+	"""
+	Switches the primary path of the associations of an SCTP socket to the
+	fastest one. See module docstring.
+
+	on_switch, if set, is called as on_switch(assoc_id, old_addr, new_addr)
+	after each switch made by the manager. Errors of set_primary() are
+	passed to on_error(assoc_id, addr, exception) if set, and ignored
+	otherwise (the association may be gone). An error reading the socket
+	status ends the background sampling (see sctp.periodic_sampler).
+	"""
+	def __init__(self, sk, policy=None, interval=1.0):
+		self.sk = sk
+		self.default_policy = policy or path_policy()
+		self.interval = interval
+		self.on_switch = None
+		self.on_error = None
+		self._policies = {}
+		self._state = {}
+		self._lock = threading.Lock()
+
+		sk.events.address = True
+		sk.events.association = True
+		sk.events.flush()
+
+	def set_policy(self, assoc_id, policy):
+		"""
+		Sets the policy of one association. Pass None to go back to default_policy.
+		"""
+		self._lock.acquire()
+		try:
+			if policy is None:
+				self._policies.pop(assoc_id, None)
+			else:
+				self._policies[assoc_id] = policy
+		finally:
+			self._lock.release()
+
+	def get_policy(self, assoc_id):
+		return self._policies.get(assoc_id, self.default_policy)
+
+	def _get_state(self, assoc_id):
+		st = self._state.get(assoc_id)
+		if st is None:
+			st = self._state[assoc_id] = _assoc_state()
+		return st
+
+	def handle_notification(self, notif):
+		"""
+		Feeds an event received by the application. paddr_change events reset
+		the hysteresis of the association (unreachable addresses are not
+		eligible until they are available again); the state of terminated
+		associations is forgotten. Other objects are ignored, so every
+		sctp_recv() result can be passed.
+		"""
+		if isinstance(notif, sctp.paddr_change):
+			self._lock.acquire()
+			try:
+				st = self._get_state(notif.assoc_id)
+				st.candidate = None
+				st.streak = 0
+				st.last_change = time.time()
+				addr = notif.addr[0]
+				if notif.state in (sctp.paddr_change.state_ADDR_UNREACHABLE,
+						   sctp.paddr_change.state_ADDR_REMOVED):
+					st.down.add(addr)
+				elif notif.state in (sctp.paddr_change.state_ADDR_AVAILABLE,
+						     sctp.paddr_change.state_ADDR_ADDED):
+					st.down.discard(addr)
+			finally:
+				self._lock.release()
+
+		elif isinstance(notif, sctp.assoc_change):
+			if notif.state in (sctp.assoc_change.state_COMM_LOST,
+					   sctp.assoc_change.state_SHUTDOWN_COMP):
+				self._lock.acquire()
+				try:
+					self._state.pop(notif.assoc_id, None)
+					self._policies.pop(notif.assoc_id, None)
+				finally:
+					self._lock.release()
+
+	def sample(self):
+		"""
+		Takes one sample of every association and switches primaries where
+		needed. Returns the list of (assoc_id, old_addr, new_addr) switches
+		made. start() calls it every "interval" seconds; an application may
+		call it from its own loop instead, at a steady pace, since
+		path_policy.samples counts calls.
+		"""
+		t = self.sk.get_status_all(with_paths=True)
+		now = time.time()
+		switches = []
+
+		# group path rows by association
+		paths = {}
+		for i in range(len(t.path_assoc_id)):
+			paths.setdefault(t.path_assoc_id[i], []).append(i)
+
+		self._lock.acquire()
+		try:
+			for assoc_id, rows in paths.items():
+				policy = self.get_policy(assoc_id)
+				if not policy.enabled:
+					continue
+				st = self._get_state(assoc_id)
+				new = self._decide(t, rows, policy, st, now)
+				if new:
+					switches.append((assoc_id,) + new)
+		finally:
+			self._lock.release()
+
+		for assoc_id, old, new in switches[:]:
+			try:
+				self.sk.set_primary(assoc_id, new)
+			except (IOError, OSError, ValueError) as e:
+				switches.remove((assoc_id, old, new))
+				if self.on_error:
+					self.on_error(assoc_id, new, e)
+				continue
+			if self.on_switch:
+				self.on_switch(assoc_id, old, new)
+
+		return switches
+
+	def _decide(self, t, rows, policy, st, now):
+		primary = None
+		best = None
+		for i in rows:
+			if t.path_primary[i]:
+				primary = i
+				continue
+			if t.path_state[i] != sctp.paddrinfo.state_ACTIVE or not t.path_srtt[i]:
+				continue
+			if t.path_cwnd[i] < policy.min_cwnd or t.path_sockaddr[i] is None:
+				continue
+			if t.path_sockaddr[i][0] in st.down:
+				continue
+			if best is None or t.path_srtt[i] < t.path_srtt[best]:
+				best = i
+
+		if primary is None or best is None or t.path_state[primary] != sctp.paddrinfo.state_ACTIVE:
+			# no alternative, or the kernel is already failing over
+			st.candidate = None
+			st.streak = 0
+			return None
+
+		psrtt = t.path_srtt[primary]
+		bsrtt = t.path_srtt[best]
+		if bsrtt > psrtt * policy.ratio or psrtt - bsrtt < policy.min_delta:
+			st.candidate = None
+			st.streak = 0
+			return None
+
+		addr = t.path_sockaddr[best]
+		if st.candidate != addr:
+			st.candidate = addr
+			st.streak = 0
+		st.streak += 1
+
+		if st.streak < policy.samples or now - st.last_change < policy.hold_down:
+			return None
+
+		st.candidate = None
+		st.streak = 0
+		st.last_change = now
+		return (t.path_sockaddr[primary], addr)
@@ -0,0 +1,549 @@
+# SCTP bindings for Python
+# -*- coding: utf-8 -*-
+#
+# Client-side association pool
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Association pool over a single UDP-style (one-to-many) socket.
+
+Talking to many peers through one sctpsocket_tcp() per peer costs one
+file descriptor and one socket buffer per peer. assoc_pool() keeps all
+associations in one sctpsocket_udp(), and maps every configured peer to
+its assoc_id, so that messages are sent by assoc_id. Two Diameter peers,
+one of them multihomed:
+
+import sctp, sctp_pool
+
+pool = sctp_pool.assoc_pool(socket.AF_INET)
+pool.add_peer("hss1", [("10.0.1.1", 3868), ("10.0.2.1", 3868)])
+pool.add_peer("hss2", [("10.0.1.2", 3868)])
+pool.connect_all()
+
+pool.send("hss1", msg, ppid=46)
+
+while True:
+	peer, fromaddr, flags, msg, notif = pool.recv(2048)
+	...
+
+Associations are established up front by connect_all(), that starts
+all handshakes at once (non-blocking connectx()) and polls their state
+until they complete, without reading the socket. The peer to assoc_id
+map is then kept by assoc_change notifications: the pool subscribes to
+association events, and recv() passes them to handle_notification().
+Applications reading the socket themselves must call
+handle_notification() with every notification they receive.
+
+The pool puts its socket in non-blocking mode, which non-blocking
+handshakes need; recv() and send() wait for the socket as a blocking
+socket would.
+
+When an association is lost, the peer is reconnected by the next send()
+to it (or by maintain()), with exponential backoff between attempts.
+Counters of hits (send over a live association), misses (send that had
+to connect first) and reconnects are returned by stats().
+"""
+
+import os
+import errno
+import select
+import threading
+import time
+
+import sctp
+import _sctp
+
+# send() errors meaning that the association is gone. Not EINVAL: Linux
+# returns it for bad parameters (e.g. a stream beyond outstrms) on a live
+# association, and EPIPE for an assoc_id that no longer exists.
+_DEAD_ERRNOS = (errno.EPIPE, errno.ENOENT, errno.ESHUTDOWN,
+		errno.ECONNRESET, errno.ENOTCONN)
+
+class pool_peer(object):
+	"""
+	State of one configured peer. Attributes:
+
+	name: the name passed to add_peer().
+	addrs: list of address/port tuples of the peer.
+	assoc_id: association ID, or None if there is no association.
+	up: True while the association is established.
+	connecting: True while a handshake started by the pool is in progress.
+	connects: number of associations established to the peer.
+	failures: consecutive failed connection attempts.
+	retry_at: time (time.time()) before which no new attempt is made.
+	last_error: last connection error (exception), or None.
+	"""
+	def __init__(self, name, addrs):
+		self.name = name
+		self.addrs = addrs
+		self.assoc_id = None
+		self.up = False
+		self.connecting = False
+		self.connects = 0
+		self.failures = 0
+		self.retry_at = 0.0
+		self.last_error = None
+
+	def __repr__(self):
+		return "pool_peer(%r, %r, assoc_id=%r, up=%r)" % \
+			(self.name, self.addrs, self.assoc_id, self.up)
+
+class assoc_pool(object):
+	"""
+	Pool of associations to a set of peers, over one UDP-style socket.
+	See module docstring.
+
+	family: address family of the socket, if sk is not given.
+
+	sk: an existing sctpsocket_udp() to use instead of a new one.
+
+	backoff: delay in seconds after the first failed connection attempt
+		 (or association loss). It doubles on every consecutive failure,
+		 up to max_backoff, and is reset when the association comes up.
+
+	on_up, on_down: if set, called as on_up(peer) and on_down(peer), with
+		 the pool_peer() object, when an association of a configured peer
+		 comes up or goes away.
+
+	The pool lock is not held while waiting for handshakes, so send() and
+	recv() to other peers go on meanwhile; a peer whose handshake is in
+	progress is not connected again until it completes.
+	"""
+	def __init__(self, family=None, sk=None, backoff=0.1, max_backoff=30.0):
+		if sk is None:
+			sk = sctp.sctpsocket_udp(family)
+		self.sk = sk
+		self.backoff = backoff
+		self.max_backoff = max_backoff
+		self.on_up = None
+		self.on_down = None
+
+		self.hits = 0
+		self.misses = 0
+		self.reconnects = 0
+		self.failures = 0
+
+		self._peers = {}
+		self._by_assoc = {}
+		self._by_addr = {}
+		self._lock = threading.RLock()
+
+		sk.events.association = True
+		sk.events.flush()
+		sk.setblocking(False)
+
+	def add_peer(self, name, addrs):
+		"""
+		Configures a peer. addrs is an address/port tuple, or a list of them
+		for multihomed peers. The association is not established until
+		connect(), connect_all() or the first send().
+		"""
+		if isinstance(addrs, tuple):
+			addrs = [addrs]
+		addrs = [(a[0], a[1]) for a in addrs]
+
+		self._lock.acquire()
+		try:
+			if name in self._peers:
+				raise ValueError("peer %r already configured" % (name,))
+			peer = pool_peer(name, addrs)
+			self._peers[name] = peer
+			for addr in addrs:
+				self._by_addr[addr] = peer
+			return peer
+		finally:
+			self._lock.release()
+
+	def remove_peer(self, name, shutdown=True):
+		"""
+		Forgets a peer. If shutdown is True and the peer has an association,
+		it is gracefully shut down (MSG_EOF).
+		"""
+		self._lock.acquire()
+		try:
+			peer = self._peers.pop(name)
+			for addr in peer.addrs:
+				if self._by_addr.get(addr) is peer:
+					del self._by_addr[addr]
+			assoc_id = peer.assoc_id
+			if assoc_id is not None:
+				self._by_assoc.pop(assoc_id, None)
+			peer.assoc_id = None
+			peer.up = False
+		finally:
+			self._lock.release()
+
+		if shutdown and assoc_id is not None:
+			try:
+				self.sk.sctp_send(b"", to=assoc_id, flags=sctp.MSG_EOF)
+			except IOError:
+				pass
+
+	def peer(self, name):
+		"""
+		Returns the pool_peer() object of a configured peer.
+		"""
+		return self._peers[name]
+
+	def peers(self):
+		"""
+		Returns the list of pool_peer() objects of all configured peers.
+		"""
+		self._lock.acquire()
+		try:
+			return list(self._peers.values())
+		finally:
+			self._lock.release()
+
+	def assoc_id(self, name):
+		"""
+		Returns the association ID of a peer, or None if it has no live association.
+		"""
+		peer = self._peers[name]
+		if peer.up:
+			return peer.assoc_id
+		return None
+
+	def _start(self, peers):
+		# called with the lock held: starts the handshakes. Returns
+		# {assoc_id: peer} of those started, and {peer name: exception} of
+		# those that could not be
+		if "connectx_many" not in _sctp.__dict__:
+			raise RuntimeError("Underlying SCTP implementation does not have connectx()")
+		now = time.time()
+		for peer in peers:
+			if peer.connects:
+				self.reconnects += 1
+		started = _sctp.connectx_many(self.sk.fileno(), [p.addrs for p in peers])
+
+		pending = {}
+		errors = {}
+		for peer, (assoc_id, err) in zip(peers, started):
+			if err:
+				errors[peer.name] = IOError(err, os.strerror(err))
+				self._set_failed(peer, errors[peer.name], now)
+				continue
+			peer.connecting = True
+			peer.assoc_id = assoc_id
+			self._by_assoc[assoc_id] = peer
+			pending[assoc_id] = peer
+		return pending, errors
+
+	def _wait(self, pending, timeout):
+		# called without the lock: polls the state of the handshakes, as
+		# the notifications may be read by another thread. Returns
+		# {assoc_id: assoc_id or exception}
+		results = {}
+		ids = list(pending.keys())
+		deadline = timeout is not None and time.time() + timeout
+		delay = 0.001
+		while ids:
+			for assoc_id in list(ids):
+				try:
+					state = self.sk.get_status(assoc_id).state
+				except IOError:
+					# the association is gone: the handshake failed
+					state = None
+				if state in (sctp.status.state_COOKIE_WAIT, sctp.status.state_COOKIE_ECHOED):
+					continue
+				ids.remove(assoc_id)
+				if state == sctp.status.state_ESTABLISHED:
+					results[assoc_id] = assoc_id
+				else:
+					results[assoc_id] = IOError(errno.ECONNREFUSED,
+						"association %d could not be established" % assoc_id)
+			if not ids:
+				break
+			wait = delay
+			if deadline:
+				wait = min(delay, deadline - time.time())
+				if wait <= 0:
+					break
+			time.sleep(wait)
+			delay = min(delay * 2, 0.05)
+
+		for assoc_id in ids:
+			results[assoc_id] = IOError(errno.ETIMEDOUT,
+				"association %d not established after %ss" % (assoc_id, timeout))
+		return results
+
+	def _finish(self, pending, results):
+		# called with the lock held; returns {peer name: exception} of the
+		# peers that failed
+		errors = {}
+		now = time.time()
+		for assoc_id, peer in pending.items():
+			peer.connecting = False
+			if self._peers.get(peer.name) is not peer:
+				# removed meanwhile
+				self._by_assoc.pop(assoc_id, None)
+				continue
+			result = results[assoc_id]
+			if isinstance(result, Exception):
+				if peer.assoc_id == assoc_id and not peer.up:
+					self._by_assoc.pop(assoc_id, None)
+					peer.assoc_id = None
+				self._set_failed(peer, result, now)
+				errors[peer.name] = result
+			else:
+				self._set_up(peer, result)
+		return errors
+
+	def _connect(self, peers, timeout):
+		# called without the lock; returns the peers connected, and
+		# {peer name: exception} of those that failed
+		self._lock.acquire()
+		try:
+			pending, errors = self._start(peers)
+		finally:
+			self._lock.release()
+
+		results = self._wait(pending, timeout)
+
+		self._lock.acquire()
+		try:
+			errors.update(self._finish(pending, results))
+		finally:
+			self._lock.release()
+		return [p for p in pending.values() if p.name not in errors], errors
+
+	def _set_failed(self, peer, e, now):
+		self.failures += 1
+		peer.failures += 1
+		peer.last_error = e
+		peer.retry_at = now + min(self.backoff * (2 ** (peer.failures - 1)), self.max_backoff)
+
+	def _set_up(self, peer, assoc_id):
+		if peer.assoc_id is not None and peer.assoc_id != assoc_id:
+			self._by_assoc.pop(peer.assoc_id, None)
+		fresh = not peer.up or peer.assoc_id != assoc_id
+		peer.assoc_id = assoc_id
+		peer.up = True
+		peer.failures = 0
+		peer.retry_at = 0.0
+		peer.last_error = None
+		self._by_assoc[assoc_id] = peer
+		if fresh:
+			peer.connects += 1
+			if self.on_up:
+				self.on_up(peer)
+
+	def _set_down(self, peer, delay=True):
+		if peer.assoc_id is not None:
+			self._by_assoc.pop(peer.assoc_id, None)
+		was_up = peer.up
+		peer.assoc_id = None
+		peer.up = False
+		if delay:
+			peer.failures += 1
+			peer.retry_at = time.time() + \
+				min(self.backoff * (2 ** (peer.failures - 1)), self.max_backoff)
+		if was_up and self.on_down:
+			self.on_down(peer)
+
+	def connect(self, name):
+		"""
+		Establishes the association to a peer, if it has none. Raises IOError
+		if the association cannot be established, or if the peer is still in
+		backoff, or has a handshake in progress (EAGAIN). Returns the
+		association ID.
+		"""
+		self._lock.acquire()
+		try:
+			peer = self._peers[name]
+			if peer.up:
+				return peer.assoc_id
+			now = time.time()
+			if peer.connecting:
+				raise IOError(errno.EAGAIN, "peer %r: handshake in progress" % (peer.name,))
+			if now < peer.retry_at:
+				raise IOError(errno.EAGAIN, "peer %r: reconnection backing off for %.3fs" %
+						(peer.name, peer.retry_at - now))
+		finally:
+			self._lock.release()
+
+		connected, errors = self._connect([peer], None)
+		if name in errors:
+			raise errors[name]
+		return peer.assoc_id
+
+	def _connect_all(self, timeout):
+		now = time.time()
+		self._lock.acquire()
+		try:
+			todo = [p for p in self._peers.values()
+				if not p.up and not p.connecting and now >= p.retry_at]
+		finally:
+			self._lock.release()
+		if not todo:
+			return [], {}
+		return self._connect(todo, timeout)
+
+	def connect_all(self, timeout=None):
+		"""
+		Establishes the associations to all configured peers that have none
+		and are not in backoff. The handshakes run in parallel, waiting at
+		most timeout seconds, without holding the pool lock. Failures do not
+		stop the remaining connections; returns a dictionary of peer name to
+		exception for the peers that failed.
+		"""
+		return self._connect_all(timeout)[1]
+
+	def maintain(self, timeout=None):
+		"""
+		Reconnects the dead associations whose backoff expired. Meant to be
+		called periodically, so that peers are reconnected before the next
+		send() to them. Returns the number of peers reconnected.
+		"""
+		return len(self._connect_all(timeout)[0])
+
+	def _send(self, assoc_id, msg, kwargs):
+		while True:
+			try:
+				return self.sk.sctp_send(msg, to=assoc_id, **kwargs)
+			except IOError as e:
+				if e.errno not in (errno.EAGAIN, errno.EWOULDBLOCK):
+					raise
+			select.select([], [self.sk], [])
+
+	def send(self, name, msg, **kwargs):
+		"""
+		Sends a message to a peer, by association ID. The keyword parameters
+		are those of sctpsocket.sctp_send() (ppid, flags, stream, ...).
+
+		If the peer has no live association, it is (re)connected first. If
+		the association turns out to be gone, it is reconnected and the send
+		is retried once. Connection errors are raised as IOError. Waits for
+		room in the socket send buffer, as on a blocking socket.
+		"""
+		self._lock.acquire()
+		try:
+			peer = self._peers[name]
+			if peer.up:
+				self.hits += 1
+			else:
+				self.misses += 1
+			assoc_id = peer.assoc_id
+			up = peer.up
+		finally:
+			self._lock.release()
+		if not up:
+			assoc_id = self.connect(name)
+
+		try:
+			return self._send(assoc_id, msg, kwargs)
+		except IOError as e:
+			if e.errno not in _DEAD_ERRNOS:
+				raise
+
+		self._lock.acquire()
+		try:
+			if peer.assoc_id == assoc_id:
+				self._set_down(peer, delay=False)
+		finally:
+			self._lock.release()
+
+		return self._send(self.connect(name), msg, kwargs)
+
+	def handle_notification(self, fromaddr, notif):
+		"""
+		Updates the pool from a notification returned by sctp_recv(). Only
+		assoc_change() notifications matter; others are ignored. Returns the
+		pool_peer() the notification refers to, or None.
+		"""
+		if not isinstance(notif, sctp.assoc_change):
+			return None
+
+		self._lock.acquire()
+		try:
+			peer = self._by_assoc.get(notif.assoc_id)
+			if peer is None and fromaddr:
+				peer = self._by_addr.get((fromaddr[0], fromaddr[1]))
+			if peer is None:
+				return None
+
+			state = notif.state
+			if state in (sctp.assoc_change.state_COMM_UP, sctp.assoc_change.state_RESTART):
+				self._set_up(peer, notif.assoc_id)
+			elif state in (sctp.assoc_change.state_COMM_LOST,
+					sctp.assoc_change.state_SHUTDOWN_COMP,
+					sctp.assoc_change.state_CANT_STR_ASSOC):
+				if peer.assoc_id in (None, notif.assoc_id):
+					self._set_down(peer)
+			return peer
+		finally:
+			self._lock.release()
+
+	def recv(self, maxlen):
+		"""
+		Receives one message or notification from the socket, like
+		sctpsocket.sctp_recv() on a blocking socket, passing notifications
+		to handle_notification().
+		Returns (peer, fromaddr, flags, msg, notif), where peer is the name of
+		the configured peer the message or notification belongs to, or None.
+		"""
+		while True:
+			select.select([self.sk], [], [])
+			try:
+				fromaddr, flags, msg, notif = self.sk.sctp_recv(maxlen)
+				break
+			except IOError as e:
+				# read by another thread meanwhile
+				if e.errno not in (errno.EAGAIN, errno.EWOULDBLOCK):
+					raise
+		if flags & sctp.FLAG_NOTIFICATION:
+			peer = self.handle_notification(fromaddr, notif)
+		else:
+			self._lock.acquire()
+			try:
+				peer = self._by_assoc.get(getattr(notif, "assoc_id", None))
+				if peer is None and fromaddr:
+					peer = self._by_addr.get((fromaddr[0], fromaddr[1]))
+			finally:
+				self._lock.release()
+		return (peer and peer.name, fromaddr, flags, msg, notif)
+
+	def stats(self):
+		"""
+		Returns a dictionary of counters: hits, misses, reconnects, failures
+		(failed connection attempts), peers and up (live associations).
+		"""
+		self._lock.acquire()
+		try:
+			return {
+				"hits": self.hits,
+				"misses": self.misses,
+				"reconnects": self.reconnects,
+				"failures": self.failures,
+				"peers": len(self._peers),
+				"up": len([p for p in self._peers.values() if p.up]),
+			}
+		finally:
+			self._lock.release()
+
+	def close(self):
+		"""
+		Closes the socket, and with it every association of the pool.
+		"""
+		self._lock.acquire()
+		try:
+			for peer in self._peers.values():
+				peer.assoc_id = None
+				peer.up = False
+				peer.connecting = False
+			self._by_assoc.clear()
+		finally:
+			self._lock.release()
+		self.sk.close()
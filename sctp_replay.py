@@ -0,0 +1,521 @@
+# SCTP bindings for Python
+# -*- coding: utf-8 -*-
+#
+# Capture replay tool
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Replays SCTP messages recorded in pcap/pcapng captures, for load testing.
+
+Captures may come from tcpdump/Wireshark (Ethernet, Linux cooked, raw IP,
+loopback link types; IPv4 or IPv6) or from pysctp's own pcap_writer. DATA
+chunks are extracted, fragmented messages are reassembled, and messages are
+re-sent over one or many associations preserving stream, PPID and the
+unordered flag. Pacing can follow the original timing, optionally scaled,
+or a maximum rate, or be as fast as possible. Messages received from the
+peer are matched with the oldest unanswered message of the association to
+measure response latency.
+
+Command line:
+
+python sctp_replay.py capture.pcapng 10.0.0.1:2905 [--dport 2905] [--assocs 4]
+			[--speed 2.0 | --rate 1000 | --flood] [--udp]
+
+As a library:
+
+msgs = sctp_replay.read_capture("capture.pcapng", dport=2905)
+r = sctp_replay.replayer(("10.0.0.1", 2905), assocs=4)
+report = r.run(msgs, speed=1.0)
+"""
+
+import sys
+import time
+import struct
+import socket
+import select
+import threading
+
+import sctp
+
+try:
+	now = time.perf_counter
+except AttributeError:
+	now = time.time
+
+class message(object):
+	"""
+	One SCTP message read from a capture. "flow" identifies the original
+	association ((src, sport, dst, dport) tuple) so messages of a flow are
+	replayed on the same association. "outbound" is True/False for pysctp
+	captures (direction flag of the packet) and None if unknown.
+	"""
+	def __init__(self, timestamp, flow, stream, ppid, unordered, data, outbound=None):
+		self.timestamp = timestamp
+		self.flow = flow
+		self.stream = stream
+		self.ppid = ppid
+		self.unordered = unordered
+		self.data = data
+		self.outbound = outbound
+
+######### CAPTURE READING
+
+LINKTYPE_NULL = 0
+LINKTYPE_ETHERNET = 1
+LINKTYPE_RAW = 101
+LINKTYPE_LINUX_SLL = 113
+LINKTYPE_IPV4 = 228
+LINKTYPE_IPV6 = 229
+LINKTYPE_LINUX_SLL2 = 276
+
+def _packets(f):
+	"""
+	Yields (timestamp, linktype, packet, outbound) from a pcap or pcapng file.
+	"""
+	head = f.read(4)
+	if head == b"\x0a\x0d\x0d\x0a":
+		for p in _pcapng_packets(f, head):
+			yield p
+		return
+
+	head += f.read(20)
+	if len(head) < 24:
+		raise ValueError("not a pcap or pcapng file")
+	magic = struct.unpack("<I", head[:4])[0]
+	if magic in (0xa1b2c3d4, 0xa1b23c4d):
+		endian = "<"
+	elif magic in (0xd4c3b2a1, 0x4d3cb2a1):
+		endian = ">"
+	else:
+		raise ValueError("not a pcap or pcapng file")
+	nano = magic in (0xa1b23c4d, 0x4d3cb2a1)
+	linktype = struct.unpack(endian + "I", head[20:24])[0] & 0x0FFFFFFF
+
+	while True:
+		rec = f.read(16)
+		if len(rec) < 16:
+			return
+		sec, frac, caplen, origlen = struct.unpack(endian + "IIII", rec)
+		data = f.read(caplen)
+		yield (sec + frac / (nano and 1e9 or 1e6), linktype, data, None)
+
+def _pcapng_packets(f, head):
+	endian = "<"
+	interfaces = []
+	while True:
+		if not head:
+			head = f.read(4)
+		if len(head) < 4:
+			return
+		rest = f.read(4)
+		if len(rest) < 4:
+			return
+		if head == b"\x0a\x0d\x0d\x0a":
+			# section header: byte order magic follows the length
+			bom = f.read(4)
+			endian = (bom == b"\x4d\x3c\x2b\x1a") and "<" or ">"
+			blen = struct.unpack(endian + "I", rest)[0]
+			f.read(blen - 12)
+			interfaces = []
+			head = None
+			continue
+
+		btype = struct.unpack(endian + "I", head)[0]
+		blen = struct.unpack(endian + "I", rest)[0]
+		body = f.read(blen - 8)
+		head = None
+
+		if btype == 1:
+			linktype = struct.unpack(endian + "H", body[:2])[0]
+			tsresol = 1e-6
+			opts = body[8:-4]
+			while len(opts) >= 4:
+				code, olen = struct.unpack(endian + "HH", opts[:4])
+				if code == 0:
+					break
+				if code == 9 and olen >= 1:
+					v = ord(opts[4:5])
+					tsresol = (v & 0x80) and 2.0 ** -(v & 0x7f) or 10.0 ** -v
+				opts = opts[4 + ((olen + 3) & ~3):]
+			interfaces.append((linktype, tsresol))
+
+		elif btype == 6:
+			ifid, th, tl, caplen, origlen = struct.unpack(endian + "IIIII", body[:20])
+			data = body[20:20 + caplen]
+			outbound = None
+			opts = body[20 + ((caplen + 3) & ~3):-4]
+			while len(opts) >= 4:
+				code, olen = struct.unpack(endian + "HH", opts[:4])
+				if code == 0:
+					break
+				if code == 2 and olen == 4:
+					direction = struct.unpack(endian + "I", opts[4:8])[0] & 3
+					if direction:
+						outbound = (direction == 2)
+				opts = opts[4 + ((olen + 3) & ~3):]
+			if ifid < len(interfaces):
+				linktype, tsresol = interfaces[ifid]
+				yield (((th << 32) | tl) * tsresol, linktype, data, outbound)
+
+		elif btype == 3:
+			# simple packet block, no timestamp
+			if interfaces:
+				yield (0.0, interfaces[0][0], body[4:], None)
+
+def _ip_payload(linktype, pkt):
+	"""
+	Returns the IP packet inside a link-layer frame, or None.
+	"""
+	if linktype in (LINKTYPE_RAW, LINKTYPE_IPV4, LINKTYPE_IPV6):
+		return pkt
+	if linktype == LINKTYPE_NULL:
+		return pkt[4:]
+	if linktype == LINKTYPE_ETHERNET:
+		off = 12
+		etype = struct.unpack(">H", pkt[off:off + 2])[0]
+		while etype in (0x8100, 0x88a8):
+			off += 4
+			etype = struct.unpack(">H", pkt[off:off + 2])[0]
+		if etype not in (0x0800, 0x86dd):
+			return None
+		return pkt[off + 2:]
+	if linktype == LINKTYPE_LINUX_SLL:
+		return pkt[16:]
+	if linktype == LINKTYPE_LINUX_SLL2:
+		return pkt[20:]
+	return None
+
+def _sctp_packet(ip):
+	"""
+	Returns (src, dst, sctp_packet) from an IP packet, or None if not SCTP.
+	"""
+	if len(ip) < 20:
+		return None
+	version = ord(ip[0:1]) >> 4
+	if version == 4:
+		ihl = (ord(ip[0:1]) & 0x0f) * 4
+		if ord(ip[9:10]) != 132:
+			return None
+		frag = struct.unpack(">H", ip[6:8])[0]
+		if frag & 0x1fff or frag & 0x2000:
+			# IP fragments are not reassembled
+			return None
+		total = struct.unpack(">H", ip[2:4])[0]
+		return (socket.inet_ntoa(ip[12:16]), socket.inet_ntoa(ip[16:20]), ip[ihl:total])
+	if version == 6 and len(ip) >= 40:
+		nh = ord(ip[6:7])
+		off = 40
+		# skip hop-by-hop, routing and destination options headers
+		while nh in (0, 43, 60) and len(ip) >= off + 8:
+			nh = ord(ip[off:off + 1])
+			off += (ord(ip[off + 1:off + 2]) + 1) * 8
+		if nh != 132:
+			return None
+		src = socket.inet_ntop(socket.AF_INET6, ip[8:24])
+		dst = socket.inet_ntop(socket.AF_INET6, ip[24:40])
+		return (src, dst, ip[off:40 + struct.unpack(">H", ip[4:6])[0]])
+	return None
+
+def read_capture(path, dport=None, sport=None, outbound=None):
+	"""
+	Reads the SCTP messages of a pcap/pcapng file, in capture order. Returns a
+	list of message() objects.
+
+	Parameters:
+
+	dport, sport: keep only messages sent to/from this SCTP port, e.g. the
+		      port of the server being load-tested.
+
+	outbound: for captures made by pysctp's pcap_writer, keep only messages
+		  sent (True) or received (False) by the recording application.
+
+	Retransmitted DATA chunks (a TSN already seen on the flow) are skipped.
+	"""
+	msgs = []
+	partial = {}
+	seen = {}
+	f = open(path, "rb")
+	try:
+		for ts, linktype, pkt, direction in _packets(f):
+			if outbound is not None and direction is not None and direction != outbound:
+				continue
+			ip = _ip_payload(linktype, pkt)
+			if ip is None:
+				continue
+			p = _sctp_packet(ip)
+			if p is None or len(p[2]) < 12:
+				continue
+			src, dst, sp = p
+			ps, pd = struct.unpack(">HH", sp[:4])
+			if (dport is not None and pd != dport) or (sport is not None and ps != sport):
+				continue
+			flow = (src, ps, dst, pd)
+			# TSNs are per association and direction, which the verification
+			# tag tells even on a retransmission to another address.
+			# pcap_writer records carry a zero tag, which no DATA packet on
+			# the wire does, and number their TSNs per message (or repeat
+			# sinfo_tsn over partial reads): no dedupe for them
+			tsns = None
+			if sp[4:8] != b"\0\0\0\0":
+				tsns = seen.setdefault((ps, pd, sp[4:8]), set())
+
+			off = 12
+			while off + 4 <= len(sp):
+				ctype, cflags, clen = struct.unpack(">BBH", sp[off:off + 4])
+				if clen < 4:
+					break
+				if ctype == 0 and clen >= 16:
+					tsn, stream, ssn, ppid = struct.unpack(">IHHI", sp[off + 4:off + 16])
+					data = sp[off + 16:off + clen]
+					if tsns is not None:
+						if tsn in tsns:
+							off += (clen + 3) & ~3
+							continue
+						tsns.add(tsn)
+					if cflags & 2 and cflags & 1:
+						msgs.append(message(ts, flow, stream, ppid, bool(cflags & 4), data, direction))
+					elif cflags & 2:
+						partial[(flow, stream)] = [data]
+					elif (flow, stream) in partial:
+						partial[(flow, stream)].append(data)
+						if cflags & 1:
+							data = b"".join(partial.pop((flow, stream)))
+							msgs.append(message(ts, flow, stream, ppid, bool(cflags & 4), data, direction))
+				off += (clen + 3) & ~3
+	finally:
+		f.close()
+
+	return msgs
+
+######### REPLAY
+
+class replayer(object):
+	"""
+	Re-sends messages to a target over "assocs" associations, one TCP-style
+	socket each; or over a single UDP-style socket (udp=True), which can hold
+	only one association with the target. Flows of the capture are spread over
+	the associations, and all messages of a flow use the same association.
+
+	Streams above the negotiated number of outbound streams are folded with
+	a modulo. initparams, if given, is a dict applied to every socket's
+	initparams (e.g. {"num_ostreams": 64}).
+	"""
+	def __init__(self, target, assocs=1, udp=False, family=None, initparams=None):
+		self.target = target
+		self.udp = udp
+		if family is None:
+			family = (":" in target[0]) and socket.AF_INET6 or socket.AF_INET
+		self.family = family
+		self.initparams = initparams or {}
+		self.assocs = assocs
+		self.socks = []
+		self._lock = threading.Lock()
+		self._pending = {}
+		self._latencies = []
+		self._received = 0
+		self._stop = False
+
+	def _setup(self, sk):
+		for k, v in self.initparams.items():
+			setattr(sk.initparams, k, v)
+		sk.events.clear()
+		sk.events.data_io = 1
+		sk.events.association = 1
+
+	def connect(self):
+		if self.udp:
+			sk = sctp.sctpsocket_udp(self.family)
+			self._setup(sk)
+			self.socks = [sk]
+			# UDP-style sockets associate implicitly on the first send
+			self.channels = [(0, self.target)]
+		else:
+			for i in range(self.assocs):
+				sk = sctp.sctpsocket_tcp(self.family)
+				self._setup(sk)
+				sk.connect(self.target)
+				self.socks.append(sk)
+			self.channels = [(i, ("", 0)) for i in range(self.assocs)]
+		self.ostreams = []
+		for sk in self.socks:
+			try:
+				self.ostreams.append(max(sk.get_status(0).outstrms, 1))
+			except (IOError, OSError, ValueError):
+				self.ostreams.append(sk.initparams.num_ostreams or 1)
+
+	def close(self):
+		for sk in self.socks:
+			sk.close()
+		self.socks = []
+
+	def _receiver(self):
+		fds = dict([(sk.fileno(), i) for i, sk in enumerate(self.socks)])
+		while not self._stop:
+			r, w, x = select.select(list(fds.keys()), [], [], 0.1)
+			for fd in r:
+				i = fds[fd]
+				try:
+					fromaddr, flags, msg, notif = self.socks[i].sctp_recv(65536 + 1024)
+				except (IOError, OSError):
+					del fds[fd]
+					continue
+				if flags & sctp.FLAG_NOTIFICATION or not flags & sctp.FLAG_EOR:
+					continue
+				t = now()
+				self._lock.acquire()
+				try:
+					self._received += 1
+					pending = self._pending.get(i)
+					if pending:
+						self._latencies.append(t - pending.pop(0))
+				finally:
+					self._lock.release()
+
+	def run(self, msgs, speed=1.0, rate=None, flood=False, drain=1.0):
+		"""
+		Replays a list of message() objects and returns a report dictionary.
+
+		Pacing: by default the original timing, divided by "speed" (2.0 replays
+		twice as fast); rate=N sends at most N messages per second regardless of
+		capture timing; flood=True sends as fast as possible.
+
+		drain: seconds to wait for outstanding responses at the end.
+
+		Report keys: sent, bytes, elapsed, msgs_per_s, mb_per_s, errors,
+		responses, latency_p50_ms, latency_p99_ms, latency_max_ms.
+		"""
+		if not self.socks:
+			self.connect()
+
+		self._stop = False
+		receiver = threading.Thread(target=self._receiver)
+		receiver.daemon = True
+		receiver.start()
+
+		flows = {}
+		sent = 0
+		nbytes = 0
+		errors = 0
+		t0 = now()
+		ts0 = msgs and msgs[0].timestamp or 0.0
+
+		for n, m in enumerate(msgs):
+			if flood:
+				pass
+			elif rate:
+				delay = t0 + n / float(rate) - now()
+				if delay > 0:
+					time.sleep(delay)
+			else:
+				delay = t0 + (m.timestamp - ts0) / speed - now()
+				if delay > 0:
+					time.sleep(delay)
+
+			c = flows.get(m.flow)
+			if c is None:
+				c = flows[m.flow] = len(flows) % len(self.channels)
+			i, to = self.channels[c]
+			sk = self.socks[i]
+			flags = m.unordered and sctp.MSG_UNORDERED or 0
+
+			self._lock.acquire()
+			self._pending.setdefault(i, []).append(now())
+			self._lock.release()
+			try:
+				sk.sctp_send(m.data, to=to, ppid=m.ppid, flags=flags,
+					     stream=m.stream % self.ostreams[i], timetolive=0)
+				sent += 1
+				nbytes += len(m.data)
+			except (IOError, OSError):
+				errors += 1
+				self._lock.acquire()
+				self._pending[i].pop()
+				self._lock.release()
+
+		elapsed = now() - t0
+		time.sleep(drain)
+		self._stop = True
+		receiver.join()
+
+		lat = sorted(self._latencies)
+		def pct(q):
+			if not lat:
+				return None
+			return round(lat[min(len(lat) - 1, int(q * len(lat)))] * 1e3, 3)
+
+		return {
+			"sent": sent,
+			"bytes": nbytes,
+			"errors": errors,
+			"elapsed": round(elapsed, 6),
+			"msgs_per_s": elapsed and round(sent / elapsed, 1) or 0.0,
+			"mb_per_s": elapsed and round(nbytes / elapsed / 1e6, 3) or 0.0,
+			"responses": self._received,
+			"latency_p50_ms": pct(0.50),
+			"latency_p99_ms": pct(0.99),
+			"latency_max_ms": lat and round(lat[-1] * 1e3, 3) or None,
+		}
+
+def main(argv=None):
+	import json
+	import argparse
+
+	p = argparse.ArgumentParser(description="replay SCTP messages from a capture")
+	p.add_argument("capture", help="pcap or pcapng file")
+	p.add_argument("target", help="host:port, or [v6addr]:port")
+	p.add_argument("--dport", type=int, help="replay only messages sent to this port")
+	p.add_argument("--sport", type=int, help="replay only messages sent from this port")
+	p.add_argument("--outbound", action="store_true", help="pysctp captures: only messages sent by the recorder")
+	p.add_argument("--assocs", type=int, default=1)
+	p.add_argument("--udp", action="store_true", help="use a single UDP-style socket (one association)")
+	p.add_argument("--streams", type=int, default=0, help="outbound streams to request")
+	p.add_argument("--speed", type=float, default=1.0, help="original timing divided by SPEED")
+	p.add_argument("--rate", type=float, help="maximum messages per second")
+	p.add_argument("--flood", action="store_true", help="send as fast as possible")
+	p.add_argument("--loops", type=int, default=1, help="replay the capture LOOPS times")
+	p.add_argument("--drain", type=float, default=1.0, help="seconds to wait for late responses")
+	args = p.parse_args(argv)
+
+	host, port = args.target.rsplit(":", 1)
+	host = host.strip("[]")
+	msgs = read_capture(args.capture, dport=args.dport, sport=args.sport,
+			    outbound=args.outbound and True or None)
+	if not msgs:
+		sys.stderr.write("no SCTP messages found in %s\n" % args.capture)
+		return 1
+
+	if args.loops > 1:
+		span = msgs[-1].timestamp - msgs[0].timestamp
+		looped = []
+		for l in range(args.loops):
+			for m in msgs:
+				looped.append(message(m.timestamp + l * span, m.flow, m.stream, m.ppid,
+						      m.unordered, m.data, m.outbound))
+		msgs = looped
+
+	initparams = {}
+	if args.streams:
+		initparams["num_ostreams"] = args.streams
+	r = replayer((host, int(port)), assocs=args.assocs, udp=args.udp, initparams=initparams)
+	try:
+		report = r.run(msgs, speed=args.speed, rate=args.rate, flood=args.flood, drain=args.drain)
+	finally:
+		r.close()
+
+	print(json.dumps(report, indent=1, sort_keys=True))
+	return 0
+
+if __name__ == '__main__':
+	sys.exit(main())
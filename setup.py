@@ -19,8 +19,40 @@ along with this library; If not, see <http://www.gnu.org/licenses/>.
 
 """
 
+import os
+import shutil
+import tempfile
 import setuptools
 from distutils.core import setup, Extension
+from distutils.ccompiler import new_compiler
+from distutils.errors import CompileError
+from distutils.sysconfig import customize_compiler
+
+def have_struct_member(struct, member, headers):
+    """
+    Configure-style check: whether "struct.member" compiles against the
+    system headers. Fields the kernel added later come without a macro.
+    """
+    cc = new_compiler()
+    customize_compiler(cc)
+    tmpdir = tempfile.mkdtemp()
+    try:
+        src = os.path.join(tmpdir, "probe.c")
+        with open(src, "w") as f:
+            for h in headers:
+                f.write("#include <%s>\n" % h)
+            f.write("int main(void) { struct %s v; (void) v.%s; return 0; }\n" % (struct, member))
+        try:
+            cc.compile([src], output_dir=tmpdir)
+        except CompileError:
+            return False
+        return True
+    finally:
+        shutil.rmtree(tmpdir)
+
+sctp_macros = []
+if have_struct_member("sctp_pdapi_event", "pdapi_stream", ["sys/socket.h", "netinet/sctp.h"]):
+    sctp_macros.append(("HAVE_SCTP_PDAPI_STREAM", "1"))
 
 setup(name='pysctp',
       version='0.7.3',
@@ -37,12 +69,16 @@ setup(name='pysctp',
                      'Programming Language :: Python',
                      'Topic :: Software Development :: Libraries :: Python Modules',
                      'Topic :: System :: Networking' ],
-      py_modules=['sctp'],
+      py_modules=['sctp', 'sctp_metrics', 'sctp_pathmgr', 'sctp_replay', 'sctp_pool',
+                  'sctp_autotune', 'sctp_handoff'],
 	  ext_modules=[Extension('_sctp', sources=['_sctp.c'],
 	  						 include_dirs=['.', '/usr/include'],
 	  						 libraries=['sctp'], 
+	  						 define_macros=sctp_macros,
 	  						 library_dirs=['/usr/lib/', '/usr/local/lib/'],
-							)
+							),
+				   Extension('_sigtran', sources=['_sigtran.c'], depends=['_codec.h']),
+				   Extension('_diameter', sources=['_diameter.c'], depends=['_codec.h'])
 				  ],
 	  data_files=[('include', ['_sctp.h'])],
 	  author='Elvis Pfutzenreuter',
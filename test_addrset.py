@@ -0,0 +1,131 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Tests of sctp.AddressSet. Only the bindx()/connectx() test needs SCTP
+support in the kernel, and is skipped without it:
+
+python test_addrset.py
+"""
+
+import socket
+import unittest
+
+import sctp
+
+A1 = ("10.0.0.1", 5000)
+A2 = ("10.0.0.2", 5000)
+A3 = ("10.0.0.3", 5000)
+V6 = ("2001:db8::1", 5000)
+
+
+class AddressSetTest(unittest.TestCase):
+
+    def test_duplicates(self):
+        s = sctp.AddressSet([A1, A2, A1, A2, A1])
+        self.assertEqual(len(s), 2)
+        self.assertEqual(list(s), [A1, A2])
+        self.assertEqual(len(sctp.AddressSet([])), 0)
+
+    def test_contains(self):
+        s = sctp.AddressSet([A1, V6])
+        self.assertTrue(A1 in s)
+        self.assertTrue(V6 in s)
+        self.assertFalse(A2 in s)
+        self.assertFalse(("10.0.0.1", 5001) in s)
+        # not addresses at all
+        self.assertFalse("10.0.0.1" in s)
+        self.assertFalse(("nowhere", "port") in s)
+
+    def test_equality(self):
+        s = sctp.AddressSet([A1, A2])
+        self.assertEqual(s, sctp.AddressSet([A1, A2, A1]))
+        self.assertNotEqual(s, sctp.AddressSet([A1]))
+        # ordered, like the tuples getpaddrs() returned
+        self.assertNotEqual(s, sctp.AddressSet([A2, A1]))
+        self.assertEqual(set(s), set(sctp.AddressSet([A2, A1])))
+        self.assertEqual(s, (A1, A2))
+        self.assertEqual((A1, A2), s)
+        self.assertNotEqual(s, (A2, A1))
+        self.assertNotEqual(s, [A1, A2])
+        self.assertTrue(s < (A1, A2, A3))
+        self.assertTrue(sctp.AddressSet([A1]) < s)
+
+    def test_hash(self):
+        s = sctp.AddressSet([A1, A2])
+        self.assertEqual(hash(s), hash((A1, A2)))
+        self.assertEqual(hash(s), hash(sctp.AddressSet([A1, A2])))
+        d = {s: 1}
+        self.assertEqual(d[(A1, A2)], 1)
+        self.assertEqual(d[sctp.AddressSet([A1, A2])], 1)
+        self.assertEqual(len(set([s, sctp.AddressSet([A1, A2]), (A1, A2)])), 1)
+
+    def test_operators(self):
+        a = sctp.AddressSet([A1, A2])
+        b = sctp.AddressSet([A2, A3])
+        self.assertEqual(a | b, (A1, A2, A3))
+        self.assertEqual(a - b, (A1,))
+        self.assertEqual(a & b, (A2,))
+        self.assertEqual(a.union([A3]), (A1, A2, A3))
+        self.assertEqual(a.difference([A1]), (A2,))
+        self.assertEqual(a.intersection([A3]), ())
+        self.assertEqual(a - a, ())
+        # the operands are left alone
+        self.assertEqual(a, (A1, A2))
+        self.assertEqual(b, (A2, A3))
+
+    def test_large(self):
+        addrs = [("10.%d.%d.1" % (i // 250, i % 250), 5000) for i in range(5000)]
+        s = sctp.AddressSet(addrs + addrs)
+        self.assertEqual(len(s), len(addrs))
+        self.assertEqual(list(s), addrs)
+        self.assertTrue(addrs[-1] in s)
+        self.assertEqual(len(s | s), len(addrs))
+        self.assertEqual(len(s & sctp.AddressSet(addrs[::2])), len(addrs) // 2)
+
+    def test_ipv6_normalization(self):
+        s = sctp.AddressSet([("2001:db8::1", 5000), ("2001:0db8:0:0:0:0:0:1", 5000),
+                             ("2001:DB8::0:1", 5000)])
+        self.assertEqual(list(s), [V6])
+        self.assertTrue(("2001:0db8::0001", 5000) in s)
+        self.assertNotEqual(s, sctp.AddressSet([("2001:db8::1", 5001)]))
+        mixed = sctp.AddressSet([A1, V6, A1, ("2001:db8:0::1", 5000)])
+        self.assertEqual(mixed, (A1, V6))
+        self.assertEqual(mixed.packed(), sctp.AddressSet([A1, V6]).packed())
+
+    def test_bindx_connectx(self):
+        try:
+            srv = sctp.sctpsocket_tcp(socket.AF_INET)
+        except (IOError, OSError):
+            self.skipTest("no SCTP support")
+        srv.bindx(sctp.AddressSet([("127.0.0.1", 0)]))
+        srv.listen(1)
+        laddrs = srv.getladdrs()
+        self.assertTrue(isinstance(laddrs, sctp.AddressSet))
+        self.assertEqual(laddrs, (srv.getsockname(),))
+
+        cli = sctp.sctpsocket_tcp(socket.AF_INET)
+        cli.connectx(laddrs)
+        conn, fromaddr = srv.accept()
+        self.assertTrue(fromaddr in cli.getladdrs())
+        self.assertEqual(cli.getpaddrs(), laddrs)
+        conn.close()
+        cli.close()
+        srv.close()
+
+if __name__ == '__main__':
+    unittest.main()
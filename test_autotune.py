@@ -0,0 +1,143 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+How sctp_autotune sizes the buffers: buffer_tuner.sample() once a second
+over the congestion windows, RTTs and byte counters scripted on a fakesctp
+socket.
+
+python test_autotune.py
+"""
+
+import unittest
+
+import sctp
+import sctp_autotune
+from fakesctp import fake_socket, status_table, latency_stats, clock
+
+K = 1 << 10
+M = 1 << 20
+
+ACTIVE = sctp.paddrinfo.state_ACTIVE
+P1 = ("10.0.0.1", 5000)
+P2 = ("10.0.0.2", 5000)
+
+
+class SampleTest(unittest.TestCase):
+
+    def setUp(self):
+        self.clock = clock()
+        self.addCleanup(self.clock.install(sctp_autotune))
+        self.sk = fake_socket()
+        self.sk.stats = latency_stats(0, 0)
+        self.tuner = sctp_autotune.buffer_tuner(self.sk, sctp_autotune.buffer_policy(
+            bdp_multiple=2.0, min_sndbuf=64 * K, max_sndbuf=16 * M, min_rcvbuf=64 * K,
+            max_rcvbuf=16 * M, saturation=0.75, hysteresis=0.25, shrink_samples=5))
+        # the first sample has no rate to compute
+        self.tuner.sample()
+
+    def sample(self, cwnd=None, srtt=100, sent=0, received=0):
+        """
+        One second later, with one association of congestion window cwnd
+        and srtt milliseconds, after sent and received more bytes.
+        """
+        if cwnd is not None:
+            self.sk.table = status_table((1, P1, srtt, ACTIVE, cwnd))
+        stats = self.sk.stats
+        self.sk.stats = latency_stats(stats.send_bytes.sum + sent, stats.recv_bytes.sum + received)
+        self.clock.advance(1)
+        return self.tuner.sample()
+
+    def test_grow(self):
+        # 1 MB in flight, twice that, of which half is usable: 4 MB
+        self.assertEqual(self.sample(1 * M), [("sndbuf", 64 * K, 4 * M)])
+        # at once, and up to max_sndbuf
+        self.assertEqual(self.sample(100 * M), [("sndbuf", 4 * M, 16 * M)])
+
+    def test_rates(self):
+        # 100 ms at most; 10 MB sent and 1 MB received in the last second
+        self.sk.table = status_table((1, P1, 20, ACTIVE, 64 * K), (2, P2, 100, ACTIVE, 128 * K))
+        changed = []
+        self.tuner.on_change = lambda *args: changed.append(args)
+        changes = self.sample(sent=10 * M, received=1 * M)
+        e = self.tuner.estimates
+        self.assertEqual((e["window"], e["srtt"]), (192 * K, 0.1))
+        self.assertEqual((e["send_rate"], e["recv_rate"]), (10 * M, 1 * M))
+        # the rate beats the window for the send buffer
+        self.assertEqual((e["send_bdp"], e["recv_bdp"]), (1 * M, 0.1 * M))
+        self.assertEqual(changes, [("sndbuf", 64 * K, 4 * M), ("rcvbuf", 64 * K, int(0.4 * M))])
+        self.assertEqual(changed, changes)
+
+    def test_hysteresis(self):
+        self.sample(1 * M)
+        # a 4.8 MB target is less than 25% larger
+        self.assertEqual(self.sample(1.2 * M), [])
+        # a 3.2 MB target less than 25% smaller, however long it lasts
+        for i in range(10):
+            self.assertEqual(self.sample(0.8 * M), [])
+        self.assertEqual(self.sk.sndbuf, 4 * M)
+
+    def test_saturation(self):
+        self.sk.sndbuf = self.sk.rcvbuf = 1 * M
+        # the rate fills 75% of the usable half: the buffer may be what holds
+        # it back, and is doubled rather than sized to the 1.5 MB it asks for
+        self.assertEqual(self.sample(64 * K, sent=3840 * K, received=3840 * K),
+                         [("sndbuf", 1 * M, 2 * M), ("rcvbuf", 1 * M, 2 * M)])
+        # without traffic, the small window-based target shrinks it later only
+        self.assertEqual(self.sample(64 * K), [])
+
+    def test_shrink(self):
+        self.sample(1 * M)
+        for i in range(4):
+            self.assertEqual(self.sample(64 * K), [])
+        self.assertEqual(self.sample(64 * K), [("sndbuf", 4 * M, 256 * K)])
+
+    def test_shrink_interrupted(self):
+        self.sample(1 * M)
+        for i in range(4):
+            self.sample(64 * K)
+        # a target within the hysteresis starts the count over
+        self.assertEqual(self.sample(1 * M), [])
+        for i in range(4):
+            self.assertEqual(self.sample(64 * K), [])
+        self.assertEqual(self.sample(64 * K), [("sndbuf", 4 * M, 256 * K)])
+
+    def test_bounds(self):
+        # below the minimum: grown to it at once, whatever the hysteresis
+        self.sk.sndbuf = self.sk.rcvbuf = 60 * K
+        self.assertEqual(self.sample(0), [("sndbuf", 60 * K, 64 * K), ("rcvbuf", 60 * K, 64 * K)])
+        # above the maximum: shrunk to it at once
+        self.sk.sndbuf = 32 * M
+        self.assertEqual(self.sample(100 * M), [("sndbuf", 32 * M, 16 * M)])
+
+    def test_clamped(self):
+        self.sk.sndbuf = self.sk.buffer_limit = 256 * K
+        # the kernel leaves the buffer as it is: no change to report
+        self.assertEqual(self.sample(1 * M), [])
+        self.assertEqual(self.sk.sndbuf, 256 * K)
+
+    def test_counters_reset(self):
+        self.sample(64 * K, sent=10 * M, received=10 * M)
+        # the statistics were reset: no rate, only the window
+        self.sk.stats = latency_stats(1 * M, 1 * M)
+        self.clock.advance(1)
+        self.tuner.sample()
+        e = self.tuner.estimates
+        self.assertEqual((e["send_rate"], e["recv_rate"], e["send_bdp"]), (0.0, 0.0, 64 * K))
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,186 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Tests of the Diameter message index (_diameter) against messages laid out
+as in RFC 6733 and RFC 4006. No SCTP stack is needed:
+
+python test_diameter.py
+"""
+
+import struct
+import binascii
+import unittest
+
+import _diameter as dia
+
+VENDOR_3GPP = 10415
+AVP_SERVICE_INFORMATION = 873
+
+
+def vector(s):
+    return binascii.unhexlify(s.replace(" ", ""))
+
+
+def avp(code, data, flags=0x40, vendor=None):
+    if isinstance(data, int):
+        data = struct.pack("!I", data)
+    head = 8
+    if vendor is not None:
+        flags |= dia.AVP_FLAG_VENDOR
+        head = 12
+    out = struct.pack("!IB", code, flags) + struct.pack("!I", head + len(data))[1:]
+    if vendor is not None:
+        out += struct.pack("!I", vendor)
+    return out + data + b"\0" * (-len(data) % 4)
+
+
+def message(flags, code, app, hbh, e2e, avps):
+    body = b"".join(avps)
+    return (struct.pack("!I", 0x01000000 | (20 + len(body))) +
+            struct.pack("!I", (flags << 24) | code) + struct.pack("!III", app, hbh, e2e) + body)
+
+# RFC 6733 5.5.1 Device-Watchdog-Request: Origin-Host "a", Origin-Realm "b"
+DWR = vector("01 00002c 80 000118 00000000 00000011 00000022"
+             "00000108 40 000009 61 000000  00000128 40 000009 62 000000")
+
+CER = message(0x80, dia.CMD_CAPABILITIES_EXCHANGE, 0, 0x1234, 0x5678, [
+    avp(dia.AVP_ORIGIN_HOST, b"pcef1.epc.mnc001.mcc001.3gppnetwork.org"),
+    avp(dia.AVP_ORIGIN_REALM, b"epc.mnc001.mcc001.3gppnetwork.org"),
+    avp(dia.AVP_HOST_IP_ADDRESS, vector("0001 0a000001")),
+    avp(dia.AVP_VENDOR_ID, 0),
+    avp(dia.AVP_PRODUCT_NAME, b"pysctp", flags=0),
+    avp(dia.AVP_ORIGIN_STATE_ID, 1),
+    avp(dia.AVP_SUPPORTED_VENDOR_ID, VENDOR_3GPP),
+    avp(dia.AVP_AUTH_APPLICATION_ID, 4),
+    avp(dia.AVP_VENDOR_SPECIFIC_APPLICATION_ID,
+        avp(dia.AVP_VENDOR_ID, VENDOR_3GPP) + avp(dia.AVP_AUTH_APPLICATION_ID, 16777238)),
+    avp(dia.AVP_FIRMWARE_REVISION, 1, flags=0),
+])
+
+CCR = message(0xc0, dia.CMD_CREDIT_CONTROL, 4, 0xdeadbeef, 0xcafe0001, [
+    avp(dia.AVP_SESSION_ID, b"pcef1.epc;1;2;3"),
+    avp(dia.AVP_ORIGIN_HOST, b"pcef1.epc"),
+    avp(dia.AVP_ORIGIN_REALM, b"epc"),
+    avp(dia.AVP_DESTINATION_REALM, b"ocs"),
+    avp(dia.AVP_AUTH_APPLICATION_ID, 4),
+    avp(dia.AVP_SERVICE_CONTEXT_ID, b"32251@3gpp.org"),
+    avp(dia.AVP_CC_REQUEST_TYPE, 1),
+    avp(dia.AVP_CC_REQUEST_NUMBER, 0),
+    avp(dia.AVP_EVENT_TIMESTAMP, vector("e3b0c442")),
+    avp(dia.AVP_SUBSCRIPTION_ID, avp(dia.AVP_SUBSCRIPTION_ID_TYPE, 0) +
+        avp(dia.AVP_SUBSCRIPTION_ID_DATA, b"33612345678")),
+    avp(dia.AVP_SUBSCRIPTION_ID, avp(dia.AVP_SUBSCRIPTION_ID_TYPE, 1) +
+        avp(dia.AVP_SUBSCRIPTION_ID_DATA, b"208011234567890")),
+    avp(dia.AVP_MULTIPLE_SERVICES_CREDIT_CONTROL, avp(437, avp(421, struct.pack("!Q", 1 << 33)))),
+    avp(AVP_SERVICE_INFORMATION, avp(874, b"ps", vendor=VENDOR_3GPP), flags=0xc0, vendor=VENDOR_3GPP),
+])
+
+
+class ParseTest(unittest.TestCase):
+
+    def test_header(self):
+        m = dia.diameter_parse(DWR)
+        self.assertEqual((m.version, m.flags, m.command_code, m.application_id, m.length),
+                         (1, dia.FLAG_REQUEST, dia.CMD_DEVICE_WATCHDOG, 0, len(DWR)))
+        self.assertEqual((m.hop_by_hop, m.end_to_end), (0x11, 0x22))
+        self.assertEqual(m.ids(), (0x11, 0x22))
+        self.assertTrue(m.is_request)
+        # (code, flags, vendor_id, data offset, data length)
+        self.assertEqual(list(m), [(dia.AVP_ORIGIN_HOST, 0x40, 0, 28, 1),
+                                   (dia.AVP_ORIGIN_REALM, 0x40, 0, 40, 1)])
+        self.assertEqual(bytes(m.get(dia.AVP_ORIGIN_REALM)), b"b")
+
+    def test_cer(self):
+        m = dia.diameter_parse(CER)
+        self.assertEqual(len(m), 10)
+        self.assertEqual(m.ids(), (0x1234, 0x5678))
+        self.assertEqual(bytes(m.get(dia.AVP_ORIGIN_HOST)), b"pcef1.epc.mnc001.mcc001.3gppnetwork.org")
+        self.assertEqual(m.get_u32(dia.AVP_SUPPORTED_VENDOR_ID), VENDOR_3GPP)
+        self.assertEqual(m[m.find(dia.AVP_PRODUCT_NAME)][1], 0)
+        g = m.group(m.find(dia.AVP_VENDOR_SPECIFIC_APPLICATION_ID))
+        self.assertEqual([a[0] for a in g], [dia.AVP_VENDOR_ID, dia.AVP_AUTH_APPLICATION_ID])
+        self.assertEqual(g.get_u32(dia.AVP_AUTH_APPLICATION_ID), 16777238)
+        self.assertEqual(g.ids(), m.ids())
+
+    def test_ccr(self):
+        m = dia.diameter_parse(CCR)
+        self.assertEqual((m.command_code, m.application_id, m.flags),
+                         (dia.CMD_CREDIT_CONTROL, 4, dia.FLAG_REQUEST | dia.FLAG_PROXIABLE))
+        self.assertEqual(m.get_u32(dia.AVP_CC_REQUEST_TYPE), 1)
+        self.assertEqual(m.find_all(dia.AVP_SUBSCRIPTION_ID), [9, 10])
+        sub = m.group(10)
+        self.assertEqual(bytes(sub.get(dia.AVP_SUBSCRIPTION_ID_DATA)), b"208011234567890")
+        mscc = m.group(m.find(dia.AVP_MULTIPLE_SERVICES_CREDIT_CONTROL))
+        self.assertEqual(mscc.group(0).get_u64(421), 1 << 33)
+        # vendor-specific AVPs are only found with their vendor id
+        self.assertEqual(m.find(AVP_SERVICE_INFORMATION), -1)
+        i = m.find(AVP_SERVICE_INFORMATION, VENDOR_3GPP)
+        self.assertEqual(m[i][:3], (AVP_SERVICE_INFORMATION, 0xc0, VENDOR_3GPP))
+        si = m.group(i)
+        self.assertEqual(bytes(si.get(874, None, VENDOR_3GPP)), b"ps")
+
+    def test_lookup(self):
+        m = dia.diameter_parse(DWR)
+        self.assertEqual(m.find(dia.AVP_RESULT_CODE), -1)
+        self.assertEqual(m.find_all(dia.AVP_RESULT_CODE), [])
+        self.assertEqual(m.get(dia.AVP_RESULT_CODE), None)
+        self.assertEqual(m.get_u32(dia.AVP_RESULT_CODE, 2001), 2001)
+        self.assertRaises(ValueError, m.get_u32, dia.AVP_ORIGIN_HOST)
+        self.assertRaises(IndexError, lambda: m[2])
+        self.assertRaises(IndexError, m.group, 2)
+
+    def test_zero_copy(self):
+        buf = bytearray(b"\xff" * 4 + DWR)
+        m = dia.diameter_parse(buf, 4)
+        self.assertEqual(m.offset, 4)
+        self.assertTrue(m.buffer is buf)
+        host = m.get(dia.AVP_ORIGIN_HOST)
+        buf[4 + 28] = ord("z")
+        self.assertEqual(bytes(host), b"z")
+        # the buffer cannot be resized under the index
+        self.assertRaises(BufferError, buf.extend, b"x")
+        del m, host
+        buf.extend(b"x")
+
+    def test_avps(self):
+        g = avp(dia.AVP_VENDOR_ID, 1) + avp(dia.AVP_RESULT_CODE, 2001)
+        m = dia.diameter_avps(g)
+        self.assertEqual(m.get_u32(dia.AVP_RESULT_CODE), 2001)
+        m = dia.diameter_avps(b"\0" * 3 + g, 3, len(g) - 12)
+        self.assertEqual([a[0] for a in m], [dia.AVP_VENDOR_ID])
+        self.assertRaises(ValueError, dia.diameter_avps, g, 0, len(g) + 1)
+
+    def test_malformed(self):
+        bad = [
+            DWR[:19],                                   # shorter than the header
+            b"\x02" + DWR[1:],                          # version 2
+            DWR[:1] + vector("000013") + DWR[4:],       # length below the header
+            DWR[:1] + vector("000030") + DWR[4:],       # length beyond the buffer
+            DWR[:25] + vector("000007") + DWR[28:],     # AVP length below its header
+            DWR[:25] + vector("000011") + DWR[28:],     # AVP beyond the message
+            DWR[:24] + b"\xc0" + DWR[25:],              # V flag without room for the vendor id
+            DWR[:1] + vector("000018") + DWR[4:24],     # truncated AVP header
+        ]
+        for msg in bad:
+            self.assertRaises(ValueError, dia.diameter_parse, msg)
+        self.assertRaises(ValueError, dia.diameter_parse, DWR, 12)
+        self.assertRaises(ValueError, dia.diameter_parse, DWR, -1)
+        self.assertEqual(dia.diameter_parse(DWR + b"\0" * 8).length, len(DWR))
+
+if __name__ == '__main__':
+    unittest.main()
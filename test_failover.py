@@ -0,0 +1,223 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Measures the path failover time of a multihomed association, with and
+without sctp.failover_profile.fast(). Needs root and iproute2 (ip, tc):
+
+sudo python test_failover.py [--profiles fast,rfc4960] [--max-gap 2.0]
+
+Two network namespaces are linked by two veth pairs (10.1.0.0/24 and
+10.2.0.0/24). A client in one namespace echoes small messages every 10 ms
+with a server in the other one, the primary path (10.1) is broken with
+netem (100% loss, both ways, so no local error shortcuts detection), and
+the longest gap between two echoes is reported as the failover time.
+The "fast" profile must fail over within --max-gap seconds. The rfc4960
+profile, if requested, only reports; expect about a minute.
+"""
+
+import os
+import sys
+import time
+import select
+import socket
+import argparse
+import subprocess
+
+import sctp
+
+NS_CLI = "pysctp_fo_cli"
+NS_SRV = "pysctp_fo_srv"
+PATHS = (("10.1.0.1", "10.1.0.2"), ("10.2.0.1", "10.2.0.2"))
+PORT = 10010
+PROBE = 0.010
+
+
+def profile(name):
+    return getattr(sctp.failover_profile, name)()
+
+
+def sh(*cmd):
+    subprocess.check_call(cmd)
+
+
+def netns(ns, *cmd):
+    sh("ip", "netns", "exec", ns, *cmd)
+
+
+def setup():
+    teardown()
+    sh("ip", "netns", "add", NS_CLI)
+    sh("ip", "netns", "add", NS_SRV)
+    for ns in (NS_CLI, NS_SRV):
+        netns(ns, "ip", "link", "set", "lo", "up")
+    for x, (cli, srv) in enumerate(PATHS):
+        a = "fo%dc" % x
+        b = "fo%ds" % x
+        sh("ip", "link", "add", a, "netns", NS_CLI, "type", "veth", "peer", "name", b, "netns", NS_SRV)
+        netns(NS_CLI, "ip", "addr", "add", cli + "/24", "dev", a)
+        netns(NS_SRV, "ip", "addr", "add", srv + "/24", "dev", b)
+        netns(NS_CLI, "ip", "link", "set", a, "up")
+        netns(NS_SRV, "ip", "link", "set", b, "up")
+
+
+def teardown():
+    for ns in (NS_CLI, NS_SRV):
+        subprocess.call(["ip", "netns", "del", ns], stderr=open(os.devnull, "w"))
+
+
+def set_loss(loss):
+    action = loss and "add" or "del"
+    for ns, dev in ((NS_CLI, "fo0c"), (NS_SRV, "fo0s")):
+        cmd = ["tc", "qdisc", action, "dev", dev, "root"]
+        if loss:
+            cmd += ["netem", "loss", "100%"]
+        netns(ns, *cmd)
+
+
+def run_server(name):
+    srv = sctp.sctpsocket_tcp(socket.AF_INET)
+    srv.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    # endpoint defaults, inherited by the accepted association
+    srv.apply_failover_profile(profile(name))
+    srv.bindx([(s, PORT) for c, s in PATHS])
+    srv.listen(1)
+    sys.stdout.write("listening\n")
+    sys.stdout.flush()
+
+    conn, addr = srv.accept()
+    for addr, port in conn.getpaddrs():
+        if addr == PATHS[0][0]:
+            conn.set_primary(0, (addr, port))
+    while True:
+        fromaddr, flags, msg, notif = conn.sctp_recv(256)
+        if flags & sctp.FLAG_NOTIFICATION:
+            continue
+        if not msg:
+            break
+        conn.sctp_send(msg)
+    conn.close()
+    srv.close()
+
+
+def run_client(name, duration):
+    cli = sctp.sctpsocket_tcp(socket.AF_INET)
+    cli.apply_failover_profile(profile(name))
+    cli.events.clear()
+    cli.events.data_io = 1
+    cli.connectx([(s, PORT) for c, s in PATHS])
+    cli.set_primary(0, (PATHS[0][1], PORT))
+    sys.stdout.write("up\n")
+    sys.stdout.flush()
+
+    seq = 0
+    last = time.time()
+    gap = 0.0
+    end = last + duration
+    due = last
+    while True:
+        now = time.time()
+        if now >= end:
+            break
+        w = now >= due and [cli] or []
+        r, w, x = select.select([cli], w, [], max(0.0, min(due, end) - now))
+        if w:
+            cli.sctp_send(("%d" % seq).encode())
+            seq += 1
+            due += PROBE
+        if r:
+            fromaddr, flags, msg, notif = cli.sctp_recv(256)
+            if flags & sctp.FLAG_NOTIFICATION:
+                continue
+            now = time.time()
+            gap = max(gap, now - last)
+            last = now
+    # echoes that never resumed after the break count up to the end
+    gap = max(gap, end - last)
+    cli.close()
+    sys.stdout.write("gap %.3f\n" % gap)
+    sys.stdout.flush()
+
+
+def measure(name, break_after, duration):
+    me = os.path.abspath(__file__)
+    srv = subprocess.Popen(["ip", "netns", "exec", NS_SRV, sys.executable, me, "server", name],
+                           stdout=subprocess.PIPE, universal_newlines=True)
+    try:
+        srv.stdout.readline()
+        cli = subprocess.Popen(["ip", "netns", "exec", NS_CLI, sys.executable, me,
+                                "client", name, str(duration)],
+                               stdout=subprocess.PIPE, universal_newlines=True)
+        try:
+            if cli.stdout.readline().strip() != "up":
+                raise Exception("client failed to connect")
+            time.sleep(break_after)
+            set_loss(True)
+            try:
+                line = cli.stdout.readline().split()
+            finally:
+                set_loss(False)
+            if cli.wait() != 0 or not line or line[0] != "gap":
+                raise Exception("client failed")
+            return float(line[1])
+        finally:
+            if cli.poll() is None:
+                cli.kill()
+    finally:
+        # the server leaves once the client closed; not if the client failed
+        for i in range(50):
+            if srv.poll() is not None:
+                break
+            time.sleep(0.1)
+        else:
+            srv.kill()
+            srv.wait()
+
+
+def main():
+    if len(sys.argv) > 1 and sys.argv[1] == "server":
+        return run_server(sys.argv[2])
+    if len(sys.argv) > 1 and sys.argv[1] == "client":
+        return run_client(sys.argv[2], float(sys.argv[3]))
+
+    p = argparse.ArgumentParser(description="measure SCTP path failover time in network namespaces")
+    p.add_argument("--profiles", default="fast", help="comma-separated failover_profile constructors")
+    p.add_argument("--max-gap", type=float, default=2.0, help="seconds, for the fast profile")
+    p.add_argument("--break-after", type=float, default=1.0)
+    p.add_argument("--duration", type=float, default=0.0,
+                   help="seconds of traffic; default break-after plus 10s (90s for rfc4960)")
+    args = p.parse_args()
+
+    if os.geteuid() != 0:
+        print("test_failover.py needs root (network namespaces)")
+        return 1
+
+    failed = 0
+    setup()
+    try:
+        for name in args.profiles.split(","):
+            duration = args.duration or args.break_after + (name == "rfc4960" and 90 or 10)
+            gap = measure(name, args.break_after, duration)
+            ok = name != "fast" or gap <= args.max_gap
+            failed += not ok
+            print("%-8s failover %.3f s%s" % (name, gap, not ok and "  FAILED" or ""))
+    finally:
+        teardown()
+    return failed and 1 or 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,192 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Hands off loopback associations to worker processes (sctp_handoff) and
+measures the handoff rate and the echo throughput through the workers.
+Needs SCTP support in the kernel:
+
+python test_handoff.py [--assocs 64] [--workers 4] [--messages 2000]
+
+Associations come both from a TCP-style listener (accept_many) and from a
+UDP-style socket (peeloff). The workers check the metadata they receive
+against what the clients negotiated, and echo every message.
+"""
+
+import os
+import sys
+import time
+import select
+import socket
+import argparse
+
+import sctp
+import sctp_handoff
+
+STREAMS = 5
+
+
+def worker(chan):
+    poll = select.poll()
+    poll.register(chan.fileno(), select.POLLIN)
+    socks = {}
+    while True:
+        for fd, ev in poll.poll():
+            if fd == chan.fileno():
+                sk, info = sctp_handoff.recv_socket(chan)
+                if sk is None:
+                    return 0
+                # the client asked for STREAMS streams both ways
+                if (info.instrms, info.outstrms) != (STREAMS, STREAMS) or not len(info.paddrs):
+                    return 1
+                if sk._ttl != 1000 or sk.events.data_io != True or info.extra["n"] < 0:
+                    return 1
+                sk.setblocking(False)
+                socks[sk.fileno()] = sk
+                poll.register(sk.fileno(), select.POLLIN)
+                continue
+            sk = socks[fd]
+            fromaddr, flags, msg, notif = sk.sctp_recv(2048)
+            if flags & sctp.FLAG_NOTIFICATION:
+                continue
+            if not msg:
+                poll.unregister(fd)
+                del socks[fd]
+                sk.close()
+                continue
+            sk.sctp_send(msg, stream=notif.stream)
+
+
+def connect_clients(addr, n):
+    clients = []
+    for i in range(n):
+        cli = sctp.sctpsocket_tcp(socket.AF_INET)
+        cli.initparams.num_ostreams = STREAMS
+        cli.initparams.max_instreams = STREAMS
+        cli.connect(addr)
+        clients.append(cli)
+    return clients
+
+
+def main(argv=None):
+    p = argparse.ArgumentParser(description="association handoff throughput")
+    p.add_argument("--assocs", type=int, default=64, help="associations of each style")
+    p.add_argument("--workers", type=int, default=4)
+    p.add_argument("--messages", type=int, default=2000, help="echoes per association")
+    args = p.parse_args(argv)
+
+    chans, pids = [], []
+    for i in range(args.workers):
+        chan, worker_chan = sctp_handoff.channel()
+        pid = os.fork()
+        if pid == 0:
+            chan.close()
+            for c in chans:
+                c.close()
+            os._exit(worker(worker_chan))
+        worker_chan.close()
+        chans.append(chan)
+        pids.append(pid)
+
+    tcp = sctp.sctpsocket_tcp(socket.AF_INET)
+    tcp.bind(("127.0.0.1", 0))
+    tcp.initparams.num_ostreams = STREAMS
+    tcp.initparams.max_instreams = STREAMS
+    tcp.listen(args.assocs)
+    udp = sctp.sctpsocket_udp(socket.AF_INET)
+    udp.bind(("127.0.0.1", 0))
+    udp.initparams.num_ostreams = STREAMS
+    udp.initparams.max_instreams = STREAMS
+    udp.events.clear()
+    udp.events.association = True
+    udp.listen(args.assocs)
+
+    clients = connect_clients(tcp.getsockname(), args.assocs)
+    clients += connect_clients(udp.getsockname(), args.assocs)
+
+    accepted = []
+    while len(accepted) < args.assocs:
+        accepted += tcp.accept_many()
+    assoc_ids = []
+    while len(assoc_ids) < args.assocs:
+        fromaddr, flags, msg, notif = udp.sctp_recv(2048)
+        if isinstance(notif, sctp.assoc_change) and notif.state == sctp.assoc_change.state_COMM_UP:
+            assoc_ids.append(notif.assoc_id)
+
+    t0 = time.time()
+    n = 0
+    for sk, fromaddr in accepted:
+        sk.set_ttl(1000)
+        sctp_handoff.send_socket(chans[n % len(chans)], sk, extra={"n": n})
+        n += 1
+    udp.set_ttl(1000)
+    for assoc_id in assoc_ids:
+        sctp_handoff.send_assoc(chans[n % len(chans)], udp, assoc_id, extra={"n": n})
+        n += 1
+    handoff = time.time() - t0
+    print("%d handoffs in %.3f s: %.0f/s" % (n, handoff, n / handoff))
+
+    # every client keeps one message in flight
+    poll = select.poll()
+    byfd = {}
+    left = {}
+    for cli in clients:
+        byfd[cli.fileno()] = cli
+        left[cli.fileno()] = args.messages
+        poll.register(cli.fileno(), select.POLLIN)
+    msg = b"x" * 100
+    t0 = time.time()
+    for i, cli in enumerate(clients):
+        cli.sctp_send(msg, stream=i % STREAMS)
+    pending = len(clients)
+    while pending:
+        events = poll.poll(5000)
+        if not events:
+            raise Exception("echoes timed out")
+        for fd, ev in events:
+            cli = byfd[fd]
+            fromaddr, flags, data, notif = cli.sctp_recv(2048)
+            if flags & sctp.FLAG_NOTIFICATION:
+                continue
+            if data != msg:
+                raise Exception("bad echo %r" % data)
+            left[fd] -= 1
+            if left[fd]:
+                cli.sctp_send(msg, stream=notif.stream)
+            else:
+                poll.unregister(fd)
+                pending -= 1
+    elapsed = time.time() - t0
+    total = len(clients) * args.messages
+    print("%d echoes over %d associations, %d workers in %.3f s: %.0f msgs/s" %
+          (total, len(clients), args.workers, elapsed, total / elapsed))
+
+    for cli in clients:
+        cli.close()
+    for c in chans:
+        c.close()
+    failed = 0
+    for pid in pids:
+        failed += os.waitpid(pid, 0)[1] != 0
+    tcp.close()
+    udp.close()
+    if failed:
+        raise Exception("%d workers got wrong handoff metadata" % failed)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
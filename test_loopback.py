@@ -24,11 +24,18 @@
 # You should have received a copy of the GNU Lesser General Public License
 # along with this library; If not, see <http://www.gnu.org/licenses/>.
 
+import os
 import sys
+import errno
 import time
+import select
 import socket
+import shutil
+import tempfile
+import threading
 import _sctp
 import sctp
+import sctp_replay
 
 
 addr_client = ("127.0.0.1", 10002)
@@ -69,13 +76,265 @@ def test_cli():
     print("server sctp_recv, flag %d" % flags)
     print("server sctp_recv, buf: %s" % msgret)
     print("")
+    # str is sent UTF-8 encoded, as it always was
+    text = u"caf\u00e9"
+    if cli.sctp_send(text) != len(text.encode("utf-8")):
+        raise(Exception("sctp_send() of a str failed"))
+    flags = sctp.FLAG_NOTIFICATION
+    while flags & sctp.FLAG_NOTIFICATION:
+        fromaddr, flags, msgret, notif = srv_to_cli.sctp_recv(2048)
+    if msgret != text.encode("utf-8"):
+        raise(Exception("str sent as %r" % msgret))
 	#
     cli.close()
+    # the descriptor is forgotten, so it cannot hit a socket that reuses it
+    if cli.fileno() != -1:
+        raise(Exception("sctpsocket.close() failed to invalidate the descriptor"))
     time.sleep(0.01)
     srv.close()
     #
     return 0
 
+def test_sendfile():
+    srv = init_server()
+    cli = sctp.sctpsocket_tcp(socket.AF_INET)
+    cli.connect(addr_server)
+    srv_to_cli, _addr_client = srv.accept()
+    #
+    data = os.urandom(300000)
+    f = tempfile.TemporaryFile()
+    f.write(data)
+    f.seek(0)
+    frag = cli.get_status().fragmentation_point
+    sent = cli.sctp_sendfile(f, chunk_size=4 * frag)
+    if sent != len(data) or f.tell() != len(data):
+        raise(Exception("sctp_sendfile() sent %d bytes" % sent))
+    #
+    received = []
+    while sum(map(len, received)) < len(data):
+        fromaddr, flags, msg, notif = srv_to_cli.sctp_recv(65536)
+        if not flags & sctp.FLAG_NOTIFICATION:
+            received.append(msg)
+    # one message per chunk
+    if b"".join(received) != data or len(received[0]) != 4 * frag:
+        raise(Exception("sctp_sendfile() chunks do not match the file"))
+    print("sctp_sendfile: %d bytes in %d messages" % (len(data), len(received)))
+    #
+    cli.close()
+    srv_to_cli.close()
+    srv.close()
+    return 0
+
+def test_partial_delivery():
+    srv = init_server()
+    # inherited by the accepted socket
+    srv.partial_delivery_point = 8192
+    srv.fragment_interleave = 1
+    # the receive window cannot hold the message: unless fragments are
+    # handed over before the peer has sent all of it, it never completes
+    srv.set_rcvbuf(32768)
+    cli = sctp.sctpsocket_tcp(socket.AF_INET)
+    cli.connect(addr_server)
+    srv_to_cli, _addr_client = srv.accept()
+    if srv_to_cli.partial_delivery_point != 8192:
+        raise(Exception("partial_delivery_point not set"))
+    #
+    data = os.urandom(4 * srv_to_cli.get_rcvbuf())
+    # may block until the receiver makes room
+    sender = threading.Thread(target=cli.sctp_send, args=(data,), kwargs={"stream": 1})
+    sender.start()
+    subscribed = srv_to_cli.events.partial_delivery
+    fragments = []
+    for assoc_id, stream, fragment, eor in srv_to_cli.sctp_recv_stream(16384):
+        if fragment is None:
+            raise(Exception("partial delivery aborted on stream %d" % stream))
+        if stream != 1 or len(fragment) > 16384:
+            raise(Exception("bad fragment on stream %d, %d bytes" % (stream, len(fragment))))
+        fragments.append(fragment)
+        if eor:
+            break
+    sender.join()
+    if len(fragments) < 2:
+        raise(Exception("message delivered whole, in one fragment"))
+    if b"".join(fragments) != data:
+        raise(Exception("fragments do not make up the message"))
+    if srv_to_cli.events.partial_delivery != subscribed:
+        raise(Exception("sctp_recv_stream did not restore the subscriptions"))
+    print("sctp_recv_stream: %d bytes in %d fragments, %d bytes receive buffer" %
+          (len(data), len(fragments), srv_to_cli.get_rcvbuf()))
+    #
+    cli.close()
+    srv_to_cli.close()
+    srv.close()
+    return 0
+
+def test_reconfig():
+    srv = init_server()
+    srv.reconfig_supported = True
+    cli = sctp.sctpsocket_tcp(socket.AF_INET)
+    cli.reconfig_supported = True
+    cli.set_enable_stream_reset(sctp.ENABLE_RESET_STREAM_REQ)
+    cli.events.stream_reset = True
+    # a dictionary without the RFC 6525 keys leaves their subscriptions alone
+    old_keys = dict((k, v) for k, v in _sctp.get_events(cli.fileno()).items()
+                    if k not in ("_stream_reset", "_assoc_reset", "_stream_change"))
+    _sctp.set_events(cli.fileno(), old_keys)
+    if not _sctp.get_events(cli.fileno())["_stream_reset"]:
+        raise(Exception("set_events() cancelled the stream_reset subscription"))
+    #
+    cli.connect(addr_server)
+    srv_to_cli, _addr_client = srv.accept()
+    cli.reset_streams(streams=[0])
+    while True:
+        fromaddr, flags, msg, notif = cli.sctp_recv(2048)
+        if isinstance(notif, sctp.stream_reset_event):
+            break
+    if notif.flags & (sctp.stream_reset_event.flags_DENIED | sctp.stream_reset_event.flags_FAILED):
+        raise(Exception("stream reset refused, flags 0x%x" % notif.flags))
+    print("stream_reset_event: streams %s, flags 0x%x" % (notif.stream_list, notif.flags))
+    #
+    cli.close()
+    srv_to_cli.close()
+    srv.close()
+    return 0
+
+def test_pcap():
+    srv = init_server()
+    cli = sctp.sctpsocket_tcp(socket.AF_INET)
+    cli.connect(addr_server)
+    srv_to_cli, _addr_client = srv.accept()
+    tmpdir = tempfile.mkdtemp()
+    writer = sctp.pcap_writer(os.path.join(tmpdir, "test"))
+    cli.datalogging = writer
+    srv_to_cli.datalogging = writer
+    #
+    # the large message is split into several DATA chunks when recorded, and
+    # received in pieces, each recorded without EOR until the last one
+    msgs = [b"first", os.urandom(100000), b"last"]
+    for i, msg in enumerate(msgs):
+        cli.sctp_send(msg, ppid=i + 1, stream=1)
+    received = []
+    pieces = 0
+    while len(received) < len(msgs):
+        fromaddr, flags, msg, notif = srv_to_cli.sctp_recv(16384)
+        if flags & sctp.FLAG_NOTIFICATION:
+            continue
+        pieces += 1
+        if received and not received[-1][1]:
+            received[-1][0].append(msg)
+        else:
+            received.append([[msg], False])
+        received[-1][1] = bool(flags & sctp.FLAG_EOR)
+    writer.close()
+    #
+    capture = writer.stats()["filename"]
+    sent = sctp_replay.read_capture(capture, outbound=True)
+    recvd = sctp_replay.read_capture(capture, outbound=False)
+    if [m.data for m in sent] != msgs or [m.ppid for m in sent] != [1, 2, 3]:
+        raise(Exception("recorded messages sent do not match"))
+    if [m.data for m in recvd] != msgs or set([m.stream for m in recvd]) != set([1]):
+        raise(Exception("recorded messages received do not match"))
+    if pieces <= len(msgs):
+        raise(Exception("the large message was not received in pieces"))
+    print("pcap_writer: %d messages each way, %d pieces received" % (len(msgs), pieces))
+    #
+    cli.close()
+    srv_to_cli.close()
+    srv.close()
+    shutil.rmtree(tmpdir)
+    return 0
+
+def test_special_assoc():
+    srv = sctp.sctpsocket_udp(socket.AF_INET)
+    srv.bind(addr_server)
+    srv.events.clear()
+    srv.events.association = True
+    srv.listen(5)
+    clients = []
+    ids = []
+    for i in range(2):
+        cli = sctp.sctpsocket_tcp(socket.AF_INET)
+        cli.connect(addr_server)
+        clients.append(cli)
+    while len(ids) < len(clients):
+        fromaddr, flags, msg, notif = srv.sctp_recv(2048)
+        if isinstance(notif, sctp.assoc_change) and notif.state == sctp.assoc_change.state_COMM_UP:
+            ids.append(notif.assoc_id)
+
+    def initial_rto():
+        return [srv.get_rtoinfo(i).initial for i in [sctp.FUTURE_ASSOC] + ids]
+
+    def set_initial_rto(assoc_id, value):
+        rto = srv.get_rtoinfo(ids[0])
+        rto.assoc_id = assoc_id
+        rto.initial = value
+        srv.set_rtoinfo(rto)
+
+    # a real id, which may well be 1 or 2 before Linux 5.1, names one association
+    defaults = initial_rto()[0]
+    set_initial_rto(ids[0], 1001)
+    if initial_rto()[:2] != [defaults, 1001] or 1001 in initial_rto()[2:]:
+        raise(Exception("assoc_id %d set other associations: %s" % (ids[0], initial_rto())))
+    set_initial_rto(sctp.CURRENT_ASSOC, 1002)
+    if initial_rto() != [defaults] + [1002] * len(ids):
+        raise(Exception("CURRENT_ASSOC: %s" % initial_rto()))
+    set_initial_rto(sctp.ALL_ASSOC, 1003)
+    if initial_rto() != [1003] * (len(ids) + 1):
+        raise(Exception("ALL_ASSOC: %s" % initial_rto()))
+    print("special assoc_ids: associations %s, CURRENT_ASSOC %d, ALL_ASSOC %d" %
+          (ids, sctp.CURRENT_ASSOC, sctp.ALL_ASSOC))
+    #
+    for cli in clients:
+        cli.close()
+    srv.close()
+    return 0
+
+def test_pr_policy():
+    srv = init_server()
+    srv.pr_supported = True
+    # a small window keeps most of the messages queued at the sender
+    srv.set_rcvbuf(32768)
+    cli = sctp.sctpsocket_tcp(socket.AF_INET)
+    cli.pr_supported = True
+    cli.connect(addr_server)
+    srv_to_cli, _addr_client = srv.accept()
+    #
+    msg = b"p" * 4096
+    cli.setblocking(False)
+    sent = 0
+    for i in range(64):
+        try:
+            cli.sctp_send(msg, stream=1, pr_policy=sctp.PR_SCTP_TTL, timetolive=10)
+        except (IOError, OSError) as e:
+            if e.errno not in (errno.EAGAIN, errno.EWOULDBLOCK):
+                raise
+            break
+        sent += 1
+    # let the queued messages expire, then open the window
+    time.sleep(0.2)
+    received = 0
+    while select.select([srv_to_cli.fileno()], [], [], 0.5)[0]:
+        fromaddr, flags, data, notif = srv_to_cli.sctp_recv(8192)
+        if not flags & sctp.FLAG_NOTIFICATION:
+            received += 1
+    #
+    stream = cli.get_prstatus(sid=1, policy=sctp.PR_SCTP_TTL)
+    assoc = cli.get_prstatus()
+    abandoned = stream.abandoned_unsent + stream.abandoned_sent
+    # a message abandoned after being sent may still have made it
+    if received + abandoned < sent or not abandoned:
+        raise(Exception("%d messages sent, %d received, %d abandoned" % (sent, received, abandoned)))
+    if assoc.abandoned_unsent + assoc.abandoned_sent != abandoned:
+        raise(Exception("association and stream 1 counters differ"))
+    print("PR_SCTP_TTL: %d messages sent, %d received, %d abandoned unsent, %d sent" %
+          (sent, received, stream.abandoned_unsent, stream.abandoned_sent))
+    #
+    cli.close()
+    srv_to_cli.close()
+    srv.close()
+    return 0
+
 if __name__ == '__main__':
-    sys.exit(test_cli())
+    sys.exit(test_cli() or test_sendfile() or test_partial_delivery() or test_reconfig() or
+             test_pcap() or test_special_assoc() or test_pr_policy())
 
@@ -0,0 +1,159 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+When sctp_pathmgr switches primaries: path_manager.sample() over scripted
+srtt/cwnd tables of a fakesctp socket, with the clock under control.
+
+python test_pathmgr.py
+"""
+
+import errno
+import unittest
+
+import sctp
+import sctp_pathmgr
+from fakesctp import fake_socket, status_table, clock
+
+ACTIVE = sctp.paddrinfo.state_ACTIVE
+INACTIVE = sctp.paddrinfo.state_INACTIVE
+
+P1 = ("10.0.0.1", 5000)
+P2 = ("10.0.1.1", 5000)
+P3 = ("10.0.2.1", 5000)
+
+
+class SampleTest(unittest.TestCase):
+
+    def setUp(self):
+        self.clock = clock()
+        self.addCleanup(self.clock.install(sctp_pathmgr))
+        self.sk = fake_socket()
+        self.pm = sctp_pathmgr.path_manager(self.sk, sctp_pathmgr.path_policy(
+            ratio=0.5, min_delta=5, samples=3, hold_down=30.0, min_cwnd=1000))
+
+    def sample(self, *paths):
+        # one sample a second
+        if paths:
+            self.sk.table = status_table(*paths)
+        self.clock.advance(1)
+        return self.pm.sample()
+
+    def test_subscriptions(self):
+        self.assertTrue(self.sk.events.address and self.sk.events.association)
+
+    def test_switch_after_samples(self):
+        paths = ((1, P1, 100, ACTIVE, 4380), (1, P2, 40, ACTIVE, 4380))
+        self.assertEqual(self.sample(*paths), [])
+        self.assertEqual(self.sample(), [])
+        self.assertEqual(self.sample(), [(1, P1, P2)])
+        self.assertEqual(self.sk.primaries, [(1, P2)])
+        # the new primary is the fastest: nothing more to do
+        for i in range(5):
+            self.assertEqual(self.sample(), [])
+
+    def test_not_fast_enough(self):
+        # above ratio * primary srtt
+        for i in range(5):
+            self.assertEqual(self.sample((1, P1, 100, ACTIVE, 4380), (1, P2, 60, ACTIVE, 4380)), [])
+        # within min_delta of the primary
+        for i in range(5):
+            self.assertEqual(self.sample((1, P1, 8, ACTIVE, 4380), (1, P2, 4, ACTIVE, 4380)), [])
+
+    def test_streak_reset(self):
+        fast = ((1, P1, 100, ACTIVE, 4380), (1, P2, 40, ACTIVE, 4380))
+        slow = ((1, P1, 100, ACTIVE, 4380), (1, P2, 90, ACTIVE, 4380))
+        self.sample(*fast)
+        self.sample(*fast)
+        self.assertEqual(self.sample(*slow), [])
+        self.assertEqual(self.sample(*fast), [])
+        self.assertEqual(self.sample(*fast), [])
+        self.assertEqual(self.sample(*fast), [(1, P1, P2)])
+
+    def test_candidate_change(self):
+        # the fastest path is the candidate, and a new candidate starts over
+        self.sample((1, P1, 100, ACTIVE, 4380), (1, P2, 40, ACTIVE, 4380), (1, P3, 45, ACTIVE, 4380))
+        self.sample()
+        p3_faster = ((1, P1, 100, ACTIVE, 4380), (1, P2, 40, ACTIVE, 4380), (1, P3, 30, ACTIVE, 4380))
+        self.assertEqual(self.sample(*p3_faster), [])
+        self.assertEqual(self.sample(), [])
+        self.assertEqual(self.sample(), [(1, P1, P3)])
+
+    def test_hold_down(self):
+        paths = ((1, P1, 100, ACTIVE, 4380), (1, P2, 40, ACTIVE, 4380))
+        for i in range(3):
+            self.sample(*paths)
+        # P1 gets faster than P2 at once, but 30 s must pass since the switch
+        self.sk.table = status_table((1, P1, 10, ACTIVE, 4380), (1, P2, 40, ACTIVE, 4380))
+        self.sk.table.set_primary(1, P2)
+        switches = [self.sample() for i in range(40)]
+        self.assertEqual(switches.index([(1, P2, P1)]), 29)
+        self.assertEqual(len([s for s in switches if s]), 1)
+
+    def test_ineligible_paths(self):
+        # inactive, without srtt, or with a small cwnd
+        for row in [(1, P2, 40, INACTIVE, 4380), (1, P2, 0, ACTIVE, 4380), (1, P2, 40, ACTIVE, 999)]:
+            for i in range(5):
+                self.assertEqual(self.sample((1, P1, 100, ACTIVE, 4380), row), [])
+
+    def test_primary_failing(self):
+        # the kernel is already failing over
+        for i in range(5):
+            self.assertEqual(self.sample((1, P1, 100, INACTIVE, 4380), (1, P2, 40, ACTIVE, 4380)), [])
+
+    def test_unreachable_address(self):
+        paths = ((1, P1, 100, ACTIVE, 4380), (1, P2, 40, ACTIVE, 4380))
+        self.pm.handle_notification(sctp.paddr_change({
+            "assoc_id": 1, "addr": P2, "state": sctp.paddr_change.state_ADDR_UNREACHABLE}))
+        self.clock.advance(60)
+        for i in range(5):
+            self.assertEqual(self.sample(*paths), [])
+        # the event also starts a hold down
+        self.pm.handle_notification(sctp.paddr_change({
+            "assoc_id": 1, "addr": P2, "state": sctp.paddr_change.state_ADDR_AVAILABLE}))
+        switches = [self.sample() for i in range(40)]
+        self.assertEqual(switches.index([(1, P1, P2)]), 29)
+
+    def test_associations(self):
+        self.pm.default_policy.hold_down = 0
+        self.pm.set_policy(3, sctp_pathmgr.path_policy(enabled=False))
+        switched = []
+        self.pm.on_switch = lambda *args: switched.append(args)
+        paths = ((1, P1, 100, ACTIVE, 4380), (1, P2, 40, ACTIVE, 4380),
+                 (2, P1, 100, ACTIVE, 4380), (2, P2, 90, ACTIVE, 4380),
+                 (3, P1, 100, ACTIVE, 4380), (3, P2, 40, ACTIVE, 4380))
+        self.assertEqual(self.sample(*paths), [])
+        self.assertEqual(self.sample(), [])
+        self.assertEqual(self.sample(), [(1, P1, P2)])
+        self.assertEqual(switched, [(1, P1, P2)])
+
+    def test_set_primary_error(self):
+        self.pm.default_policy.hold_down = 0
+        errors = []
+        self.pm.on_error = lambda *args: errors.append(args)
+
+        def gone(assoc_id, addr):
+            raise IOError(errno.EINVAL, "Invalid argument")
+        self.sk.set_primary = gone
+        paths = ((1, P1, 100, ACTIVE, 4380), (1, P2, 40, ACTIVE, 4380))
+        self.sample(*paths)
+        self.sample()
+        self.assertEqual(self.sample(), [])
+        self.assertEqual([e[:2] for e in errors], [(1, P2)])
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,121 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+sctp_pool bookkeeping of peers and their assoc_id, as the assoc_change
+notifications and messages scripted on a fakesctp socket come in.
+
+python test_pool.py
+"""
+
+import errno
+import unittest
+
+import sctp
+import sctp_pool
+from fakesctp import fake_socket
+
+HSS1 = [("10.0.1.1", 3868), ("10.0.2.1", 3868)]
+HSS2 = [("10.0.1.2", 3868)]
+
+
+def assoc_change(assoc_id, state):
+    return sctp.assoc_change({"assoc_id": assoc_id, "state": state})
+
+
+def data(assoc_id, msg):
+    info = sctp.sndrcvinfo()
+    info.assoc_id = assoc_id
+    return (None, 0, msg, info)
+
+
+class PoolTest(unittest.TestCase):
+
+    def setUp(self):
+        self.sk = fake_socket()
+        self.pool = sctp_pool.assoc_pool(sk=self.sk)
+        self.pool.add_peer("hss1", HSS1)
+        self.pool.add_peer("hss2", HSS2)
+
+    def tearDown(self):
+        self.pool.close()
+
+    def notify(self, fromaddr, assoc_id, state):
+        self.sk.received.append((fromaddr, sctp.FLAG_NOTIFICATION, b"",
+                                 assoc_change(assoc_id, state)))
+        return self.pool.recv(2048)[0]
+
+    def test_lookup_by_assoc_id(self):
+        # associations are learnt from COMM_UP, by any of the peer addresses
+        self.assertEqual(self.notify(HSS1[1], 7, sctp.assoc_change.state_COMM_UP), "hss1")
+        self.assertEqual(self.notify(HSS2[0], 9, sctp.assoc_change.state_COMM_UP), "hss2")
+        self.assertEqual((self.pool.assoc_id("hss1"), self.pool.assoc_id("hss2")), (7, 9))
+
+        # messages carry no address, only their assoc_id
+        self.sk.received += [data(9, b"to hss2"), data(7, b"to hss1"), data(8, b"unknown")]
+        self.assertEqual(self.pool.recv(2048)[0::3], ("hss2", b"to hss2"))
+        self.assertEqual(self.pool.recv(2048)[0::3], ("hss1", b"to hss1"))
+        self.assertEqual(self.pool.recv(2048)[0::3], (None, b"unknown"))
+
+        self.pool.send("hss2", b"a")
+        self.pool.send("hss1", b"b")
+        self.assertEqual(self.sk.sent, [(9, b"a"), (7, b"b")])
+        self.assertEqual(self.pool.stats()["hits"], 2)
+
+    def test_lost_and_restarted(self):
+        self.notify(HSS1[0], 7, sctp.assoc_change.state_COMM_UP)
+        self.assertEqual(self.notify(None, 7, sctp.assoc_change.state_COMM_LOST), "hss1")
+        self.assertEqual(self.pool.assoc_id("hss1"), None)
+        self.sk.received.append(data(7, b"late"))
+        self.assertEqual(self.pool.recv(2048)[0], None)
+
+        # a new association to the same peer takes over the lookup
+        self.notify(HSS1[0], 12, sctp.assoc_change.state_COMM_UP)
+        self.sk.received.append(data(12, b"again"))
+        self.assertEqual(self.pool.recv(2048)[0], "hss1")
+        self.assertEqual(self.pool.peer("hss1").connects, 2)
+
+    def test_stale_assoc_id(self):
+        # an old association going away leaves the current one alone
+        self.notify(HSS1[0], 7, sctp.assoc_change.state_COMM_UP)
+        self.notify(HSS1[0], 12, sctp.assoc_change.state_RESTART)
+        self.assertEqual(self.notify(HSS1[0], 7, sctp.assoc_change.state_SHUTDOWN_COMP), "hss1")
+        self.assertEqual(self.pool.assoc_id("hss1"), 12)
+
+    def test_bad_parameters(self):
+        # EINVAL (e.g. a stream beyond outstrms) leaves the association alone
+        self.notify(HSS1[0], 7, sctp.assoc_change.state_COMM_UP)
+        self.sk.send_errors.append(errno.EINVAL)
+        try:
+            self.pool.send("hss1", b"a", stream=100)
+            self.fail("EINVAL not raised")
+        except IOError as e:
+            self.assertEqual(e.errno, errno.EINVAL)
+        self.assertEqual(self.pool.assoc_id("hss1"), 7)
+        self.assertEqual(self.pool.peer("hss1").retry_at, 0.0)
+        self.pool.send("hss1", b"b")
+        self.assertEqual(self.sk.sent, [(7, b"b")])
+
+    def test_remove_peer(self):
+        self.notify(HSS2[0], 9, sctp.assoc_change.state_COMM_UP)
+        self.pool.remove_peer("hss2")
+        self.assertEqual(self.sk.sent, [(9, b"")])
+        self.sk.received.append(data(9, b"late"))
+        self.assertEqual(self.pool.recv(2048)[0], None)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,189 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+#
+# This library is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by the
+# Free Software Foundation; either version 2.1 of the License, or (at your
+# option) any later version.
+#
+# This library is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+"""
+Conformance tests of the M3UA codec (_sigtran) against messages laid out
+as in RFC 4666 section 3. No SCTP stack is needed:
+
+python test_sigtran.py
+"""
+
+import socket
+import binascii
+import unittest
+
+import _sigtran as m3ua
+
+
+def vector(s):
+    return binascii.unhexlify(s.replace(" ", ""))
+
+# RFC 4666 3.5.1 ASP Up, ASP Identifier 1
+ASPUP = vector("01 00 03 01 00000010  0011 0008 00000001")
+# RFC 4666 3.7.1 ASP Active, Traffic Mode Type 2 (loadshare), Routing Context 1
+ASPAC = vector("01 00 04 01 00000018  000b 0008 00000002  0006 0008 00000001")
+# RFC 4666 3.3.1 Payload Data, Routing Context 1, OPC 1, DPC 2, SI 3 (SCCP),
+# NI 2, MP 0, SLS 5, 3 bytes of user data (padded)
+DATA = vector("01 00 01 01 00000024  0006 0008 00000001"
+              "0210 0013 00000001 00000002 03 02 00 05 616263 00")
+# RFC 4666 3.5.5 Heartbeat, 5 bytes of Heartbeat Data (padded)
+BEAT = vector("01 00 03 03 00000014  0009 0009 0102030405 000000")
+# RFC 4666 3.8.2 Notify, Status Type 1 (AS-State_Change), Information 3 (AS-ACTIVE)
+NTFY = vector("01 00 00 01 00000010  000d 0008 0001 0003")
+# RFC 4666 3.8.1 Error, Error Code 0x01 (Invalid Version)
+ERR = vector("01 00 00 00 00000010  000c 0008 00000001")
+# RFC 4666 3.4.1 DUNA, Affected Point Code 0x001234
+DUNA = vector("01 00 02 01 00000010  0012 0008 00001234")
+
+
+class ParseTest(unittest.TestCase):
+
+    def check(self, msg, cls, typ, params):
+        m = m3ua.m3ua_parse(msg)
+        self.assertEqual((m.version, m.msg_class, m.msg_type, m.length), (1, cls, typ, len(msg)))
+        self.assertEqual([p[0] for p in m], params)
+        return m
+
+    def test_management(self):
+        m = self.check(ASPUP, m3ua.CLASS_ASPSM, m3ua.ASPUP, [m3ua.TAG_ASP_IDENTIFIER])
+        self.assertEqual(m.get_u32(m3ua.TAG_ASP_IDENTIFIER), 1)
+        m = self.check(ASPAC, m3ua.CLASS_ASPTM, m3ua.ASPAC,
+                       [m3ua.TAG_TRAFFIC_MODE_TYPE, m3ua.TAG_ROUTING_CONTEXT])
+        self.assertEqual(m.get_u32(m3ua.TAG_TRAFFIC_MODE_TYPE), 2)
+        self.assertEqual(m.get_u32(m3ua.TAG_ROUTING_CONTEXT), 1)
+        m = self.check(NTFY, m3ua.CLASS_MGMT, m3ua.NTFY, [m3ua.TAG_STATUS])
+        self.assertEqual(bytes(m.get(m3ua.TAG_STATUS)), vector("0001 0003"))
+        m = self.check(ERR, m3ua.CLASS_MGMT, m3ua.ERR, [m3ua.TAG_ERROR_CODE])
+        self.assertEqual(m.get_u32(m3ua.TAG_ERROR_CODE), 1)
+        m = self.check(DUNA, m3ua.CLASS_SSNM, m3ua.DUNA, [m3ua.TAG_AFFECTED_POINT_CODE])
+        self.assertEqual(m.get_u32(m3ua.TAG_AFFECTED_POINT_CODE), 0x1234)
+
+    def test_data(self):
+        m = self.check(DATA, m3ua.CLASS_TRANSFER, m3ua.DATA,
+                       [m3ua.TAG_ROUTING_CONTEXT, m3ua.TAG_PROTOCOL_DATA])
+        opc, dpc, si, ni, mp, sls, data = m.protocol_data()
+        self.assertEqual((opc, dpc, si, ni, mp, sls), (1, 2, 3, 2, 0, 5))
+        self.assertEqual(bytes(data), b"abc")
+        # (tag, value offset, value length)
+        self.assertEqual(m[1], (m3ua.TAG_PROTOCOL_DATA, 20, 15))
+        self.assertEqual(m[-1], m[1])
+
+    def test_padding(self):
+        m = self.check(BEAT, m3ua.CLASS_ASPSM, m3ua.BEAT, [m3ua.TAG_HEARTBEAT_DATA])
+        self.assertEqual(bytes(m.get(m3ua.TAG_HEARTBEAT_DATA)), vector("0102030405"))
+        # padding of the last parameter left out of the message length
+        short = BEAT[:4] + vector("00000011") + BEAT[8:17]
+        m = m3ua.m3ua_parse(short)
+        self.assertEqual(bytes(m.get(m3ua.TAG_HEARTBEAT_DATA)), vector("0102030405"))
+
+    def test_lookup(self):
+        m = m3ua.m3ua_parse(ASPAC)
+        self.assertEqual(m.find(m3ua.TAG_ROUTING_CONTEXT), 1)
+        self.assertEqual(m.find(m3ua.TAG_INFO_STRING), -1)
+        self.assertEqual(m.get(m3ua.TAG_INFO_STRING), None)
+        self.assertEqual(m.get_u32(m3ua.TAG_INFO_STRING, 7), 7)
+        self.assertEqual(m.protocol_data(), None)
+        self.assertRaises(IndexError, lambda: m[2])
+
+    def test_zero_copy(self):
+        buf = bytearray(b"\xff" * 4 + DATA)
+        m = m3ua.m3ua_parse(buf, 4)
+        self.assertEqual(m.offset, 4)
+        self.assertTrue(m.buffer is buf)
+        data = m.protocol_data()[6]
+        buf[-4:-1] = b"xyz"
+        self.assertEqual(bytes(data), b"xyz")
+        # the buffer cannot be resized under the index
+        self.assertRaises(BufferError, buf.extend, b"x")
+        del m, data
+        buf.extend(b"x")
+
+    def test_malformed(self):
+        bad = [
+            ASPUP[:7],                                     # shorter than the header
+            b"\x02" + ASPUP[1:],                           # version 2
+            ASPUP[:4] + vector("00000007") + ASPUP[8:],    # length below the header
+            ASPUP[:4] + vector("00000014") + ASPUP[8:],    # length beyond the buffer
+            ASPUP[:10] + vector("0003") + ASPUP[12:],      # parameter length below 4
+            ASPUP[:10] + vector("000c") + ASPUP[12:],      # parameter beyond the message
+            ASPUP[:4] + vector("0000000a") + ASPUP[8:10],  # truncated parameter header
+        ]
+        for msg in bad:
+            self.assertRaises(ValueError, m3ua.m3ua_parse, msg)
+        self.assertRaises(ValueError, m3ua.m3ua_parse, ASPUP, 12)
+        self.assertRaises(ValueError, m3ua.m3ua_parse, ASPUP, -1)
+        trailing = ASPUP + b"\0" * 8
+        self.assertEqual(m3ua.m3ua_parse(trailing).length, len(ASPUP))
+
+
+class EncodeTest(unittest.TestCase):
+
+    def test_encode(self):
+        self.assertEqual(m3ua.m3ua_encode(None, 0, m3ua.CLASS_ASPSM, m3ua.ASPUP,
+                                          [(m3ua.TAG_ASP_IDENTIFIER, 1)]), ASPUP)
+        self.assertEqual(m3ua.m3ua_encode(None, 0, m3ua.CLASS_ASPTM, m3ua.ASPAC,
+                                          [(m3ua.TAG_TRAFFIC_MODE_TYPE, 2),
+                                           (m3ua.TAG_ROUTING_CONTEXT, 1)]), ASPAC)
+        self.assertEqual(m3ua.m3ua_encode(None, 0, m3ua.CLASS_ASPSM, m3ua.BEAT,
+                                          [(m3ua.TAG_HEARTBEAT_DATA, vector("0102030405"))]), BEAT)
+        self.assertEqual(m3ua.m3ua_encode(None, 0, m3ua.CLASS_MGMT, m3ua.NTFY,
+                                          [(m3ua.TAG_STATUS, bytearray(vector("0001 0003")))]), NTFY)
+
+    def test_encode_data(self):
+        self.assertEqual(m3ua.m3ua_encode_data(None, 0, 1, 2, 3, 2, 0, 5, b"abc", 1), DATA)
+        msg = m3ua.m3ua_encode_data(None, 0, 0x3fff, 0x10, 3, 2, 1, 15, b"x" * 100, None, 7, 9)
+        m = m3ua.m3ua_parse(msg)
+        self.assertEqual([p[0] for p in m], [m3ua.TAG_NETWORK_APPEARANCE, m3ua.TAG_PROTOCOL_DATA,
+                                             m3ua.TAG_CORRELATION_ID])
+        self.assertEqual(m.get_u32(m3ua.TAG_NETWORK_APPEARANCE), 7)
+        self.assertEqual(m.get_u32(m3ua.TAG_CORRELATION_ID), 9)
+        self.assertEqual(m.protocol_data()[:6], (0x3fff, 0x10, 3, 2, 1, 15))
+        self.assertEqual(bytes(m.protocol_data()[6]), b"x" * 100)
+
+    def test_into_buffer(self):
+        buf = bytearray(64)
+        n = m3ua.m3ua_encode_data(buf, 4, 1, 2, 3, 2, 0, 5, b"abc", 1)
+        self.assertEqual(n, len(DATA))
+        self.assertEqual(bytes(buf[4:4 + n]), DATA)
+        n = m3ua.m3ua_encode(memoryview(buf), 0, m3ua.CLASS_ASPSM, m3ua.ASPUP,
+                             [(m3ua.TAG_ASP_IDENTIFIER, 1)])
+        self.assertEqual(bytes(buf[:n]), ASPUP)
+        self.assertRaises(ValueError, m3ua.m3ua_encode_data, buf, 40, 1, 2, 3, 2, 0, 5, b"abc", 1)
+        self.assertRaises((TypeError, BufferError), m3ua.m3ua_encode_data, b"read-only" * 8, 0, 1, 2, 3, 2, 0, 5, b"")
+
+    def test_bad_params(self):
+        self.assertRaises(TypeError, m3ua.m3ua_encode, None, 0, 3, 1, [1])
+        self.assertRaises(TypeError, m3ua.m3ua_encode, None, 0, 3, 1, [(1,)])
+        self.assertRaises(TypeError, m3ua.m3ua_encode, None, 0, 3, 1, [(1, 1.5)])
+        self.assertRaises(ValueError, m3ua.m3ua_encode, None, 0, 3, 1, [(1, b"x" * 65532)])
+
+    def test_send_buffer(self):
+        # the encode buffer goes to sctp_send() as is, without a copy
+        try:
+            import _sctp
+        except ImportError:
+            return
+        a, b = socket.socketpair(socket.AF_UNIX, socket.SOCK_SEQPACKET)
+        buf = bytearray(256)
+        n = m3ua.m3ua_encode_data(buf, 0, 1, 2, 3, 2, 0, 5, b"abc", 1)
+        _sctp.sctp_send_msg(a.fileno(), memoryview(buf)[:n], ("", 0), m3ua.PPID_M3UA, 0, 0, 0, 0)
+        self.assertEqual(b.recv(256), DATA)
+        a.close()
+        b.close()
+
+if __name__ == '__main__':
+    unittest.main()